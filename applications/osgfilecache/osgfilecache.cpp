@@ -415,6 +415,9 @@ int main( int argc, char **argv )
     arguments.getApplicationUsage()->addCommandLineOption("-e level minX minY maxX maxY","Read down to <level> across the extents minX, minY to maxY, maxY.  Note, for geocentric datase X and Y are longitude and latitude respectively.");
     arguments.getApplicationUsage()->addCommandLineOption("-c directory","Shorthand for --file-cache directory.");
     arguments.getApplicationUsage()->addCommandLineOption("--file-cache directory","Set directory as to place cache download files.");
+    arguments.getApplicationUsage()->addCommandLineOption("--content-addressed","Store the cached files once per distinct content, named by a hash of their contents.");
+    arguments.getApplicationUsage()->addCommandLineOption("--compress","Compress the files of the content addressed cache.");
+    arguments.getApplicationUsage()->addCommandLineOption("--max-size megabytes","Maximum size of the content addressed cache, least recently used files being evicted beyond it.");
 
     // if user request help write it out to cout.
     if (arguments.read("-h") || arguments.read("--help"))
@@ -443,7 +446,17 @@ int main( int argc, char **argv )
         return 1;
     }
 
-    ldv.setFileCache(new osgDB::FileCache(fileCachePath));
+    osg::ref_ptr<osgDB::FileCache> fileCache = new osgDB::FileCache(fileCachePath);
+
+    if (arguments.read("--compress")) fileCache->setCompressed(true);
+
+    double maxSize = 0.0;
+    while(arguments.read("--max-size",maxSize)) {}
+    if (maxSize>0.0) fileCache->setMaximumSizeInBytes(static_cast<unsigned long long>(maxSize*1024.0*1024.0));
+
+    if (arguments.read("--content-addressed")) fileCache->setContentAddressed(true);
+
+    ldv.setFileCache(fileCache.get());
 
     unsigned int maxLevels = 0;
     while(arguments.read("-l",maxLevels))
@@ -0,0 +1,141 @@
+/*  -*-c++-*-
+ *
+ * This library is open source and may be redistributed and/or modified under
+ * the terms of the OpenSceneGraph Public License (OSGPL) version 0.0 or
+ * (at your option) any later version.  The full license is in LICENSE file
+ * included with this distribution, and on the openscenegraph.org website.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * OpenSceneGraph Public License for more details.
+*/
+
+// Micro benchmark of the keyframe lookup of osgAnimation samplers: the cached/uniform rate
+// lookup of TemplateInterpolatorBase is compared with a plain binary search on dense
+// (resampled, evenly spaced) and sparse (irregular) tracks, sampled sequentially like
+// a playing animation and randomly.
+
+#include <algorithm>
+#include <iostream>
+#include <cstdlib>
+#include <vector>
+
+#include <osg/ArgumentParser>
+#include <osg/ApplicationUsage>
+#include <osg/Timer>
+#include <osgAnimation/Sampler>
+
+
+// keyframe search used before the lookup cache
+int binarySearch(const osgAnimation::Vec3KeyframeContainer& keys, double time)
+{
+    int k = 0;
+    int l = keys.size();
+    int mid = l / 2;
+    while (mid != k)
+    {
+        if (keys[mid].getTime() < time)
+            k = mid;
+        else
+            l = mid;
+        mid = (l + k) / 2;
+    }
+    return k;
+}
+
+
+osgAnimation::Vec3LinearSampler* createSampler(unsigned int numKeys, bool dense)
+{
+    osgAnimation::Vec3LinearSampler* sampler = new osgAnimation::Vec3LinearSampler;
+    osgAnimation::Vec3KeyframeContainer* keys = sampler->getOrCreateKeyframeContainer();
+    double time = 0.0;
+    for (unsigned int i = 0; i < numKeys; i++)
+    {
+        keys->push_back(osgAnimation::Vec3Keyframe(time, osg::Vec3(i, 2.0f * i, 3.0f * i)));
+        time += dense ? 1.0 / 30.0 : 0.05 + 2.0 * rand() / RAND_MAX;
+    }
+    return sampler;
+}
+
+
+void benchmark(const std::string& label, const osgAnimation::Vec3LinearSampler& sampler, const std::vector<double>& times)
+{
+    const osgAnimation::Vec3KeyframeContainer& keys = *sampler.getKeyframeContainerTyped();
+
+    osg::Timer_t start = osg::Timer::instance()->tick();
+    int checksum = 0;
+    for (unsigned int i = 0; i < times.size(); i++)
+        checksum += binarySearch(keys, times[i]);
+    double searchTime = osg::Timer::instance()->delta_u(start, osg::Timer::instance()->tick());
+
+    osgAnimation::Vec3LinearInterpolator interpolator;
+    start = osg::Timer::instance()->tick();
+    int cachedChecksum = 0;
+    for (unsigned int i = 0; i < times.size(); i++)
+        cachedChecksum += interpolator.getKeyIndexFromTime(keys, times[i]);
+    double cachedTime = osg::Timer::instance()->delta_u(start, osg::Timer::instance()->tick());
+
+    start = osg::Timer::instance()->tick();
+    osg::Vec3 sum;
+    for (unsigned int i = 0; i < times.size(); i++)
+    {
+        osg::Vec3 value;
+        sampler.getValueAt(times[i], value);
+        sum += value;
+    }
+    double samplerTime = osg::Timer::instance()->delta_u(start, osg::Timer::instance()->tick());
+
+    std::cout << label << ": binary search " << 1000.0 * searchTime / times.size() << " ns, cached lookup "
+              << 1000.0 * cachedTime / times.size() << " ns (speedup " << (cachedTime > 0.0 ? searchTime / cachedTime : 0.0)
+              << "), sampler " << 1000.0 * samplerTime / times.size() << " ns per evaluation"
+              << (checksum == cachedChecksum ? "" : " MISMATCH") << std::endl;
+}
+
+
+int main(int argc, char** argv)
+{
+    osg::ArgumentParser arguments(&argc, argv);
+    arguments.getApplicationUsage()->setApplicationName(arguments.getApplicationName());
+    arguments.getApplicationUsage()->setDescription(arguments.getApplicationName() + " benchmarks the keyframe lookup of osgAnimation samplers.");
+    arguments.getApplicationUsage()->setCommandLineUsage(arguments.getApplicationName() + " [options]");
+    arguments.getApplicationUsage()->addCommandLineOption("--dense <n>", "Number of keys of the evenly spaced track (default 20000).");
+    arguments.getApplicationUsage()->addCommandLineOption("--sparse <n>", "Number of keys of the irregular track (default 200).");
+    arguments.getApplicationUsage()->addCommandLineOption("--samples <n>", "Number of evaluations (default 1000000).");
+    arguments.getApplicationUsage()->addCommandLineOption("-h or --help", "Display this information.");
+
+    if (arguments.read("-h") || arguments.read("--help"))
+    {
+        arguments.getApplicationUsage()->write(std::cout);
+        return 1;
+    }
+
+    unsigned int numDense = 20000, numSparse = 200, numSamples = 1000000;
+    while (arguments.read("--dense", numDense)) {}
+    while (arguments.read("--sparse", numSparse)) {}
+    while (arguments.read("--samples", numSamples)) {}
+
+    osg::ref_ptr<osgAnimation::Vec3LinearSampler> dense = createSampler(std::max(numDense, 2u), true);
+    osg::ref_ptr<osgAnimation::Vec3LinearSampler> sparse = createSampler(std::max(numSparse, 2u), false);
+
+    const osgAnimation::Vec3LinearSampler* samplers[2] = { dense.get(), sparse.get() };
+    const char* names[2] = { "dense", "sparse" };
+    for (unsigned int s = 0; s < 2; s++)
+    {
+        double startTime = samplers[s]->getStartTime(), endTime = samplers[s]->getEndTime();
+
+        // playback: small time steps looping over the track
+        std::vector<double> times(numSamples);
+        double step = (endTime - startTime) / 5000.0;
+        for (unsigned int i = 0; i < numSamples; i++)
+            times[i] = startTime + (endTime - startTime) * 1e-6 + static_cast<double>(i % 5000) * step;
+        benchmark(std::string(names[s]) + " playback", *samplers[s], times);
+
+        // random access
+        for (unsigned int i = 0; i < numSamples; i++)
+            times[i] = startTime + (endTime - startTime) * rand() / RAND_MAX;
+        benchmark(std::string(names[s]) + " random", *samplers[s], times);
+    }
+
+    return 0;
+}
@@ -0,0 +1,232 @@
+/*  -*-c++-*-
+ *
+ * This library is open source and may be redistributed and/or modified under
+ * the terms of the OpenSceneGraph Public License (OSGPL) version 0.0 or
+ * (at your option) any later version.  The full license is in LICENSE file
+ * included with this distribution, and on the openscenegraph.org website.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * OpenSceneGraph Public License for more details.
+*/
+
+// Compares a double precision reference skinning, computed per bone set like the former
+// RigTransformSoftware implementation, with the palette based (SIMD, optionally threaded)
+// skinning used by RigTransformSoftware::operator().
+
+#include <iostream>
+#include <sstream>
+#include <cmath>
+#include <algorithm>
+#include <map>
+
+#include <osg/ArgumentParser>
+#include <osg/ApplicationUsage>
+#include <osg/Geometry>
+#include <osg/Timer>
+#include <osgAnimation/Bone>
+#include <osgAnimation/Skeleton>
+#include <osgAnimation/RigGeometry>
+#include <osgAnimation/RigTransformSoftware>
+
+
+// a cylinder along z, each ring being influenced by the two closest bones of a vertical chain
+osgAnimation::RigGeometry* createRig(osgAnimation::Skeleton* skeleton, unsigned int numVertexes, unsigned int numBones,
+                                     std::vector<osgAnimation::Bone*>& bones)
+{
+    for (unsigned int i = 0; i < numBones; i++)
+    {
+        std::ostringstream name;
+        name << "bone" << i;
+        osgAnimation::Bone* bone = new osgAnimation::Bone(name.str());
+        bone->setInvBindMatrixInSkeletonSpace(osg::Matrix::translate(0.0, 0.0, -static_cast<double>(i)));
+        skeleton->addChild(bone);
+        bones.push_back(bone);
+    }
+
+    const unsigned int ringSize = 64;
+    unsigned int numRings = std::max(numVertexes / ringSize, 2u);
+    float height = static_cast<float>(numBones - 1);
+
+    osg::ref_ptr<osg::Geometry> source = new osg::Geometry;
+    osg::ref_ptr<osg::Vec3Array> vertexes = new osg::Vec3Array;
+    osg::ref_ptr<osg::Vec3Array> normals = new osg::Vec3Array;
+    osg::ref_ptr<osgAnimation::VertexInfluenceMap> influences = new osgAnimation::VertexInfluenceMap;
+
+    for (unsigned int r = 0; r < numRings; r++)
+    {
+        float z = height * r / (numRings - 1);
+        unsigned int bone = std::min(static_cast<unsigned int>(z), numBones - 2);
+        // weights are quantized so that rings share their bone sets like in authored rigs
+        float weight = std::floor((z - bone) * 8.0f + 0.5f) / 8.0f;
+
+        for (unsigned int s = 0; s < ringSize; s++)
+        {
+            float angle = 2.0f * osg::PI * s / ringSize;
+            int index = vertexes->size();
+            vertexes->push_back(osg::Vec3(cosf(angle), sinf(angle), z));
+            normals->push_back(osg::Vec3(cosf(angle), sinf(angle), 0.0f));
+
+            std::string lower = bones[bone]->getName(), upper = bones[bone + 1]->getName();
+            if (weight < 1.0f)
+            {
+                (*influences)[lower].setName(lower);
+                (*influences)[lower].push_back(osgAnimation::VertexIndexWeight(index, 1.0f - weight));
+            }
+            if (weight > 0.0f)
+            {
+                (*influences)[upper].setName(upper);
+                (*influences)[upper].push_back(osgAnimation::VertexIndexWeight(index, weight));
+            }
+        }
+    }
+
+    source->setVertexArray(vertexes.get());
+    source->setNormalArray(normals.get(), osg::Array::BIND_PER_VERTEX);
+    source->addPrimitiveSet(new osg::DrawArrays(GL_POINTS, 0, vertexes->size()));
+
+    osgAnimation::RigGeometry* rig = new osgAnimation::RigGeometry;
+    rig->setSourceGeometry(source.get());
+    rig->setInfluenceMap(influences.get());
+    rig->setSkeleton(skeleton);
+    rig->buildVertexInfluenceSet();
+    return rig;
+}
+
+
+// skins the source streams of the rig in double precision, one matrix per bone set
+void skinReference(const osgAnimation::RigGeometry& rig, const std::vector<osgAnimation::Bone*>& bones,
+                   const osg::Vec3Array& positionSrc, osg::Vec3Array& positionDst,
+                   const osg::Vec3Array& normalSrc, osg::Vec3Array& normalDst)
+{
+    std::map<std::string, const osgAnimation::Bone*> boneMap;
+    for (unsigned int i = 0; i < bones.size(); i++)
+        boneMap[bones[i]->getName()] = bones[i];
+
+    const osg::Matrix& transform = rig.getMatrixFromSkeletonToGeometry();
+    const osg::Matrix& invTransform = rig.getInvMatrixFromSkeletonToGeometry();
+
+    const osgAnimation::VertexInfluenceSet::UniqVertexSetToBoneSetList& boneSets = rig.getVertexInfluenceSet().getUniqVertexSetToBoneSetList();
+    for (unsigned int i = 0; i < boneSets.size(); i++)
+    {
+        const osgAnimation::VertexInfluenceSet::BoneWeightList& boneWeights = boneSets[i].getBones();
+        osg::Matrix accumulated(0, 0, 0, 0,
+                                0, 0, 0, 0,
+                                0, 0, 0, 0,
+                                0, 0, 0, 1);
+        for (unsigned int b = 0; b < boneWeights.size(); b++)
+        {
+            const osgAnimation::Bone* bone = boneMap[boneWeights[b].getBoneName()];
+            osg::Matrix m = bone->getInvBindMatrixInSkeletonSpace() * bone->getMatrixInSkeletonSpace();
+            for (unsigned int row = 0; row < 4; row++)
+                for (unsigned int col = 0; col < 3; col++)
+                    accumulated(row, col) += m(row, col) * boneWeights[b].getWeight();
+        }
+        osg::Matrix matrix = transform * accumulated * invTransform;
+
+        const std::vector<int>& vertexes = boneSets[i].getVertexes();
+        for (unsigned int j = 0; j < vertexes.size(); j++)
+        {
+            int idx = vertexes[j];
+            positionDst[idx] = positionSrc[idx] * matrix;
+            normalDst[idx] = osg::Matrix::transform3x3(normalSrc[idx], matrix);
+        }
+    }
+}
+
+
+void animate(std::vector<osgAnimation::Bone*>& bones, unsigned int frame)
+{
+    for (unsigned int i = 0; i < bones.size(); i++)
+    {
+        double angle = 0.1 * sin(0.05 * frame + 0.3 * i);
+        bones[i]->setMatrixInSkeletonSpace(osg::Matrix::rotate(angle, osg::X_AXIS) * osg::Matrix::translate(0.0, 0.0, static_cast<double>(i)));
+    }
+}
+
+
+int main(int argc, char** argv)
+{
+    osg::ArgumentParser arguments(&argc, argv);
+    arguments.getApplicationUsage()->setApplicationName(arguments.getApplicationName());
+    arguments.getApplicationUsage()->setDescription(arguments.getApplicationName() + " benchmarks the software skinning of RigTransformSoftware.");
+    arguments.getApplicationUsage()->setCommandLineUsage(arguments.getApplicationName() + " [options]");
+    arguments.getApplicationUsage()->addCommandLineOption("--vertexes <n>", "Number of skinned vertexes (default 100000).");
+    arguments.getApplicationUsage()->addCommandLineOption("--bones <n>", "Number of bones (default 64).");
+    arguments.getApplicationUsage()->addCommandLineOption("--frames <n>", "Number of skinned frames (default 200).");
+    arguments.getApplicationUsage()->addCommandLineOption("--threads <n>", "Threads used by the palette path (default 0 i.e. number of processors).");
+    arguments.getApplicationUsage()->addCommandLineOption("-h or --help", "Display this information.");
+
+    if (arguments.read("-h") || arguments.read("--help"))
+    {
+        arguments.getApplicationUsage()->write(std::cout);
+        return 1;
+    }
+
+    unsigned int numVertexes = 100000, numBones = 64, numFrames = 200, numThreads = 0;
+    while (arguments.read("--vertexes", numVertexes)) {}
+    while (arguments.read("--bones", numBones)) {}
+    while (arguments.read("--frames", numFrames)) {}
+    while (arguments.read("--threads", numThreads)) {}
+    numBones = std::max(numBones, 2u);
+    numFrames = std::max(numFrames, 1u);
+
+    osg::ref_ptr<osgAnimation::Skeleton> skeleton = new osgAnimation::Skeleton;
+    std::vector<osgAnimation::Bone*> bones;
+    osg::ref_ptr<osgAnimation::RigGeometry> rig = createRig(skeleton.get(), numVertexes, numBones, bones);
+
+    osg::ref_ptr<osgAnimation::RigTransformSoftware> software = new osgAnimation::RigTransformSoftware;
+    rig->setRigTransformImplementation(software.get());
+    animate(bones, 0);
+    (*software)(*rig); // initialization
+
+    osg::Vec3Array* positionSrc = dynamic_cast<osg::Vec3Array*>(rig->getSourceGeometry()->getVertexArray());
+    osg::Vec3Array* normalSrc = dynamic_cast<osg::Vec3Array*>(rig->getSourceGeometry()->getNormalArray());
+    osg::Vec3Array* positionDst = dynamic_cast<osg::Vec3Array*>(rig->getVertexArray());
+    osg::Vec3Array* normalDst = dynamic_cast<osg::Vec3Array*>(rig->getNormalArray());
+    if (!positionSrc || !normalSrc || !positionDst || !normalDst)
+    {
+        std::cout << "rig initialization failed" << std::endl;
+        return 1;
+    }
+    std::cout << positionSrc->size() << " vertexes, " << numBones << " bones, "
+              << rig->getVertexInfluenceSet().getUniqVertexSetToBoneSetList().size() << " bone sets" << std::endl;
+
+    osg::ref_ptr<osg::Vec3Array> positionRef = new osg::Vec3Array(*positionDst);
+    osg::ref_ptr<osg::Vec3Array> normalRef = new osg::Vec3Array(*normalDst);
+
+    osg::Timer_t start = osg::Timer::instance()->tick();
+    for (unsigned int frame = 0; frame < numFrames; frame++)
+    {
+        animate(bones, frame);
+        skinReference(*rig, bones, *positionSrc, *positionRef, *normalSrc, *normalRef);
+    }
+    double reference = osg::Timer::instance()->delta_m(start, osg::Timer::instance()->tick()) / numFrames;
+    std::cout << "reference path:      " << reference << " ms/frame" << std::endl;
+
+    unsigned int threads[2] = { 1, numThreads };
+    for (unsigned int t = 0; t < 2; t++)
+    {
+        software->setNumThreads(threads[t]);
+        start = osg::Timer::instance()->tick();
+        for (unsigned int frame = 0; frame < numFrames; frame++)
+        {
+            animate(bones, frame);
+            (*software)(*rig);
+        }
+        double time = osg::Timer::instance()->delta_m(start, osg::Timer::instance()->tick()) / numFrames;
+        std::cout << "palette path, " << software->getNumThreads() << " thread(s): " << time << " ms/frame (speedup "
+                  << (time > 0.0 ? reference / time : 0.0) << ")" << std::endl;
+    }
+
+    float positionError = 0.0f, normalError = 0.0f;
+    for (unsigned int i = 0; i < positionDst->size(); i++)
+    {
+        positionError = std::max(positionError, ((*positionDst)[i] - (*positionRef)[i]).length());
+        normalError = std::max(normalError, ((*normalDst)[i] - (*normalRef)[i]).length());
+    }
+    std::cout << "max difference: positions " << positionError << ", normals " << normalError << std::endl;
+
+    return (positionError < 1e-3f && normalError < 1e-3f) ? 0 : 1;
+}
@@ -0,0 +1,190 @@
+/* OpenSceneGraph example, osgbinaryload.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+*  THE SOFTWARE.
+*/
+
+// Compares the load time of a .osgb file read through a regular file stream and
+// through the memory mapped input of the osg plugin. A large scene is generated
+// (and written) when no file is given.
+
+#include <osg/ArgumentParser>
+#include <osg/ApplicationUsage>
+#include <osg/Geode>
+#include <osg/Geometry>
+#include <osg/NodeVisitor>
+#include <osg/Timer>
+
+#include <osgDB/ReadFile>
+#include <osgDB/WriteFile>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+
+// numGeometries grids of size x size vertices with normals, colors and texture coordinates
+osg::Node* createScene(unsigned int numGeometries, unsigned int size)
+{
+    osg::Geode* geode = new osg::Geode;
+    for(unsigned int g = 0 ; g < numGeometries ; ++ g) {
+        osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array;
+        osg::ref_ptr<osg::Vec3Array> normals = new osg::Vec3Array;
+        osg::ref_ptr<osg::Vec4Array> colors = new osg::Vec4Array;
+        osg::ref_ptr<osg::Vec2Array> texCoords = new osg::Vec2Array;
+        osg::ref_ptr<osg::DrawElementsUInt> triangles = new osg::DrawElementsUInt(GL_TRIANGLES);
+
+        for(unsigned int y = 0 ; y < size ; ++ y) {
+            for(unsigned int x = 0 ; x < size ; ++ x) {
+                float u = static_cast<float>(x) / size, v = static_cast<float>(y) / size;
+                vertices->push_back(osg::Vec3(u + g, v, 0.1f * sinf(10.f * u) * cosf(10.f * v)));
+                normals->push_back(osg::Vec3(0.f, 0.f, 1.f));
+                colors->push_back(osg::Vec4(u, v, 1.f, 1.f));
+                texCoords->push_back(osg::Vec2(u, v));
+
+                if(x + 1 < size && y + 1 < size) {
+                    unsigned int i = y * size + x;
+                    triangles->push_back(i); triangles->push_back(i + 1); triangles->push_back(i + size + 1);
+                    triangles->push_back(i); triangles->push_back(i + size + 1); triangles->push_back(i + size);
+                }
+            }
+        }
+
+        osg::Geometry* geometry = new osg::Geometry;
+        geometry->setVertexArray(vertices.get());
+        geometry->setNormalArray(normals.get(), osg::Array::BIND_PER_VERTEX);
+        geometry->setColorArray(colors.get(), osg::Array::BIND_PER_VERTEX);
+        geometry->setTexCoordArray(0, texCoords.get(), osg::Array::BIND_PER_VERTEX);
+        geometry->addPrimitiveSet(triangles.get());
+        geode->addDrawable(geometry);
+    }
+    return geode;
+}
+
+
+// concatenates the bytes of all the arrays and primitives of the scene
+struct CollectData : public osg::NodeVisitor
+{
+    CollectData() : osg::NodeVisitor(osg::NodeVisitor::TRAVERSE_ALL_CHILDREN) {}
+
+    void apply(osg::Geometry& geometry)
+    {
+        osg::Geometry::ArrayList arrays;
+        geometry.getArrayList(arrays);
+        for(unsigned int i = 0 ; i < arrays.size() ; ++ i) {
+            append(arrays[i]->getDataPointer(), arrays[i]->getTotalDataSize());
+        }
+        for(unsigned int i = 0 ; i < geometry.getNumPrimitiveSets() ; ++ i) {
+            osg::DrawElements* primitive = geometry.getPrimitiveSet(i)->getDrawElements();
+            if(primitive) {
+                append(primitive->getDataPointer(), primitive->getTotalDataSize());
+            }
+        }
+    }
+
+    void append(const void* data, unsigned int size)
+    {
+        const char* bytes = static_cast<const char*>(data);
+        _data.insert(_data.end(), bytes, bytes + size);
+    }
+
+    std::vector<char> _data;
+};
+
+
+double load(const std::string& filename, const std::string& options, unsigned int repeat, std::vector<char>& data)
+{
+    osg::ref_ptr<osgDB::Options> readOptions = new osgDB::Options(options);
+    readOptions->setObjectCacheHint(osgDB::Options::CACHE_NONE);
+
+    double time = 0.;
+    for(unsigned int r = 0 ; r < repeat ; ++ r) {
+        osg::Timer_t start = osg::Timer::instance()->tick();
+        osg::ref_ptr<osg::Node> node = osgDB::readRefNodeFile(filename, readOptions.get());
+        time += osg::Timer::instance()->delta_s(start, osg::Timer::instance()->tick());
+
+        if(!node) {
+            return -1.;
+        }
+        if(r == 0) {
+            CollectData collector;
+            node->accept(collector);
+            data.swap(collector._data);
+        }
+    }
+    return time / repeat;
+}
+
+
+int main(int argc, char** argv)
+{
+    osg::ArgumentParser arguments(&argc, argv);
+    arguments.getApplicationUsage()->setApplicationName(arguments.getApplicationName());
+    arguments.getApplicationUsage()->setDescription(arguments.getApplicationName() + " compares the stream based and memory mapped loading of .osgb files.");
+    arguments.getApplicationUsage()->setCommandLineUsage(arguments.getApplicationName() + " [options] [filename.osgb]");
+    arguments.getApplicationUsage()->addCommandLineOption("--geometries <n>", "Number of geometries of the generated scene (default 64).");
+    arguments.getApplicationUsage()->addCommandLineOption("--size <n>", "Each generated geometry is a grid of n*n vertices (default 512).");
+    arguments.getApplicationUsage()->addCommandLineOption("--output <file>", "File the generated scene is written to (default osgbinaryload.osgb).");
+    arguments.getApplicationUsage()->addCommandLineOption("--repeat <n>", "Number of loads averaged for each path (default 3).");
+    arguments.getApplicationUsage()->addCommandLineOption("-h or --help", "Display this information.");
+
+    if(arguments.read("-h") || arguments.read("--help")) {
+        arguments.getApplicationUsage()->write(std::cout);
+        return 1;
+    }
+
+    unsigned int numGeometries = 64;
+    while(arguments.read("--geometries", numGeometries)) {}
+
+    unsigned int size = 512;
+    while(arguments.read("--size", size)) {}
+
+    std::string filename = "osgbinaryload.osgb";
+    while(arguments.read("--output", filename)) {}
+
+    unsigned int repeat = 3;
+    while(arguments.read("--repeat", repeat)) {}
+    repeat = std::max(repeat, 1u);
+
+    if(arguments.argc() > 1) {
+        filename = arguments[1];
+    }
+    else {
+        osg::ref_ptr<osg::Node> scene = createScene(numGeometries, std::max(size, 2u));
+        if(!osgDB::writeNodeFile(*scene, filename)) {
+            std::cout << "unable to write " << filename << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<char> streamed, mapped;
+    double streamTime = load(filename, "DisableMemoryMapping", repeat, streamed);
+    double mappedTime = load(filename, "", repeat, mapped);
+    if(streamTime < 0. || mappedTime < 0.) {
+        std::cout << "unable to read " << filename << std::endl;
+        return 1;
+    }
+
+    bool identical = (streamed == mapped);
+    std::cout << filename << ": " << streamed.size() << " bytes of arrays" << std::endl;
+    std::cout << "file stream: " << streamTime << "s" << std::endl;
+    std::cout << "memory mapped: " << mappedTime << "s" << std::endl;
+    std::cout << "speedup: " << (mappedTime > 0. ? streamTime / mappedTime : 0.)
+              << ", outputs " << (identical ? "identical" : "DIFFER") << std::endl;
+
+    return identical ? 0 : 1;
+}
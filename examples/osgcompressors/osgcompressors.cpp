@@ -0,0 +1,130 @@
+/* OpenSceneGraph example, osgcompressors.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+*  THE SOFTWARE.
+*/
+
+// Reports the compression ratio and the compression/decompression throughput of the
+// compressors registered to the osgDB serializers (null, zlib, chunked...) on the
+// binary serialization of a scene.
+
+#include <osg/ArgumentParser>
+#include <osg/ApplicationUsage>
+#include <osg/Geode>
+#include <osg/Shape>
+#include <osg/ShapeDrawable>
+#include <osg/Timer>
+
+#include <osgDB/ObjectWrapper>
+#include <osgDB/ReadFile>
+#include <osgDB/Registry>
+
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+
+
+// a geode of tessellated spheres
+osg::Node* createScene(unsigned int numSpheres)
+{
+    osg::ref_ptr<osg::TessellationHints> hints = new osg::TessellationHints;
+    hints->setDetailRatio(4.f);
+
+    osg::Geode* geode = new osg::Geode;
+    for(unsigned int i = 0 ; i < numSpheres ; ++ i) {
+        osg::ShapeDrawable* sphere = new osg::ShapeDrawable(new osg::Sphere(osg::Vec3(i * 2.f, 0.f, 0.f), 1.f), hints.get());
+        geode->addDrawable(sphere);
+    }
+    return geode;
+}
+
+
+int main(int argc, char** argv)
+{
+    osg::ArgumentParser arguments(&argc, argv);
+    arguments.getApplicationUsage()->setApplicationName(arguments.getApplicationName());
+    arguments.getApplicationUsage()->setDescription(arguments.getApplicationName() + " reports the throughput of the osgDB compressors.");
+    arguments.getApplicationUsage()->setCommandLineUsage(arguments.getApplicationName() + " [options] [filename]");
+    arguments.getApplicationUsage()->addCommandLineOption("--spheres <n>", "Number of spheres of the generated scene (default 256).");
+    arguments.getApplicationUsage()->addCommandLineOption("--level <n>", "CompressorLevel option given to the compressors.");
+    arguments.getApplicationUsage()->addCommandLineOption("--block-size <bytes>", "CompressorBlockSize option given to the compressors.");
+    arguments.getApplicationUsage()->addCommandLineOption("--repeat <n>", "Number of runs averaged for each compressor (default 3).");
+    arguments.getApplicationUsage()->addCommandLineOption("-h or --help", "Display this information.");
+
+    if(arguments.read("-h") || arguments.read("--help")) {
+        arguments.getApplicationUsage()->write(std::cout);
+        return 1;
+    }
+
+    unsigned int numSpheres = 256;
+    while(arguments.read("--spheres", numSpheres)) {}
+
+    osg::ref_ptr<osgDB::Options> options = new osgDB::Options;
+    std::string value;
+    while(arguments.read("--level", value)) { options->setPluginStringData("CompressorLevel", value); }
+    while(arguments.read("--block-size", value)) { options->setPluginStringData("CompressorBlockSize", value); }
+
+    unsigned int repeat = 3;
+    while(arguments.read("--repeat", repeat)) {}
+    repeat = std::max(repeat, 1u);
+
+    osg::ref_ptr<osg::Node> scene = osgDB::readRefNodeFiles(arguments);
+    if(!scene) {
+        scene = createScene(numSpheres);
+    }
+
+    osgDB::ReaderWriter* writer = osgDB::Registry::instance()->getReaderWriterForExtension("osgb");
+    std::stringstream serialized;
+    if(!writer || !writer->writeNode(*scene, serialized).success()) {
+        std::cout << "unable to serialize the scene" << std::endl;
+        return 1;
+    }
+    std::string source = serialized.str();
+    std::cout << "source: " << source.size() << " bytes" << std::endl;
+
+    bool succeeded = true;
+    const osgDB::ObjectWrapperManager::CompressorMap& compressors = osgDB::Registry::instance()->getObjectWrapperManager()->getCompressorMap();
+    for(osgDB::ObjectWrapperManager::CompressorMap::const_iterator itr = compressors.begin() ; itr != compressors.end() ; ++ itr) {
+        osgDB::BaseCompressor* compressor = itr->second.get();
+
+        double compressTime = 0., decompressTime = 0.;
+        std::string compressed, decompressed;
+        bool ok = true;
+        for(unsigned int r = 0 ; r < repeat && ok ; ++ r) {
+            std::ostringstream out;
+            osg::Timer_t start = osg::Timer::instance()->tick();
+            ok = compressor->compress(out, source, options.get());
+            compressTime += osg::Timer::instance()->delta_s(start, osg::Timer::instance()->tick());
+            compressed = out.str();
+
+            std::istringstream in(compressed);
+            decompressed.clear();
+            start = osg::Timer::instance()->tick();
+            ok = ok && compressor->decompress(in, decompressed);
+            decompressTime += osg::Timer::instance()->delta_s(start, osg::Timer::instance()->tick());
+        }
+
+        ok = ok && decompressed == source;
+        succeeded = succeeded && ok;
+
+        double megabytes = source.size() / (1024. * 1024.);
+        std::cout << itr->first << ": ratio " << (compressed.empty() ? 0. : static_cast<double>(source.size()) / compressed.size())
+                  << ", compress " << (compressTime > 0. ? megabytes * repeat / compressTime : 0.) << " MB/s"
+                  << ", decompress " << (decompressTime > 0. ? megabytes * repeat / decompressTime : 0.) << " MB/s"
+                  << (ok ? "" : " (FAILED)") << std::endl;
+    }
+
+    return succeeded ? 0 : 1;
+}
@@ -0,0 +1,144 @@
+/* OpenSceneGraph example, osgconcurrentload.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+*  THE SOFTWARE.
+*/
+
+// Measures how the osgDB::Registry lookups (ReaderWriter per extension and serializer
+// wrappers) and the loading of a file scale with the number of loading threads.
+
+#include <osg/ArgumentParser>
+#include <osg/ApplicationUsage>
+#include <osg/Timer>
+
+#include <osgDB/ReadFile>
+#include <osgDB/Registry>
+
+#include <OpenThreads/Barrier>
+#include <OpenThreads/Thread>
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+
+class LoadThread : public OpenThreads::Thread
+{
+public:
+    LoadThread(OpenThreads::Barrier& barrier, const std::string& filename, unsigned int iterations):
+        _barrier(barrier),
+        _filename(filename),
+        _iterations(iterations),
+        _failures(0)
+    {}
+
+    virtual void run()
+    {
+        osgDB::Registry* registry = osgDB::Registry::instance();
+        osg::ref_ptr<osgDB::Options> options = new osgDB::Options;
+        options->setObjectCacheHint(osgDB::Options::CACHE_NONE);
+
+        _barrier.block();
+        for(unsigned int i = 0 ; i < _iterations ; ++ i) {
+            if(_filename.empty()) {
+                // the lookups done for each file and each serialized object
+                if(!registry->getReaderWriterForExtension("osgb")) ++ _failures;
+                if(!registry->getObjectWrapperManager()->findWrapper("osg::Geometry")) ++ _failures;
+                if(!registry->getObjectWrapperManager()->findWrapper("osg::Node")) ++ _failures;
+            }
+            else if(!osgDB::readRefNodeFile(_filename, options.get())) {
+                ++ _failures;
+            }
+        }
+        _barrier.block();
+    }
+
+    unsigned int getFailures() const { return _failures; }
+
+protected:
+    OpenThreads::Barrier& _barrier;
+    std::string _filename;
+    unsigned int _iterations;
+    unsigned int _failures;
+};
+
+
+int main(int argc, char** argv)
+{
+    osg::ArgumentParser arguments(&argc, argv);
+    arguments.getApplicationUsage()->setApplicationName(arguments.getApplicationName());
+    arguments.getApplicationUsage()->setDescription(arguments.getApplicationName() + " measures the scaling of the osgDB lookups and file loading with the number of threads.");
+    arguments.getApplicationUsage()->setCommandLineUsage(arguments.getApplicationName() + " [options] [filename]");
+    arguments.getApplicationUsage()->addCommandLineOption("--threads <n>", "Maximal number of loading threads (default 16).");
+    arguments.getApplicationUsage()->addCommandLineOption("--iterations <n>", "Lookups (or loads when a file is given) per thread (default 200000, or 20 loads).");
+    arguments.getApplicationUsage()->addCommandLineOption("-h or --help", "Display this information.");
+
+    if(arguments.read("-h") || arguments.read("--help")) {
+        arguments.getApplicationUsage()->write(std::cout);
+        return 1;
+    }
+
+    unsigned int maxThreads = 16;
+    while(arguments.read("--threads", maxThreads)) {}
+    maxThreads = std::max(maxThreads, 1u);
+
+    std::string filename = arguments.argc() > 1 ? arguments[1] : std::string();
+
+    unsigned int iterations = filename.empty() ? 200000 : 20;
+    while(arguments.read("--iterations", iterations)) {}
+
+    // load the plugins and serializers before timing
+    if(filename.empty()) {
+        osgDB::Registry::instance()->getReaderWriterForExtension("osgb");
+        osgDB::Registry::instance()->getObjectWrapperManager()->findWrapper("osg::Geometry");
+        osgDB::Registry::instance()->getObjectWrapperManager()->findWrapper("osg::Node");
+    }
+    else if(!osgDB::readRefNodeFile(filename)) {
+        std::cout << "unable to read " << filename << std::endl;
+        return 1;
+    }
+
+    double reference = 0.;
+    unsigned int failures = 0;
+    for(unsigned int numThreads = 1 ; numThreads <= maxThreads ; numThreads *= 2) {
+        OpenThreads::Barrier barrier(numThreads + 1);
+        std::vector<LoadThread*> threads;
+        for(unsigned int i = 0 ; i < numThreads ; ++ i) {
+            threads.push_back(new LoadThread(barrier, filename, iterations));
+            threads.back()->start();
+        }
+
+        barrier.block();
+        osg::Timer_t start = osg::Timer::instance()->tick();
+        barrier.block();
+        double time = osg::Timer::instance()->delta_s(start, osg::Timer::instance()->tick());
+
+        for(unsigned int i = 0 ; i < numThreads ; ++ i) {
+            threads[i]->join();
+            failures += threads[i]->getFailures();
+            delete threads[i];
+        }
+
+        double throughput = time > 0. ? numThreads * iterations / time : 0.;
+        if(numThreads == 1) reference = throughput;
+        std::cout << numThreads << " threads: " << throughput << (filename.empty() ? " lookups/s" : " loads/s")
+                  << ", scaling " << (reference > 0. ? throughput / reference : 0.) << std::endl;
+    }
+
+    if(failures) {
+        std::cout << failures << " failed lookups/loads" << std::endl;
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,341 @@
+/* OpenSceneGraph example, osgcullbenchmark.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+*  THE SOFTWARE.
+*/
+
+// Headless benchmark of the cull traversal: culls a procedural city with osgUtil::SceneView,
+// without any graphics context, serially and then with increasing numbers of parallel cull
+// threads, checking that every parallel cull produces exactly the same sorted render graph.
+// With --static the buildings have no LODs, and the city is also culled with the drawables
+// of each block cached by the CullVisitor, see osg::Group::setCacheRenderLeaves().
+
+#include <osg/ArgumentParser>
+#include <osg/ApplicationUsage>
+#include <osg/Geode>
+#include <osg/Group>
+#include <osg/LOD>
+#include <osg/MatrixTransform>
+#include <osg/ShapeDrawable>
+#include <osg/Material>
+#include <osg/BlendFunc>
+#include <osg/FrameStamp>
+#include <osg/Timer>
+#include <osg/Notify>
+
+#include <osgUtil/SceneView>
+#include <osgUtil/RenderStage>
+
+#include <iostream>
+#include <vector>
+
+typedef std::vector< osg::ref_ptr<osg::Group> > GroupList;
+
+osg::Node* createCity(unsigned int numBlocks, unsigned int numBuildingsPerBlock, float blockSize, bool useLODs, GroupList& blockGroups)
+{
+    // a palette of shared materials, one in eight being transparent and so going to the depth sorted bin.
+    std::vector< osg::ref_ptr<osg::StateSet> > palette;
+    for(unsigned int i=0; i<16; ++i)
+    {
+        osg::StateSet* stateset = new osg::StateSet;
+        osg::Material* material = new osg::Material;
+        material->setDiffuse(osg::Material::FRONT_AND_BACK, osg::Vec4(float(i%4)/4.0f, float(i/4)/4.0f, 0.5f, (i%8==7) ? 0.5f : 1.0f));
+        stateset->setAttributeAndModes(material);
+        if (i%8==7)
+        {
+            stateset->setAttributeAndModes(new osg::BlendFunc);
+            stateset->setRenderingHint(osg::StateSet::TRANSPARENT_BIN);
+        }
+        palette.push_back(stateset);
+    }
+
+    // shared building drawables, a detailed and a coarse one for each LOD.
+    osg::ref_ptr<osg::Geode> detailed = new osg::Geode;
+    detailed->addDrawable(new osg::ShapeDrawable(new osg::Box(osg::Vec3(0.0f,0.0f,0.5f), 1.0f)));
+    detailed->addDrawable(new osg::ShapeDrawable(new osg::Cone(osg::Vec3(0.0f,0.0f,1.0f), 0.5f, 0.5f)));
+
+    osg::ref_ptr<osg::Geode> coarse = new osg::Geode;
+    coarse->addDrawable(new osg::ShapeDrawable(new osg::Box(osg::Vec3(0.0f,0.0f,0.5f), 1.0f)));
+
+    osg::Group* city = new osg::Group;
+    unsigned int side = static_cast<unsigned int>(ceil(sqrt(static_cast<double>(numBuildingsPerBlock))));
+    float spacing = blockSize/static_cast<float>(side+1);
+    for(unsigned int by=0; by<numBlocks; ++by)
+    {
+        for(unsigned int bx=0; bx<numBlocks; ++bx)
+        {
+            osg::MatrixTransform* block = new osg::MatrixTransform(osg::Matrix::translate(float(bx)*blockSize, float(by)*blockSize, 0.0f));
+            osg::Group* buildings = new osg::Group;
+            block->addChild(buildings);
+            blockGroups.push_back(buildings);
+            for(unsigned int i=0; i<numBuildingsPerBlock; ++i)
+            {
+                float height = 1.0f + float((bx*7 + by*13 + i*5)%23);
+                osg::MatrixTransform* building = new osg::MatrixTransform(
+                    osg::Matrix::scale(spacing*0.8f, spacing*0.8f, height) *
+                    osg::Matrix::translate(float(i%side+1)*spacing, float(i/side+1)*spacing, 0.0f));
+                building->setStateSet(palette[(bx + by*3 + i)%palette.size()].get());
+
+                if (useLODs)
+                {
+                    osg::LOD* lod = new osg::LOD;
+                    lod->addChild(detailed.get(), 0.0f, blockSize*4.0f);
+                    lod->addChild(coarse.get(), blockSize*4.0f, 1e7f);
+                    building->addChild(lod);
+                }
+                else
+                {
+                    building->addChild(detailed.get());
+                }
+
+                buildings->addChild(building);
+            }
+            city->addChild(block);
+        }
+    }
+    return city;
+}
+
+/** A RenderLeaf as it will be drawn, used to compare the render graphs of serial and parallel culls.*/
+struct DrawnLeaf
+{
+    const osg::Drawable*    drawable;
+    const osg::StateSet*    stateset;
+    int                     binNum;
+    float                   depth;
+    osg::Matrix             modelview;
+    osg::Matrix             projection;
+
+    bool operator == (const DrawnLeaf& rhs) const
+    {
+        return drawable==rhs.drawable && stateset==rhs.stateset && binNum==rhs.binNum &&
+               depth==rhs.depth && modelview==rhs.modelview && projection==rhs.projection;
+    }
+};
+
+typedef std::vector<DrawnLeaf> DrawnLeaves;
+
+void collectLeaf(const osgUtil::RenderBin* bin, const osgUtil::RenderLeaf* leaf, DrawnLeaves& leaves)
+{
+    DrawnLeaf drawn;
+    drawn.drawable = leaf->getDrawable();
+    drawn.stateset = leaf->_parent ? leaf->_parent->getStateSet() : 0;
+    drawn.binNum = bin->getBinNum();
+    drawn.depth = leaf->_depth;
+    drawn.modelview = leaf->_modelview.valid() ? *leaf->_modelview : osg::Matrix::identity();
+    drawn.projection = leaf->_projection.valid() ? *leaf->_projection : osg::Matrix::identity();
+    leaves.push_back(drawn);
+}
+
+/** Collect the leaves of a sorted RenderBin in the order RenderBin::drawImplementation() draws them.*/
+void collectLeaves(const osgUtil::RenderBin* bin, DrawnLeaves& leaves)
+{
+    const osgUtil::RenderBin::RenderBinList& bins = bin->getRenderBinList();
+    osgUtil::RenderBin::RenderBinList::const_iterator bitr = bins.begin();
+    for(; bitr!=bins.end() && bitr->first<0; ++bitr) collectLeaves(bitr->second.get(), leaves);
+
+    const osgUtil::RenderBin::RenderLeafList& renderLeaves = bin->getRenderLeafList();
+    for(osgUtil::RenderBin::RenderLeafList::const_iterator litr = renderLeaves.begin(); litr!=renderLeaves.end(); ++litr)
+    {
+        collectLeaf(bin, *litr, leaves);
+    }
+
+    const osgUtil::RenderBin::StateGraphList& stateGraphs = bin->getStateGraphList();
+    for(osgUtil::RenderBin::StateGraphList::const_iterator sitr = stateGraphs.begin(); sitr!=stateGraphs.end(); ++sitr)
+    {
+        for(osgUtil::StateGraph::LeafList::const_iterator litr = (*sitr)->_leaves.begin(); litr!=(*sitr)->_leaves.end(); ++litr)
+        {
+            collectLeaf(bin, litr->get(), leaves);
+        }
+    }
+
+    for(; bitr!=bins.end(); ++bitr) collectLeaves(bitr->second.get(), leaves);
+}
+
+/** Return true if the same drawables are drawn with the same StateSets and in the same bins, ignoring round off differences of their matrices.*/
+bool sameDrawables(const DrawnLeaves& lhs, const DrawnLeaves& rhs)
+{
+    if (lhs.size()!=rhs.size()) return false;
+    for(unsigned int i=0; i<lhs.size(); ++i)
+    {
+        if (lhs[i].drawable!=rhs[i].drawable || lhs[i].stateset!=rhs[i].stateset || lhs[i].binNum!=rhs[i].binNum) return false;
+    }
+    return true;
+}
+
+/** Cull numFrames frames orbiting around the city, collecting the leaves drawn each frame, and return the average cull time in ms.*/
+double cullFrames(osgUtil::SceneView* sceneView, osg::FrameStamp* frameStamp, unsigned int& frameNumber,
+                  const osg::Vec3& center, float citySize, unsigned int numFrames, std::vector<DrawnLeaves>& drawnLeaves)
+{
+    // a first frame to set up the threads and warm up the render graph.
+    sceneView->setProjectionMatrixAsPerspective(60.0, 1920.0/1080.0, 1.0, 100000.0);
+    sceneView->setViewMatrixAsLookAt(center+osg::Vec3(0.0f, -citySize*0.5f, citySize*0.25f), center, osg::Vec3(0.0f,0.0f,1.0f));
+    frameStamp->setFrameNumber(frameNumber++);
+    sceneView->cull();
+
+    double cullTime = 0.0;
+    drawnLeaves.resize(numFrames);
+    for(unsigned int frame=0; frame<numFrames; ++frame)
+    {
+        // orbit around the city, looking across it.
+        double angle = osg::PI*2.0*double(frame)/double(numFrames);
+        osg::Vec3 eye = center + osg::Vec3(sin(angle)*citySize*0.5, -cos(angle)*citySize*0.5, citySize*0.05);
+        // SceneView clamps its projection matrix to the computed near/far planes, so start each frame afresh.
+        sceneView->setProjectionMatrixAsPerspective(60.0, 1920.0/1080.0, 1.0, 100000.0);
+        sceneView->setViewMatrixAsLookAt(eye, center, osg::Vec3(0.0f,0.0f,1.0f));
+        frameStamp->setFrameNumber(frameNumber++);
+
+        osg::Timer_t startTick = osg::Timer::instance()->tick();
+        sceneView->cull();
+        cullTime += osg::Timer::instance()->delta_m(startTick, osg::Timer::instance()->tick());
+
+        drawnLeaves[frame].clear();
+        collectLeaves(sceneView->getRenderStage(), drawnLeaves[frame]);
+    }
+
+    return cullTime/double(numFrames);
+}
+
+unsigned int countLeaves(const std::vector<DrawnLeaves>& drawnLeaves)
+{
+    unsigned int numLeaves = 0;
+    for(unsigned int i=0; i<drawnLeaves.size(); ++i) numLeaves += drawnLeaves[i].size();
+    return drawnLeaves.empty() ? 0 : numLeaves/drawnLeaves.size();
+}
+
+int main(int argc, char** argv)
+{
+    osg::ArgumentParser arguments(&argc,argv);
+
+    arguments.getApplicationUsage()->setApplicationName(arguments.getApplicationName());
+    arguments.getApplicationUsage()->setDescription(arguments.getApplicationName()+" benchmarks the serial and parallel cull traversals of a procedural city, without a graphics context.");
+    arguments.getApplicationUsage()->setCommandLineUsage(arguments.getApplicationName()+" [options]");
+    arguments.getApplicationUsage()->addCommandLineOption("--blocks <n>","Number of city blocks along each side, default 100.");
+    arguments.getApplicationUsage()->addCommandLineOption("--buildings <n>","Number of buildings per block, default 10, each building having up to two drawables.");
+    arguments.getApplicationUsage()->addCommandLineOption("--threads <n>","Maximum number of parallel cull threads to benchmark, default 4.");
+    arguments.getApplicationUsage()->addCommandLineOption("--frames <n>","Number of frames culled per run, default 20.");
+    arguments.getApplicationUsage()->addCommandLineOption("--min-children <n>","Minimum number of children of the groups split across the threads, default 64.");
+    arguments.getApplicationUsage()->addCommandLineOption("--primitives","Compute the near and far planes using primitives rather than bounding volumes.");
+    arguments.getApplicationUsage()->addCommandLineOption("--static","Build the buildings without LODs, and also cull the city with the drawables of each block cached.");
+    arguments.getApplicationUsage()->addCommandLineOption("-h or --help","Display this information");
+
+    if (arguments.read("-h") || arguments.read("--help"))
+    {
+        arguments.getApplicationUsage()->write(std::cout);
+        return 1;
+    }
+
+    unsigned int numBlocks = 100;
+    unsigned int numBuildings = 10;
+    unsigned int maxThreads = 4;
+    unsigned int numFrames = 20;
+    unsigned int minChildren = 64;
+    while(arguments.read("--blocks", numBlocks)) {}
+    while(arguments.read("--buildings", numBuildings)) {}
+    while(arguments.read("--threads", maxThreads)) {}
+    while(arguments.read("--frames", numFrames)) {}
+    while(arguments.read("--min-children", minChildren)) {}
+    bool usePrimitives = arguments.read("--primitives");
+    bool staticCity = arguments.read("--static");
+
+    const float blockSize = 100.0f;
+    GroupList blockGroups;
+    osg::ref_ptr<osg::Node> city = createCity(numBlocks, numBuildings, blockSize, !staticCity, blockGroups);
+
+    osg::ref_ptr<osgUtil::SceneView> sceneView = new osgUtil::SceneView;
+    sceneView->setDefaults();
+    sceneView->setSceneData(city.get());
+    sceneView->setViewport(0, 0, 1920, 1080);
+    sceneView->setParallelCullMinimumNumChildren(minChildren);
+    if (usePrimitives) sceneView->setComputeNearFarMode(osg::CullSettings::COMPUTE_NEAR_FAR_USING_PRIMITIVES);
+
+    osg::ref_ptr<osg::FrameStamp> frameStamp = new osg::FrameStamp;
+    sceneView->setFrameStamp(frameStamp.get());
+
+    float citySize = float(numBlocks)*blockSize;
+    osg::Vec3 center(citySize*0.5f, citySize*0.5f, 0.0f);
+
+    std::cout<<"Culling "<<numBlocks*numBlocks<<" blocks of "<<numBuildings<<" buildings over "<<numFrames<<" frames"<<std::endl;
+
+    std::vector<DrawnLeaves> reference;
+    std::vector<DrawnLeaves> drawnLeaves;
+    double serialTime = 0.0;
+    unsigned int frameNumber = 0;
+    for(unsigned int numThreads=0; numThreads<=maxThreads; ++numThreads)
+    {
+        sceneView->setNumParallelCullThreads(numThreads);
+
+        double cullTime = cullFrames(sceneView.get(), frameStamp.get(), frameNumber, center, citySize, numFrames, numThreads==0 ? reference : drawnLeaves);
+        if (numThreads==0) serialTime = cullTime;
+
+        std::cout<<"  threads "<<numThreads<<" : "<<cullTime<<"ms per frame, "<<countLeaves(numThreads==0 ? reference : drawnLeaves)<<" drawables per frame";
+        if (numThreads>0)
+        {
+            std::cout<<", speed up "<<serialTime/cullTime<<", render graph "<<(drawnLeaves==reference ? "identical" : "DIFFERENT")<<" to the serial cull";
+        }
+        std::cout<<std::endl;
+    }
+
+    if (staticCity)
+    {
+        sceneView->setNumParallelCullThreads(0);
+        for(GroupList::iterator itr = blockGroups.begin(); itr != blockGroups.end(); ++itr)
+        {
+            (*itr)->setCacheRenderLeaves(true);
+        }
+
+        double cullTime = cullFrames(sceneView.get(), frameStamp.get(), frameNumber, center, citySize, numFrames, drawnLeaves);
+
+        // the cached drawables are culled against their bounding boxes in the coordinate frame of their block, which may let
+        // through a few drawables the traversal would have culled.
+        unsigned int numIdentical = 0;
+        for(unsigned int i=0; i<numFrames; ++i)
+        {
+            if (sameDrawables(drawnLeaves[i], reference[i])) ++numIdentical;
+        }
+
+        std::cout<<"  cached    : "<<cullTime<<"ms per frame, "<<countLeaves(drawnLeaves)<<" drawables per frame, speed up "<<serialTime/cullTime
+                 <<", same drawables as the serial cull in "<<numIdentical<<" of "<<numFrames<<" frames"<<std::endl;
+
+        // hide one building in three and remove the StateSet of another, the caches of the blocks having to follow these changes.
+        for(GroupList::iterator itr = blockGroups.begin(); itr != blockGroups.end(); ++itr)
+        {
+            for(unsigned int i=0; i<(*itr)->getNumChildren(); ++i)
+            {
+                if (i%3==0) (*itr)->getChild(i)->setNodeMask(0x0);
+                else if (i%3==1) (*itr)->getChild(i)->setStateSet(0);
+            }
+        }
+
+        cullFrames(sceneView.get(), frameStamp.get(), frameNumber, center, citySize, numFrames, drawnLeaves);
+
+        for(GroupList::iterator itr = blockGroups.begin(); itr != blockGroups.end(); ++itr)
+        {
+            (*itr)->setCacheRenderLeaves(false);
+        }
+
+        cullFrames(sceneView.get(), frameStamp.get(), frameNumber, center, citySize, numFrames, reference);
+
+        numIdentical = 0;
+        for(unsigned int i=0; i<numFrames; ++i)
+        {
+            if (sameDrawables(drawnLeaves[i], reference[i])) ++numIdentical;
+        }
+
+        std::cout<<"  modified  : "<<countLeaves(drawnLeaves)<<" drawables per frame, same drawables as the serial cull in "<<numIdentical<<" of "<<numFrames<<" frames"<<std::endl;
+    }
+
+    return 0;
+}
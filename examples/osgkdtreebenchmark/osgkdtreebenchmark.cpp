@@ -0,0 +1,263 @@
+/* OpenSceneGraph example, osgkdtreebenchmark.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+*  THE SOFTWARE.
+*/
+
+// Headless benchmark of osg::KdTree: builds the kdtree of a procedural terrain with each split
+// method, number of build threads and node layout, then intersects it with random line segments
+// through osgUtil::LineSegmentIntersector. The build time, the size of the nodes and the number
+// of intersections per second are reported, and the nearest intersections found with each kdtree
+// are checked against those found with the kdtree split at the middle of the longest axis, and the
+// boxes of the compact nodes checked to enclose those of the nodes they replace.
+
+#include <osg/ArgumentParser>
+#include <osg/ApplicationUsage>
+#include <osg/Geode>
+#include <osg/Geometry>
+#include <osg/KdTree>
+#include <osg/Timer>
+
+#include <osgUtil/IntersectionVisitor>
+#include <osgUtil/LineSegmentIntersector>
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <stdlib.h>
+
+/** Create a terrain of about numTriangles triangles, rolling hills with some roughness on top.*/
+osg::Geometry* createTerrain(unsigned int numTriangles, float size)
+{
+    unsigned int numColumns = static_cast<unsigned int>(sqrt(double(numTriangles)*0.5))+1;
+    float spacing = size/float(numColumns-1);
+
+    osg::Vec3Array* vertices = new osg::Vec3Array;
+    vertices->reserve(numColumns*numColumns);
+    for(unsigned int r=0; r<numColumns; ++r)
+    {
+        for(unsigned int c=0; c<numColumns; ++c)
+        {
+            float x = float(c)*spacing;
+            float y = float(r)*spacing;
+            float height = size*0.05f*(sinf(x*8.0f/size)*cosf(y*5.0f/size) + 0.5f*sinf((x+y)*23.0f/size)) +
+                           spacing*0.5f*float(rand())/float(RAND_MAX);
+            vertices->push_back(osg::Vec3(x, y, height));
+        }
+    }
+
+    osg::DrawElementsUInt* triangles = new osg::DrawElementsUInt(GL_TRIANGLES);
+    triangles->reserve((numColumns-1)*(numColumns-1)*6);
+    for(unsigned int r=0; r<numColumns-1; ++r)
+    {
+        for(unsigned int c=0; c<numColumns-1; ++c)
+        {
+            unsigned int i = r*numColumns+c;
+            triangles->push_back(i);
+            triangles->push_back(i+1);
+            triangles->push_back(i+numColumns);
+
+            triangles->push_back(i+1);
+            triangles->push_back(i+numColumns+1);
+            triangles->push_back(i+numColumns);
+        }
+    }
+
+    osg::Geometry* geometry = new osg::Geometry;
+    geometry->setVertexArray(vertices);
+    geometry->addPrimitiveSet(triangles);
+    return geometry;
+}
+
+struct Segment
+{
+    osg::Vec3d start;
+    osg::Vec3d end;
+};
+
+typedef std::vector<Segment> Segments;
+
+/** Create segments from above the terrain to below it, at random angles as picking from a variety of view points would.*/
+void createSegments(const osg::BoundingBox& bb, unsigned int numSegments, Segments& segments)
+{
+    osg::Vec3 dimensions = bb._max-bb._min;
+    segments.resize(numSegments);
+    for(unsigned int i=0; i<numSegments; ++i)
+    {
+        float x0 = float(rand())/float(RAND_MAX), y0 = float(rand())/float(RAND_MAX);
+        float x1 = float(rand())/float(RAND_MAX), y1 = float(rand())/float(RAND_MAX);
+        segments[i].start = bb._min + osg::Vec3(x0*dimensions.x(), y0*dimensions.y(), dimensions.z()*2.0f);
+        segments[i].end = bb._min + osg::Vec3(x1*dimensions.x(), y1*dimensions.y(), -dimensions.z());
+    }
+}
+
+/** Intersect the segments with the geode, storing the ratio of the nearest intersection of each, or -1 if there is none.
+  * Return the time taken in ms.*/
+double intersectSegments(osg::Geode* geode, const Segments& segments, std::vector<double>& ratios)
+{
+    ratios.resize(segments.size());
+
+    osg::Timer_t startTick = osg::Timer::instance()->tick();
+    for(unsigned int i=0; i<segments.size(); ++i)
+    {
+        osg::ref_ptr<osgUtil::LineSegmentIntersector> intersector = new osgUtil::LineSegmentIntersector(segments[i].start, segments[i].end);
+        osgUtil::IntersectionVisitor iv(intersector.get());
+        geode->accept(iv);
+
+        ratios[i] = intersector->containsIntersections() ? intersector->getFirstIntersection().ratio : -1.0;
+    }
+    return osg::Timer::instance()->delta_m(startTick, osg::Timer::instance()->tick());
+}
+
+struct Variant
+{
+    std::string             name;
+    osg::KdTree::BuildOptions options;
+};
+
+int main(int argc, char** argv)
+{
+    osg::ArgumentParser arguments(&argc,argv);
+
+    arguments.getApplicationUsage()->setApplicationName(arguments.getApplicationName());
+    arguments.getApplicationUsage()->setDescription(arguments.getApplicationName()+" benchmarks building and intersecting osg::KdTree's with each split method and node layout, without a graphics context.");
+    arguments.getApplicationUsage()->setCommandLineUsage(arguments.getApplicationName()+" [options]");
+    arguments.getApplicationUsage()->addCommandLineOption("--triangles <n>","Number of triangles of the terrain, default 2000000.");
+    arguments.getApplicationUsage()->addCommandLineOption("--segments <n>","Number of line segments intersected with each kdtree, default 100000.");
+    arguments.getApplicationUsage()->addCommandLineOption("--threads <n>","Maximum number of threads building the surface area heuristic kdtrees, default 4.");
+    arguments.getApplicationUsage()->addCommandLineOption("--bins <n>","Number of surface area heuristic bins, default 16.");
+    arguments.getApplicationUsage()->addCommandLineOption("--triangles-per-leaf <n>","Target number of triangles per leaf, default 4.");
+    arguments.getApplicationUsage()->addCommandLineOption("-h or --help","Display this information");
+
+    if (arguments.read("-h") || arguments.read("--help"))
+    {
+        arguments.getApplicationUsage()->write(std::cout);
+        return 1;
+    }
+
+    unsigned int numTriangles = 2000000;
+    unsigned int numSegments = 100000;
+    unsigned int maxThreads = 4;
+    unsigned int numBins = 16;
+    unsigned int trianglesPerLeaf = 4;
+    while(arguments.read("--triangles", numTriangles)) {}
+    while(arguments.read("--segments", numSegments)) {}
+    while(arguments.read("--threads", maxThreads)) {}
+    while(arguments.read("--bins", numBins)) {}
+    while(arguments.read("--triangles-per-leaf", trianglesPerLeaf)) {}
+
+    if (numTriangles<2 || numSegments==0)
+    {
+        std::cout<<"The number of triangles and segments must be positive."<<std::endl;
+        return 1;
+    }
+
+    std::vector<Variant> variants;
+    {
+        Variant variant;
+        variant.options._targetNumTrianglesPerLeaf = trianglesPerLeaf;
+        variant.options._numSurfaceAreaHeuristicBins = numBins;
+
+        variant.name = "middle of longest axis";
+        variants.push_back(variant);
+
+        variant.options._splitMethod = osg::KdTree::BuildOptions::SURFACE_AREA_HEURISTIC;
+        for(unsigned int numThreads=0; numThreads<=maxThreads; numThreads = (numThreads==0) ? 1 : numThreads*2)
+        {
+            std::ostringstream name;
+            name<<"surface area heuristic, "<<numThreads<<" threads";
+            variant.name = name.str();
+            variant.options._numThreads = numThreads;
+            variants.push_back(variant);
+        }
+
+        variant.name = "surface area heuristic, compact";
+        variant.options._compactNodes = true;
+        variants.push_back(variant);
+    }
+
+    srand(1);
+    osg::ref_ptr<osg::Geometry> geometry = createTerrain(numTriangles, 1000.0f);
+    osg::ref_ptr<osg::Geode> geode = new osg::Geode;
+    geode->addDrawable(geometry.get());
+
+    Segments segments;
+    createSegments(geometry->getBoundingBox(), numSegments, segments);
+
+    std::cout<<geometry->getPrimitiveSet(0)->getNumIndices()/3<<" triangles, "<<numSegments<<" line segments"<<std::endl;
+    std::cout<<"  "<<std::left<<std::setw(34)<<"kdtree"<<std::right<<std::setw(10)<<"build ms"<<std::setw(10)<<"nodes"
+             <<std::setw(12)<<"node MB"<<std::setw(14)<<"segments/s"<<std::setw(10)<<"hits"<<std::endl;
+
+    std::vector<double> referenceRatios;
+    for(unsigned int v=0; v<variants.size(); ++v)
+    {
+        osg::KdTree::BuildOptions options = variants[v].options;
+
+        osg::ref_ptr<osg::KdTree> kdTree = new osg::KdTree;
+        osg::Timer_t startTick = osg::Timer::instance()->tick();
+        bool built = kdTree->build(options, geometry.get());
+        double buildTime = osg::Timer::instance()->delta_m(startTick, osg::Timer::instance()->tick());
+
+        if (!built)
+        {
+            std::cout<<"  "<<variants[v].name<<" failed to build"<<std::endl;
+            continue;
+        }
+
+        geometry->setShape(kdTree.get());
+
+        std::vector<double> ratios;
+        double intersectTime = intersectSegments(geode.get(), segments, ratios);
+
+        unsigned int numHits = 0;
+        for(unsigned int i=0; i<ratios.size(); ++i)
+        {
+            if (ratios[i]>=0.0) ++numHits;
+        }
+
+        unsigned int numNodes = options._compactNodes ? kdTree->getCompactNodes().size() : kdTree->getNodes().size();
+        double nodeSize = options._compactNodes ? double(numNodes*sizeof(osg::KdTree::CompactKdNode)) : double(numNodes*sizeof(osg::KdTree::KdNode));
+
+        std::cout<<"  "<<std::left<<std::setw(34)<<variants[v].name<<std::right<<std::fixed<<std::setprecision(1)
+                 <<std::setw(10)<<buildTime<<std::setw(10)<<numNodes<<std::setw(12)<<nodeSize/(1024.0*1024.0)
+                 <<std::setw(14)<<std::setprecision(0)<<double(numSegments)*1000.0/intersectTime<<std::setw(10)<<numHits;
+
+        if (v==0) referenceRatios.swap(ratios);
+        else if (ratios!=referenceRatios) std::cout<<"  DIFFERENT nearest intersections";
+
+        if (options._compactNodes)
+        {
+            // check that the decoded boxes of the compact nodes enclose the boxes of the nodes they replace.
+            osg::KdTree::BuildOptions uncompactedOptions = variants[v].options;
+            uncompactedOptions._compactNodes = false;
+            osg::ref_ptr<osg::KdTree> uncompacted = new osg::KdTree;
+            uncompacted->build(uncompactedOptions, geometry.get());
+            osg::KdTree::KdNodeList nodes = uncompacted->getNodes();
+            uncompacted->compactNodes();
+
+            unsigned int numNotEnclosing = 0;
+            for(unsigned int i=0; i<nodes.size(); ++i)
+            {
+                if (!nodes[i].bb.valid()) continue;
+                osg::BoundingBox decoded = uncompacted->getBoundingBox(uncompacted->getCompactNodes()[i]);
+                if (!decoded.contains(nodes[i].bb._min) || !decoded.contains(nodes[i].bb._max)) ++numNotEnclosing;
+            }
+            if (numNotEnclosing>0) std::cout<<"  "<<numNotEnclosing<<" compact nodes NOT ENCLOSING their nodes";
+        }
+        std::cout<<std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,213 @@
+/* OpenSceneGraph example, osgmeshwelding.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+*  THE SOFTWARE.
+*/
+
+// Compares the sort based and hash based vertex welding of the gles plugin on a large
+// triangle soup (or on the geometries of a model). The plugin is driven through osgDB as
+// its ".gles" pseudo loader with the optional passes disabled, and the time taken to read the
+// scene without the plugin is subtracted.
+
+#include <osg/ArgumentParser>
+#include <osg/ApplicationUsage>
+#include <osg/Geode>
+#include <osg/Geometry>
+#include <osg/NodeVisitor>
+#include <osg/Timer>
+#include <osg/Notify>
+
+#include <osgDB/ReadFile>
+#include <osgDB/WriteFile>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <sstream>
+#include <stdio.h>
+#include <vector>
+
+
+// a grid of size x size quads where each triangle owns its three vertices
+osg::Geometry* createTriangleSoup(unsigned int size)
+{
+    osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array;
+    osg::ref_ptr<osg::Vec3Array> normals = new osg::Vec3Array;
+    osg::ref_ptr<osg::Vec2Array> texCoords = new osg::Vec2Array;
+
+    unsigned int numVertices = size * size * 6;
+    vertices->reserve(numVertices);
+    normals->reserve(numVertices);
+    texCoords->reserve(numVertices);
+
+    const unsigned int corners[6][2] = { {0, 0}, {1, 0}, {1, 1}, {0, 0}, {1, 1}, {0, 1} };
+    for(unsigned int y = 0 ; y < size ; ++ y) {
+        for(unsigned int x = 0 ; x < size ; ++ x) {
+            for(unsigned int c = 0 ; c < 6 ; ++ c) {
+                float u = static_cast<float>(x + corners[c][0]) / size;
+                float v = static_cast<float>(y + corners[c][1]) / size;
+                vertices->push_back(osg::Vec3(u, v, 0.1f * sinf(10.f * u) * cosf(10.f * v)));
+                normals->push_back(osg::Vec3(0.f, 0.f, 1.f));
+                texCoords->push_back(osg::Vec2(u, v));
+            }
+        }
+    }
+
+    osg::Geometry* geometry = new osg::Geometry;
+    geometry->setVertexArray(vertices.get());
+    geometry->setNormalArray(normals.get(), osg::Array::BIND_PER_VERTEX);
+    geometry->setTexCoordArray(0, texCoords.get(), osg::Array::BIND_PER_VERTEX);
+    geometry->addPrimitiveSet(new osg::DrawArrays(GL_TRIANGLES, 0, numVertices));
+    return geometry;
+}
+
+
+struct CollectGeometries : public osg::NodeVisitor
+{
+    CollectGeometries() : osg::NodeVisitor(osg::NodeVisitor::TRAVERSE_ALL_CHILDREN) {}
+
+    void apply(osg::Geometry& geometry) { _geometries.push_back(&geometry); }
+
+    std::vector< osg::ref_ptr<osg::Geometry> > _geometries;
+};
+
+
+struct Result
+{
+    Result() : _time(0.), _numVertices(0) {}
+
+    double _time;
+    unsigned int _numVertices;
+    std::vector<unsigned int> _indices;
+};
+
+
+// read the scene file through the gles plugin with the given options, or directly if options is empty
+Result weld(const std::string& fileName, const std::string& options, unsigned int repeat)
+{
+    Result result;
+    for(unsigned int r = 0 ; r < repeat ; ++ r) {
+        osg::Timer_t start = osg::Timer::instance()->tick();
+        osg::ref_ptr<osg::Node> model;
+        if(options.empty()) {
+            model = osgDB::readRefNodeFile(fileName);
+        }
+        else {
+            model = osgDB::readRefNodeFile(fileName + ".gles", new osgDB::Options(options));
+        }
+        result._time += osg::Timer::instance()->delta_s(start, osg::Timer::instance()->tick());
+
+        if(r == 0 && model.valid()) {
+            CollectGeometries collector;
+            model->accept(collector);
+            for(unsigned int i = 0 ; i < collector._geometries.size() ; ++ i) {
+                osg::Geometry& geometry = *collector._geometries[i];
+                result._numVertices += geometry.getVertexArray() ? geometry.getVertexArray()->getNumElements() : 0;
+                for(unsigned int p = 0 ; p < geometry.getNumPrimitiveSets() ; ++ p) {
+                    const osg::PrimitiveSet* primitive = geometry.getPrimitiveSet(p);
+                    for(unsigned int k = 0 ; k < primitive->getNumIndices() ; ++ k) {
+                        result._indices.push_back(primitive->index(k));
+                    }
+                }
+            }
+        }
+    }
+    result._time /= repeat;
+    return result;
+}
+
+
+int main(int argc, char** argv)
+{
+    osg::ArgumentParser arguments(&argc, argv);
+    arguments.getApplicationUsage()->setApplicationName(arguments.getApplicationName());
+    arguments.getApplicationUsage()->setDescription(arguments.getApplicationName() + " compares the sort and hash based vertex welding of the gles plugin.");
+    arguments.getApplicationUsage()->setCommandLineUsage(arguments.getApplicationName() + " [options] [filename]");
+    arguments.getApplicationUsage()->addCommandLineOption("--size <n>", "Weld a generated triangle soup of 2*n*n triangles (default 1000).");
+    arguments.getApplicationUsage()->addCommandLineOption("--epsilon <value>", "Also run the hash welding with the given near duplicates epsilon.");
+    arguments.getApplicationUsage()->addCommandLineOption("--repeat <n>", "Number of runs averaged for each path (default 1).");
+    arguments.getApplicationUsage()->addCommandLineOption("-h or --help", "Display this information.");
+
+    if(arguments.read("-h") || arguments.read("--help")) {
+        arguments.getApplicationUsage()->write(std::cout);
+        return 1;
+    }
+
+    unsigned int size = 1000;
+    while(arguments.read("--size", size)) {}
+
+    double epsilon = 0.;
+    while(arguments.read("--epsilon", epsilon)) {}
+
+    unsigned int repeat = 1;
+    while(arguments.read("--repeat", repeat)) {}
+    repeat = std::max(repeat, 1u);
+
+    CollectGeometries collector;
+    osg::ref_ptr<osg::Node> model = osgDB::readRefNodeFiles(arguments);
+    if(model.valid()) {
+        model->accept(collector);
+    }
+    else {
+        collector._geometries.push_back(createTriangleSoup(size));
+    }
+
+    unsigned int numVertices = 0;
+    osg::ref_ptr<osg::Geode> geode = new osg::Geode;
+    for(unsigned int i = 0 ; i < collector._geometries.size() ; ++ i) {
+        const osg::Array* vertices = collector._geometries[i]->getVertexArray();
+        numVertices += vertices ? vertices->getNumElements() : 0;
+        geode->addDrawable(collector._geometries[i].get());
+    }
+    std::cout << collector._geometries.size() << " geometries, " << numVertices << " input vertices" << std::endl;
+
+    // the plugin is a pseudo loader, the geometries are written to a file it reads back
+    const std::string fileName = "osgmeshwelding_input.osgb";
+    if(!osgDB::writeNodeFile(*geode, fileName)) {
+        std::cout << "could not write " << fileName << std::endl;
+        return 1;
+    }
+
+    // skip the animation, strip and pre-transform passes, the remaining passes cost the same with either welding
+    const std::string glesOptions = "glesMode=geometry disableTriStrip disablePreTransform";
+
+    Result read = weld(fileName, std::string(), repeat);
+    std::cout << "read without the gles plugin: " << read._time << "s" << std::endl;
+
+    Result sorted = weld(fileName, glesOptions + " sortWelding", repeat);
+    sorted._time -= read._time;
+    std::cout << "sort welding: " << sorted._time << "s, " << sorted._numVertices << " vertices" << std::endl;
+
+    Result hashed = weld(fileName, glesOptions, repeat);
+    hashed._time -= read._time;
+    std::cout << "hash welding: " << hashed._time << "s, " << hashed._numVertices << " vertices" << std::endl;
+
+    bool identical = (sorted._numVertices == hashed._numVertices && sorted._indices == hashed._indices);
+    std::cout << "speedup: " << (hashed._time > 0. ? sorted._time / hashed._time : 0.)
+              << ", outputs " << (identical ? "identical" : "DIFFER") << std::endl;
+
+    if(epsilon > 0.) {
+        std::ostringstream epsilonOption;
+        epsilonOption << " weldingEpsilon=" << epsilon;
+        Result welded = weld(fileName, glesOptions + epsilonOption.str(), repeat);
+        welded._time -= read._time;
+        std::cout << "hash welding (epsilon " << epsilon << "): " << welded._time << "s, "
+                  << welded._numVertices << " vertices" << std::endl;
+    }
+
+    remove(fileName.c_str());
+
+    return identical ? 0 : 1;
+}
@@ -0,0 +1,232 @@
+/* OpenSceneGraph example, osgrenderbinbenchmark.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+*  THE SOFTWARE.
+*/
+
+// Headless benchmark of the RenderBin sort modes: synthetic sets of render leaves, spread over
+// StateSets sharing a limited number of programs and textures, are added to a RenderBin the way
+// the cull traversal does it, then sorted with each sort mode. The time taken to fill and to sort
+// the bin is reported along with the number of program, texture and StateSet changes the sorted
+// draw order would make.
+
+#include <osg/ArgumentParser>
+#include <osg/ApplicationUsage>
+#include <osg/Geometry>
+#include <osg/Program>
+#include <osg/Texture2D>
+#include <osg/Timer>
+
+#include <osgUtil/RenderBin>
+#include <osgUtil/StateGraph>
+#include <osgUtil/RenderLeaf>
+
+#include <iostream>
+#include <iomanip>
+#include <stdlib.h>
+
+struct DrawOrderChanges
+{
+    DrawOrderChanges(): programs(0), textures(0), stateGraphs(0), numLeaves(0) {}
+
+    unsigned int programs;
+    unsigned int textures;
+    unsigned int stateGraphs;
+    unsigned int numLeaves;
+};
+
+// count the state changes drawing the leaves of a sorted bin would make, in the order RenderBin::drawImplementation() draws them.
+DrawOrderChanges countChanges(osgUtil::RenderBin* bin)
+{
+    std::vector<osgUtil::RenderLeaf*> leaves(bin->getRenderLeafList());
+    for(osgUtil::RenderBin::StateGraphList::iterator itr = bin->getStateGraphList().begin(); itr != bin->getStateGraphList().end(); ++itr)
+    {
+        for(osgUtil::StateGraph::LeafList::iterator litr = (*itr)->_leaves.begin(); litr != (*itr)->_leaves.end(); ++litr)
+        {
+            leaves.push_back(litr->get());
+        }
+    }
+
+    DrawOrderChanges changes;
+    const osg::StateAttribute* program = 0;
+    const osg::StateAttribute* texture = 0;
+    const osgUtil::StateGraph* stateGraph = 0;
+    for(std::vector<osgUtil::RenderLeaf*>::iterator itr = leaves.begin(); itr != leaves.end(); ++itr)
+    {
+        const osgUtil::StateGraph* sg = (*itr)->_parent;
+        const osg::StateSet* stateset = sg->getStateSet();
+        const osg::StateAttribute* leafProgram = stateset->getAttribute(osg::StateAttribute::PROGRAM);
+        const osg::StateAttribute* leafTexture = stateset->getTextureAttribute(0, osg::StateAttribute::TEXTURE);
+
+        if (leafProgram!=program || changes.numLeaves==0) ++changes.programs;
+        if (leafTexture!=texture || changes.numLeaves==0) ++changes.textures;
+        if (sg!=stateGraph) ++changes.stateGraphs;
+
+        program = leafProgram;
+        texture = leafTexture;
+        stateGraph = sg;
+        ++changes.numLeaves;
+    }
+    return changes;
+}
+
+int main(int argc, char** argv)
+{
+    osg::ArgumentParser arguments(&argc,argv);
+
+    arguments.getApplicationUsage()->setApplicationName(arguments.getApplicationName());
+    arguments.getApplicationUsage()->setDescription(arguments.getApplicationName()+" benchmarks the filling and sorting of RenderBins with synthetic render leaves, without a graphics context.");
+    arguments.getApplicationUsage()->setCommandLineUsage(arguments.getApplicationName()+" [options]");
+    arguments.getApplicationUsage()->addCommandLineOption("--leaves <n>","Benchmark only <n> render leaves, rather than 10k, 100k and 1M.");
+    arguments.getApplicationUsage()->addCommandLineOption("--statesets <n>","Number of StateSets the leaves are spread over, default 4096.");
+    arguments.getApplicationUsage()->addCommandLineOption("--programs <n>","Number of programs shared by the StateSets, default 16.");
+    arguments.getApplicationUsage()->addCommandLineOption("--textures <n>","Number of textures shared by the StateSets, default 256.");
+    arguments.getApplicationUsage()->addCommandLineOption("--runs <n>","Number of times each bin is filled and sorted, default 5.");
+    arguments.getApplicationUsage()->addCommandLineOption("-h or --help","Display this information");
+
+    if (arguments.read("-h") || arguments.read("--help"))
+    {
+        arguments.getApplicationUsage()->write(std::cout);
+        return 1;
+    }
+
+    std::vector<unsigned int> sizes;
+    unsigned int size = 0;
+    while(arguments.read("--leaves", size)) { sizes.push_back(size); }
+    if (sizes.empty())
+    {
+        sizes.push_back(10000);
+        sizes.push_back(100000);
+        sizes.push_back(1000000);
+    }
+
+    unsigned int numStateSets = 4096;
+    unsigned int numPrograms = 16;
+    unsigned int numTextures = 256;
+    unsigned int numRuns = 5;
+    while(arguments.read("--statesets", numStateSets)) {}
+    while(arguments.read("--programs", numPrograms)) {}
+    while(arguments.read("--textures", numTextures)) {}
+    while(arguments.read("--runs", numRuns)) {}
+    if (numStateSets==0 || numPrograms==0 || numTextures==0 || numRuns==0)
+    {
+        std::cout<<"The number of StateSets, programs, textures and runs must be positive."<<std::endl;
+        return 1;
+    }
+
+    srand(1);
+
+    std::vector< osg::ref_ptr<osg::Program> > programs;
+    for(unsigned int i=0; i<numPrograms; ++i) programs.push_back(new osg::Program);
+
+    std::vector< osg::ref_ptr<osg::Texture2D> > textures;
+    for(unsigned int i=0; i<numTextures; ++i) textures.push_back(new osg::Texture2D);
+
+    std::vector< osg::ref_ptr<osg::StateSet> > statesets;
+    for(unsigned int i=0; i<numStateSets; ++i)
+    {
+        osg::StateSet* stateset = new osg::StateSet;
+        stateset->setAttribute(programs[rand()%numPrograms].get());
+        stateset->setTextureAttribute(0, textures[rand()%numTextures].get());
+        statesets.push_back(stateset);
+    }
+
+    osg::ref_ptr<osg::Geometry> drawable = new osg::Geometry;
+    osg::ref_ptr<osg::RefMatrix> projection = new osg::RefMatrix;
+    osg::ref_ptr<osg::RefMatrix> modelview = new osg::RefMatrix;
+
+    struct Mode
+    {
+        osgUtil::RenderBin::SortMode mode;
+        const char* name;
+    };
+    const Mode modes[] =
+    {
+        { osgUtil::RenderBin::SORT_BY_STATE, "SORT_BY_STATE" },
+        { osgUtil::RenderBin::SORT_BY_STATE_THEN_FRONT_TO_BACK, "SORT_BY_STATE_THEN_FRONT_TO_BACK" },
+        { osgUtil::RenderBin::SORT_FRONT_TO_BACK, "SORT_FRONT_TO_BACK" },
+        { osgUtil::RenderBin::SORT_BACK_TO_FRONT, "SORT_BACK_TO_FRONT" },
+        { osgUtil::RenderBin::TRAVERSAL_ORDER, "TRAVERSAL_ORDER" },
+        { osgUtil::RenderBin::SORT_BY_STATE_KEY, "SORT_BY_STATE_KEY" }
+    };
+    const unsigned int numModes = sizeof(modes)/sizeof(Mode);
+
+    for(std::vector<unsigned int>::iterator sitr = sizes.begin(); sitr != sizes.end(); ++sitr)
+    {
+        unsigned int numLeaves = *sitr;
+
+        // the leaves in cull order, each with the StateSet it is drawn with and a random depth.
+        std::vector< osg::ref_ptr<osgUtil::RenderLeaf> > leaves;
+        std::vector<const osg::StateSet*> leafStateSets;
+        leaves.reserve(numLeaves);
+        leafStateSets.reserve(numLeaves);
+        for(unsigned int i=0; i<numLeaves; ++i)
+        {
+            float depth = 1.0f + 1000.0f*float(rand())/float(RAND_MAX);
+            leaves.push_back(new osgUtil::RenderLeaf(drawable.get(), projection.get(), modelview.get(), depth, i));
+            leafStateSets.push_back(statesets[rand()%numStateSets].get());
+        }
+
+        std::cout<<numLeaves<<" leaves over "<<numStateSets<<" StateSets, "<<numPrograms<<" programs and "<<numTextures<<" textures"<<std::endl;
+        std::cout<<"  "<<std::left<<std::setw(34)<<"sort mode"<<std::right<<std::setw(10)<<"fill ms"<<std::setw(10)<<"sort ms"
+                 <<std::setw(10)<<"programs"<<std::setw(10)<<"textures"<<std::setw(11)<<"StateSets"<<std::endl;
+
+        for(unsigned int m=0; m<numModes; ++m)
+        {
+            osg::ref_ptr<osgUtil::StateGraph> root = new osgUtil::StateGraph;
+            osg::ref_ptr<osgUtil::RenderBin> bin = new osgUtil::RenderBin(modes[m].mode);
+
+            double fillTime = 0.0;
+            double sortTime = 0.0;
+            for(unsigned int run=0; run<numRuns; ++run)
+            {
+                bin->reset();
+                root->clean();
+
+                // add the leaves as CullVisitor::addDrawableAndDepth() and CullVisitor::addStateGraph() do.
+                osg::Timer_t startTick = osg::Timer::instance()->tick();
+                for(unsigned int i=0; i<numLeaves; ++i)
+                {
+                    osgUtil::StateGraph* sg = root->find_or_insert(leafStateSets[i]);
+                    if (sg->leaves_empty()) bin->addStateGraph(sg);
+                    sg->addLeaf(leaves[i].get());
+                }
+                osg::Timer_t sortTick = osg::Timer::instance()->tick();
+                bin->sort();
+                osg::Timer_t endTick = osg::Timer::instance()->tick();
+
+                fillTime += osg::Timer::instance()->delta_m(startTick, sortTick);
+                sortTime += osg::Timer::instance()->delta_m(sortTick, endTick);
+            }
+
+            DrawOrderChanges changes = countChanges(bin.get());
+            if (changes.numLeaves!=numLeaves)
+            {
+                std::cout<<"  "<<modes[m].name<<" lost leaves, "<<changes.numLeaves<<" sorted out of "<<numLeaves<<std::endl;
+                return 1;
+            }
+
+            std::cout<<"  "<<std::left<<std::setw(34)<<modes[m].name<<std::right<<std::fixed<<std::setprecision(3)
+                     <<std::setw(10)<<fillTime/double(numRuns)<<std::setw(10)<<sortTime/double(numRuns)
+                     <<std::setw(10)<<changes.programs<<std::setw(10)<<changes.textures<<std::setw(11)<<changes.stateGraphs<<std::endl;
+
+            bin->reset();
+            root->clean();
+        }
+        std::cout<<std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,661 @@
+/* OpenSceneGraph example, osgstatebenchmark.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+*  THE SOFTWARE.
+*/
+
+// Headless benchmark of the state tracking of osg::State: a synthetic render graph of StateSets is
+// recorded as the sequence of pushStateSet(), popStateSet() and apply() calls RenderLeaf::render()
+// makes while drawing it, which is then replayed against an osg::State without a graphics context.
+// The StateAttributes are stubs that only count their applies, the modes are marked invalid so that
+// they are tracked without glEnable()/glDisable() calls, and no Program is ever applied so uniforms
+// are tracked but never sent, which leaves the cost of the state tracking itself. The same sequence
+// is replayed against a std::map based reference model of the former State as a baseline, whose
+// attribute applies osg::State has to match.
+
+#include <osg/ArgumentParser>
+#include <osg/ApplicationUsage>
+#include <osg/State>
+#include <osg/StateSet>
+#include <osg/Uniform>
+#include <osg/Timer>
+
+#include <iostream>
+#include <vector>
+#include <map>
+#include <string>
+#include <algorithm>
+#include <stdlib.h>
+
+static unsigned int s_numStubApplies = 0;
+
+/** StateAttribute of any type that does no OpenGL call, only counting its applies.*/
+class StubAttribute : public osg::StateAttribute
+{
+    public:
+
+        StubAttribute(Type type=MATERIAL, unsigned int member=0, bool textureAttribute=false):
+            _type(type),
+            _member(member),
+            _textureAttribute(textureAttribute) {}
+
+        StubAttribute(const StubAttribute& rhs, const osg::CopyOp& copyop=osg::CopyOp::SHALLOW_COPY):
+            osg::StateAttribute(rhs, copyop),
+            _type(rhs._type),
+            _member(rhs._member),
+            _textureAttribute(rhs._textureAttribute) {}
+
+        virtual osg::Object* cloneType() const { return new StubAttribute(_type, _member, _textureAttribute); }
+        virtual osg::Object* clone(const osg::CopyOp& copyop) const { return new StubAttribute(*this, copyop); }
+        virtual bool isSameKindAs(const osg::Object* obj) const { return dynamic_cast<const StubAttribute*>(obj)!=NULL; }
+        virtual const char* libraryName() const { return "osgstatebenchmark"; }
+        virtual const char* className() const { return "StubAttribute"; }
+
+        virtual Type getType() const { return _type; }
+        virtual unsigned int getMember() const { return _member; }
+        virtual bool isTextureAttribute() const { return _textureAttribute; }
+
+        virtual int compare(const osg::StateAttribute& sa) const
+        {
+            if (this==&sa) return 0;
+            return this<&sa ? -1 : 1;
+        }
+
+        virtual void apply(osg::State&) const { ++s_numStubApplies; }
+
+    protected:
+
+        Type            _type;
+        unsigned int    _member;
+        bool            _textureAttribute;
+};
+
+/** Reference model of the state tracking osg::State made before its mode and attribute maps were indexed: a
+  * std::map of stacks per mode, attribute and uniform, each apply() walking the whole map alongside the lists
+  * of the applied StateSet. It makes no OpenGL call, counting the mode changes and attribute applies instead,
+  * so that replaying against it gives a baseline for both the time and the state changes of osg::State. Like
+  * osg::State without a graphics context, it can only select texture unit 0, making no change on the others.*/
+class ReferenceState
+{
+    public:
+
+        ReferenceState(): numModeChanges(0), numAttributeApplies(0), _unitSelected(true) {}
+
+        void pushStateSet(const osg::StateSet* stateset)
+        {
+            _stateSetStack.push_back(stateset);
+
+            pushList(_modeMap, stateset->getModeList());
+            pushList(_attributeMap, stateset->getAttributeList());
+
+            const osg::StateSet::TextureModeList& textureModeList = stateset->getTextureModeList();
+            if (_textureModeMapList.size()<textureModeList.size()) _textureModeMapList.resize(textureModeList.size());
+            for(unsigned int unit=0; unit<textureModeList.size(); ++unit) pushList(_textureModeMapList[unit], textureModeList[unit]);
+
+            const osg::StateSet::TextureAttributeList& textureAttributeList = stateset->getTextureAttributeList();
+            if (_textureAttributeMapList.size()<textureAttributeList.size()) _textureAttributeMapList.resize(textureAttributeList.size());
+            for(unsigned int unit=0; unit<textureAttributeList.size(); ++unit) pushList(_textureAttributeMapList[unit], textureAttributeList[unit]);
+
+            pushList(_uniformMap, stateset->getUniformList());
+        }
+
+        void popStateSet()
+        {
+            if (_stateSetStack.empty()) return;
+
+            const osg::StateSet* stateset = _stateSetStack.back();
+
+            popList(_modeMap, stateset->getModeList());
+            popList(_attributeMap, stateset->getAttributeList());
+
+            const osg::StateSet::TextureModeList& textureModeList = stateset->getTextureModeList();
+            for(unsigned int unit=0; unit<textureModeList.size(); ++unit) popList(_textureModeMapList[unit], textureModeList[unit]);
+
+            const osg::StateSet::TextureAttributeList& textureAttributeList = stateset->getTextureAttributeList();
+            for(unsigned int unit=0; unit<textureAttributeList.size(); ++unit) popList(_textureAttributeMapList[unit], textureAttributeList[unit]);
+
+            popList(_uniformMap, stateset->getUniformList());
+
+            _stateSetStack.pop_back();
+        }
+
+        void apply(const osg::StateSet* stateset)
+        {
+            applyList(_modeMap, stateset->getModeList());
+            applyList(_attributeMap, stateset->getAttributeList());
+
+            const osg::StateSet::TextureModeList& textureModeList = stateset->getTextureModeList();
+            if (_textureModeMapList.size()<textureModeList.size()) _textureModeMapList.resize(textureModeList.size());
+            for(unsigned int unit=0; unit<_textureModeMapList.size(); ++unit)
+            {
+                _unitSelected = unit==0;
+                if (unit<textureModeList.size()) applyList(_textureModeMapList[unit], textureModeList[unit]);
+                else applyMap(_textureModeMapList[unit]);
+            }
+
+            const osg::StateSet::TextureAttributeList& textureAttributeList = stateset->getTextureAttributeList();
+            if (_textureAttributeMapList.size()<textureAttributeList.size()) _textureAttributeMapList.resize(textureAttributeList.size());
+            for(unsigned int unit=0; unit<_textureAttributeMapList.size(); ++unit)
+            {
+                _unitSelected = unit==0;
+                if (unit<textureAttributeList.size()) applyList(_textureAttributeMapList[unit], textureAttributeList[unit]);
+                else applyMap(_textureAttributeMapList[unit]);
+            }
+            _unitSelected = true;
+
+            // uniforms are only tracked, no Program being applied.
+        }
+
+        void apply()
+        {
+            applyMap(_modeMap);
+            applyMap(_attributeMap);
+            for(unsigned int unit=0; unit<_textureModeMapList.size(); ++unit)
+            {
+                _unitSelected = unit==0;
+                applyMap(_textureModeMapList[unit]);
+            }
+            for(unsigned int unit=0; unit<_textureAttributeMapList.size(); ++unit)
+            {
+                _unitSelected = unit==0;
+                applyMap(_textureAttributeMapList[unit]);
+            }
+            _unitSelected = true;
+        }
+
+        unsigned int numModeChanges;
+        unsigned int numAttributeApplies;
+
+    protected:
+
+        typedef std::pair<const osg::StateAttribute*, osg::StateAttribute::OverrideValue> AttributePair;
+        typedef std::pair<const osg::Uniform*, osg::StateAttribute::OverrideValue> UniformPair;
+
+        struct ModeStack
+        {
+            typedef osg::StateAttribute::GLModeValue Entry;
+            ModeStack(): changed(false), last_applied_value(false), global_default_value(false) {}
+
+            std::vector<Entry>  entries;
+            bool                changed;
+            bool                last_applied_value;
+            bool                global_default_value;
+        };
+
+        struct AttributeStack
+        {
+            typedef AttributePair Entry;
+            AttributeStack(): changed(false), last_applied_attribute(0) {}
+
+            std::vector<Entry>                      entries;
+            bool                                    changed;
+            const osg::StateAttribute*              last_applied_attribute;
+            osg::ref_ptr<const osg::StateAttribute> global_default_attribute;
+        };
+
+        struct UniformStack
+        {
+            typedef UniformPair Entry;
+            UniformStack(): changed(false) {}
+
+            std::vector<Entry>  entries;
+            bool                changed;
+        };
+
+        typedef std::map<osg::StateAttribute::GLMode, ModeStack> ModeMap;
+        typedef std::map<osg::StateAttribute::TypeMemberPair, AttributeStack> AttributeMap;
+        typedef std::map<std::string, UniformStack> UniformMap;
+
+        static osg::StateAttribute::GLModeValue makeEntry(osg::StateAttribute::GLModeValue value) { return value; }
+        static AttributePair makeEntry(const osg::StateSet::RefAttributePair& rap) { return AttributePair(rap.first.get(), rap.second); }
+        static UniformPair makeEntry(const osg::StateSet::RefUniformPair& rup) { return UniformPair(rup.first.get(), rup.second); }
+
+        static osg::StateAttribute::OverrideValue overrideValue(osg::StateAttribute::GLModeValue value) { return value; }
+        template<class P>
+        static osg::StateAttribute::OverrideValue overrideValue(const P& pair) { return pair.second; }
+
+        template<class M, class L>
+        void pushList(M& map, const L& list)
+        {
+            for(typename L::const_iterator itr = list.begin(); itr != list.end(); ++itr)
+            {
+                typename M::mapped_type& stack = map[itr->first];
+                typename M::mapped_type::Entry entry = makeEntry(itr->second);
+                if (!stack.entries.empty() &&
+                    (overrideValue(stack.entries.back()) & osg::StateAttribute::OVERRIDE) &&
+                    !(overrideValue(entry) & osg::StateAttribute::PROTECTED))
+                {
+                    // the overriding entry below stays in effect.
+                    stack.entries.push_back(stack.entries.back());
+                }
+                else
+                {
+                    stack.entries.push_back(entry);
+                }
+                stack.changed = true;
+            }
+        }
+
+        template<class M, class L>
+        void popList(M& map, const L& list)
+        {
+            for(typename L::const_iterator itr = list.begin(); itr != list.end(); ++itr)
+            {
+                typename M::mapped_type& stack = map[itr->first];
+                if (!stack.entries.empty()) stack.entries.pop_back();
+                stack.changed = true;
+            }
+        }
+
+        bool applyMode(bool enabled, ModeStack& ms)
+        {
+            if (ms.last_applied_value == enabled || !_unitSelected) return false;
+            ms.last_applied_value = enabled;
+            ++numModeChanges;
+            return true;
+        }
+
+        bool applyAttribute(const osg::StateAttribute* attribute, AttributeStack& as)
+        {
+            if (as.last_applied_attribute == attribute || !_unitSelected) return false;
+            if (!as.global_default_attribute.valid()) as.global_default_attribute = attribute->cloneType()->asStateAttribute();
+            as.last_applied_attribute = attribute;
+            ++numAttributeApplies;
+            return true;
+        }
+
+        bool applyIncoming(ModeStack& ms, osg::StateAttribute::GLModeValue value) { return applyMode((value & osg::StateAttribute::ON)!=0, ms); }
+        bool applyIncoming(AttributeStack& as, const osg::StateSet::RefAttributePair& rap) { return applyAttribute(rap.first.get(), as); }
+
+        /** apply the top of a stack, or the global default when the stack is empty.*/
+        void revert(ModeStack& ms)
+        {
+            if (!ms.entries.empty()) applyMode((ms.entries.back() & osg::StateAttribute::ON)!=0, ms);
+            else applyMode(ms.global_default_value, ms);
+        }
+
+        void revert(AttributeStack& as)
+        {
+            if (!as.entries.empty()) applyAttribute(as.entries.back().first, as);
+            else if (as.last_applied_attribute != as.global_default_attribute.get() && _unitSelected)
+            {
+                as.last_applied_attribute = as.global_default_attribute.get();
+                if (as.global_default_attribute.valid()) ++numAttributeApplies;
+            }
+        }
+
+        template<class M, class L>
+        void applyList(M& map, const L& list)
+        {
+            typename L::const_iterator ds_itr = list.begin();
+            typename M::iterator this_itr = map.begin();
+            while(this_itr != map.end() && ds_itr != list.end())
+            {
+                if (this_itr->first<ds_itr->first)
+                {
+                    typename M::mapped_type& stack = this_itr->second;
+                    if (stack.changed)
+                    {
+                        stack.changed = false;
+                        revert(stack);
+                    }
+                    ++this_itr;
+                }
+                else if (ds_itr->first<this_itr->first)
+                {
+                    // a key first seen, will need to be reverted on the next apply.
+                    typename M::mapped_type& stack = map[ds_itr->first];
+                    applyIncoming(stack, ds_itr->second);
+                    stack.changed = true;
+                    ++ds_itr;
+                }
+                else
+                {
+                    typename M::mapped_type& stack = this_itr->second;
+                    if (!stack.entries.empty() &&
+                        (overrideValue(stack.entries.back()) & osg::StateAttribute::OVERRIDE) &&
+                        !(overrideValue(ds_itr->second) & osg::StateAttribute::PROTECTED))
+                    {
+                        if (stack.changed)
+                        {
+                            stack.changed = false;
+                            revert(stack);
+                        }
+                    }
+                    else if (applyIncoming(stack, ds_itr->second))
+                    {
+                        stack.changed = true;
+                    }
+                    ++this_itr;
+                    ++ds_itr;
+                }
+            }
+
+            for(; this_itr != map.end(); ++this_itr)
+            {
+                typename M::mapped_type& stack = this_itr->second;
+                if (stack.changed)
+                {
+                    stack.changed = false;
+                    revert(stack);
+                }
+            }
+
+            for(; ds_itr != list.end(); ++ds_itr)
+            {
+                typename M::mapped_type& stack = map[ds_itr->first];
+                applyIncoming(stack, ds_itr->second);
+                stack.changed = true;
+            }
+        }
+
+        template<class M>
+        void applyMap(M& map)
+        {
+            for(typename M::iterator itr = map.begin(); itr != map.end(); ++itr)
+            {
+                if (itr->second.changed)
+                {
+                    itr->second.changed = false;
+                    revert(itr->second);
+                }
+            }
+        }
+
+        std::vector<const osg::StateSet*>   _stateSetStack;
+        ModeMap                             _modeMap;
+        AttributeMap                        _attributeMap;
+        std::vector<ModeMap>                _textureModeMapList;
+        std::vector<AttributeMap>           _textureAttributeMapList;
+        UniformMap                          _uniformMap;
+        bool                                _unitSelected;
+};
+
+/** One call made on the State, as recorded from the drawing of the render graph.*/
+struct StateOperation
+{
+    enum Type
+    {
+        PUSH,
+        POP,
+        APPLY
+    };
+
+    StateOperation(Type t, const osg::StateSet* ss=0): type(t), stateset(ss) {}
+
+    Type                    type;
+    const osg::StateSet*    stateset;
+};
+
+typedef std::vector<StateOperation> StateOperations;
+
+/** The StateSets of a StateGraph from the root down to the StateSet of its leaves.*/
+typedef std::vector<const osg::StateSet*> StateSetPath;
+
+inline int randomIndex(int n) { return rand()%n; }
+
+/** Create a three level render graph: a root StateSet with the global modes, StateSets for groups of
+  * materials and per object StateSets holding textures, lights and uniforms. Each path ends with the
+  * StateSet applied to the leaves, the StateSets above it being pushed.*/
+void createRenderGraph(unsigned int numGroups, unsigned int numObjectsPerGroup, std::vector< osg::ref_ptr<osg::StateSet> >& statesets, std::vector<StateSetPath>& paths)
+{
+    const unsigned int numTextures = 64;
+    std::vector< osg::ref_ptr<StubAttribute> > textures;
+    for(unsigned int i=0; i<numTextures; ++i) textures.push_back(new StubAttribute(osg::StateAttribute::TEXTURE, 0, true));
+
+    osg::StateSet* root = new osg::StateSet;
+    root->setMode(GL_DEPTH_TEST, osg::StateAttribute::ON);
+    root->setMode(GL_LIGHTING, osg::StateAttribute::ON);
+    root->setMode(GL_LIGHT0, osg::StateAttribute::ON);
+    root->setAttribute(new StubAttribute(osg::StateAttribute::LIGHTMODEL));
+    root->setAttribute(new StubAttribute(osg::StateAttribute::LIGHT, 0));
+    root->setAttribute(new StubAttribute(osg::StateAttribute::VIEWPORT));
+    root->addUniform(new osg::Uniform("osg_FrameTime", 0.0f));
+    statesets.push_back(root);
+
+    for(unsigned int g=0; g<numGroups; ++g)
+    {
+        osg::StateSet* group = new osg::StateSet;
+        group->setAttribute(new StubAttribute(osg::StateAttribute::MATERIAL));
+        group->setMode(GL_CULL_FACE, randomIndex(2) ? osg::StateAttribute::ON : osg::StateAttribute::OFF);
+        if (g%4==3)
+        {
+            group->setAttributeAndModes(new StubAttribute(osg::StateAttribute::BLENDFUNC), osg::StateAttribute::ON);
+            group->setMode(GL_BLEND, osg::StateAttribute::ON);
+            group->setAttribute(new StubAttribute(osg::StateAttribute::DEPTH));
+        }
+        if (g%8==5)
+        {
+            // groups shown unlit whatever their objects set.
+            group->setMode(GL_LIGHTING, osg::StateAttribute::OFF | osg::StateAttribute::OVERRIDE);
+        }
+        group->addUniform(new osg::Uniform("baseColor", osg::Vec4(float(g%4)/4.0f, 0.5f, 0.5f, 1.0f)));
+        statesets.push_back(group);
+
+        for(unsigned int o=0; o<numObjectsPerGroup; ++o)
+        {
+            osg::StateSet* object = new osg::StateSet;
+            object->setTextureAttribute(0, textures[randomIndex(numTextures)].get());
+            object->setTextureMode(0, GL_TEXTURE_2D, osg::StateAttribute::ON);
+            if (randomIndex(4)==0)
+            {
+                object->setTextureAttribute(1, textures[randomIndex(numTextures)].get());
+                object->setTextureMode(1, GL_TEXTURE_2D, osg::StateAttribute::ON);
+                object->setTextureAttribute(1, new StubAttribute(osg::StateAttribute::TEXENV, 0, true));
+            }
+            if (randomIndex(3)==0)
+            {
+                unsigned int light = 1+randomIndex(3);
+                object->setAttribute(new StubAttribute(osg::StateAttribute::LIGHT, light));
+                object->setMode(GL_LIGHT0+light, osg::StateAttribute::ON);
+            }
+            if (randomIndex(2)==0) object->setMode(GL_LIGHTING, osg::StateAttribute::ON);
+            if (randomIndex(5)==0) object->setAttribute(new StubAttribute(osg::StateAttribute::POLYGONOFFSET));
+            if (randomIndex(5)==0) object->setMode(GL_POLYGON_OFFSET_FILL, osg::StateAttribute::ON);
+            object->addUniform(new osg::Uniform("objectId", int(o)));
+            if (randomIndex(2)==0) object->addUniform(new osg::Uniform("shininess", float(randomIndex(128))));
+            statesets.push_back(object);
+
+            StateSetPath path;
+            path.push_back(root);
+            path.push_back(group);
+            path.push_back(object);
+            paths.push_back(path);
+        }
+    }
+}
+
+/** Record the State calls of drawing leaves of the given StateGraph paths in turn, as StateGraph::moveStateGraph()
+  * and RenderLeaf::render() make them: pop up to the common ancestor of the previous and new StateGraphs, push
+  * down to the parent of the new StateGraph, then apply the StateSet of the new StateGraph.*/
+void recordOperations(const std::vector<StateSetPath>& paths, const std::vector<unsigned int>& drawOrder, StateOperations& operations)
+{
+    const StateSetPath* previous = 0;
+    for(std::vector<unsigned int>::const_iterator itr = drawOrder.begin(); itr != drawOrder.end(); ++itr)
+    {
+        const StateSetPath& path = paths[*itr];
+        if (&path==previous) continue;
+
+        unsigned int numPushed = previous ? previous->size()-1 : 0;
+        unsigned int numCommon = 0;
+        while(numCommon<numPushed && numCommon<path.size()-1 && (*previous)[numCommon]==path[numCommon]) ++numCommon;
+
+        for(unsigned int i=numCommon; i<numPushed; ++i) operations.push_back(StateOperation(StateOperation::POP));
+        for(unsigned int i=numCommon; i<path.size()-1; ++i) operations.push_back(StateOperation(StateOperation::PUSH, path[i]));
+        operations.push_back(StateOperation(StateOperation::APPLY, path.back()));
+
+        previous = &path;
+    }
+
+    // RenderStage::drawImplementation() ends its bins with popAllStateSets() and an apply().
+    if (previous)
+    {
+        for(unsigned int i=0; i<previous->size()-1; ++i) operations.push_back(StateOperation(StateOperation::POP));
+    }
+    operations.push_back(StateOperation(StateOperation::APPLY));
+}
+
+/** Mark every mode and texture mode of the StateSets invalid, so that the State tracks them without calling
+  * glEnable() or glDisable(), there being no graphics context.*/
+void disableModes(osg::State& state, const std::vector< osg::ref_ptr<osg::StateSet> >& statesets)
+{
+    for(std::vector< osg::ref_ptr<osg::StateSet> >::const_iterator itr = statesets.begin(); itr != statesets.end(); ++itr)
+    {
+        const osg::StateSet::ModeList& modeList = (*itr)->getModeList();
+        for(osg::StateSet::ModeList::const_iterator mitr = modeList.begin(); mitr != modeList.end(); ++mitr)
+        {
+            state.setModeValidity(mitr->first, false);
+        }
+
+        const osg::StateSet::TextureModeList& textureModeList = (*itr)->getTextureModeList();
+        for(unsigned int unit=0; unit<textureModeList.size(); ++unit)
+        {
+            for(osg::StateSet::ModeList::const_iterator mitr = textureModeList[unit].begin(); mitr != textureModeList[unit].end(); ++mitr)
+            {
+                state.setTextureModeValidity(unit, mitr->first, false);
+            }
+        }
+    }
+}
+
+template<class S>
+void replayOperations(S& state, const StateOperations& operations)
+{
+    for(StateOperations::const_iterator itr = operations.begin(); itr != operations.end(); ++itr)
+    {
+        switch(itr->type)
+        {
+            case(StateOperation::PUSH): state.pushStateSet(itr->stateset); break;
+            case(StateOperation::POP): state.popStateSet(); break;
+            case(StateOperation::APPLY):
+                if (itr->stateset) state.apply(itr->stateset);
+                else state.apply();
+                break;
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    osg::ArgumentParser arguments(&argc,argv);
+
+    arguments.getApplicationUsage()->setApplicationName(arguments.getApplicationName());
+    arguments.getApplicationUsage()->setDescription(arguments.getApplicationName()+" benchmarks the state tracking of osg::State by replaying recorded StateSet push, pop and apply sequences, without a graphics context.");
+    arguments.getApplicationUsage()->setCommandLineUsage(arguments.getApplicationName()+" [options]");
+    arguments.getApplicationUsage()->addCommandLineOption("--groups <n>","Number of material groups in the render graph, default 64.");
+    arguments.getApplicationUsage()->addCommandLineOption("--objects <n>","Number of objects per material group, default 64.");
+    arguments.getApplicationUsage()->addCommandLineOption("--leaves <n>","Number of leaves drawn per frame, default 100000.");
+    arguments.getApplicationUsage()->addCommandLineOption("--frames <n>","Number of frames replayed per draw order, default 20.");
+    arguments.getApplicationUsage()->addCommandLineOption("-h or --help","Display this information");
+
+    if (arguments.read("-h") || arguments.read("--help"))
+    {
+        arguments.getApplicationUsage()->write(std::cout);
+        return 1;
+    }
+
+    unsigned int numGroups = 64;
+    unsigned int numObjects = 64;
+    unsigned int numLeaves = 100000;
+    unsigned int numFrames = 20;
+    while(arguments.read("--groups", numGroups)) {}
+    while(arguments.read("--objects", numObjects)) {}
+    while(arguments.read("--leaves", numLeaves)) {}
+    while(arguments.read("--frames", numFrames)) {}
+    if (numGroups==0 || numObjects==0 || numFrames==0)
+    {
+        std::cout<<"The number of groups, objects and frames must be positive."<<std::endl;
+        return 1;
+    }
+
+    srand(1);
+
+    std::vector< osg::ref_ptr<osg::StateSet> > statesets;
+    std::vector<StateSetPath> paths;
+    createRenderGraph(numGroups, numObjects, statesets, paths);
+
+    // leaves drawn in traversal order, each object being drawn by several leaves scattered across the frame.
+    std::vector<unsigned int> traversalOrder;
+    for(unsigned int i=0; i<numLeaves; ++i) traversalOrder.push_back(randomIndex(paths.size()));
+
+    // the same leaves sorted by StateGraph, as RenderBin::SORT_BY_STATE draws them.
+    std::vector<unsigned int> sortedOrder(traversalOrder);
+    std::sort(sortedOrder.begin(), sortedOrder.end());
+
+    struct DrawOrder
+    {
+        const char*                     name;
+        const std::vector<unsigned int>* order;
+    };
+    const DrawOrder drawOrders[] =
+    {
+        { "sorted by state", &sortedOrder },
+        { "traversal order", &traversalOrder }
+    };
+
+    int result = 0;
+
+    std::cout<<numLeaves<<" leaves over "<<paths.size()<<" StateGraphs, replayed over "<<numFrames<<" frames"<<std::endl;
+
+    for(unsigned int d=0; d<sizeof(drawOrders)/sizeof(DrawOrder); ++d)
+    {
+        StateOperations operations;
+        recordOperations(paths, *drawOrders[d].order, operations);
+
+        // the baseline, a first frame creating the stacks of every mode and attribute.
+        ReferenceState reference;
+        replayOperations(reference, operations);
+
+        reference.numModeChanges = 0;
+        reference.numAttributeApplies = 0;
+        osg::Timer_t startTick = osg::Timer::instance()->tick();
+        for(unsigned int frame=0; frame<numFrames; ++frame)
+        {
+            replayOperations(reference, operations);
+        }
+        double referenceTime = osg::Timer::instance()->delta_m(startTick, osg::Timer::instance()->tick())/double(numFrames);
+
+        osg::ref_ptr<osg::State> state = new osg::State;
+        disableModes(*state, statesets);
+
+        replayOperations(*state, operations);
+
+        s_numStubApplies = 0;
+        startTick = osg::Timer::instance()->tick();
+        for(unsigned int frame=0; frame<numFrames; ++frame)
+        {
+            replayOperations(*state, operations);
+        }
+        double time = osg::Timer::instance()->delta_m(startTick, osg::Timer::instance()->tick())/double(numFrames);
+
+        std::cout<<"  "<<drawOrders[d].name<<" : "<<operations.size()<<" operations"<<std::endl;
+        std::cout<<"    baseline  : "<<referenceTime<<"ms per frame, "
+                 <<double(operations.size())/(referenceTime*1000.0)<<" million operations per second, "
+                 <<reference.numAttributeApplies/numFrames<<" attribute applies and "
+                 <<reference.numModeChanges/numFrames<<" mode changes per frame"<<std::endl;
+        std::cout<<"    osg::State: "<<time<<"ms per frame, "
+                 <<double(operations.size())/(time*1000.0)<<" million operations per second, "
+                 <<s_numStubApplies/numFrames<<" attribute applies per frame, speedup "
+                 <<(time>0.0 ? referenceTime/time : 0.0)<<std::endl;
+
+        if (s_numStubApplies!=reference.numAttributeApplies)
+        {
+            std::cout<<"    osg::State made different attribute applies than the baseline."<<std::endl;
+            result = 1;
+        }
+    }
+
+    return result;
+}
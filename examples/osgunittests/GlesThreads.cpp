@@ -0,0 +1,163 @@
+/* -*-c++-*-
+*
+*  OpenSceneGraph example, osgunittests.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+*  THE SOFTWARE.
+*/
+
+#include <osg/Geode>
+#include <osg/Geometry>
+#include <osgDB/ReadFile>
+#include <osgDB/WriteFile>
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdio.h>
+
+#include "GlesThreads.h"
+
+// unindexed grid of triangles, every inner vertex being duplicated so that the gles indexing has work to do
+static osg::Vec3Array* createGridVertices(unsigned int size, const osg::Vec3& origin)
+{
+    osg::Vec3Array* vertices = new osg::Vec3Array;
+    for(unsigned int r=0; r<size; ++r)
+    {
+        for(unsigned int c=0; c<size; ++c)
+        {
+            osg::Vec3 v00 = origin+osg::Vec3(float(c), float(r), float((r*7+c*3)%5)*0.1f);
+            osg::Vec3 v10 = origin+osg::Vec3(float(c+1), float(r), float((r*7+(c+1)*3)%5)*0.1f);
+            osg::Vec3 v01 = origin+osg::Vec3(float(c), float(r+1), float(((r+1)*7+c*3)%5)*0.1f);
+            osg::Vec3 v11 = origin+osg::Vec3(float(c+1), float(r+1), float(((r+1)*7+(c+1)*3)%5)*0.1f);
+            vertices->push_back(v00); vertices->push_back(v10); vertices->push_back(v01);
+            vertices->push_back(v10); vertices->push_back(v11); vertices->push_back(v01);
+        }
+    }
+    return vertices;
+}
+
+static osg::DrawElementsUInt* createTriangles(unsigned int numVertices, unsigned int offset)
+{
+    osg::DrawElementsUInt* triangles = new osg::DrawElementsUInt(GL_TRIANGLES);
+    for(unsigned int i=0; i+2<numVertices; i+=3)
+    {
+        unsigned int first = (i+offset*3)%(numVertices-numVertices%3);
+        triangles->push_back(first);
+        triangles->push_back(first+1);
+        triangles->push_back(first+2);
+    }
+    return triangles;
+}
+
+// a scene where geometries share vertex arrays, texture coordinate arrays and primitive sets with
+// one another, along with geometries sharing nothing.
+static osg::Node* createSharedArraysScene()
+{
+    osg::Geode* geode = new osg::Geode;
+    for(unsigned int i=0; i<16; ++i)
+    {
+        osg::Vec3 origin(float(i)*20.0f, 0.0f, 0.0f);
+        osg::ref_ptr<osg::Vec3Array> vertices = createGridVertices(8, origin);
+        osg::ref_ptr<osg::Vec2Array> texcoords = new osg::Vec2Array;
+        for(unsigned int v=0; v<vertices->size(); ++v)
+        {
+            texcoords->push_back(osg::Vec2((*vertices)[v].x()*0.1f, (*vertices)[v].y()*0.1f));
+        }
+
+        // two geometries drawing distinct triangles of the same arrays
+        osg::Geometry* first = new osg::Geometry;
+        first->setVertexArray(vertices.get());
+        first->setTexCoordArray(0, texcoords.get());
+        first->addPrimitiveSet(createTriangles(vertices->size()/2, 0));
+        geode->addDrawable(first);
+
+        osg::Geometry* second = new osg::Geometry;
+        second->setVertexArray(vertices.get());
+        second->setTexCoordArray(0, texcoords.get());
+        second->addPrimitiveSet(createTriangles(vertices->size(), 5));
+        geode->addDrawable(second);
+
+        // a geometry with its own vertices sharing the primitive set of the first one
+        osg::Geometry* third = new osg::Geometry;
+        third->setVertexArray(createGridVertices(8, origin+osg::Vec3(0.0f, 20.0f, 0.0f)));
+        third->addPrimitiveSet(first->getPrimitiveSet(0));
+        geode->addDrawable(third);
+
+        // and one sharing nothing
+        osg::Geometry* fourth = new osg::Geometry;
+        osg::Vec3Array* ownVertices = createGridVertices(8, origin+osg::Vec3(0.0f, 40.0f, 0.0f));
+        fourth->setVertexArray(ownVertices);
+        fourth->addPrimitiveSet(new osg::DrawArrays(GL_TRIANGLES, 0, ownVertices->size()));
+        geode->addDrawable(fourth);
+    }
+    return geode;
+}
+
+static bool readFile(const std::string& fileName, std::string& content)
+{
+    std::ifstream fin(fileName.c_str(), std::ios::in | std::ios::binary);
+    if (!fin) return false;
+
+    std::ostringstream sstream;
+    sstream<<fin.rdbuf();
+    content = sstream.str();
+    return true;
+}
+
+// optimize a fresh copy of the scene through the gles plugin, the plugin modifying the geometries of
+// the scene it is given, and return the resulting osgt file.
+static bool optimizeScene(unsigned int numThreads, std::string& content)
+{
+    osg::ref_ptr<osg::Node> scene = createSharedArraysScene();
+
+    std::ostringstream fileName;
+    fileName<<"osgunittests_gles_"<<numThreads<<"_threads.osgt";
+
+    std::ostringstream optionString;
+    optionString<<"numThreads="<<numThreads;
+    osg::ref_ptr<osgDB::Options> options = new osgDB::Options(optionString.str());
+
+    if (!osgDB::writeNodeFile(*scene, fileName.str()+".gles", options.get()))
+    {
+        std::cout<<"Could not write "<<fileName.str()<<" through the gles plugin"<<std::endl;
+        return false;
+    }
+
+    bool result = readFile(fileName.str(), content);
+    remove(fileName.str().c_str());
+    return result;
+}
+
+bool runGlesThreadsTest(unsigned int numThreads)
+{
+    std::cout<<"******   Running gles serial/parallel comparison with "<<numThreads<<" threads   ******"<<std::endl;
+
+    std::string serial, parallel;
+    if (!optimizeScene(1, serial) || !optimizeScene(numThreads, parallel))
+    {
+        std::cout<<"fail    gles serial/parallel comparison, could not optimize the scene"<<std::endl<<std::endl;
+        return false;
+    }
+
+    if (serial!=parallel)
+    {
+        std::cout<<"fail    gles serial/parallel comparison, the outputs differ"<<std::endl<<std::endl;
+        return false;
+    }
+
+    std::cout<<"pass    gles serial/parallel comparison"<<std::endl<<std::endl;
+    return true;
+}
@@ -30,6 +30,7 @@
 #include "UnitTestFramework.h"
 #include "performance.h"
 #include "MultiThreadRead.h"
+#include "GlesThreads.h"
 
 #include <iostream>
 
@@ -573,6 +574,7 @@ int main( int argc, char** argv )
     arguments.getApplicationUsage()->addCommandLineOption("matrix","Display qualified tests.");
     arguments.getApplicationUsage()->addCommandLineOption("performance","Display qualified tests.");
     arguments.getApplicationUsage()->addCommandLineOption("read-threads <numthreads>","Run multi-thread reading test.");
+    arguments.getApplicationUsage()->addCommandLineOption("gles-threads <numthreads>","Compare the output of the gles plugin processing geometries serially and in parallel.");
 
 
     if (arguments.argc()<=1)
@@ -599,6 +601,9 @@ int main( int argc, char** argv )
     int numReadThreads = 0;
     while (arguments.read("read-threads", numReadThreads)) {}
 
+    unsigned int numGlesThreads = 0;
+    while (arguments.read("gles-threads", numGlesThreads)) {}
+
     bool printPolytopeTest = false;
     while (arguments.read("polytope")) printPolytopeTest = true;
 
@@ -688,6 +693,11 @@ int main( int argc, char** argv )
     }
 
 
+    if (numGlesThreads>0)
+    {
+        if (!runGlesThreadsTest(numGlesThreads)) return 1;
+    }
+
     if (printPolytopeTest)
     {
         testPolytope();
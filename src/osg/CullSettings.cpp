@@ -43,6 +43,8 @@ void CullSettings::setDefaults()
     _cullMask = 0xffffffff;
     _cullMaskLeft = 0xffffffff;
     _cullMaskRight = 0xffffffff;
+    _numParallelCullThreads = 0;
+    _parallelCullMinimumNumChildren = 64;
 
     // override during testing
     //_computeNearFar = COMPUTE_NEAR_FAR_USING_PRIMITIVES;
@@ -69,6 +71,9 @@ void CullSettings::setCullSettings(const CullSettings& rhs)
     _cullMask = rhs._cullMask;
     _cullMaskLeft = rhs._cullMaskLeft;
     _cullMaskRight =  rhs._cullMaskRight;
+
+    _numParallelCullThreads = rhs._numParallelCullThreads;
+    _parallelCullMinimumNumChildren = rhs._parallelCullMinimumNumChildren;
 }
 
 
@@ -87,11 +92,15 @@ void CullSettings::inheritCullSettings(const CullSettings& settings, unsigned in
     if (inheritanceMask & LOD_SCALE) _LODScale = settings._LODScale;
     if (inheritanceMask & SMALL_FEATURE_CULLING_PIXEL_SIZE) _smallFeatureCullingPixelSize = settings._smallFeatureCullingPixelSize;
     if (inheritanceMask & CLAMP_PROJECTION_MATRIX_CALLBACK) _clampProjectionMatrixCallback = settings._clampProjectionMatrixCallback;
+    if (inheritanceMask & NUM_PARALLEL_CULL_THREADS) _numParallelCullThreads = settings._numParallelCullThreads;
+    if (inheritanceMask & PARALLEL_CULL_MINIMUM_NUM_CHILDREN) _parallelCullMinimumNumChildren = settings._parallelCullMinimumNumChildren;
 }
 
 
 static ApplicationUsageProxy ApplicationUsageProxyCullSettings_e0(ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_COMPUTE_NEAR_FAR_MODE <mode>","DO_NOT_COMPUTE_NEAR_FAR | COMPUTE_NEAR_FAR_USING_BOUNDING_VOLUMES | COMPUTE_NEAR_FAR_USING_PRIMITIVES");
 static ApplicationUsageProxy ApplicationUsageProxyCullSettings_e1(ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_NEAR_FAR_RATIO <float>","Set the ratio between near and far planes - must greater than 0.0 but less than 1.0.");
+static ApplicationUsageProxy ApplicationUsageProxyCullSettings_e2(ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_NUM_PARALLEL_CULL_THREADS <int>","Set the number of worker threads used to cull the children of wide groups in parallel, 0 disables parallel cull.");
+static ApplicationUsageProxy ApplicationUsageProxyCullSettings_e3(ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_PARALLEL_CULL_MINIMUM_NUM_CHILDREN <int>","Set the minimum number of children of a group for its cull to be split across the parallel cull threads.");
 
 void CullSettings::readEnvironmentalVariables()
 {
@@ -116,6 +125,20 @@ void CullSettings::readEnvironmentalVariables()
         OSG_INFO<<"Set near/far ratio to "<<_nearFarRatio<<std::endl;
     }
 
+    if ((ptr = getenv("OSG_NUM_PARALLEL_CULL_THREADS")) != 0)
+    {
+        _numParallelCullThreads = atoi(ptr);
+
+        OSG_INFO<<"Set number of parallel cull threads to "<<_numParallelCullThreads<<std::endl;
+    }
+
+    if ((ptr = getenv("OSG_PARALLEL_CULL_MINIMUM_NUM_CHILDREN")) != 0)
+    {
+        _parallelCullMinimumNumChildren = atoi(ptr);
+
+        OSG_INFO<<"Set parallel cull minimum number of children to "<<_parallelCullMinimumNumChildren<<std::endl;
+    }
+
 }
 
 void CullSettings::readCommandLine(ArgumentParser& arguments)
@@ -125,6 +148,7 @@ void CullSettings::readCommandLine(ArgumentParser& arguments)
     {
         arguments.getApplicationUsage()->addCommandLineOption("--COMPUTE_NEAR_FAR_MODE <mode>","DO_NOT_COMPUTE_NEAR_FAR | COMPUTE_NEAR_FAR_USING_BOUNDING_VOLUMES | COMPUTE_NEAR_FAR_USING_PRIMITIVES");
         arguments.getApplicationUsage()->addCommandLineOption("--NEAR_FAR_RATIO <float>","Set the ratio between near and far planes - must greater than 0.0 but less than 1.0.");
+        arguments.getApplicationUsage()->addCommandLineOption("--NUM_PARALLEL_CULL_THREADS <int>","Set the number of worker threads used to cull the children of wide groups in parallel, 0 disables parallel cull.");
     }
 
     std::string str;
@@ -145,6 +169,14 @@ void CullSettings::readCommandLine(ArgumentParser& arguments)
         OSG_INFO<<"Set near/far ratio to "<<_nearFarRatio<<std::endl;
     }
 
+    unsigned int numThreads;
+    while(arguments.read("--NUM_PARALLEL_CULL_THREADS",numThreads))
+    {
+        _numParallelCullThreads = numThreads;
+
+        OSG_INFO<<"Set number of parallel cull threads to "<<_numParallelCullThreads<<std::endl;
+    }
+
 }
 
 void CullSettings::write(std::ostream& out)
@@ -166,6 +198,8 @@ void CullSettings::write(std::ostream& out)
     out<<"    _cullMask = "<<_cullMask<<std::endl;
     out<<"    _cullMaskLeft = "<<_cullMaskLeft<<std::endl;
     out<<"    _cullMaskRight = "<<_cullMaskRight<<std::endl;
+    out<<"    _numParallelCullThreads = "<<_numParallelCullThreads<<std::endl;
+    out<<"    _parallelCullMinimumNumChildren = "<<_parallelCullMinimumNumChildren<<std::endl;
 
     out<<"{"<<std::endl;
 }
@@ -25,12 +25,16 @@
 
 using namespace osg;
 
-Group::Group()
+Group::Group():
+    _cacheRenderLeaves(false),
+    _renderLeafCacheModifiedCount(0)
 {
 }
 
 Group::Group(const Group& group,const CopyOp& copyop):
-    Node(group,copyop)
+    Node(group,copyop),
+    _cacheRenderLeaves(group._cacheRenderLeaves),
+    _renderLeafCacheModifiedCount(0)
 {
     for(NodeList::const_iterator itr=group._children.begin();
         itr!=group._children.end();
@@ -15,9 +15,13 @@
 #include <osg/Geode>
 #include <osg/TriangleIndexFunctor>
 #include <osg/Timer>
+#include <osg/OperationThread>
 
 #include <osg/io_utils>
 
+#include <algorithm>
+#include <float.h>
+
 using namespace osg;
 
 //#define VERBOSE_OUTPUT
@@ -32,21 +36,47 @@ struct BuildKdTree
         _kdTree(kdTree) {}
 
     typedef std::vector< osg::Vec3 >            CenterList;
+    typedef std::vector< osg::BoundingBox >     BoundingBoxList;
     typedef std::vector< unsigned int >           Indices;
     typedef std::vector< unsigned int >         AxisStack;
 
+    /** Subtree left to be built by the threads, into its own list of nodes whose first node replaces the node at nodeIndex.*/
+    struct Subtree
+    {
+        Subtree(int nodeIndex, unsigned int level):
+            _nodeIndex(nodeIndex),
+            _level(level) {}
+
+        int                 _nodeIndex;
+        unsigned int        _level;
+        KdTree::KdNodeList  _nodes;
+    };
+
+    typedef std::vector< Subtree >              SubtreeList;
+
     bool build(KdTree::BuildOptions& options, osg::Geometry* geometry);
 
     void computeDivisions(KdTree::BuildOptions& options);
 
     int divide(KdTree::BuildOptions& options, osg::BoundingBox& bb, int nodeIndex, unsigned int level);
 
+    /** Divide the node at nodeIndex of nodes where the binned surface area heuristic finds the cheapest split. If subtrees is non null,
+      * the nodes with no more than maxSubtreeSize triangles are added to subtrees rather than divided.*/
+    int divideBySurfaceAreaHeuristic(KdTree::BuildOptions& options, KdTree::KdNodeList& nodes, int nodeIndex, unsigned int level,
+                                     SubtreeList* subtrees, unsigned int maxSubtreeSize);
+
+    /** Build the subtrees on options._numThreads threads and the calling thread, then splice them into the kdtree.*/
+    void buildSubtrees(KdTree::BuildOptions& options, SubtreeList& subtrees);
+
+    void computeLeafBound(KdTree::KdNode& node);
+
     KdTree&             _kdTree;
 
     osg::BoundingBox    _bb;
     AxisStack           _axisStack;
     Indices             _primitiveIndices;
     CenterList          _centers;
+    BoundingBoxList     _triangleBounds;    // only collected for the SURFACE_AREA_HEURISTIC
 
 protected:
 
@@ -60,7 +90,8 @@ protected:
 struct TriangleIndicesCollector
 {
     TriangleIndicesCollector():
-        _buildKdTree(0)
+        _buildKdTree(0),
+        _collectTriangleBounds(false)
     {
     }
 
@@ -86,10 +117,12 @@ struct TriangleIndicesCollector
 
         _buildKdTree->_centers.push_back(bb.center());
         _buildKdTree->_primitiveIndices.push_back(i);
+        if (_collectTriangleBounds) _buildKdTree->_triangleBounds.push_back(bb);
 
     }
 
     BuildKdTree* _buildKdTree;
+    bool         _collectTriangleBounds;
 
 };
 
@@ -133,6 +166,8 @@ bool BuildKdTree::build(KdTree::BuildOptions& options, osg::Geometry* geometry)
 
     osg::TriangleIndexFunctor<TriangleIndicesCollector> collectTriangleIndices;
     collectTriangleIndices._buildKdTree = this;
+    collectTriangleIndices._collectTriangleBounds = (options._splitMethod==KdTree::BuildOptions::SURFACE_AREA_HEURISTIC);
+    if (collectTriangleIndices._collectTriangleBounds) _triangleBounds.reserve(estimatedNumTriangles);
     geometry->accept(collectTriangleIndices);
 
     _primitiveIndices.reserve(vertices->size());
@@ -142,8 +177,23 @@ bool BuildKdTree::build(KdTree::BuildOptions& options, osg::Geometry* geometry)
 
     int nodeNum = _kdTree.addNode(node);
 
-    osg::BoundingBox bb = _bb;
-    nodeNum = divide(options, bb, nodeNum, 0);
+    if (options._splitMethod==KdTree::BuildOptions::SURFACE_AREA_HEURISTIC)
+    {
+        // hand subtrees over to the threads once they are small enough for several to be built by each thread, so the threads finish together.
+        unsigned int numTriangles = _primitiveIndices.size();
+        bool buildInParallel = options._numThreads>0 && numTriangles>=16384;
+        unsigned int maxSubtreeSize = osg::maximum(numTriangles/((options._numThreads+1)*8), 1024u);
+
+        SubtreeList subtrees;
+        nodeNum = divideBySurfaceAreaHeuristic(options, _kdTree.getNodes(), nodeNum, 0, buildInParallel ? &subtrees : 0, maxSubtreeSize);
+
+        if (!subtrees.empty()) buildSubtrees(options, subtrees);
+    }
+    else
+    {
+        osg::BoundingBox bb = _bb;
+        nodeNum = divide(options, bb, nodeNum, 0);
+    }
 
     // now reorder the triangle list so that it's in order as per the primitiveIndex list.
     KdTree::TriangleList triangleList(_kdTree.getTriangles().size());
@@ -214,33 +264,8 @@ int BuildKdTree::divide(KdTree::BuildOptions& options, osg::BoundingBox& bb, int
     {
         if (node.first<0)
         {
-            int istart = -node.first-1;
-            int iend = istart+node.second-1;
-
             // leaf is done, now compute bound on it.
-            node.bb.init();
-            for(int i=istart; i<=iend; ++i)
-            {
-                const KdTree::Triangle& tri = _kdTree.getTriangle(_primitiveIndices[i]);
-                const osg::Vec3& v0 = (*_kdTree.getVertices())[tri.p0];
-                const osg::Vec3& v1 = (*_kdTree.getVertices())[tri.p1];
-                const osg::Vec3& v2 = (*_kdTree.getVertices())[tri.p2];
-                node.bb.expandBy(v0);
-                node.bb.expandBy(v1);
-                node.bb.expandBy(v2);
-
-            }
-
-            if (node.bb.valid())
-            {
-                float epsilon = 1e-6f;
-                node.bb._min.x() -= epsilon;
-                node.bb._min.y() -= epsilon;
-                node.bb._min.z() -= epsilon;
-                node.bb._max.x() += epsilon;
-                node.bb._max.y() += epsilon;
-                node.bb._max.z() += epsilon;
-            }
+            computeLeafBound(node);
 
 #ifdef VERBOSE_OUTPUT
             if (!node.bb.valid())
@@ -421,19 +446,346 @@ int BuildKdTree::divide(KdTree::BuildOptions& options, osg::BoundingBox& bb, int
 
 }
 
+void BuildKdTree::computeLeafBound(KdTree::KdNode& node)
+{
+    int istart = -node.first-1;
+    int iend = istart+node.second-1;
+
+    node.bb.init();
+    for(int i=istart; i<=iend; ++i)
+    {
+        const KdTree::Triangle& tri = _kdTree.getTriangle(_primitiveIndices[i]);
+        const osg::Vec3& v0 = (*_kdTree.getVertices())[tri.p0];
+        const osg::Vec3& v1 = (*_kdTree.getVertices())[tri.p1];
+        const osg::Vec3& v2 = (*_kdTree.getVertices())[tri.p2];
+        node.bb.expandBy(v0);
+        node.bb.expandBy(v1);
+        node.bb.expandBy(v2);
+
+    }
+
+    if (node.bb.valid())
+    {
+        float epsilon = 1e-6f;
+        node.bb._min.x() -= epsilon;
+        node.bb._min.y() -= epsilon;
+        node.bb._min.z() -= epsilon;
+        node.bb._max.x() += epsilon;
+        node.bb._max.y() += epsilon;
+        node.bb._max.z() += epsilon;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Surface area heuristic division of the BuildKdTree
+
+static inline int addNode(KdTree::KdNodeList& nodes, const KdTree::KdNode& node)
+{
+    int num = static_cast<int>(nodes.size());
+    nodes.push_back(node);
+    return num;
+}
+
+static inline float halfSurfaceArea(const osg::BoundingBox& bb)
+{
+    if (!bb.valid()) return 0.0f;
+
+    osg::Vec3 dimensions = bb._max-bb._min;
+    return dimensions.x()*dimensions.y() + dimensions.y()*dimensions.z() + dimensions.z()*dimensions.x();
+}
+
+static inline unsigned int binIndex(float center, float min, float scale, unsigned int numBins)
+{
+    unsigned int bin = static_cast<unsigned int>((center-min)*scale);
+    return bin<numBins ? bin : numBins-1;
+}
+
+/** Predicate of the triangles whose center falls in the bins up to and including lastBin.*/
+struct CenterInBins
+{
+    CenterInBins(const BuildKdTree::CenterList& centers, int axis, float min, float scale, unsigned int numBins, unsigned int lastBin):
+        _centers(centers), _axis(axis), _min(min), _scale(scale), _numBins(numBins), _lastBin(lastBin) {}
+
+    inline bool operator () (unsigned int primitiveIndex) const
+    {
+        return binIndex(_centers[primitiveIndex][_axis], _min, _scale, _numBins)<=_lastBin;
+    }
+
+    const BuildKdTree::CenterList&  _centers;
+    int                             _axis;
+    float                           _min;
+    float                           _scale;
+    unsigned int                    _numBins;
+    unsigned int                    _lastBin;
+
+protected:
+
+    CenterInBins& operator = (const CenterInBins&) { return *this; }
+};
+
+int BuildKdTree::divideBySurfaceAreaHeuristic(KdTree::BuildOptions& options, KdTree::KdNodeList& nodes, int nodeIndex, unsigned int level,
+                                              SubtreeList* subtrees, unsigned int maxSubtreeSize)
+{
+    KdTree::KdNode& node = nodes[nodeIndex];
+
+    int istart = -node.first-1;
+    int numTriangles = node.second;
+    int iend = istart+numTriangles;
+
+    if (level>=options._maxNumLevels || static_cast<unsigned int>(numTriangles)<=options._targetNumTrianglesPerLeaf)
+    {
+        computeLeafBound(node);
+        return nodeIndex;
+    }
+
+    if (subtrees && static_cast<unsigned int>(numTriangles)<=maxSubtreeSize)
+    {
+        subtrees->push_back(Subtree(nodeIndex, level));
+        return nodeIndex;
+    }
+
+    // the bins are spread over the bound of the triangle centers.
+    osg::BoundingBox centerBound;
+    for(int i=istart; i<iend; ++i)
+    {
+        centerBound.expandBy(_centers[_primitiveIndices[i]]);
+    }
+
+    const unsigned int maxNumBins = 64;
+    unsigned int numBins = osg::clampBetween(options._numSurfaceAreaHeuristicBins, 2u, maxNumBins);
+
+    float binScales[3];
+    unsigned int binCounts[3][maxNumBins];
+    osg::BoundingBox binBounds[3][maxNumBins];
+    for(int axis=0; axis<3; ++axis)
+    {
+        float extent = centerBound._max[axis]-centerBound._min[axis];
+        binScales[axis] = extent>0.0f ? float(numBins)/extent : 0.0f;
+        for(unsigned int bin=0; bin<numBins; ++bin) binCounts[axis][bin] = 0;
+    }
+
+    for(int i=istart; i<iend; ++i)
+    {
+        unsigned int primitiveIndex = _primitiveIndices[i];
+        const osg::BoundingBox& triangleBound = _triangleBounds[primitiveIndex];
+
+        const osg::Vec3& center = _centers[primitiveIndex];
+        for(int axis=0; axis<3; ++axis)
+        {
+            if (binScales[axis]==0.0f) continue;
+
+            unsigned int bin = binIndex(center[axis], centerBound._min[axis], binScales[axis], numBins);
+            ++binCounts[axis][bin];
+            binBounds[axis][bin].expandBy(triangleBound);
+        }
+    }
+
+    // sweep the bins from the right to accumulate the areas and triangle counts of the right children,
+    // then from the left to find the split with the lowest cost.
+    int bestAxis = -1;
+    unsigned int bestBin = 0;
+    float bestCost = FLT_MAX;
+    float rightAreas[maxNumBins];
+    unsigned int rightCounts[maxNumBins];
+    for(int axis=0; axis<3; ++axis)
+    {
+        if (binScales[axis]==0.0f) continue;
+
+        osg::BoundingBox bound;
+        unsigned int count = 0;
+        for(unsigned int bin=numBins-1; bin>0; --bin)
+        {
+            bound.expandBy(binBounds[axis][bin]);
+            count += binCounts[axis][bin];
+            rightAreas[bin] = halfSurfaceArea(bound);
+            rightCounts[bin] = count;
+        }
+
+        bound.init();
+        count = 0;
+        for(unsigned int bin=0; bin<numBins-1; ++bin)
+        {
+            bound.expandBy(binBounds[axis][bin]);
+            count += binCounts[axis][bin];
+            if (count==0 || rightCounts[bin+1]==0) continue;
+
+            float cost = halfSurfaceArea(bound)*float(count) + rightAreas[bin+1]*float(rightCounts[bin+1]);
+            if (cost<bestCost)
+            {
+                bestCost = cost;
+                bestAxis = axis;
+                bestBin = bin;
+            }
+        }
+    }
+
+    // all the triangle centers coincide, so there is no split to be had.
+    if (bestAxis<0)
+    {
+        computeLeafBound(node);
+        return nodeIndex;
+    }
+
+    Indices::iterator middle = std::partition(_primitiveIndices.begin()+istart, _primitiveIndices.begin()+iend,
+                                              CenterInBins(_centers, bestAxis, centerBound._min[bestAxis], binScales[bestAxis], numBins, bestBin));
+    int imiddle = static_cast<int>(middle-_primitiveIndices.begin());
+
+    int leftChildIndex = addNode(nodes, KdTree::KdNode(-istart-1, imiddle-istart));
+    int rightChildIndex = addNode(nodes, KdTree::KdNode(-imiddle-1, iend-imiddle));
+
+    divideBySurfaceAreaHeuristic(options, nodes, leftChildIndex, level+1, subtrees, maxSubtreeSize);
+    divideBySurfaceAreaHeuristic(options, nodes, rightChildIndex, level+1, subtrees, maxSubtreeSize);
+
+    // take a second reference to node we are working on as adding the children could have reallocated the node list.
+    KdTree::KdNode& newNodeRef = nodes[nodeIndex];
+    newNodeRef.first = leftChildIndex;
+    newNodeRef.second = rightChildIndex;
+    newNodeRef.bb.init();
+    newNodeRef.bb.expandBy(nodes[leftChildIndex].bb);
+    newNodeRef.bb.expandBy(nodes[rightChildIndex].bb);
+
+    return nodeIndex;
+}
+
+/** Operation building a subtree of a BuildKdTree on one of the threads, or on the calling thread.*/
+struct BuildSubtreeOperation : public osg::Operation
+{
+    BuildSubtreeOperation(BuildKdTree& buildKdTree, KdTree::BuildOptions& options, BuildKdTree::Subtree& subtree, osg::RefBlockCount* completed):
+        osg::Operation("BuildKdTreeSubtree", false),
+        _buildKdTree(buildKdTree),
+        _options(options),
+        _subtree(subtree),
+        _completed(completed) {}
+
+    virtual void operator () (osg::Object*)
+    {
+        _buildKdTree.divideBySurfaceAreaHeuristic(_options, _subtree._nodes, 0, _subtree._level, 0, 0);
+        _completed->completed();
+    }
+
+    BuildKdTree&                        _buildKdTree;
+    KdTree::BuildOptions&               _options;
+    BuildKdTree::Subtree&               _subtree;
+    osg::ref_ptr<osg::RefBlockCount>    _completed;
+
+protected:
+
+    BuildSubtreeOperation& operator = (const BuildSubtreeOperation&) { return *this; }
+};
+
+struct LargerSubtree
+{
+    LargerSubtree(const KdTree& kdTree):
+        _kdTree(kdTree) {}
+
+    bool operator () (const BuildKdTree::Subtree& lhs, const BuildKdTree::Subtree& rhs) const
+    {
+        return _kdTree.getNode(lhs._nodeIndex).second > _kdTree.getNode(rhs._nodeIndex).second;
+    }
+
+    const KdTree& _kdTree;
+
+protected:
+
+    LargerSubtree& operator = (const LargerSubtree&) { return *this; }
+};
+
+void BuildKdTree::buildSubtrees(KdTree::BuildOptions& options, SubtreeList& subtrees)
+{
+    // start with the largest subtrees so that the threads finish together.
+    std::sort(subtrees.begin(), subtrees.end(), LargerSubtree(_kdTree));
+
+    osg::ref_ptr<osg::OperationQueue> operationQueue = new osg::OperationQueue;
+    osg::ref_ptr<osg::RefBlockCount> completed = new osg::RefBlockCount(subtrees.size());
+    completed->reset();
+
+    for(SubtreeList::iterator itr = subtrees.begin();
+        itr != subtrees.end();
+        ++itr)
+    {
+        itr->_nodes.push_back(_kdTree.getNode(itr->_nodeIndex));
+        operationQueue->add(new BuildSubtreeOperation(*this, options, *itr, completed.get()));
+    }
+
+    typedef std::vector< osg::ref_ptr<osg::OperationThread> > OperationThreads;
+    OperationThreads threads;
+    for(unsigned int i=0; i<options._numThreads; ++i)
+    {
+        osg::ref_ptr<osg::OperationThread> thread = new osg::OperationThread;
+        thread->setOperationQueue(operationQueue.get());
+        thread->startThread();
+        threads.push_back(thread);
+    }
+
+    // the calling thread builds subtrees too, then waits for the threads to finish theirs.
+    for(osg::ref_ptr<osg::Operation> operation = operationQueue->getNextOperation(false);
+        operation.valid();
+        operation = operationQueue->getNextOperation(false))
+    {
+        (*operation)(0);
+    }
+
+    while(completed->getCurrentCount()>0)
+    {
+        completed->block();
+    }
+
+    for(OperationThreads::iterator itr = threads.begin();
+        itr != threads.end();
+        ++itr)
+    {
+        (*itr)->cancel();
+    }
+
+    // splice the subtrees in, the first node of each replacing the node it was built from.
+    KdTree::KdNodeList& nodes = _kdTree.getNodes();
+    int numTopNodes = static_cast<int>(nodes.size());
+    for(SubtreeList::iterator itr = subtrees.begin();
+        itr != subtrees.end();
+        ++itr)
+    {
+        int offset = static_cast<int>(nodes.size())-1;
+        for(unsigned int i=0; i<itr->_nodes.size(); ++i)
+        {
+            KdTree::KdNode node = itr->_nodes[i];
+            if (node.first>0)
+            {
+                node.first += offset;
+                node.second += offset;
+            }
+
+            if (i==0) nodes[itr->_nodeIndex] = node;
+            else nodes.push_back(node);
+        }
+    }
+
+    // the bounds of the nodes above the subtrees can now be computed, children always come after their parent.
+    for(int i=numTopNodes-1; i>=0; --i)
+    {
+        KdTree::KdNode& node = nodes[i];
+        if (node.first>0)
+        {
+            node.bb.init();
+            node.bb.expandBy(nodes[node.first].bb);
+            node.bb.expandBy(nodes[node.second].bb);
+        }
+    }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //
 // IntersectKdTree
 //
 struct IntersectKdTree
 {
-    IntersectKdTree(const osg::Vec3Array& vertices,
-                    const KdTree::KdNodeList& nodes,
+    IntersectKdTree(const KdTree& kdTree,
+                    const osg::Vec3Array& vertices,
                     const KdTree::TriangleList& triangles,
                     KdTree::LineSegmentIntersections& intersections,
                     const osg::Vec3d& s, const osg::Vec3d& e):
+                        _kdTree(kdTree),
                         _vertices(vertices),
-                        _kdNodes(nodes),
                         _triangles(triangles),
                         _intersections(intersections),
                         _s(s),
@@ -449,11 +801,15 @@ struct IntersectKdTree
         _d_invZ = _d.z()!=0.0f ? _d/_d.z() : osg::Vec3(0.0f,0.0f,0.0f);
     }
 
-    void intersect(const KdTree::KdNode& node, const osg::Vec3& s, const osg::Vec3& e) const;
+    template<class Node>
+    void intersect(const std::vector<Node>& nodes, const Node& node, const osg::Vec3& s, const osg::Vec3& e) const;
     bool intersectAndClip(osg::Vec3& s, osg::Vec3& e, const osg::BoundingBox& bb) const;
 
+    inline const osg::BoundingBox& getBoundingBox(const KdTree::KdNode& node) const { return node.bb; }
+    inline osg::BoundingBox getBoundingBox(const KdTree::CompactKdNode& node) const { return _kdTree.getBoundingBox(node); }
+
+    const KdTree&                       _kdTree;
     const osg::Vec3Array&               _vertices;
-    const KdTree::KdNodeList&           _kdNodes;
     const KdTree::TriangleList&         _triangles;
     KdTree::LineSegmentIntersections&   _intersections;
 
@@ -475,7 +831,8 @@ protected:
 };
 
 
-void IntersectKdTree::intersect(const KdTree::KdNode& node, const osg::Vec3& ls, const osg::Vec3& le) const
+template<class Node>
+void IntersectKdTree::intersect(const std::vector<Node>& nodes, const Node& node, const osg::Vec3& ls, const osg::Vec3& le) const
 {
     if (node.first<0)
     {
@@ -587,17 +944,17 @@ void IntersectKdTree::intersect(const KdTree::KdNode& node, const osg::Vec3& ls,
         if (node.first>0)
         {
             osg::Vec3 l(ls), e(le);
-            if (intersectAndClip(l,e, _kdNodes[node.first].bb))
+            if (intersectAndClip(l,e, getBoundingBox(nodes[node.first])))
             {
-                intersect(_kdNodes[node.first], l, e);
+                intersect(nodes, nodes[node.first], l, e);
             }
         }
         if (node.second>0)
         {
             osg::Vec3 l(ls), e(le);
-            if (intersectAndClip(l,e, _kdNodes[node.second].bb))
+            if (intersectAndClip(l,e, getBoundingBox(nodes[node.second])))
             {
-                intersect(_kdNodes[node.second], l, e);
+                intersect(nodes, nodes[node.second], l, e);
             }
         }
     }
@@ -738,7 +1095,11 @@ bool IntersectKdTree::intersectAndClip(osg::Vec3& s, osg::Vec3& e, const osg::Bo
 KdTree::BuildOptions::BuildOptions():
         _numVerticesProcessed(0),
         _targetNumTrianglesPerLeaf(4),
-        _maxNumLevels(32)
+        _maxNumLevels(32),
+        _splitMethod(MIDDLE_OF_LONGEST_AXIS),
+        _numSurfaceAreaHeuristicBins(16),
+        _numThreads(0),
+        _compactNodes(false)
 {
 }
 
@@ -754,6 +1115,9 @@ KdTree::KdTree(const KdTree& rhs, const osg::CopyOp& copyop):
     Shape(rhs, copyop),
     _vertices(rhs._vertices),
     _kdNodes(rhs._kdNodes),
+    _compactKdNodes(rhs._compactKdNodes),
+    _compactOrigin(rhs._compactOrigin),
+    _compactScale(rhs._compactScale),
     _triangles(rhs._triangles)
 {
 }
@@ -761,12 +1125,93 @@ KdTree::KdTree(const KdTree& rhs, const osg::CopyOp& copyop):
 bool KdTree::build(BuildOptions& options, osg::Geometry* geometry)
 {
     BuildKdTree build(*this);
-    return build.build(options, geometry);
+    if (!build.build(options, geometry)) return false;
+
+    if (options._compactNodes) compactNodes();
+
+    return true;
+}
+
+void KdTree::compactNodes()
+{
+    if (_kdNodes.empty()) return;
+
+    osg::BoundingBox bb;
+    for(KdNodeList::const_iterator itr = _kdNodes.begin();
+        itr != _kdNodes.end();
+        ++itr)
+    {
+        bb.expandBy(itr->bb);
+    }
+
+    // quantize the bounding boxes to 16 bits per coordinate within the overall bounding box. The scale is widened
+    // until the largest code decodes beyond the overall bounding box, so that every box can be enclosed.
+    const double maxValue = 65535.0;
+    osg::Vec3d inverseScale;
+    _compactOrigin = bb.valid() ? bb._min : osg::Vec3(0.0f,0.0f,0.0f);
+    for(int axis=0; axis<3; ++axis)
+    {
+        double extent = bb.valid() ? double(bb._max[axis])-double(bb._min[axis]) : 0.0;
+        _compactScale[axis] = static_cast<float>(extent/maxValue);
+        while(bb.valid() && _compactOrigin[axis]+_compactScale[axis]*65535.0f<bb._max[axis])
+        {
+            _compactScale[axis] += osg::maximum(_compactScale[axis]*FLT_EPSILON, FLT_MIN);
+        }
+        inverseScale[axis] = _compactScale[axis]>0.0f ? 1.0/double(_compactScale[axis]) : 0.0;
+    }
+
+    _compactKdNodes.resize(_kdNodes.size());
+    for(unsigned int i=0; i<_kdNodes.size(); ++i)
+    {
+        const KdNode& node = _kdNodes[i];
+        CompactKdNode& compactNode = _compactKdNodes[i];
+        compactNode.first = node.first;
+        compactNode.second = node.second;
+
+        if (!node.bb.valid())
+        {
+            // an empty node, encoded as an inverted box.
+            for(int axis=0; axis<3; ++axis)
+            {
+                compactNode.min[axis] = 65535;
+                compactNode.max[axis] = 0;
+            }
+            continue;
+        }
+
+        // round outwards in double precision.
+        for(int axis=0; axis<3; ++axis)
+        {
+            double min = floor((double(node.bb._min[axis])-double(_compactOrigin[axis]))*inverseScale[axis]);
+            double max = ceil((double(node.bb._max[axis])-double(_compactOrigin[axis]))*inverseScale[axis]);
+            compactNode.min[axis] = static_cast<unsigned short>(osg::clampBetween(min, 0.0, maxValue));
+            compactNode.max[axis] = static_cast<unsigned short>(osg::clampBetween(max, 0.0, maxValue));
+        }
+
+        // then check the box decoded as the intersections decode it, widening it by a step wherever the
+        // float round off of the decoding still cuts into the node's box.
+        osg::BoundingBox decoded = getBoundingBox(compactNode);
+        for(int axis=0; axis<3; ++axis)
+        {
+            while(decoded._min[axis]>node.bb._min[axis] && compactNode.min[axis]>0)
+            {
+                --compactNode.min[axis];
+                decoded = getBoundingBox(compactNode);
+            }
+            while(decoded._max[axis]<node.bb._max[axis] && compactNode.max[axis]<65535)
+            {
+                ++compactNode.max[axis];
+                decoded = getBoundingBox(compactNode);
+            }
+        }
+    }
+
+    KdNodeList().swap(_kdNodes);
 }
 
 bool KdTree::intersect(const osg::Vec3d& start, const osg::Vec3d& end, LineSegmentIntersections& intersections) const
 {
-    if (_kdNodes.empty())
+    if (_kdNodes.empty() && _compactKdNodes.empty())
     {
         OSG_NOTICE<<"Warning: _kdTree is empty"<<std::endl;
         return false;
@@ -774,13 +1219,14 @@ bool KdTree::intersect(const osg::Vec3d& start, const osg::Vec3d& end, LineSegme
 
     unsigned int numIntersectionsBefore = intersections.size();
 
-    IntersectKdTree intersector(*_vertices,
-                                _kdNodes,
+    IntersectKdTree intersector(*this,
+                                *_vertices,
                                 _triangles,
                                 intersections,
                                 start, end);
 
-    intersector.intersect(getNode(0), start, end);
+    if (!_compactKdNodes.empty()) intersector.intersect(_compactKdNodes, _compactKdNodes[0], start, end);
+    else intersector.intersect(_kdNodes, getNode(0), start, end);
 
     return numIntersectionsBefore != intersections.size();
 }
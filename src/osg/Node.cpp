@@ -164,6 +164,8 @@ void Node::setStateSet(osg::StateSet* stateset)
     {
         setNumChildrenRequiringEventTraversal(getNumChildrenRequiringEventTraversal()+delta_event);
     }
+
+    dirtyRenderLeafCaches();
 }
 
 osg::StateSet* Node::getOrCreateStateSet()
@@ -395,6 +397,8 @@ void Node::setCullingActive(bool active)
 
     // set the cullingActive itself.
     _cullingActive = active;
+
+    dirtyRenderLeafCaches();
 }
 
 void Node::setNumChildrenWithCullingDisabled(unsigned int num)
@@ -537,6 +541,10 @@ void Node::dirtyBound()
     {
         _boundingSphereComputed = false;
 
+        // the drawables a CullVisitor may have cached for a group depend on the bounds of its subgraph.
+        Group* group = asGroup();
+        if (group) group->dirtyRenderLeafCache();
+
         // dirty parent bounding sphere's to ensure that all are valid.
         for(ParentList::iterator itr=_parents.begin();
             itr!=_parents.end();
@@ -548,6 +556,19 @@ void Node::dirtyBound()
     }
 }
 
+void Node::dirtyRenderLeafCaches()
+{
+    Group* group = asGroup();
+    if (group) group->dirtyRenderLeafCache();
+
+    for(ParentList::iterator itr=_parents.begin();
+        itr!=_parents.end();
+        ++itr)
+    {
+        (*itr)->dirtyRenderLeafCaches();
+    }
+}
+
 void Node::setThreadSafeRefUnref(bool threadSafe)
 {
     Object::setThreadSafeRefUnref(threadSafe);
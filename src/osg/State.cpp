@@ -279,11 +279,9 @@ void State::releaseGLObjects()
     _textureModeMapList.clear();
 
     // release any cached attributes
-    for(AttributeMap::iterator aitr = _attributeMap.begin();
-        aitr != _attributeMap.end();
-        ++aitr)
+    for(unsigned int index=0; index<_attributeMap.size(); ++index)
     {
-        AttributeStack& as = aitr->second;
+        AttributeStack& as = _attributeMap.stack(index);
         if (as.global_default_attribute.valid())
         {
             as.global_default_attribute->releaseGLObjects(this);
@@ -297,11 +295,9 @@ void State::releaseGLObjects()
         ++itr)
     {
         AttributeMap& attributeMap = *itr;
-        for(AttributeMap::iterator aitr = attributeMap.begin();
-            aitr != attributeMap.end();
-            ++aitr)
+        for(unsigned int index=0; index<attributeMap.size(); ++index)
         {
-            AttributeStack& as = aitr->second;
+            AttributeStack& as = attributeMap.stack(index);
             if (as.global_default_attribute.valid())
             {
                 as.global_default_attribute->releaseGLObjects(this);
@@ -317,33 +313,30 @@ void State::reset()
     OSG_NOTICE<<std::endl<<"State::reset() *************************** "<<std::endl;
 
 #if 1
-    for(ModeMap::iterator mitr=_modeMap.begin();
-        mitr!=_modeMap.end();
-        ++mitr)
+    for(unsigned int index=0; index<_modeMap.size(); ++index)
     {
-        ModeStack& ms = mitr->second;
+        ModeStack& ms = _modeMap.stack(index);
         ms.valueVec.clear();
         ms.last_applied_value = !ms.global_default_value;
-        ms.changed = true;
+        _modeMap.setChanged(index);
     }
 #else
     _modeMap.clear();
 #endif
 
-    _modeMap[GL_DEPTH_TEST].global_default_value = true;
-    _modeMap[GL_DEPTH_TEST].changed = true;
+    unsigned int depthTestIndex = _modeMap.index(GL_DEPTH_TEST);
+    _modeMap.stack(depthTestIndex).global_default_value = true;
+    _modeMap.setChanged(depthTestIndex);
 
     // go through all active StateAttribute's, setting to change to force update,
     // the idea is to leave only the global defaults left.
-    for(AttributeMap::iterator aitr=_attributeMap.begin();
-        aitr!=_attributeMap.end();
-        ++aitr)
+    for(unsigned int index=0; index<_attributeMap.size(); ++index)
     {
-        AttributeStack& as = aitr->second;
+        AttributeStack& as = _attributeMap.stack(index);
         as.attributeVec.clear();
         as.last_applied_attribute = NULL;
         as.last_applied_shadercomponent = NULL;
-        as.changed = true;
+        _attributeMap.setChanged(index);
     }
 
     // we can do a straight clear, we arn't interested in GL_DEPTH_TEST defaults in texture modes.
@@ -361,15 +354,13 @@ void State::reset()
     {
         AttributeMap& attributeMap = *tamItr;
         // go through all active StateAttribute's, setting to change to force update.
-        for(AttributeMap::iterator aitr=attributeMap.begin();
-            aitr!=attributeMap.end();
-            ++aitr)
+        for(unsigned int index=0; index<attributeMap.size(); ++index)
         {
-            AttributeStack& as = aitr->second;
+            AttributeStack& as = attributeMap.stack(index);
             as.attributeVec.clear();
             as.last_applied_attribute = NULL;
             as.last_applied_shadercomponent = NULL;
-            as.changed = true;
+            attributeMap.setChanged(index);
         }
     }
 
@@ -400,11 +391,9 @@ void State::reset()
     // what about uniforms??? need to clear them too...
     // go through all active Uniform's, setting to change to force update,
     // the idea is to leave only the global defaults left.
-    for(UniformMap::iterator uitr=_uniformMap.begin();
-        uitr!=_uniformMap.end();
-        ++uitr)
+    for(unsigned int index=0; index<_uniformMap.size(); ++index)
     {
-        UniformStack& us = uitr->second;
+        UniformStack& us = _uniformMap.stack(index);
         us.uniformVec.clear();
     }
 
@@ -576,23 +565,18 @@ void State::captureCurrentState(StateSet& stateset) const
     // empty the stateset first.
     stateset.clear();
 
-    for(ModeMap::const_iterator mitr=_modeMap.begin();
-        mitr!=_modeMap.end();
-        ++mitr)
+    for(unsigned int index=0; index<_modeMap.size(); ++index)
     {
-        // note GLMode = mitr->first
-        const ModeStack& ms = mitr->second;
+        const ModeStack& ms = _modeMap.stack(index);
         if (!ms.valueVec.empty())
         {
-            stateset.setMode(mitr->first,ms.valueVec.back());
+            stateset.setMode(_modeMap.key(index),ms.valueVec.back());
         }
     }
 
-    for(AttributeMap::const_iterator aitr=_attributeMap.begin();
-        aitr!=_attributeMap.end();
-        ++aitr)
+    for(unsigned int index=0; index<_attributeMap.size(); ++index)
     {
-        const AttributeStack& as = aitr->second;
+        const AttributeStack& as = _attributeMap.stack(index);
         if (!as.attributeVec.empty())
         {
             stateset.setAttribute(const_cast<StateAttribute*>(as.attributeVec.back().first));
@@ -749,13 +733,15 @@ void State::applyShaderComposition()
 
             // OSG_NOTICE<<"State::applyShaderComposition() : _attributeMap.size()=="<<_attributeMap.size()<<std::endl;
 
-            for(AttributeMap::iterator itr = _attributeMap.begin();
-                itr != _attributeMap.end();
+            // gather the components in the order of their attribute types, so the composed shaders don't depend on the order the attributes were first applied.
+            const AttributeMap::IndexList& sortedIndices = _attributeMap.getSortedIndices();
+            for(AttributeMap::IndexList::const_iterator itr = sortedIndices.begin();
+                itr != sortedIndices.end();
                 ++itr)
             {
-                // OSG_NOTICE<<"  itr->first="<<itr->first.first<<", "<<itr->first.second<<std::endl;
+                // OSG_NOTICE<<"  type="<<_attributeMap.key(*itr).first<<", "<<_attributeMap.key(*itr).second<<std::endl;
 
-                AttributeStack& as = itr->second;
+                AttributeStack& as = _attributeMap.stack(*itr);
                 if (as.last_applied_shadercomponent)
                 {
                     shaderComponents.push_back(const_cast<ShaderComponent*>(as.last_applied_shadercomponent));
@@ -840,25 +826,26 @@ const StateAttribute* State::getLastAppliedTextureAttribute(unsigned int unit,St
 
 void State::haveAppliedMode(ModeMap& modeMap,StateAttribute::GLMode mode,StateAttribute::GLModeValue value)
 {
-    ModeStack& ms = modeMap[mode];
+    unsigned int index = modeMap.index(mode);
 
-    ms.last_applied_value = value & StateAttribute::ON;
+    modeMap.stack(index).last_applied_value = value & StateAttribute::ON;
 
     // will need to disable this mode on next apply so set it to changed.
-    ms.changed = true;
+    modeMap.setChanged(index);
 }
 
 /** mode has been set externally, update state to reflect this setting.*/
 void State::haveAppliedMode(ModeMap& modeMap,StateAttribute::GLMode mode)
 {
-    ModeStack& ms = modeMap[mode];
+    unsigned int index = modeMap.index(mode);
+    ModeStack& ms = modeMap.stack(index);
 
     // don't know what last applied value is can't apply it.
     // assume that it has changed by toggle the value of last_applied_value.
     ms.last_applied_value = !ms.last_applied_value;
 
     // will need to disable this mode on next apply so set it to changed.
-    ms.changed = true;
+    modeMap.setChanged(index);
 }
 
 /** attribute has been applied externally, update state to reflect this setting.*/
@@ -866,35 +853,34 @@ void State::haveAppliedAttribute(AttributeMap& attributeMap,const StateAttribute
 {
     if (attribute)
     {
-        AttributeStack& as = attributeMap[attribute->getTypeMemberPair()];
+        unsigned int index = attributeMap.index(attribute->getTypeMemberPair());
 
-        as.last_applied_attribute = attribute;
+        attributeMap.stack(index).last_applied_attribute = attribute;
 
         // will need to update this attribute on next apply so set it to changed.
-        as.changed = true;
+        attributeMap.setChanged(index);
     }
 }
 
 void State::haveAppliedAttribute(AttributeMap& attributeMap,StateAttribute::Type type, unsigned int member)
 {
 
-    AttributeMap::iterator itr = attributeMap.find(StateAttribute::TypeMemberPair(type,member));
-    if (itr!=attributeMap.end())
+    unsigned int index = attributeMap.find(StateAttribute::TypeMemberPair(type,member));
+    if (index<attributeMap.size())
     {
-        AttributeStack& as = itr->second;
-        as.last_applied_attribute = 0L;
+        attributeMap.stack(index).last_applied_attribute = 0L;
 
         // will need to update this attribute on next apply so set it to changed.
-        as.changed = true;
+        attributeMap.setChanged(index);
     }
 }
 
 bool State::getLastAppliedMode(const ModeMap& modeMap,StateAttribute::GLMode mode) const
 {
-    ModeMap::const_iterator itr = modeMap.find(mode);
-    if (itr!=modeMap.end())
+    unsigned int index = modeMap.find(mode);
+    if (index<modeMap.size())
     {
-        const ModeStack& ms = itr->second;
+        const ModeStack& ms = modeMap.stack(index);
         return ms.last_applied_value;
     }
     else
@@ -905,10 +891,10 @@ bool State::getLastAppliedMode(const ModeMap& modeMap,StateAttribute::GLMode mod
 
 const StateAttribute* State::getLastAppliedAttribute(const AttributeMap& attributeMap,StateAttribute::Type type, unsigned int member) const
 {
-    AttributeMap::const_iterator itr = attributeMap.find(StateAttribute::TypeMemberPair(type,member));
-    if (itr!=attributeMap.end())
+    unsigned int index = attributeMap.find(StateAttribute::TypeMemberPair(type,member));
+    if (index<attributeMap.size())
     {
-        const AttributeStack& as = itr->second;
+        const AttributeStack& as = attributeMap.stack(index);
         return as.last_applied_attribute;
     }
     else
@@ -919,13 +905,11 @@ const StateAttribute* State::getLastAppliedAttribute(const AttributeMap& attribu
 
 void State::dirtyAllModes()
 {
-    for(ModeMap::iterator mitr=_modeMap.begin();
-        mitr!=_modeMap.end();
-        ++mitr)
+    for(unsigned int index=0; index<_modeMap.size(); ++index)
     {
-        ModeStack& ms = mitr->second;
+        ModeStack& ms = _modeMap.stack(index);
         ms.last_applied_value = !ms.last_applied_value;
-        ms.changed = true;
+        _modeMap.setChanged(index);
 
     }
 
@@ -933,13 +917,11 @@ void State::dirtyAllModes()
         tmmItr!=_textureModeMapList.end();
         ++tmmItr)
     {
-        for(ModeMap::iterator mitr=tmmItr->begin();
-            mitr!=tmmItr->end();
-            ++mitr)
+        for(unsigned int index=0; index<tmmItr->size(); ++index)
         {
-            ModeStack& ms = mitr->second;
+            ModeStack& ms = tmmItr->stack(index);
             ms.last_applied_value = !ms.last_applied_value;
-            ms.changed = true;
+            tmmItr->setChanged(index);
 
         }
     }
@@ -947,13 +929,11 @@ void State::dirtyAllModes()
 
 void State::dirtyAllAttributes()
 {
-    for(AttributeMap::iterator aitr=_attributeMap.begin();
-        aitr!=_attributeMap.end();
-        ++aitr)
+    for(unsigned int index=0; index<_attributeMap.size(); ++index)
     {
-        AttributeStack& as = aitr->second;
+        AttributeStack& as = _attributeMap.stack(index);
         as.last_applied_attribute = 0;
-        as.changed = true;
+        _attributeMap.setChanged(index);
     }
 
 
@@ -962,13 +942,11 @@ void State::dirtyAllAttributes()
         ++tamItr)
     {
         AttributeMap& attributeMap = *tamItr;
-        for(AttributeMap::iterator aitr=attributeMap.begin();
-            aitr!=attributeMap.end();
-            ++aitr)
+        for(unsigned int index=0; index<attributeMap.size(); ++index)
         {
-            AttributeStack& as = aitr->second;
+            AttributeStack& as = attributeMap.stack(index);
             as.last_applied_attribute = 0;
-            as.changed = true;
+            attributeMap.setChanged(index);
         }
     }
 
@@ -1524,34 +1502,34 @@ void State::print(std::ostream& fout) const
         Program::AttribBindingList  _attributeBindingList;
 #endif
         fout<<"ModeMap _modeMap {"<<std::endl;
-        for(ModeMap::const_iterator itr = _modeMap.begin();
-            itr != _modeMap.end();
+        for(ModeMap::IndexList::const_iterator itr = _modeMap.getSortedIndices().begin();
+            itr != _modeMap.getSortedIndices().end();
             ++itr)
         {
-            fout<<"  GLMode="<<itr->first<<", ModeStack {"<<std::endl;
-            itr->second.print(fout);
+            fout<<"  GLMode="<<_modeMap.key(*itr)<<", ModeStack {"<<std::endl;
+            _modeMap.stack(*itr).print(fout);
             fout<<"  }"<<std::endl;
         }
         fout<<"}"<<std::endl;
 
         fout<<"AttributeMap _attributeMap {"<<std::endl;
-        for(AttributeMap::const_iterator itr = _attributeMap.begin();
-            itr != _attributeMap.end();
+        for(AttributeMap::IndexList::const_iterator itr = _attributeMap.getSortedIndices().begin();
+            itr != _attributeMap.getSortedIndices().end();
             ++itr)
         {
-            fout<<"  TypeMemberPaid=("<<itr->first.first<<", "<<itr->first.second<<") AttributeStack {"<<std::endl;
-            itr->second.print(fout);
+            fout<<"  TypeMemberPaid=("<<_attributeMap.key(*itr).first<<", "<<_attributeMap.key(*itr).second<<") AttributeStack {"<<std::endl;
+            _attributeMap.stack(*itr).print(fout);
             fout<<"  }"<<std::endl;
         }
         fout<<"}"<<std::endl;
 
         fout<<"UniformMap _uniformMap {"<<std::endl;
-        for(UniformMap::const_iterator itr = _uniformMap.begin();
-            itr != _uniformMap.end();
+        for(UniformMap::IndexList::const_iterator itr = _uniformMap.getSortedIndices().begin();
+            itr != _uniformMap.getSortedIndices().end();
             ++itr)
         {
-            fout<<"  name="<<itr->first<<", UniformStack {"<<std::endl;
-            itr->second.print(fout);
+            fout<<"  nameID="<<_uniformMap.key(*itr)<<", UniformStack {"<<std::endl;
+            _uniformMap.stack(*itr).print(fout);
             fout<<"  }"<<std::endl;
         }
         fout<<"}"<<std::endl;
@@ -18,21 +18,230 @@
 #include <osgAnimation/BoneMapVisitor>
 #include <osgAnimation/RigGeometry>
 
+#include <algorithm>
+
+#include <OpenThreads/Atomic>
+#include <OpenThreads/Condition>
+#include <OpenThreads/Mutex>
+#include <OpenThreads/ScopedLock>
+#include <OpenThreads/Thread>
+
+#if defined(__SSE__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+    #include <xmmintrin.h>
+    #define OSGANIMATION_SKINNING_SSE 1
+#endif
+
 using namespace osgAnimation;
 
+namespace
+{
+    // vertexes skinned by a single task, and minimal number of vertexes for a threaded skinning
+    const unsigned int SKINNING_TASK_SIZE = 2048;
+    const unsigned int SKINNING_THREAD_THRESHOLD = 4 * SKINNING_TASK_SIZE;
+
+    typedef RigTransformSoftware::PaletteMatrix PaletteMatrix;
+
+    inline void skinVertexes(const PaletteMatrix& matrix, const int* indexes, unsigned int size, const osg::Vec3* src, osg::Vec3* dst, bool isNormal)
+    {
+#ifdef OSGANIMATION_SKINNING_SSE
+        const __m128 row0 = _mm_loadu_ps(matrix._rows[0]);
+        const __m128 row1 = _mm_loadu_ps(matrix._rows[1]);
+        const __m128 row2 = _mm_loadu_ps(matrix._rows[2]);
+        const __m128 row3 = isNormal ? _mm_setzero_ps() : _mm_loadu_ps(matrix._rows[3]);
+        float result[4];
+        for (unsigned int i = 0; i < size; i++)
+        {
+            const osg::Vec3& v = src[indexes[i]];
+            __m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(v.x()), row0),
+                                             _mm_mul_ps(_mm_set1_ps(v.y()), row1)),
+                                  _mm_add_ps(_mm_mul_ps(_mm_set1_ps(v.z()), row2), row3));
+            _mm_storeu_ps(result, r);
+            dst[indexes[i]].set(result[0], result[1], result[2]);
+        }
+#else
+        const float (*m)[4] = matrix._rows;
+        const float tx = isNormal ? 0.0f : m[3][0];
+        const float ty = isNormal ? 0.0f : m[3][1];
+        const float tz = isNormal ? 0.0f : m[3][2];
+        for (unsigned int i = 0; i < size; i++)
+        {
+            const osg::Vec3& v = src[indexes[i]];
+            dst[indexes[i]].set(v.x() * m[0][0] + v.y() * m[1][0] + v.z() * m[2][0] + tx,
+                                v.x() * m[0][1] + v.y() * m[1][1] + v.z() * m[2][1] + ty,
+                                v.x() * m[0][2] + v.y() * m[1][2] + v.z() * m[2][2] + tz);
+        }
+#endif
+    }
+
+    // skins the tasks not yet taken by another thread
+    struct SkinningJob
+    {
+        SkinningJob(const std::vector<RigTransformSoftware::UniqBoneSetVertexSet>& vertexSets,
+                    const std::vector<PaletteMatrix>& palette,
+                    const std::vector<RigTransformSoftware::SkinningTask>& tasks,
+                    const osg::Vec3* positionSrc, osg::Vec3* positionDst,
+                    const osg::Vec3* normalSrc, osg::Vec3* normalDst) :
+            _vertexSets(vertexSets), _palette(palette), _tasks(tasks),
+            _positionSrc(positionSrc), _positionDst(positionDst),
+            _normalSrc(normalSrc), _normalDst(normalDst)
+        {}
+
+        void run()
+        {
+            unsigned int t;
+            while ((t = ++_next - 1) < _tasks.size())
+            {
+                const RigTransformSoftware::SkinningTask& task = _tasks[t];
+                const RigTransformSoftware::VertexList& vertexes = _vertexSets[task._vertexSet].getVertexes();
+                const int* indexes = &vertexes[task._begin];
+                unsigned int size = task._end - task._begin;
+                const PaletteMatrix& matrix = _palette[task._vertexSet];
+
+                if (_positionDst) skinVertexes(matrix, indexes, size, _positionSrc, _positionDst, false);
+                if (_normalDst) skinVertexes(matrix, indexes, size, _normalSrc, _normalDst, true);
+            }
+        }
+
+        const std::vector<RigTransformSoftware::UniqBoneSetVertexSet>& _vertexSets;
+        const std::vector<PaletteMatrix>& _palette;
+        const std::vector<RigTransformSoftware::SkinningTask>& _tasks;
+        const osg::Vec3* _positionSrc;
+        osg::Vec3* _positionDst;
+        const osg::Vec3* _normalSrc;
+        osg::Vec3* _normalDst;
+        OpenThreads::Atomic _next;
+    };
+
+    // worker threads shared by all the software rigs; the calling thread takes part in each job
+    class SkinningThreadPool : public osg::Referenced
+    {
+    public:
+        static SkinningThreadPool* instance()
+        {
+            static osg::ref_ptr<SkinningThreadPool> s_pool = new SkinningThreadPool;
+            return s_pool.get();
+        }
+
+        void run(SkinningJob& job, unsigned int numThreads)
+        {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> runLock(_runMutex);
+            {
+                OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+                while (_workers.size() + 1 < numThreads)
+                {
+                    Worker* worker = new Worker(this, _workers.size(), _generation);
+                    worker->start();
+                    _workers.push_back(worker);
+                }
+                _job = &job;
+                _numActive = numThreads - 1;
+                _pending = _numActive;
+                ++_generation;
+                _start.broadcast();
+            }
+
+            job.run();
+
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+            while (_pending)
+            {
+                _done.wait(&_mutex);
+            }
+            _job = 0;
+        }
+
+    protected:
+        class Worker : public OpenThreads::Thread
+        {
+        public:
+            Worker(SkinningThreadPool* pool, unsigned int index, unsigned int generation) :
+                _pool(pool), _index(index), _generation(generation) {}
+
+            virtual void run()
+            {
+                while (true)
+                {
+                    SkinningJob* job = 0;
+                    {
+                        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_pool->_mutex);
+                        while (!_pool->_quit && _pool->_generation == _generation)
+                        {
+                            _pool->_start.wait(&_pool->_mutex);
+                        }
+                        if (_pool->_quit)
+                            return;
+                        _generation = _pool->_generation;
+                        if (_index < _pool->_numActive)
+                            job = _pool->_job;
+                    }
+
+                    if (job)
+                    {
+                        job->run();
+                        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_pool->_mutex);
+                        if (--_pool->_pending == 0)
+                            _pool->_done.signal();
+                    }
+                }
+            }
+
+        protected:
+            SkinningThreadPool* _pool;
+            unsigned int _index;
+            unsigned int _generation;
+        };
+
+        SkinningThreadPool() : _job(0), _numActive(0), _pending(0), _generation(0), _quit(false) {}
+
+        virtual ~SkinningThreadPool()
+        {
+            {
+                OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+                _quit = true;
+                _start.broadcast();
+            }
+            for (unsigned int i = 0; i < _workers.size(); i++)
+            {
+                _workers[i]->join();
+                delete _workers[i];
+            }
+        }
+
+        OpenThreads::Mutex _runMutex;
+        OpenThreads::Mutex _mutex;
+        OpenThreads::Condition _start;
+        OpenThreads::Condition _done;
+        std::vector<Worker*> _workers;
+        SkinningJob* _job;
+        unsigned int _numActive;
+        unsigned int _pending;
+        unsigned int _generation;
+        bool _quit;
+    };
+}
+
 RigTransformSoftware::RigTransformSoftware()
 {
     _needInit = true;
+    _numVertexes = 0;
+    _numThreads = 1;
 }
 
 RigTransformSoftware::RigTransformSoftware(const RigTransformSoftware& rts,const osg::CopyOp& copyop):
     RigTransform(rts, copyop),
+    _numVertexes(0),
+    _numThreads(rts._numThreads),
     _needInit(rts._needInit),
     _invalidInfluence(rts._invalidInfluence)
 {
 
 }
 
+void RigTransformSoftware::setNumThreads(unsigned int numThreads)
+{
+    _numThreads = numThreads ? numThreads : std::max(OpenThreads::GetNumberOfProcessors(), 1);
+}
+
 bool RigTransformSoftware::init(RigGeometry& geom)
 {
     if (!geom.getSkeleton())
@@ -42,6 +251,7 @@ bool RigTransformSoftware::init(RigGeometry& geom)
     geom.getSkeleton()->accept(mapVisitor);
     BoneMap bm = mapVisitor.getBoneMap();
     initVertexSetFromBones(bm, geom.getVertexInfluenceSet().getUniqVertexSetToBoneSetList());
+    initSkinningTasks();
 
     if (geom.getSourceGeometry())
         geom.copyFrom(*geom.getSourceGeometry());
@@ -79,15 +289,6 @@ void RigTransformSoftware::operator()(RigGeometry& geom)
             }
             *positionDst = *positionSrc;
         }
-        if (!positionDst->empty())
-        {
-            compute<osg::Vec3>(geom.getMatrixFromSkeletonToGeometry(),
-                               geom.getInvMatrixFromSkeletonToGeometry(),
-                               &positionSrc->front(),
-                               &positionDst->front());
-            positionDst->dirty();
-        }
-
     }
 
     osg::Vec3Array* normalSrc = dynamic_cast<osg::Vec3Array*>(source.getNormalArray());
@@ -104,16 +305,73 @@ void RigTransformSoftware::operator()(RigGeometry& geom)
             }
             *normalDst = *normalSrc;
         }
-        if (!normalDst->empty())
-        {
-            computeNormal<osg::Vec3>(geom.getMatrixFromSkeletonToGeometry(),
-                               geom.getInvMatrixFromSkeletonToGeometry(),
-                               &normalSrc->front(),
-                               &normalDst->front());
+    }
+
+    bool hasPositions = positionSrc && !positionDst->empty();
+    bool hasNormals = normalSrc && !normalDst->empty();
+    if (hasPositions || hasNormals)
+    {
+        // bone set matrices are computed once for both streams
+        computePalette(geom.getMatrixFromSkeletonToGeometry(), geom.getInvMatrixFromSkeletonToGeometry());
+        skin(hasPositions ? &positionSrc->front() : 0, hasPositions ? &positionDst->front() : 0,
+             hasNormals ? &normalSrc->front() : 0, hasNormals ? &normalDst->front() : 0);
+
+        if (hasPositions)
+            positionDst->dirty();
+        if (hasNormals)
             normalDst->dirty();
+    }
+}
+
+void RigTransformSoftware::initSkinningTasks()
+{
+    // split the vertex sets in chunks that can be skinned concurrently
+    _tasks.clear();
+    _numVertexes = 0;
+    for (unsigned int i = 0; i < _boneSetVertexSet.size(); i++)
+    {
+        unsigned int size = _boneSetVertexSet[i].getVertexes().size();
+        for (unsigned int begin = 0; begin < size; begin += SKINNING_TASK_SIZE)
+        {
+            _tasks.push_back(SkinningTask(i, begin, std::min(begin + SKINNING_TASK_SIZE, size)));
+        }
+        _numVertexes += size;
+    }
+    _palette.resize(_boneSetVertexSet.size());
+}
+
+void RigTransformSoftware::computePalette(const osg::Matrix& transform, const osg::Matrix& invTransform)
+{
+    for (unsigned int i = 0; i < _boneSetVertexSet.size(); i++)
+    {
+        UniqBoneSetVertexSet& uniq = _boneSetVertexSet[i];
+        uniq.computeMatrixForVertexSet();
+        osg::Matrix matrix = transform * uniq.getMatrix() * invTransform;
+
+        PaletteMatrix& palette = _palette[i];
+        for (unsigned int row = 0; row < 4; row++)
+        {
+            palette._rows[row][0] = static_cast<float>(matrix(row, 0));
+            palette._rows[row][1] = static_cast<float>(matrix(row, 1));
+            palette._rows[row][2] = static_cast<float>(matrix(row, 2));
+            palette._rows[row][3] = 0.0f;
         }
     }
+}
 
+void RigTransformSoftware::skin(const osg::Vec3* positionSrc, osg::Vec3* positionDst, const osg::Vec3* normalSrc, osg::Vec3* normalDst)
+{
+    SkinningJob job(_boneSetVertexSet, _palette, _tasks, positionSrc, positionDst, normalSrc, normalDst);
+
+    unsigned int numThreads = std::min<unsigned int>(_numThreads, _tasks.size());
+    if (numThreads > 1 && _numVertexes >= SKINNING_THREAD_THRESHOLD)
+    {
+        SkinningThreadPool::instance()->run(job, numThreads);
+    }
+    else
+    {
+        job.run();
+    }
 }
 
 void RigTransformSoftware::initVertexSetFromBones(const BoneMap& map, const VertexInfluenceSet::UniqVertexSetToBoneSetList& influence)
@@ -16,7 +16,11 @@
 #include <osgDB/Registry>
 #include <osgDB/Registry>
 #include <osgDB/ObjectWrapper>
+#include <OpenThreads/Atomic>
+#include <OpenThreads/Thread>
+#include <algorithm>
 #include <sstream>
+#include <stdlib.h>
 
 using namespace osgDB;
 
@@ -54,20 +58,36 @@ REGISTER_COMPRESSOR( "null", NullCompressor )
 
 #define CHUNK 32768
 
+// compression level of the zlib based compressors, from the CompressorLevel write option
+static int getCompressorLevel( const Options* options )
+{
+    int level = 6;
+    if ( options )
+    {
+        const std::string& levelString = options->getPluginStringData("CompressorLevel");
+        if ( !levelString.empty() ) level = osg::clampBetween( atoi(levelString.c_str()), 0, 9 );
+    }
+    return level;
+}
+
 // ZLib compressor
+// Write options: CompressorLevel=<0-9> (default 6).
 class ZLibCompressor : public BaseCompressor
 {
 public:
     ZLibCompressor() {}
 
     virtual bool compress( std::ostream& fout, const std::string& src )
+    { return compress( fout, src, 0 ); }
+
+    virtual bool compress( std::ostream& fout, const std::string& src, const Options* options )
     {
         int ret, flush = Z_FINISH;
         unsigned have;
         z_stream strm;
         unsigned char out[CHUNK];
 
-        int level = 6;
+        int level = getCompressorLevel( options );
         int stategy = Z_DEFAULT_STRATEGY;
 
         /* allocate deflate state */
@@ -173,4 +193,229 @@ public:
 
 REGISTER_COMPRESSOR( "zlib", ZLibCompressor )
 
+// Chunked compressor: the stream is cut in blocks deflated independently, so that blocks
+// are compressed and decompressed concurrently. The stream layout is the block size, the
+// number of blocks, the uncompressed and compressed sizes of each block, then the blocks.
+// Write options: CompressorLevel=<0-9> (default 6), CompressorBlockSize=<bytes> (default 1MB,
+// at most 256MB).
+class ChunkedCompressor : public BaseCompressor
+{
+public:
+    ChunkedCompressor() {}
+
+    virtual bool compress( std::ostream& fout, const std::string& src )
+    { return compress( fout, src, 0 ); }
+
+    virtual bool compress( std::ostream& fout, const std::string& src, const Options* options )
+    {
+        int level = getCompressorLevel( options );
+        unsigned int blockSize = 1<<20;
+        if ( options )
+        {
+            const std::string& blockSizeString = options->getPluginStringData("CompressorBlockSize");
+            if ( !blockSizeString.empty() ) blockSize = osg::clampBetween( atoi(blockSizeString.c_str()), 1024, (int)MAX_BLOCK_SIZE );
+        }
+
+        unsigned int numBlocks = (src.size() + blockSize - 1) / blockSize;
+        std::vector<Block> blocks( numBlocks );
+        for ( unsigned int i=0; i<numBlocks; ++i )
+        {
+            blocks[i]._source = src.data() + (size_t)i * blockSize;
+            blocks[i]._sourceSize = std::min( (size_t)blockSize, src.size() - (size_t)i * blockSize );
+        }
+
+        DeflateJob job( blocks, level );
+        if ( !run(job, numBlocks) ) return false;
+
+        fout.write( (char*)&blockSize, INT_SIZE );
+        fout.write( (char*)&numBlocks, INT_SIZE );
+        for ( unsigned int i=0; i<numBlocks; ++i )
+        {
+            unsigned int sizes[2] = { (unsigned int)blocks[i]._sourceSize, (unsigned int)blocks[i]._target.size() };
+            fout.write( (char*)sizes, 2*INT_SIZE );
+        }
+        for ( unsigned int i=0; i<numBlocks; ++i )
+        {
+            fout.write( blocks[i]._target.data(), blocks[i]._target.size() );
+        }
+        return !fout.fail();
+    }
+
+    virtual bool decompress( std::istream& fin, std::string& target )
+    {
+        // the header is validated before anything is allocated from it: sizes must be
+        // consistent with the block size and, when it is known, the remaining stream length
+        std::streamoff remaining = getRemainingLength( fin );
+
+        unsigned int blockSize = 0, numBlocks = 0;
+        fin.read( (char*)&blockSize, INT_SIZE );
+        fin.read( (char*)&numBlocks, INT_SIZE );
+        if ( fin.fail() || blockSize==0 || blockSize>MAX_BLOCK_SIZE ) return false;
+        if ( remaining>=0 )
+        {
+            remaining -= 2*INT_SIZE;
+            if ( (std::streamoff)numBlocks>remaining/(2*INT_SIZE) ) return false;
+            remaining -= (std::streamoff)numBlocks*2*INT_SIZE;
+        }
+
+        // without a known stream length, the table is read by pieces so that its size is
+        // bounded by the data actually present
+        std::vector<unsigned int> sizes;
+        sizes.reserve( 2*std::min(numBlocks, 65536u) );
+        for ( unsigned int i=0; i<numBlocks; ++i )
+        {
+            unsigned int blockSizes[2] = { 0, 0 };
+            fin.read( (char*)blockSizes, 2*INT_SIZE );
+            if ( fin.fail() ) return false;
+            sizes.push_back( blockSizes[0] );
+            sizes.push_back( blockSizes[1] );
+        }
+
+        const size_t maxSourceSize = compressBound( blockSize );
+        size_t targetSize = 0, sourceSize = 0;
+        for ( unsigned int i=0; i<numBlocks; ++i )
+        {
+            size_t uncompressedSize = sizes[2*i], compressedSize = sizes[2*i+1];
+            // deflate cannot expand data more than 1032 times
+            if ( uncompressedSize>blockSize || compressedSize>maxSourceSize ||
+                 uncompressedSize>compressedSize*1032 ) return false;
+            targetSize += uncompressedSize;
+            sourceSize += compressedSize;
+        }
+        if ( remaining>=0 && (std::streamoff)sourceSize>remaining ) return false;
+
+        std::string source( sourceSize, '\0' );
+        if ( sourceSize ) fin.read( &source[0], sourceSize );
+        if ( fin.fail() ) return false;
+
+        target.resize( targetSize );
+        std::vector<Block> blocks( numBlocks );
+        size_t sourceOffset = 0, targetOffset = 0;
+        for ( unsigned int i=0; i<numBlocks; ++i )
+        {
+            blocks[i]._source = source.data() + sourceOffset;
+            blocks[i]._sourceSize = sizes[2*i+1];
+            blocks[i]._destination = &target[0] + targetOffset;
+            blocks[i]._destinationSize = sizes[2*i];
+            sourceOffset += sizes[2*i+1];
+            targetOffset += sizes[2*i];
+        }
+
+        InflateJob job( blocks );
+        return run( job, numBlocks );
+    }
+
+protected:
+    static const unsigned int MAX_BLOCK_SIZE = 1<<28;
+
+    // number of bytes left in the stream, or -1 if the stream cannot tell
+    static std::streamoff getRemainingLength( std::istream& fin )
+    {
+        std::streampos current = fin.tellg();
+        if ( current==std::streampos(-1) ) { fin.clear(); return -1; }
+        fin.seekg( 0, std::ios::end );
+        std::streampos end = fin.tellg();
+        fin.seekg( current );
+        if ( end==std::streampos(-1) || fin.fail() ) { fin.clear(); fin.seekg( current ); return -1; }
+        return end - current;
+    }
+
+    struct Block
+    {
+        Block() : _source(0), _sourceSize(0), _destination(0), _destinationSize(0) {}
+
+        const char* _source;
+        size_t _sourceSize;
+        char* _destination;        // inflated block (decompression)
+        size_t _destinationSize;
+        std::string _target;       // deflated block (compression)
+    };
+
+    struct Job
+    {
+        Job( std::vector<Block>& blocks ) : _blocks(blocks), _failed(0) {}
+        virtual ~Job() {}
+
+        // returns false on error
+        virtual bool process( Block& block ) = 0;
+
+        // processes the blocks not yet taken by another thread
+        void processBlocks()
+        {
+            unsigned int numBlocks = _blocks.size();
+            for ( unsigned int i=(++_next)-1; i<numBlocks; i=(++_next)-1 )
+            {
+                if ( !process(_blocks[i]) ) ++_failed;
+            }
+        }
+
+        std::vector<Block>& _blocks;
+        OpenThreads::Atomic _next;
+        OpenThreads::Atomic _failed;
+    };
+
+    struct DeflateJob : public Job
+    {
+        DeflateJob( std::vector<Block>& blocks, int level ) : Job(blocks), _level(level) {}
+
+        virtual bool process( Block& block )
+        {
+            uLongf size = compressBound( block._sourceSize );
+            block._target.resize( size );
+            if ( compress2((Bytef*)&block._target[0], &size, (const Bytef*)block._source, block._sourceSize, _level)!=Z_OK )
+                return false;
+            block._target.resize( size );
+            return true;
+        }
+
+        int _level;
+    };
+
+    struct InflateJob : public Job
+    {
+        InflateJob( std::vector<Block>& blocks ) : Job(blocks) {}
+
+        virtual bool process( Block& block )
+        {
+            uLongf size = block._destinationSize;
+            return uncompress((Bytef*)block._destination, &size, (const Bytef*)block._source, block._sourceSize)==Z_OK
+                && size==block._destinationSize;
+        }
+    };
+
+    class JobThread : public OpenThreads::Thread
+    {
+    public:
+        JobThread( Job& job ) : _job(job) {}
+
+        virtual void run() { _job.processBlocks(); }
+
+    protected:
+        Job& _job;
+    };
+
+    // processes the blocks with one thread per processor, the calling thread included
+    bool run( Job& job, unsigned int numBlocks )
+    {
+        unsigned int numThreads = std::min( (unsigned int)std::max(OpenThreads::GetNumberOfProcessors(), 1), numBlocks );
+        std::vector<JobThread*> threads;
+        for ( unsigned int i=1; i<numThreads; ++i )
+        {
+            threads.push_back( new JobThread(job) );
+            threads.back()->start();
+        }
+
+        job.processBlocks();
+
+        for ( unsigned int i=0; i<threads.size(); ++i )
+        {
+            threads[i]->join();
+            delete threads[i];
+        }
+        return job._failed==0;
+    }
+};
+
+REGISTER_COMPRESSOR( "chunked", ChunkedCompressor )
+
 #endif
@@ -48,6 +48,7 @@ static osg::ApplicationUsageProxy DatabasePager_e3(osg::ApplicationUsage::ENVIRO
 static osg::ApplicationUsageProxy DatabasePager_e4(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_DATABASE_PAGER_PRIORITY <mode>", "Set the thread priority to DEFAULT, MIN, LOW, NOMINAL, HIGH or MAX.");
 static osg::ApplicationUsageProxy DatabasePager_e11(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_MAX_PAGEDLOD <num>","Set the target maximum number of PagedLOD to maintain.");
 static osg::ApplicationUsageProxy DatabasePager_e12(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_ASSIGN_PBO_TO_IMAGES <ON/OFF>","Set whether PixelBufferObjects should be assigned to Images to aid download to the GPU.");
+static osg::ApplicationUsageProxy DatabasePager_e13(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_DATABASE_PAGER_IMAGE_DECODE_THREADS <num>","Set the number of threads decoding the images of the loaded subgraphs, 0 (the default) reads them inline in the database threads.");
 
 // Convert function objects that take pointer args into functions that a
 // reference to an osg::ref_ptr. This is quite useful for doing STL
@@ -125,6 +126,11 @@ struct DatabasePager::DatabasePagerCompileCompletedCallback : public osgUtil::In
 void DatabasePager::compileCompleted(DatabaseRequest* databaseRequest)
 {
     //OSG_NOTICE<<"DatabasePager::compileCompleted("<<databaseRequest<<")"<<std::endl;
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> drLock(_dr_mutex);
+        databaseRequest->_tickEndCompile = osg::Timer::instance()->tick();
+    }
+
     _dataToCompileList->remove(databaseRequest);
     _dataToMergeList->add(databaseRequest);
 }
@@ -401,11 +407,12 @@ protected:
 //
 struct DatabasePager::SortFileRequestFunctor
 {
-    bool operator() (const osg::ref_ptr<DatabasePager::DatabaseRequest>& lhs,const osg::ref_ptr<DatabasePager::DatabaseRequest>& rhs) const
+    // compares the priorities the requests were queued with, as the last requested ones can change at any time
+    bool operator() (const DatabasePager::DatabaseRequest* lhs, const DatabasePager::DatabaseRequest* rhs) const
     {
-        if (lhs->_timestampLastRequest>rhs->_timestampLastRequest) return true;
-        else if (lhs->_timestampLastRequest<rhs->_timestampLastRequest) return false;
-        else return (lhs->_priorityLastRequest>rhs->_priorityLastRequest);
+        if (lhs->_queueTimestamp>rhs->_queueTimestamp) return true;
+        else if (lhs->_queueTimestamp<rhs->_queueTimestamp) return false;
+        else return (lhs->_queuePriority>rhs->_queuePriority);
     }
 };
 
@@ -437,10 +444,11 @@ DatabasePager::RequestQueue::RequestQueue(DatabasePager* pager):
 DatabasePager::RequestQueue::~RequestQueue()
 {
     OSG_INFO<<"DatabasePager::RequestQueue::~RequestQueue() Destructing queue."<<std::endl;
-    for(RequestList::iterator itr = _requestList.begin();
-        itr != _requestList.end();
+    for(RequestHeap::iterator itr = _requestHeap.begin();
+        itr != _requestHeap.end();
         ++itr)
     {
+        (*itr)->_requestQueue = 0;
         invalidate(itr->get());
     }
 }
@@ -455,10 +463,69 @@ void DatabasePager::RequestQueue::invalidate(DatabaseRequest* dr)
         _pager->getIncrementalCompileOperation()->remove(compileSet.get());
     }
 
-
     dr->invalidate();
 }
 
+void DatabasePager::RequestQueue::place(unsigned int index, DatabaseRequest* databaseRequest)
+{
+    _requestHeap[index] = databaseRequest;
+    databaseRequest->_queueIndex = index;
+}
+
+void DatabasePager::RequestQueue::moveUp(unsigned int index)
+{
+    DatabasePager::SortFileRequestFunctor highPriority;
+
+    osg::ref_ptr<DatabaseRequest> databaseRequest = _requestHeap[index];
+    while(index>0)
+    {
+        unsigned int parent = (index-1)/2;
+        if (!highPriority(databaseRequest.get(), _requestHeap[parent].get())) break;
+
+        place(index, _requestHeap[parent].get());
+        index = parent;
+    }
+    place(index, databaseRequest.get());
+}
+
+void DatabasePager::RequestQueue::moveDown(unsigned int index)
+{
+    DatabasePager::SortFileRequestFunctor highPriority;
+
+    osg::ref_ptr<DatabaseRequest> databaseRequest = _requestHeap[index];
+    unsigned int size = _requestHeap.size();
+    while(true)
+    {
+        unsigned int child = index*2+1;
+        if (child>=size) break;
+        if (child+1<size && highPriority(_requestHeap[child+1].get(), _requestHeap[child].get())) ++child;
+        if (!highPriority(_requestHeap[child].get(), databaseRequest.get())) break;
+
+        place(index, _requestHeap[child].get());
+        index = child;
+    }
+    place(index, databaseRequest.get());
+}
+
+void DatabasePager::RequestQueue::removeNoLock(unsigned int index)
+{
+    // the caller holds _dr_mutex
+    _requestHeap[index]->_requestQueue = 0;
+
+    unsigned int last = _requestHeap.size()-1;
+    if (index!=last)
+    {
+        DatabaseRequest* moved = _requestHeap[last].get();
+        place(index, moved);
+        _requestHeap.pop_back();
+        moveUp(index);
+        if (moved->_queueIndex==index) moveDown(index);
+    }
+    else
+    {
+        _requestHeap.pop_back();
+    }
+}
 
 bool DatabasePager::RequestQueue::pruneOldRequestsAndCheckIfEmpty()
 {
@@ -467,57 +534,72 @@ bool DatabasePager::RequestQueue::pruneOldRequestsAndCheckIfEmpty()
     unsigned int frameNumber = _pager->_frameNumber;
     if (_frameNumberLastPruned != frameNumber)
     {
-        for(RequestQueue::RequestList::iterator citr = _requestList.begin();
-            citr != _requestList.end();
-            )
+        OpenThreads::ScopedLock<OpenThreads::Mutex> drLock(_pager->_dr_mutex);
+
+        // keep the current requests and rebuild the heap from them
+        unsigned int numCurrent = 0;
+        for(unsigned int i=0; i<_requestHeap.size(); ++i)
         {
-            OpenThreads::ScopedLock<OpenThreads::Mutex> drLock(_pager->_dr_mutex);
-            if ((*citr)->isRequestCurrent(frameNumber))
+            DatabaseRequest* databaseRequest = _requestHeap[i].get();
+            if (databaseRequest->isRequestCurrent(frameNumber))
             {
-                ++citr;
+                if (numCurrent!=i) _requestHeap[numCurrent] = databaseRequest;
+                ++numCurrent;
             }
             else
             {
-                invalidate(citr->get());
+                OSG_INFO<<"DatabasePager::RequestQueue::pruneOldRequestsAndCheckIfEmpty(): Pruning "<<databaseRequest<<std::endl;
+
+                // requests pruned once loaded have wasted their load
+                if (databaseRequest->_loadedModel.valid()) ++(_pager->_numWastedLoads);
+                else ++(_pager->_numCancelledRequests);
 
-                OSG_INFO<<"DatabasePager::RequestQueue::pruneOldRequestsAndCheckIfEmpty(): Pruning "<<(*citr)<<std::endl;
-                citr = _requestList.erase(citr);
+                databaseRequest->_requestQueue = 0;
+                invalidate(databaseRequest);
             }
         }
 
+        if (numCurrent!=_requestHeap.size())
+        {
+            _requestHeap.resize(numCurrent);
+            for(unsigned int i=0; i<numCurrent; ++i) _requestHeap[i]->_queueIndex = i;
+            for(unsigned int i=numCurrent/2; i>0; --i) moveDown(i-1);
+        }
+
         _frameNumberLastPruned = frameNumber;
 
         updateBlock();
     }
 
-    return _requestList.empty();
+    return _requestHeap.empty();
 }
 
 bool DatabasePager::RequestQueue::empty()
 {
     OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_requestMutex);
-    return _requestList.empty();
+    return _requestHeap.empty();
 }
 
 unsigned int DatabasePager::RequestQueue::size()
 {
     OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_requestMutex);
-    return _requestList.size();
+    return _requestHeap.size();
 }
 
 void DatabasePager::RequestQueue::clear()
 {
     OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_requestMutex);
 
-    for(RequestList::iterator citr = _requestList.begin();
-        citr != _requestList.end();
+    for(RequestHeap::iterator citr = _requestHeap.begin();
+        citr != _requestHeap.end();
         ++citr)
     {
         OpenThreads::ScopedLock<OpenThreads::Mutex> drLock(_pager->_dr_mutex);
+        (*citr)->_requestQueue = 0;
         invalidate(citr->get());
     }
 
-    _requestList.clear();
+    _requestHeap.clear();
 
     _frameNumberLastPruned = _pager->_frameNumber;
 
@@ -536,79 +618,108 @@ void DatabasePager::RequestQueue::remove(DatabasePager::DatabaseRequest* databas
 {
     // OSG_NOTICE<<"DatabasePager::RequestQueue::remove(DatabaseRequest* databaseRequest)"<<std::endl;
     OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_requestMutex);
-    for(RequestList::iterator citr = _requestList.begin();
-        citr != _requestList.end();
-        ++citr)
+    OpenThreads::ScopedLock<OpenThreads::Mutex> drLock(_pager->_dr_mutex);
+    if (databaseRequest->_requestQueue==this)
     {
-        if (citr->get()==databaseRequest)
-        {
-            // OSG_NOTICE<<"  done remove(DatabaseRequest* databaseRequest)"<<std::endl;
-            _requestList.erase(citr);
-            return;
-        }
+        // OSG_NOTICE<<"  done remove(DatabaseRequest* databaseRequest)"<<std::endl;
+        removeNoLock(databaseRequest->_queueIndex);
+        updateBlock();
     }
 }
 
 
 void DatabasePager::RequestQueue::addNoLock(DatabasePager::DatabaseRequest* databaseRequest)
 {
-    _requestList.push_back(databaseRequest);
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> drLock(_pager->_dr_mutex);
+        if (databaseRequest->_requestQueue==this) return;
+
+        databaseRequest->_requestQueue = this;
+        databaseRequest->_queueTimestamp = databaseRequest->_timestampLastRequest;
+        databaseRequest->_queuePriority = databaseRequest->_priorityLastRequest;
+    }
+
+    _requestHeap.push_back(databaseRequest);
+    databaseRequest->_queueIndex = _requestHeap.size()-1;
+    moveUp(databaseRequest->_queueIndex);
+
     updateBlock();
 }
 
-void DatabasePager::RequestQueue::swap(RequestList& requestList)
+void DatabasePager::RequestQueue::reprioritize(DatabasePager::DatabaseRequest* databaseRequest)
 {
     OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_requestMutex);
-    _requestList.swap(requestList);
+    OpenThreads::ScopedLock<OpenThreads::Mutex> drLock(_pager->_dr_mutex);
+
+    // the request may have been taken out of the queue since it was last requested
+    if (databaseRequest->_requestQueue!=this) return;
+
+    databaseRequest->_queueTimestamp = databaseRequest->_timestampLastRequest;
+    databaseRequest->_queuePriority = databaseRequest->_priorityLastRequest;
+
+    unsigned int index = databaseRequest->_queueIndex;
+    moveUp(index);
+    if (databaseRequest->_queueIndex==index) moveDown(index);
 }
 
-void DatabasePager::RequestQueue::takeFirst(osg::ref_ptr<DatabaseRequest>& databaseRequest)
+void DatabasePager::RequestQueue::swap(RequestList& requestList)
 {
     OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_requestMutex);
 
-    if (!_requestList.empty())
+    RequestList queuedList;
     {
-        DatabasePager::SortFileRequestFunctor highPriority;
+        OpenThreads::ScopedLock<OpenThreads::Mutex> drLock(_pager->_dr_mutex);
+        while(!_requestHeap.empty())
+        {
+            queuedList.push_back(_requestHeap.front());
+            removeNoLock(0);
+        }
+    }
+
+    for(RequestList::iterator itr = requestList.begin();
+        itr != requestList.end();
+        ++itr)
+    {
+        addNoLock(itr->get());
+    }
+
+    requestList.swap(queuedList);
+}
 
-        RequestQueue::RequestList::iterator selected_itr = _requestList.end();
+void DatabasePager::RequestQueue::takeFirst(osg::ref_ptr<DatabaseRequest>& databaseRequest)
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_requestMutex);
 
+    if (!_requestHeap.empty())
+    {
         int frameNumber = _pager->_frameNumber;
 
-        for(RequestQueue::RequestList::iterator citr = _requestList.begin();
-            citr != _requestList.end();
-            )
+        OpenThreads::ScopedLock<OpenThreads::Mutex> drLock(_pager->_dr_mutex);
+
+        // requests no longer requested keep their old timestamp and so sink below the current ones,
+        // prune those that make it to the top
+        while(!_requestHeap.empty() && !databaseRequest.valid())
         {
-            OpenThreads::ScopedLock<OpenThreads::Mutex> drLock(_pager->_dr_mutex);
-            if ((*citr)->isRequestCurrent(frameNumber))
-            {
-                if (selected_itr==_requestList.end() || highPriority(*citr, *selected_itr))
-                {
-                    selected_itr = citr;
-                }
+            osg::ref_ptr<DatabaseRequest> first = _requestHeap.front();
+            removeNoLock(0);
 
-                ++citr;
+            if (first->isRequestCurrent(frameNumber))
+            {
+                databaseRequest = first;
+                OSG_INFO<<" DatabasePager::RequestQueue::takeFirst() Found DatabaseRequest size()="<<_requestHeap.size()<<std::endl;
             }
             else
             {
-                invalidate(citr->get());
+                invalidate(first.get());
+                ++(_pager->_numCancelledRequests);
 
-                OSG_INFO<<"DatabasePager::RequestQueue::takeFirst(): Pruning "<<(*citr)<<std::endl;
-                citr = _requestList.erase(citr);
+                OSG_INFO<<"DatabasePager::RequestQueue::takeFirst(): Pruning "<<first.get()<<std::endl;
             }
-
         }
 
-        _frameNumberLastPruned = frameNumber;
-
-        if (selected_itr != _requestList.end())
-        {
-            databaseRequest = *selected_itr;
-            _requestList.erase(selected_itr);
-            OSG_INFO<<" DatabasePager::RequestQueue::takeFirst() Found DatabaseRequest size()="<<_requestList.size()<<std::endl;
-        }
-        else
+        if (!databaseRequest.valid())
         {
-            OSG_INFO<<" DatabasePager::RequestQueue::takeFirst() No suitable DatabaseRequest found size()="<<_requestList.size()<<std::endl;
+            OSG_INFO<<" DatabasePager::RequestQueue::takeFirst() No suitable DatabaseRequest found size()="<<_requestHeap.size()<<std::endl;
         }
 
         updateBlock();
@@ -628,10 +739,368 @@ DatabasePager::ReadQueue::ReadQueue(DatabasePager* pager, const std::string& nam
 
 void DatabasePager::ReadQueue::updateBlock()
 {
-    _block->set((!_requestList.empty() || !_childrenToDeleteList.empty()) &&
+    _block->set((!_requestHeap.empty() || !_childrenToDeleteList.empty()) &&
                 !_pager->_databasePagerThreadPaused);
 }
 
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  ReadRequestCallback
+//
+namespace
+{
+
+// formats read into plain osg::Image, rather than ImageStream or ImageSequence, so that they can be decoded ahead
+bool isDecodableImageFile(const std::string& fileName)
+{
+    static const char* const extensions[] =
+    {
+        "png", "jpg", "jpeg", "jpe", "bmp", "tga", "tif", "tiff", "rgb", "rgba", "sgi", "int", "inta", "bw",
+        "dds", "ktx", "pnm", "ppm", "pgm", "pbm", "hdr", "jp2", "j2k", 0
+    };
+
+    std::string ext = osgDB::getLowerCaseFileExtension(fileName);
+    for(const char* const* itr = extensions; *itr; ++itr)
+    {
+        if (ext==*itr) return true;
+    }
+    return false;
+}
+
+// move the pixel data of a decoded image into the placeholder image handed out to the reader of the subgraph,
+// leaving the object properties that the reader may have already set on the placeholder. The data is only
+// taken over when nothing else references the decoded image (a ReadFileCallback or a plugin may have cached
+// it), and copied otherwise.
+void transferImage(osg::Image& source, osg::Image& destination)
+{
+    if (source.referenceCount()==1 && source.getAllocationMode()!=osg::Image::NO_DELETE)
+    {
+        destination.setImage(source.s(), source.t(), source.r(),
+                             source.getInternalTextureFormat(), source.getPixelFormat(), source.getDataType(),
+                             source.data(), source.getAllocationMode(),
+                             source.getPacking(), source.getRowLength());
+        source.setAllocationMode(osg::Image::NO_DELETE);
+    }
+    else
+    {
+        unsigned int size = source.getTotalSizeInBytesIncludingMipmaps();
+        unsigned char* data = new unsigned char[size];
+        if (source.isDataContiguous())
+        {
+            memcpy(data, source.data(), size);
+        }
+        else
+        {
+            unsigned char* ptr = data;
+            for(osg::Image::DataIterator itr(&source); itr.valid(); ++itr)
+            {
+                memcpy(ptr, itr.data(), itr.size());
+                ptr += itr.size();
+            }
+        }
+        destination.setImage(source.s(), source.t(), source.r(),
+                             source.getInternalTextureFormat(), source.getPixelFormat(), source.getDataType(),
+                             data, osg::Image::USE_NEW_DELETE,
+                             source.getPacking(), source.isDataContiguous() ? source.getRowLength() : 0);
+    }
+
+    destination.setMipmapLevels(source.getMipmapLevels());
+    destination.setOrigin(source.getOrigin());
+    destination.setPixelAspectRatio(source.getPixelAspectRatio());
+    if (destination.getName().empty()) destination.setName(source.getName());
+    if (!destination.getUserDataContainer() && source.getUserDataContainer()) destination.setUserDataContainer(source.getUserDataContainer());
+}
+
+// detach the placeholders of the images that failed to decode from the textures of a loaded subgraph,
+// leaving the textures without image as if the reader had been handed a null image
+class RemovePlaceholderImagesVisitor : public osg::NodeVisitor
+{
+public:
+    RemovePlaceholderImagesVisitor(const std::set<osg::Image*>& images):
+        osg::NodeVisitor(osg::NodeVisitor::TRAVERSE_ALL_CHILDREN),
+        _images(images) {}
+
+    virtual void apply(osg::Node& node)
+    {
+        removeImages(node.getStateSet());
+        traverse(node);
+    }
+
+    void removeImages(osg::StateSet* stateset)
+    {
+        if (!stateset) return;
+
+        const osg::StateSet::TextureAttributeList& textureAttributes = stateset->getTextureAttributeList();
+        for(osg::StateSet::TextureAttributeList::const_iterator itr = textureAttributes.begin(); itr != textureAttributes.end(); ++itr)
+        {
+            for(osg::StateSet::AttributeList::const_iterator aitr = itr->begin(); aitr != itr->end(); ++aitr)
+            {
+                osg::Texture* texture = aitr->second.first->asTexture();
+                if (!texture) continue;
+
+                for(unsigned int i = 0; i < texture->getNumImages(); ++i)
+                {
+                    if (_images.count(texture->getImage(i))!=0) texture->setImage(i, 0);
+                }
+            }
+        }
+    }
+
+protected:
+
+    const std::set<osg::Image*>& _images;
+};
+
+}
+
+/** ReadFileCallback installed on the options of a subgraph being loaded by a DatabaseThread.
+  * Once the request is no longer current the nested reads of the subgraph return no object, so that an out of date load
+  * stops early rather than running to completion. When given the image decode queue, it also returns placeholder
+  * images to the reader and queues the actual image reads to the image decode threads, so that the images are
+  * decoded concurrently with the parse of the subgraph and with each other. All the other reads are passed on.*/
+class DatabasePager::ReadRequestCallback : public ReadFileCallback
+{
+public:
+
+    ReadRequestCallback(DatabasePager* pager, DatabaseRequest* databaseRequest, osg::OperationQueue* imageDecodeQueue, ReadFileCallback* previousCallback):
+        _pager(pager),
+        _databaseRequest(databaseRequest),
+        _queue(imageDecodeQueue),
+        _previousCallback(previousCallback),
+        _active(true),
+        _cancelled(false),
+        _numPendingImages(0)
+    {
+        // options kept by the subgraphs of earlier loads may still carry a spent callback
+        ReadRequestCallback* previousRequestCallback = dynamic_cast<ReadRequestCallback*>(previousCallback);
+        if (previousRequestCallback) _previousCallback = previousRequestCallback->getPreviousCallback();
+    }
+
+    struct PendingImage : public osg::Referenced
+    {
+        std::string                 _fileName;
+        osg::ref_ptr<const Options> _options;
+        osg::ref_ptr<Options>       _decodeOptions;
+        bool                        _cacheImage;
+        osg::ref_ptr<osg::Image>    _placeholder;
+        osg::ref_ptr<osg::Image>    _image;
+        std::string                 _statusMessage;
+    };
+
+    struct DecodeImageOperation : public osg::Operation
+    {
+        DecodeImageOperation(ReadRequestCallback* callback, PendingImage* pendingImage):
+            osg::Operation("DecodeImage", false),
+            _callback(callback),
+            _pendingImage(pendingImage) {}
+
+        virtual void operator () (osg::Object*)
+        {
+            if (!_callback->isCancelled())
+            {
+                ReaderWriter::ReadResult rr = Registry::instance()->readImage(_pendingImage->_fileName, _pendingImage->_decodeOptions.get());
+                if (rr.validImage()) _pendingImage->_image = rr.getImage();
+                else _pendingImage->_statusMessage = rr.statusMessage();
+            }
+
+            _callback->imageDecoded();
+        }
+
+        osg::ref_ptr<ReadRequestCallback> _callback;
+        osg::ref_ptr<PendingImage>        _pendingImage;
+    };
+
+    ReadFileCallback* getPreviousCallback() { return _previousCallback.get(); }
+
+    /** Return true once the request has stopped being current during the load, the subgraph is then incomplete.*/
+    bool isCancelled()
+    {
+        if (!_cancelled)
+        {
+            // the reference taken on the request is released before requestNodeFile() can check for orphaned requests
+            OpenThreads::ScopedLock<OpenThreads::Mutex> drLock(_pager->_dr_mutex);
+            osg::ref_ptr<DatabaseRequest> databaseRequest;
+            if (!_databaseRequest.lock(databaseRequest) || !databaseRequest->isRequestCurrent(_pager->_frameNumber)) _cancelled = true;
+        }
+        return _cancelled;
+    }
+
+    /** Stop checking the request, the options of the loaded subgraph may keep the callback past the load.*/
+    void loadCompleted() { _active = false; }
+
+    virtual ReaderWriter::ReadResult readImage(const std::string& fileName, const Options* options)
+    {
+        if (_active && isCancelled()) return cancelledResult();
+
+        if (!_active || !_queue.valid() || !isDecodableImageFile(fileName)) return next() ? next()->readImage(fileName, options) : ReadFileCallback::readImage(fileName, options);
+
+        // check the object cache as Registry::readImplementation() would
+        bool cacheImage = options && (options->getObjectCacheHint() & Options::CACHE_IMAGES)!=0;
+        if (cacheImage)
+        {
+            ObjectCache* optionsCache = options->getObjectCache();
+            osg::ref_ptr<osg::Object> object = optionsCache ? optionsCache->getRefFromObjectCache(fileName, options) : 0;
+            if (!object && Registry::instance()->getObjectCache()) object = Registry::instance()->getObjectCache()->getRefFromObjectCache(fileName, options);
+
+            osg::Image* image = dynamic_cast<osg::Image*>(object.get());
+            if (image) return ReaderWriter::ReadResult(image, ReaderWriter::ReadResult::FILE_LOADED_FROM_CACHE);
+        }
+
+        osg::ref_ptr<PendingImage> pendingImage = new PendingImage;
+        pendingImage->_fileName = fileName;
+        pendingImage->_options = options;
+        pendingImage->_decodeOptions = options ? options->cloneOptions() : new Options;
+        pendingImage->_decodeOptions->setReadFileCallback(_previousCallback.get());
+        pendingImage->_decodeOptions->setObjectCacheHint(static_cast<Options::CacheHintOptions>(pendingImage->_decodeOptions->getObjectCacheHint() & ~Options::CACHE_IMAGES));
+        pendingImage->_cacheImage = cacheImage;
+        pendingImage->_placeholder = new osg::Image;
+        pendingImage->_placeholder->setFileName(fileName);
+
+        {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+            _pendingImages.push_back(pendingImage);
+            ++_numPendingImages;
+        }
+
+        _queue->add(new DecodeImageOperation(this, pendingImage.get()));
+
+        return pendingImage->_placeholder.get();
+    }
+
+    /** Wait for the images to be decoded, helping with the queued decodes rather than idling,
+      * then fill in the placeholder images of the loaded subgraph.*/
+    void completeImages(osg::Object* loadedObject)
+    {
+        if (!_queue.valid()) return;
+
+        while(true)
+        {
+            {
+                OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+                if (_numPendingImages==0) break;
+            }
+
+            osg::ref_ptr<osg::Operation> operation = _queue->getNextOperation(false);
+            if (operation.valid())
+            {
+                (*operation)(0);
+            }
+            else
+            {
+                OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+                while(_numPendingImages>0) _imagesDecoded.wait(&_mutex);
+            }
+        }
+
+        // the subgraph of a cancelled request is discarded
+        if (isCancelled())
+        {
+            _pendingImages.clear();
+            return;
+        }
+
+        std::set<osg::Image*> failedImages;
+        for(PendingImages::iterator itr = _pendingImages.begin();
+            itr != _pendingImages.end();
+            ++itr)
+        {
+            PendingImage& pendingImage = **itr;
+            if (!pendingImage._image)
+            {
+                OSG_WARN<<"Error in reading image "<<pendingImage._fileName<<" : "<<pendingImage._statusMessage<<std::endl;
+                failedImages.insert(pendingImage._placeholder.get());
+                continue;
+            }
+
+            transferImage(*pendingImage._image, *pendingImage._placeholder);
+
+            if (pendingImage._cacheImage)
+            {
+                ObjectCache* cache = pendingImage._options->getObjectCache() ? pendingImage._options->getObjectCache() : Registry::instance()->getObjectCache();
+                if (cache) cache->addEntryToObjectCache(pendingImage._fileName, pendingImage._placeholder.get(), 0.0, pendingImage._options.get());
+            }
+        }
+
+        osg::Node* loadedNode = loadedObject ? loadedObject->asNode() : 0;
+        if (!failedImages.empty() && loadedNode)
+        {
+            RemovePlaceholderImagesVisitor rpiv(failedImages);
+            loadedNode->accept(rpiv);
+        }
+        _pendingImages.clear();
+    }
+
+    virtual ReaderWriter::ReadResult openArchive(const std::string& fileName, ReaderWriter::ArchiveStatus status, unsigned int indexBlockSizeHint, const Options* options)
+    {
+        if (_active && isCancelled()) return cancelledResult();
+        return next() ? next()->openArchive(fileName, status, indexBlockSizeHint, options) : ReadFileCallback::openArchive(fileName, status, indexBlockSizeHint, options);
+    }
+
+    virtual ReaderWriter::ReadResult readObject(const std::string& fileName, const Options* options)
+    {
+        if (_active && isCancelled()) return cancelledResult();
+        return next() ? next()->readObject(fileName, options) : ReadFileCallback::readObject(fileName, options);
+    }
+
+    virtual ReaderWriter::ReadResult readHeightField(const std::string& fileName, const Options* options)
+    {
+        if (_active && isCancelled()) return cancelledResult();
+        return next() ? next()->readHeightField(fileName, options) : ReadFileCallback::readHeightField(fileName, options);
+    }
+
+    virtual ReaderWriter::ReadResult readNode(const std::string& fileName, const Options* options)
+    {
+        if (_active && isCancelled()) return cancelledResult();
+        return next() ? next()->readNode(fileName, options) : ReadFileCallback::readNode(fileName, options);
+    }
+
+    virtual ReaderWriter::ReadResult readShader(const std::string& fileName, const Options* options)
+    {
+        if (_active && isCancelled()) return cancelledResult();
+        return next() ? next()->readShader(fileName, options) : ReadFileCallback::readShader(fileName, options);
+    }
+
+    virtual ReaderWriter::ReadResult readScript(const std::string& fileName, const Options* options)
+    {
+        if (_active && isCancelled()) return cancelledResult();
+        return next() ? next()->readScript(fileName, options) : ReadFileCallback::readScript(fileName, options);
+    }
+
+protected:
+
+    virtual ~ReadRequestCallback() {}
+
+    // The nested reads of a cancelled load return no object without an error status, as osgDB::read*File() would
+    // otherwise warn about each of them. The cancellation itself is reported once, at INFO level, by the DatabaseThread.
+    static ReaderWriter::ReadResult cancelledResult() { return ReaderWriter::ReadResult(ReaderWriter::ReadResult::FILE_LOADED); }
+
+    // callback the reads are passed on to, as the Registry would have chosen it without this callback
+    ReadFileCallback* next() const
+    {
+        return _previousCallback.valid() ? _previousCallback.get() : Registry::instance()->getReadFileCallback();
+    }
+
+    void imageDecoded()
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+        if (--_numPendingImages==0) _imagesDecoded.broadcast();
+    }
+
+    typedef std::vector< osg::ref_ptr<PendingImage> > PendingImages;
+
+    DatabasePager*                      _pager;
+    osg::observer_ptr<DatabaseRequest>  _databaseRequest;
+    osg::ref_ptr<osg::OperationQueue>   _queue;
+    osg::ref_ptr<ReadFileCallback>      _previousCallback;
+    volatile bool                       _active;
+    volatile bool                       _cancelled;
+
+    OpenThreads::Mutex                  _mutex;
+    OpenThreads::Condition              _imagesDecoded;
+    PendingImages                       _pendingImages;
+    unsigned int                        _numPendingImages;
+};
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 //
 //  DatabaseThread
@@ -828,7 +1297,7 @@ void DatabasePager::DatabaseThread::run()
                 // need to disable any attempt to use the cache when loading as we're handle this ourselves to avoid threading conflicts
                 {
                     OpenThreads::ScopedLock<OpenThreads::Mutex> drLock(_pager->_dr_mutex);
-                    databaseRequest->_objectCache = new ObjectCache;
+                    databaseRequest->_objectCache = new ObjectCache(1);
                     dr_loadOptions->setObjectCache(databaseRequest->_objectCache.get());
                 }
             }
@@ -905,14 +1374,43 @@ void DatabasePager::DatabaseThread::run()
             //osg::Timer_t before = osg::Timer::instance()->tick();
 
 
+            osg::Timer_t startReadTick = osg::Timer::instance()->tick();
+
+            // cancel the nested reads once the request is out of date, and hand the images over to the
+            // image decode threads rather than reading them inline
+            osg::ref_ptr<ReadRequestCallback> readRequestCallback = new ReadRequestCallback(_pager, databaseRequest.get(), _pager->_imageDecodeQueue.get(), dr_loadOptions->getReadFileCallback());
+            dr_loadOptions->setReadFileCallback(readRequestCallback.get());
+
             // assume that readNode is thread safe...
             ReaderWriter::ReadResult rr = readFromFileCache ?
                         fileCache->readNode(fileName, dr_loadOptions.get(), false) :
                         Registry::instance()->readNode(fileName, dr_loadOptions.get(), false);
 
+            osg::Timer_t endReadTick = osg::Timer::instance()->tick();
+
+            // the subgraph is only complete once its images are decoded.
+            readRequestCallback->completeImages(rr.getObject());
+
+            osg::Timer_t endImageDecodeTick = osg::Timer::instance()->tick();
+
+            // a load cancelled part way through leaves an incomplete subgraph, which is discarded even if requested again since.
+            bool cancelled = readRequestCallback->isCancelled();
+            readRequestCallback->loadCompleted();
+
+            // the options may have been kept by the subgraph
+            dr_loadOptions->setReadFileCallback(readRequestCallback->getPreviousCallback());
+
             osg::ref_ptr<osg::Node> loadedModel;
-            if (rr.validNode()) loadedModel = rr.getNode();
-            if (!rr.success()) OSG_WARN<<"Error in reading file "<<fileName<<" : "<<rr.statusMessage() << std::endl;
+            if (cancelled)
+            {
+                OSG_INFO<<_name<<": DatabaseRequest "<<fileName<<" no longer required, load cancelled."<<std::endl;
+                ++(_pager->_numWastedLoads);
+            }
+            else
+            {
+                if (rr.validNode()) loadedModel = rr.getNode();
+                if (!rr.success()) OSG_WARN<<"Error in reading file "<<fileName<<" : "<<rr.statusMessage() << std::endl;
+            }
 
             if (loadedModel.valid() &&
                 fileCache.valid() &&
@@ -924,10 +1422,11 @@ void DatabasePager::DatabaseThread::run()
 
             {
                 OpenThreads::ScopedLock<OpenThreads::Mutex> drLock(_pager->_dr_mutex);
-                if ((_pager->_frameNumber-databaseRequest->_frameNumberLastRequest)>1)
+                if (loadedModel.valid() && (_pager->_frameNumber-databaseRequest->_frameNumberLastRequest)>1)
                 {
                     OSG_INFO<<_name<<": Warning DatabaseRquest no longer required."<<std::endl;
                     loadedModel = 0;
+                    ++(_pager->_numWastedLoads);
                 }
             }
 
@@ -971,6 +1470,10 @@ void DatabasePager::DatabaseThread::run()
                     OpenThreads::ScopedLock<OpenThreads::Mutex> drLock(_pager->_dr_mutex);
                     databaseRequest->_loadedModel = loadedModel;
                     databaseRequest->_compileSet = compileSet;
+                    databaseRequest->_tickStartRead = startReadTick;
+                    databaseRequest->_tickEndRead = endReadTick;
+                    databaseRequest->_tickEndImageDecode = endImageDecodeTick;
+                    databaseRequest->_tickEndCompile = 0;
                 }
                 // Dereference the databaseRequest while the queue is
                 // locked. This prevents the request from being
@@ -1098,6 +1601,14 @@ DatabasePager::DatabasePager()
                         strcmp(str,"on")==0 || strcmp(str,"ON")==0;
     }
 
+    // deferred image decoding is opt-in: plugins inspecting the images they read while parsing a
+    // subgraph (e.g. for transparency) only see the empty placeholders
+    _numImageDecodeThreads = 0;
+    if( (str = getenv("OSG_DATABASE_PAGER_IMAGE_DECODE_THREADS")) != 0)
+    {
+        _numImageDecodeThreads = atoi(str);
+    }
+
     // initialize the stats variables
     resetStats();
 
@@ -1177,6 +1688,8 @@ DatabasePager::DatabasePager(const DatabasePager& rhs)
 
     _doPreCompile = rhs._doPreCompile;
 
+    _numImageDecodeThreads = rhs._numImageDecodeThreads;
+
     _fileRequestQueue = new ReadQueue(this,"fileRequestQueue");
     _httpRequestQueue = new ReadQueue(this,"httpRequestQueue");
 
@@ -1357,6 +1870,9 @@ int DatabasePager::cancel()
         (*dt_itr)->cancel();
     }
 
+    // the database threads no longer wait for decoded images
+    cancelImageDecodeThreads();
+
     _done = true;
     _startThreadCalled = false;
 
@@ -1378,6 +1894,34 @@ void DatabasePager::clear()
     // _activeGraphicsContexts
 }
 
+void DatabasePager::startImageDecodeThreads()
+{
+    if (_numImageDecodeThreads==0) return;
+
+    _imageDecodeQueue = new osg::OperationQueue;
+    for(unsigned int i=0; i<_numImageDecodeThreads; ++i)
+    {
+        osg::ref_ptr<osg::OperationThread> thread = new osg::OperationThread;
+        thread->setOperationQueue(_imageDecodeQueue.get());
+        thread->setProcessorAffinity(_affinity);
+        thread->startThread();
+        _imageDecodeThreads.push_back(thread);
+    }
+}
+
+void DatabasePager::cancelImageDecodeThreads()
+{
+    for(ImageDecodeThreadList::iterator itr = _imageDecodeThreads.begin();
+        itr != _imageDecodeThreads.end();
+        ++itr)
+    {
+        (*itr)->cancel();
+    }
+
+    _imageDecodeThreads.clear();
+    _imageDecodeQueue = 0;
+}
+
 void DatabasePager::resetStats()
 {
     // initialize the stats variables
@@ -1385,6 +1929,37 @@ void DatabasePager::resetStats()
     _maximumTimeToMergeTile = -DBL_MAX;
     _totalTimeToMergeTiles = 0.0;
     _numTilesMerges = 0;
+
+    for(unsigned int i=0; i<NUMBER_OF_LOAD_STAGES; ++i)
+    {
+        _totalTimeOfLoadStage[i] = 0.0;
+        _maximumTimeOfLoadStage[i] = 0.0;
+        _numLoadStageTimes[i] = 0;
+    }
+
+    _numWastedLoads.exchange(0);
+    _numCancelledRequests.exchange(0);
+}
+
+void DatabasePager::addLoadStageTime(LoadStage stage, double time)
+{
+    _totalTimeOfLoadStage[stage] += time;
+    if (time>_maximumTimeOfLoadStage[stage]) _maximumTimeOfLoadStage[stage] = time;
+    ++_numLoadStageTimes[stage];
+}
+
+void DatabasePager::reportStats(osg::Stats* stats, unsigned int frameNumber) const
+{
+    if (!stats) return;
+
+    stats->setAttribute(frameNumber, "DatabasePager merge time", getAverageTimeToMergeTiles()*1000.0);
+    stats->setAttribute(frameNumber, "DatabasePager request time", getAverageTimeOfLoadStage(REQUEST_STAGE)*1000.0);
+    stats->setAttribute(frameNumber, "DatabasePager read time", getAverageTimeOfLoadStage(READ_STAGE)*1000.0);
+    stats->setAttribute(frameNumber, "DatabasePager image decode time", getAverageTimeOfLoadStage(IMAGE_DECODE_STAGE)*1000.0);
+    stats->setAttribute(frameNumber, "DatabasePager compile time", getAverageTimeOfLoadStage(COMPILE_STAGE)*1000.0);
+    stats->setAttribute(frameNumber, "DatabasePager useful loads", getNumUsefulLoads());
+    stats->setAttribute(frameNumber, "DatabasePager wasted loads", getNumWastedLoads());
+    stats->setAttribute(frameNumber, "DatabasePager cancelled requests", getNumCancelledRequests());
 }
 
 bool DatabasePager::getRequestsInProgress() const
@@ -1470,6 +2045,7 @@ void DatabasePager::requestNodeFile(const std::string& fileName, osg::NodePath&
     {
         DatabaseRequest* databaseRequest = dynamic_cast<DatabaseRequest*>(databaseRequestRef.get());
         bool requeue = false;
+        RequestQueue* requestQueue = 0;
         if (databaseRequest)
         {
             OpenThreads::ScopedLock<OpenThreads::Mutex> drLock(_dr_mutex);
@@ -1491,6 +2067,8 @@ void DatabasePager::requestNodeFile(const std::string& fileName, osg::NodePath&
 
                 foundEntry = true;
 
+                requestQueue = databaseRequest->_requestQueue;
+
                 if (databaseRequestRef->referenceCount()==1)
                 {
                     OSG_INFO<<"DatabasePager::requestNodeFile("<<fileName<<") orphaned, resubmitting."<<std::endl;
@@ -1502,6 +2080,7 @@ void DatabasePager::requestNodeFile(const std::string& fileName, osg::NodePath&
                     databaseRequest->_terrain = terrain;
                     databaseRequest->_loadOptions = loadOptions;
                     databaseRequest->_objectCache = 0;
+                    databaseRequest->_tickEndRead = 0;
                     requeue = true;
                 }
 
@@ -1509,6 +2088,8 @@ void DatabasePager::requestNodeFile(const std::string& fileName, osg::NodePath&
         }
         if (requeue)
             _fileRequestQueue->add(databaseRequest);
+        else if (requestQueue)
+            requestQueue->reprioritize(databaseRequest);
     }
 
     if (!foundEntry)
@@ -1527,6 +2108,7 @@ void DatabasePager::requestNodeFile(const std::string& fileName, osg::NodePath&
             databaseRequest->_fileName = fileName;
             databaseRequest->_frameNumberFirstRequest = frameNumber;
             databaseRequest->_timestampFirstRequest = timestamp;
+            databaseRequest->_tickFirstRequest = osg::Timer::instance()->tick();
             databaseRequest->_priorityFirstRequest = priority;
             databaseRequest->_frameNumberLastRequest = frameNumber;
             databaseRequest->_timestampLastRequest = timestamp;
@@ -1557,6 +2139,8 @@ void DatabasePager::requestNodeFile(const std::string& fileName, osg::NodePath&
                     osg::DisplaySettings::instance()->getNumOfHttpDatabaseThreadsHint());
             }
 
+            startImageDecodeThreads();
+
             for(DatabaseThreadList::const_iterator dt_itr = _databaseThreads.begin();
                 dt_itr != _databaseThreads.end();
                 ++dt_itr)
@@ -1732,10 +2316,23 @@ void DatabasePager::addLoadedDataToSceneGraph(const osg::FrameStamp &frameStamp)
 
             _totalTimeToMergeTiles += timeToMerge;
             ++_numTilesMerges;
+
+            if (databaseRequest->_tickEndRead != 0)
+            {
+                const osg::Timer* timer = osg::Timer::instance();
+                addLoadStageTime(REQUEST_STAGE, timer->delta_s(databaseRequest->_tickFirstRequest, databaseRequest->_tickStartRead));
+                addLoadStageTime(READ_STAGE, timer->delta_s(databaseRequest->_tickStartRead, databaseRequest->_tickEndRead));
+                addLoadStageTime(IMAGE_DECODE_STAGE, timer->delta_s(databaseRequest->_tickEndRead, databaseRequest->_tickEndImageDecode));
+                if (databaseRequest->_tickEndCompile != 0)
+                {
+                    addLoadStageTime(COMPILE_STAGE, timer->delta_s(databaseRequest->_tickEndImageDecode, databaseRequest->_tickEndCompile));
+                }
+            }
         }
         else
         {
             OSG_INFO<<"DatabasePager::addLoadedDataToSceneGraph() node in parental chain deleted, discarding subgaph."<<std::endl;
+            ++_numWastedLoads;
         }
 
         // reset the loadedModel pointer
@@ -16,16 +16,157 @@
 #include <osgDB/FileNameUtils>
 #include <osgDB/ReadFile>
 #include <osgDB/WriteFile>
+#include <osgDB/ConvertUTF>
+#include <osgDB/ObjectWrapper>
+#include <osgDB/Registry>
+#include <osgDB/fstream>
+
+#include <OpenThreads/ScopedLock>
+#include <OpenThreads/Atomic>
+
+#include <sstream>
+#include <stdio.h>
 
 using namespace osgDB;
 
+namespace
+{
+
+inline unsigned long long rotl64(unsigned long long x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+inline unsigned long long fmix64(unsigned long long k)
+{
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdULL;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ULL;
+    k ^= k >> 33;
+    return k;
+}
+
+// 128 bit MurmurHash3 (x64 variant) of the contents, as 32 hexadecimal digits
+std::string hashContent(const std::string& content)
+{
+    const unsigned char* data = reinterpret_cast<const unsigned char*>(content.data());
+    const std::size_t length = content.size();
+    const std::size_t numBlocks = length / 16;
+
+    const unsigned long long c1 = 0x87c37b91114253d5ULL;
+    const unsigned long long c2 = 0x4cf5ad432745937fULL;
+
+    unsigned long long h1 = 0, h2 = 0;
+
+    for(std::size_t i=0; i<numBlocks; ++i)
+    {
+        unsigned long long k1 = 0, k2 = 0;
+        for(int b=7; b>=0; --b) k1 = (k1 << 8) | data[i*16 + b];
+        for(int b=7; b>=0; --b) k2 = (k2 << 8) | data[i*16 + 8 + b];
+
+        k1 *= c1; k1 = rotl64(k1,31); k1 *= c2; h1 ^= k1;
+        h1 = rotl64(h1,27); h1 += h2; h1 = h1*5+0x52dce729;
+
+        k2 *= c2; k2 = rotl64(k2,33); k2 *= c1; h2 ^= k2;
+        h2 = rotl64(h2,31); h2 += h1; h2 = h2*5+0x38495ab5;
+    }
+
+    const unsigned char* tail = data + numBlocks*16;
+    const std::size_t remaining = length & 15;
+    if (remaining>8)
+    {
+        unsigned long long k2 = 0;
+        for(std::size_t i=remaining; i>8; --i) k2 = (k2 << 8) | tail[i-1];
+        k2 *= c2; k2 = rotl64(k2,33); k2 *= c1; h2 ^= k2;
+    }
+    if (remaining>0)
+    {
+        unsigned long long k1 = 0;
+        for(std::size_t i=(remaining<8 ? remaining : 8); i>0; --i) k1 = (k1 << 8) | tail[i-1];
+        k1 *= c1; k1 = rotl64(k1,31); k1 *= c2; h1 ^= k1;
+    }
+
+    h1 ^= length; h2 ^= length;
+    h1 += h2; h2 += h1;
+    h1 = fmix64(h1); h2 = fmix64(h2);
+    h1 += h2; h2 += h1;
+
+    char hex[33];
+    sprintf(hex, "%016llx%016llx", h1, h2);
+    return std::string(hex, 32);
+}
+
+bool readWholeFile(const std::string& fileName, std::string& content)
+{
+    osgDB::ifstream fin(fileName.c_str(), std::ios::in | std::ios::binary);
+    if (!fin) return false;
+
+    std::ostringstream buffer;
+    buffer << fin.rdbuf();
+    content = buffer.str();
+    return !fin.bad();
+}
+
+unsigned long long getFileSize(const std::string& fileName)
+{
+    osgDB::ifstream fin(fileName.c_str(), std::ios::in | std::ios::binary);
+    if (!fin) return 0;
+
+    fin.seekg(0, std::ios::end);
+    std::streamoff size = fin.tellg();
+    return size>0 ? static_cast<unsigned long long>(size) : 0;
+}
+
+// Plugins reading from a stream don't know the file name, so the path of the original file is put first in the
+// database paths, as the plugins do when reading the file itself, for the files it references to be found.
+osg::ref_ptr<Options> createStreamOptions(const std::string& originalFileName, const Options* options)
+{
+    osg::ref_ptr<Options> streamOptions = options ? options->cloneOptions() : new Options;
+    streamOptions->getDatabasePathList().push_front(osgDB::getFilePath(originalFileName));
+    return streamOptions;
+}
+
+bool removeCacheFile(const std::string& fileName)
+{
+#ifdef WIN32
+    return _wremove(OSGDB_STRING_TO_FILENAME(fileName).c_str())==0;
+#else
+    return ::remove(fileName.c_str())==0;
+#endif
+}
+
+bool renameCacheFile(const std::string& from, const std::string& to)
+{
+#ifdef WIN32
+    // rename doesn't replace an existing file on windows
+    _wremove(OSGDB_STRING_TO_FILENAME(to).c_str());
+    return _wrename(OSGDB_STRING_TO_FILENAME(from).c_str(), OSGDB_STRING_TO_FILENAME(to).c_str())==0;
+#else
+    return ::rename(from.c_str(), to.c_str())==0;
+#endif
+}
+
+// makes the temporary file names of concurrent writes of the same contents unique
+OpenThreads::Atomic s_temporaryFileCount;
+
+const unsigned int s_numChangesBetweenIndexWrites = 64;
+
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////
 //
 // FileCache
 //
 FileCache::FileCache(const std::string& path):
     osg::Referenced(true),
-    _fileCachePath(path)
+    _fileCachePath(path),
+    _contentAddressed(false),
+    _maximumSizeInBytes(0),
+    _compressed(false),
+    _indexRead(false),
+    _sizeInBytes(0),
+    _numChangesSinceIndexWritten(0)
 {
     OSG_INFO<<"Constructed FileCache : "<<path<<std::endl;
 }
@@ -33,6 +174,336 @@ FileCache::FileCache(const std::string& path):
 FileCache::~FileCache()
 {
     OSG_INFO<<"Destructed FileCache "<<std::endl;
+
+    if (_numChangesSinceIndexWritten>0) writeIndexNoLock();
+}
+
+void FileCache::setContentAddressed(bool flag)
+{
+    _contentAddressed = flag;
+    if (_contentAddressed && !_indexRead) readIndex();
+}
+
+void FileCache::setMaximumSizeInBytes(unsigned long long size)
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_indexMutex);
+    _maximumSizeInBytes = size;
+    evictNoLock();
+}
+
+unsigned long long FileCache::getSizeInBytes() const
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_indexMutex);
+    return _sizeInBytes;
+}
+
+unsigned int FileCache::getNumFiles() const
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_indexMutex);
+    return _cachedFiles.size();
+}
+
+std::string FileCache::getIndexFileName() const
+{
+    return _fileCachePath + "/index";
+}
+
+void FileCache::readIndex()
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_indexMutex);
+
+    _indexRead = true;
+
+    osgDB::ifstream fin(getIndexFileName().c_str());
+    if (!fin) return;
+
+    // one line per cached file, most recently used first:
+    // compressed <tab> size <tab> extension <tab> content file name <tab> original file name
+    std::string line;
+    while(std::getline(fin, line))
+    {
+        std::string::size_type fields[4];
+        std::string::size_type position = 0;
+        unsigned int numFields = 0;
+        for(; numFields<4; ++numFields)
+        {
+            position = line.find('\t', position);
+            if (position==std::string::npos) break;
+            fields[numFields] = position++;
+        }
+        if (numFields<4) continue;
+
+        bool compressed = line.compare(0, fields[0], "1")==0;
+        unsigned long long size = 0;
+        std::istringstream(std::string(line, fields[0]+1, fields[1]-fields[0]-1)) >> size;
+        std::string extension(line, fields[1]+1, fields[2]-fields[1]-1);
+        std::string contentFileName(line, fields[2]+1, fields[3]-fields[2]-1);
+        std::string originalFileName(line, fields[3]+1, std::string::npos);
+
+        if (_cachedFiles.count(originalFileName)==0)
+        {
+            addCachedFileNoLock(originalFileName, contentFileName, extension, compressed, size);
+
+            // keep the order of the index, the files being added in most recently used first order
+            _lruList.splice(_lruList.end(), _lruList, _lruList.begin());
+        }
+    }
+
+    _numChangesSinceIndexWritten = 0;
+
+    // the maximum size may have been set before the index was read
+    evictNoLock();
+
+    OSG_INFO<<"FileCache::readIndex() "<<_cachedFiles.size()<<" files, "<<_sizeInBytes<<" bytes"<<std::endl;
+}
+
+bool FileCache::writeIndex() const
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_indexMutex);
+    return writeIndexNoLock();
+}
+
+bool FileCache::writeIndexNoLock() const
+{
+    std::string indexFileName = getIndexFileName();
+    std::string temporaryFileName = indexFileName + ".tmp";
+
+    if (!osgDB::fileExists(_fileCachePath) && !osgDB::makeDirectory(_fileCachePath))
+    {
+        OSG_NOTICE<<"Could not create cache directory: "<<_fileCachePath<<std::endl;
+        return false;
+    }
+
+    {
+        osgDB::ofstream fout(temporaryFileName.c_str());
+        for(FileNameList::const_iterator itr = _lruList.begin();
+            itr != _lruList.end();
+            ++itr)
+        {
+            const CachedFile& cachedFile = _cachedFiles.find(*itr)->second;
+            const StoredContent& storedContent = _storedContents.find(cachedFile._contentFileName)->second;
+            fout<<(cachedFile._compressed ? "1" : "0")<<'\t'<<storedContent._size<<'\t'<<cachedFile._extension<<'\t'
+                <<cachedFile._contentFileName<<'\t'<<*itr<<'\n';
+        }
+
+        if (!fout)
+        {
+            OSG_NOTICE<<"Could not write FileCache index: "<<temporaryFileName<<std::endl;
+            return false;
+        }
+    }
+
+    if (!renameCacheFile(temporaryFileName, indexFileName))
+    {
+        OSG_NOTICE<<"Could not replace FileCache index: "<<indexFileName<<std::endl;
+        return false;
+    }
+
+    _numChangesSinceIndexWritten = 0;
+    return true;
+}
+
+void FileCache::addCachedFileNoLock(const std::string& originalFileName, const std::string& contentFileName, const std::string& extension, bool compressed, unsigned long long size) const
+{
+    CachedFileMap::iterator itr = _cachedFiles.find(originalFileName);
+    if (itr!=_cachedFiles.end())
+    {
+        // replace the previous contents of the file, which are still held if just rewritten
+        if (itr->second._contentFileName==contentFileName)
+        {
+            StoredContent& storedContent = _storedContents[contentFileName];
+            _sizeInBytes += size - storedContent._size;
+            storedContent._size = size;
+
+            _lruList.splice(_lruList.begin(), _lruList, itr->second._lruPosition);
+            return;
+        }
+        removeCachedFileNoLock(itr);
+    }
+
+    StoredContent& storedContent = _storedContents[contentFileName];
+    if (storedContent._numFiles==0) _sizeInBytes += size;
+    else _sizeInBytes += size - storedContent._size;
+    storedContent._size = size;
+    ++storedContent._numFiles;
+
+    _lruList.push_front(originalFileName);
+
+    CachedFile& cachedFile = _cachedFiles[originalFileName];
+    cachedFile._contentFileName = contentFileName;
+    cachedFile._extension = extension;
+    cachedFile._compressed = compressed;
+    cachedFile._lruPosition = _lruList.begin();
+}
+
+void FileCache::removeCachedFileNoLock(CachedFileMap::iterator itr) const
+{
+    _lruList.erase(itr->second._lruPosition);
+
+    StoredContentMap::iterator sitr = _storedContents.find(itr->second._contentFileName);
+    if (sitr!=_storedContents.end() && --(sitr->second._numFiles)==0)
+    {
+        // the contents are no longer used by any file
+        removeCacheFile(_fileCachePath + "/" + sitr->first);
+        _sizeInBytes -= sitr->second._size;
+        _storedContents.erase(sitr);
+    }
+
+    _cachedFiles.erase(itr);
+    ++_numChangesSinceIndexWritten;
+}
+
+void FileCache::evictNoLock() const
+{
+    // the most recently used file is kept even if larger than the budget on its own
+    while(_maximumSizeInBytes>0 && _sizeInBytes>_maximumSizeInBytes && _lruList.size()>1)
+    {
+        OSG_INFO<<"FileCache::evict("<<_lruList.back()<<")"<<std::endl;
+        removeCachedFileNoLock(_cachedFiles.find(_lruList.back()));
+    }
+}
+
+ReaderWriter* FileCache::readContent(const std::string& originalFileName, std::string& payload, std::string& cacheFileName) const
+{
+    CachedFile cachedFile;
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_indexMutex);
+        CachedFileMap::iterator itr = _cachedFiles.find(originalFileName);
+        if (itr==_cachedFiles.end()) return 0;
+
+        _lruList.splice(_lruList.begin(), _lruList, itr->second._lruPosition);
+        cachedFile = itr->second;
+    }
+
+    cacheFileName = _fileCachePath + "/" + cachedFile._contentFileName;
+
+    // files cached with the original path layout are read with their plugin by the caller
+    if (cachedFile._extension.empty()) return 0;
+
+    ReaderWriter* rw = osgDB::Registry::instance()->getReaderWriterForExtension(cachedFile._extension);
+
+    std::string content;
+    bool contentRead = rw && readWholeFile(cacheFileName, content);
+    if (contentRead && cachedFile._compressed)
+    {
+        BaseCompressor* compressor = osgDB::Registry::instance()->getObjectWrapperManager()->findCompressor("zlib");
+        std::istringstream istream(content);
+        contentRead = compressor && compressor->decompress(istream, payload);
+    }
+    else
+    {
+        payload.swap(content);
+    }
+
+    if (!contentRead)
+    {
+        OSG_NOTICE<<"FileCache::readContent("<<originalFileName<<") could not read "<<cacheFileName<<", removing it from the cache."<<std::endl;
+
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_indexMutex);
+        CachedFileMap::iterator itr = _cachedFiles.find(originalFileName);
+        if (itr!=_cachedFiles.end() && itr->second._contentFileName==cachedFile._contentFileName) removeCachedFileNoLock(itr);
+
+        cacheFileName.clear();
+        return 0;
+    }
+
+    OSG_INFO<<"FileCache::readContent("<<originalFileName<<") from "<<cacheFileName<<std::endl;
+    return rw;
+}
+
+ReaderWriter* FileCache::getReaderWriterForContent(const std::string& originalFileName) const
+{
+    std::string extension = osgDB::getLowerCaseFileExtension(originalFileName);
+    return extension.empty() ? 0 : osgDB::Registry::instance()->getReaderWriterForExtension(extension);
+}
+
+ReaderWriter::WriteResult FileCache::writeContent(const std::string& originalFileName, const std::string& payload) const
+{
+    std::string content;
+    bool compressed = false;
+    if (_compressed)
+    {
+        BaseCompressor* compressor = osgDB::Registry::instance()->getObjectWrapperManager()->findCompressor("zlib");
+        std::ostringstream ostream;
+        if (compressor && compressor->compress(ostream, payload))
+        {
+            content = ostream.str();
+            compressed = true;
+        }
+    }
+    if (!compressed) content = payload;
+
+    std::string hash = hashContent(content);
+    std::string contentFileName = std::string("objects/") + hash.substr(0,2) + "/" + hash.substr(2) + (compressed ? ".z" : "");
+    std::string cacheFileName = _fileCachePath + "/" + contentFileName;
+
+    bool stored = false;
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_indexMutex);
+        stored = _storedContents.count(contentFileName)!=0;
+    }
+
+    if (!stored)
+    {
+        if (!osgDB::makeDirectoryForFile(cacheFileName))
+        {
+            OSG_NOTICE<<"Could not create cache directory: "<<osgDB::getFilePath(cacheFileName)<<std::endl;
+            return ReaderWriter::WriteResult::ERROR_IN_WRITING_FILE;
+        }
+
+        // written under a temporary name so that a partially written file is never found in the store
+        std::ostringstream temporaryFileName;
+        temporaryFileName<<cacheFileName<<"."<<++s_temporaryFileCount<<".tmp";
+        {
+            osgDB::ofstream fout(temporaryFileName.str().c_str(), std::ios::out | std::ios::binary);
+            fout.write(content.data(), content.size());
+            if (!fout)
+            {
+                OSG_NOTICE<<"Could not write cache file: "<<temporaryFileName.str()<<std::endl;
+                return ReaderWriter::WriteResult::ERROR_IN_WRITING_FILE;
+            }
+        }
+
+        if (!renameCacheFile(temporaryFileName.str(), cacheFileName))
+        {
+            removeCacheFile(temporaryFileName.str());
+            return ReaderWriter::WriteResult::ERROR_IN_WRITING_FILE;
+        }
+    }
+
+    OSG_INFO<<"FileCache::writeContent("<<originalFileName<<") as "<<cacheFileName<<(stored ? ", already stored" : "")<<std::endl;
+
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_indexMutex);
+        addCachedFileNoLock(originalFileName, contentFileName, osgDB::getLowerCaseFileExtension(originalFileName), compressed, content.size());
+        ++_numChangesSinceIndexWritten;
+        evictNoLock();
+        if (_numChangesSinceIndexWritten>=s_numChangesBetweenIndexWrites) writeIndexNoLock();
+    }
+
+    removeFileFromBlackListed(originalFileName);
+
+    return ReaderWriter::WriteResult::FILE_SAVED;
+}
+
+void FileCache::addCachedFile(const std::string& originalFileName, const std::string& cacheFileName) const
+{
+    // files with the original path layout are indexed relative to the cache path
+    std::string cachePath = _fileCachePath + "/";
+    if (cacheFileName.compare(0, cachePath.size(), cachePath)!=0)
+    {
+        OSG_INFO<<"FileCache::addCachedFile("<<originalFileName<<") "<<cacheFileName<<" is not in the cache directory, not indexed."<<std::endl;
+        return;
+    }
+
+    std::string contentFileName(cacheFileName, cachePath.size(), std::string::npos);
+    unsigned long long size = getFileSize(cacheFileName);
+
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_indexMutex);
+    addCachedFileNoLock(originalFileName, contentFileName, std::string(), false, size);
+    ++_numChangesSinceIndexWritten;
+    evictNoLock();
+    if (_numChangesSinceIndexWritten>=s_numChangesBetweenIndexWrites) writeIndexNoLock();
 }
 
 bool FileCache::isFileAppropriateForFileCache(const std::string& originalFileName) const
@@ -54,6 +525,17 @@ std::string FileCache::createCacheFileName(const std::string& originalFileName)
 
 bool FileCache::existsInCache(const std::string& originalFileName) const
 {
+    if (_contentAddressed)
+    {
+        // the index is authoritative, sparing the file system check
+        bool cached = false;
+        {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_indexMutex);
+            cached = _cachedFiles.count(originalFileName)!=0;
+        }
+        return cached && !isCachedFileBlackListed(originalFileName);
+    }
+
     if (osgDB::fileExists(createCacheFileName(originalFileName)))
     {
         return !isCachedFileBlackListed(originalFileName);
@@ -63,8 +545,24 @@ bool FileCache::existsInCache(const std::string& originalFileName) const
 
 ReaderWriter::ReadResult FileCache::readObject(const std::string& originalFileName, const osgDB::Options* options) const
 {
-    std::string cacheFileName = createCacheFileName(originalFileName);
-    if (!cacheFileName.empty() && osgDB::fileExists(cacheFileName))
+    std::string cacheFileName;
+    if (_contentAddressed)
+    {
+        std::string payload;
+        ReaderWriter* rw = readContent(originalFileName, payload, cacheFileName);
+        if (rw)
+        {
+            std::istringstream istream(payload);
+            return rw->readObject(istream, createStreamOptions(originalFileName, options).get());
+        }
+    }
+    else
+    {
+        cacheFileName = createCacheFileName(originalFileName);
+        if (!osgDB::fileExists(cacheFileName)) cacheFileName.clear();
+    }
+
+    if (!cacheFileName.empty())
     {
         OSG_INFO<<"FileCache::readObjectFromCache("<<originalFileName<<") as "<<cacheFileName<<std::endl;
         return osgDB::Registry::instance()->readObject(cacheFileName, options);
@@ -77,6 +575,16 @@ ReaderWriter::ReadResult FileCache::readObject(const std::string& originalFileNa
 
 ReaderWriter::WriteResult FileCache::writeObject(const osg::Object& object, const std::string& originalFileName, const osgDB::Options* options) const
 {
+    ReaderWriter* rw = _contentAddressed ? getReaderWriterForContent(originalFileName) : 0;
+    if (rw)
+    {
+        std::ostringstream ostream;
+        ReaderWriter::WriteResult result = rw->writeObject(object, ostream, options);
+        if (result.success()) return writeContent(originalFileName, ostream.str());
+
+        // plugins that can't write to a stream fall back to the original path layout
+    }
+
     std::string cacheFileName = createCacheFileName(originalFileName);
     if (!cacheFileName.empty())
     {
@@ -92,6 +600,7 @@ ReaderWriter::WriteResult FileCache::writeObject(const osg::Object& object, cons
         ReaderWriter::WriteResult result = osgDB::Registry::instance()->writeObject(object, cacheFileName, options);
         if (result.success())
         {
+            if (_contentAddressed) addCachedFile(originalFileName, cacheFileName);
             removeFileFromBlackListed(originalFileName);
         }
         return result;
@@ -101,8 +610,24 @@ ReaderWriter::WriteResult FileCache::writeObject(const osg::Object& object, cons
 
 ReaderWriter::ReadResult FileCache::readImage(const std::string& originalFileName, const osgDB::Options* options) const
 {
-    std::string cacheFileName = createCacheFileName(originalFileName);
-    if (!cacheFileName.empty() && osgDB::fileExists(cacheFileName))
+    std::string cacheFileName;
+    if (_contentAddressed)
+    {
+        std::string payload;
+        ReaderWriter* rw = readContent(originalFileName, payload, cacheFileName);
+        if (rw)
+        {
+            std::istringstream istream(payload);
+            return rw->readImage(istream, createStreamOptions(originalFileName, options).get());
+        }
+    }
+    else
+    {
+        cacheFileName = createCacheFileName(originalFileName);
+        if (!osgDB::fileExists(cacheFileName)) cacheFileName.clear();
+    }
+
+    if (!cacheFileName.empty())
     {
         OSG_INFO<<"FileCache::readImageFromCache("<<originalFileName<<") as "<<cacheFileName<<std::endl;
         return osgDB::Registry::instance()->readImage(cacheFileName, options);
@@ -115,6 +640,16 @@ ReaderWriter::ReadResult FileCache::readImage(const std::string& originalFileNam
 
 ReaderWriter::WriteResult FileCache::writeImage(const osg::Image& image, const std::string& originalFileName, const osgDB::Options* options) const
 {
+    ReaderWriter* rw = _contentAddressed ? getReaderWriterForContent(originalFileName) : 0;
+    if (rw)
+    {
+        std::ostringstream ostream;
+        ReaderWriter::WriteResult result = rw->writeImage(image, ostream, options);
+        if (result.success()) return writeContent(originalFileName, ostream.str());
+
+        // plugins that can't write to a stream fall back to the original path layout
+    }
+
     std::string cacheFileName = createCacheFileName(originalFileName);
     if (!cacheFileName.empty())
     {
@@ -130,6 +665,7 @@ ReaderWriter::WriteResult FileCache::writeImage(const osg::Image& image, const s
         ReaderWriter::WriteResult result = osgDB::Registry::instance()->writeImage(image, cacheFileName, options);
         if (result.success())
         {
+            if (_contentAddressed) addCachedFile(originalFileName, cacheFileName);
             removeFileFromBlackListed(originalFileName);
         }
         return result;
@@ -139,8 +675,24 @@ ReaderWriter::WriteResult FileCache::writeImage(const osg::Image& image, const s
 
 ReaderWriter::ReadResult FileCache::readHeightField(const std::string& originalFileName, const osgDB::Options* options) const
 {
-    std::string cacheFileName = createCacheFileName(originalFileName);
-    if (!cacheFileName.empty() && osgDB::fileExists(cacheFileName))
+    std::string cacheFileName;
+    if (_contentAddressed)
+    {
+        std::string payload;
+        ReaderWriter* rw = readContent(originalFileName, payload, cacheFileName);
+        if (rw)
+        {
+            std::istringstream istream(payload);
+            return rw->readHeightField(istream, createStreamOptions(originalFileName, options).get());
+        }
+    }
+    else
+    {
+        cacheFileName = createCacheFileName(originalFileName);
+        if (!osgDB::fileExists(cacheFileName)) cacheFileName.clear();
+    }
+
+    if (!cacheFileName.empty())
     {
         OSG_INFO<<"FileCache::readHeightFieldFromCache("<<originalFileName<<") as "<<cacheFileName<<std::endl;
         return osgDB::Registry::instance()->readHeightField(cacheFileName, options);
@@ -153,6 +705,16 @@ ReaderWriter::ReadResult FileCache::readHeightField(const std::string& originalF
 
 ReaderWriter::WriteResult FileCache::writeHeightField(const osg::HeightField& hf, const std::string& originalFileName, const osgDB::Options* options) const
 {
+    ReaderWriter* rw = _contentAddressed ? getReaderWriterForContent(originalFileName) : 0;
+    if (rw)
+    {
+        std::ostringstream ostream;
+        ReaderWriter::WriteResult result = rw->writeHeightField(hf, ostream, options);
+        if (result.success()) return writeContent(originalFileName, ostream.str());
+
+        // plugins that can't write to a stream fall back to the original path layout
+    }
+
     std::string cacheFileName = createCacheFileName(originalFileName);
     if (!cacheFileName.empty())
     {
@@ -168,6 +730,7 @@ ReaderWriter::WriteResult FileCache::writeHeightField(const osg::HeightField& hf
         ReaderWriter::WriteResult result = osgDB::Registry::instance()->writeHeightField(hf, cacheFileName, options);
         if (result.success())
         {
+            if (_contentAddressed) addCachedFile(originalFileName, cacheFileName);
             removeFileFromBlackListed(originalFileName);
         }
         return result;
@@ -177,8 +740,26 @@ ReaderWriter::WriteResult FileCache::writeHeightField(const osg::HeightField& hf
 
 ReaderWriter::ReadResult FileCache::readNode(const std::string& originalFileName, const osgDB::Options* options, bool buildKdTreeIfRequired) const
 {
-    std::string cacheFileName = createCacheFileName(originalFileName);
-    if (!cacheFileName.empty() && osgDB::fileExists(cacheFileName))
+    std::string cacheFileName;
+    if (_contentAddressed)
+    {
+        std::string payload;
+        ReaderWriter* rw = readContent(originalFileName, payload, cacheFileName);
+        if (rw)
+        {
+            std::istringstream istream(payload);
+            ReaderWriter::ReadResult result = rw->readNode(istream, createStreamOptions(originalFileName, options).get());
+            if (buildKdTreeIfRequired) osgDB::Registry::instance()->_buildKdTreeIfRequired(result, options);
+            return result;
+        }
+    }
+    else
+    {
+        cacheFileName = createCacheFileName(originalFileName);
+        if (!osgDB::fileExists(cacheFileName)) cacheFileName.clear();
+    }
+
+    if (!cacheFileName.empty())
     {
         OSG_INFO<<"FileCache::readNodeFromCache("<<originalFileName<<") as "<<cacheFileName<<std::endl;
         return osgDB::Registry::instance()->readNode(cacheFileName, options, buildKdTreeIfRequired);
@@ -191,6 +772,16 @@ ReaderWriter::ReadResult FileCache::readNode(const std::string& originalFileName
 
 ReaderWriter::WriteResult FileCache::writeNode(const osg::Node& node, const std::string& originalFileName, const osgDB::Options* options) const
 {
+    ReaderWriter* rw = _contentAddressed ? getReaderWriterForContent(originalFileName) : 0;
+    if (rw)
+    {
+        std::ostringstream ostream;
+        ReaderWriter::WriteResult result = rw->writeNode(node, ostream, options);
+        if (result.success()) return writeContent(originalFileName, ostream.str());
+
+        // plugins that can't write to a stream fall back to the original path layout
+    }
+
     std::string cacheFileName = createCacheFileName(originalFileName);
     if (!cacheFileName.empty())
     {
@@ -206,6 +797,7 @@ ReaderWriter::WriteResult FileCache::writeNode(const osg::Node& node, const std:
         ReaderWriter::WriteResult result = osgDB::Registry::instance()->writeNode(node, cacheFileName, options);
         if (result.success())
         {
+            if (_contentAddressed) addCachedFile(originalFileName, cacheFileName);
             removeFileFromBlackListed(originalFileName);
         }
         return result;
@@ -216,8 +808,24 @@ ReaderWriter::WriteResult FileCache::writeNode(const osg::Node& node, const std:
 
 ReaderWriter::ReadResult FileCache::readShader(const std::string& originalFileName, const osgDB::Options* options) const
 {
-    std::string cacheFileName = createCacheFileName(originalFileName);
-    if (!cacheFileName.empty() && osgDB::fileExists(cacheFileName))
+    std::string cacheFileName;
+    if (_contentAddressed)
+    {
+        std::string payload;
+        ReaderWriter* rw = readContent(originalFileName, payload, cacheFileName);
+        if (rw)
+        {
+            std::istringstream istream(payload);
+            return rw->readShader(istream, createStreamOptions(originalFileName, options).get());
+        }
+    }
+    else
+    {
+        cacheFileName = createCacheFileName(originalFileName);
+        if (!osgDB::fileExists(cacheFileName)) cacheFileName.clear();
+    }
+
+    if (!cacheFileName.empty())
     {
         OSG_INFO<<"FileCache::readShaderFromCache("<<originalFileName<<") as "<<cacheFileName<<std::endl;
         return osgDB::Registry::instance()->readShader(cacheFileName, options);
@@ -230,6 +838,16 @@ ReaderWriter::ReadResult FileCache::readShader(const std::string& originalFileNa
 
 ReaderWriter::WriteResult FileCache::writeShader(const osg::Shader& shader, const std::string& originalFileName, const osgDB::Options* options) const
 {
+    ReaderWriter* rw = _contentAddressed ? getReaderWriterForContent(originalFileName) : 0;
+    if (rw)
+    {
+        std::ostringstream ostream;
+        ReaderWriter::WriteResult result = rw->writeShader(shader, ostream, options);
+        if (result.success()) return writeContent(originalFileName, ostream.str());
+
+        // plugins that can't write to a stream fall back to the original path layout
+    }
+
     std::string cacheFileName = createCacheFileName(originalFileName);
     if (!cacheFileName.empty())
     {
@@ -245,6 +863,7 @@ ReaderWriter::WriteResult FileCache::writeShader(const osg::Shader& shader, cons
         ReaderWriter::WriteResult result = osgDB::Registry::instance()->writeShader(shader, cacheFileName, options);
         if (result.success())
         {
+            if (_contentAddressed) addCachedFile(originalFileName, cacheFileName);
             removeFileFromBlackListed(originalFileName);
         }
         return result;
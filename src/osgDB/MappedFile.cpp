@@ -0,0 +1,85 @@
+/* -*-c++-*- OpenSceneGraph - Copyright (C) 1998-2006 Robert Osfield
+ *
+ * This library is open source and may be redistributed and/or modified under
+ * the terms of the OpenSceneGraph Public License (OSGPL) version 0.0 or
+ * (at your option) any later version.  The full license is in LICENSE file
+ * included with this distribution, and on the openscenegraph.org website.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * OpenSceneGraph Public License for more details.
+*/
+
+#include <osgDB/MappedFile>
+#include <osgDB/ConvertUTF>
+
+#if defined(_WIN32) && !defined(__CYGWIN__)
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+#else
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+using namespace osgDB;
+
+MappedFile::MappedFile(const std::string& fileName):
+    _data(0),
+    _size(0)
+{
+#if defined(_WIN32) && !defined(__CYGWIN__)
+    #ifdef OSG_USE_UTF8_FILENAME
+    HANDLE file = CreateFileW(convertUTF8toUTF16(fileName).c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    #else
+    HANDLE file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    #endif
+    if (file==INVALID_HANDLE_VALUE) return;
+
+    LARGE_INTEGER size;
+    if (GetFileSizeEx(file, &size) && size.QuadPart>0 && static_cast<unsigned long long>(size.QuadPart)<=static_cast<size_t>(-1))
+    {
+        HANDLE mapping = CreateFileMapping(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mapping)
+        {
+            _data = static_cast<char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+            if (_data) _size = static_cast<size_t>(size.QuadPart);
+            CloseHandle(mapping);
+        }
+    }
+    CloseHandle(file);
+#else
+    int file = open(fileName.c_str(), O_RDONLY);
+    if (file<0) return;
+
+    struct stat status;
+    if (fstat(file, &status)==0 && status.st_size>0)
+    {
+        void* data = mmap(0, status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+        if (data!=MAP_FAILED)
+        {
+            _data = static_cast<char*>(data);
+            _size = status.st_size;
+    #ifdef MADV_SEQUENTIAL
+            // readers go through the file front to back, let the kernel read ahead.
+            madvise(data, _size, MADV_SEQUENTIAL);
+    #endif
+        }
+    }
+    close(file);
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+    if (!_data) return;
+#if defined(_WIN32) && !defined(__CYGWIN__)
+    UnmapViewOfFile(_data);
+#else
+    munmap(_data, _size);
+#endif
+}
@@ -11,9 +11,13 @@
  * OpenSceneGraph Public License for more details.
 */
 
+#include <osg/Geometry>
+#include <osg/Texture>
 #include <osgDB/ObjectCache>
 #include <osgDB/Options>
 
+#include <set>
+
 using namespace osgDB;
 
 bool ObjectCache::ClassComp::operator() (const ObjectCache::FileNameOptionsPair& lhs, const ObjectCache::FileNameOptionsPair& rhs) const
@@ -36,14 +40,104 @@ bool ObjectCache::ClassComp::operator() (const ObjectCache::FileNameOptionsPair&
     return lhs.second < rhs.second;
 }
 
+namespace
+{
+
+class EstimateSizeVisitor : public osg::NodeVisitor
+{
+public:
+
+    EstimateSizeVisitor():
+        osg::NodeVisitor(osg::NodeVisitor::TRAVERSE_ALL_CHILDREN),
+        _sizeInBytes(0) {}
+
+    void apply(osg::Node& node)
+    {
+        applyStateSet(node.getStateSet());
+        traverse(node);
+    }
+
+    void apply(osg::Geometry& geometry)
+    {
+        applyStateSet(geometry.getStateSet());
+
+        osg::Geometry::ArrayList arrays;
+        geometry.getArrayList(arrays);
+        for(osg::Geometry::ArrayList::iterator itr = arrays.begin(); itr != arrays.end(); ++itr)
+        {
+            applyData(itr->get());
+        }
+
+        const osg::Geometry::PrimitiveSetList& primitives = geometry.getPrimitiveSetList();
+        for(osg::Geometry::PrimitiveSetList::const_iterator itr = primitives.begin(); itr != primitives.end(); ++itr)
+        {
+            applyData(itr->get());
+        }
+    }
+
+    void applyStateSet(osg::StateSet* stateset)
+    {
+        if (!stateset || !_visited.insert(stateset).second) return;
+
+        const osg::StateSet::TextureAttributeList& textureAttributes = stateset->getTextureAttributeList();
+        for(osg::StateSet::TextureAttributeList::const_iterator itr = textureAttributes.begin(); itr != textureAttributes.end(); ++itr)
+        {
+            for(osg::StateSet::AttributeList::const_iterator aitr = itr->begin(); aitr != itr->end(); ++aitr)
+            {
+                applyTexture(aitr->second.first->asTexture());
+            }
+        }
+    }
+
+    void applyTexture(osg::Texture* texture)
+    {
+        if (!texture || !_visited.insert(texture).second) return;
+
+        for(unsigned int i = 0; i < texture->getNumImages(); ++i)
+        {
+            applyData(texture->getImage(i));
+        }
+    }
+
+    void applyData(const osg::BufferData* data)
+    {
+        if (data && _visited.insert(data).second) _sizeInBytes += data->getTotalDataSize();
+    }
+
+    std::size_t                     _sizeInBytes;
+    std::set<const osg::Object*>    _visited;
+};
+
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////
 //
 // ObjectCache
 //
-ObjectCache::ObjectCache():
-    osg::Referenced(true)
+ObjectCache::Shard::Shard():
+    _numHits(0),
+    _numMisses(0),
+    _numEvictions(0)
+{
+}
+
+ObjectCache::Shard::~Shard()
+{
+}
+
+ObjectCache::ObjectCache(unsigned int numShards):
+    osg::Referenced(true),
+    _maximumSizeInBytes(0),
+    _sizeInBytes(0)
 {
 //    OSG_NOTICE<<"Constructed ObjectCache"<<std::endl;
+    if (numShards==0) numShards = 1;
+
+    _shards.reserve(numShards);
+    for(unsigned int i=0; i<numShards; ++i)
+    {
+        _shards.push_back(new Shard);
+    }
 }
 
 ObjectCache::~ObjectCache()
@@ -51,33 +145,195 @@ ObjectCache::~ObjectCache()
 //    OSG_NOTICE<<"Destructed ObjectCache"<<std::endl;
 }
 
+ObjectCache::Shard& ObjectCache::getShard(const std::string& fileName) const
+{
+    if (_shards.size()==1) return *_shards.front();
+
+    // FNV-1a hash of the file name, entries for the same file with different Options share a shard.
+    unsigned int hash = 2166136261u;
+    for(std::string::const_iterator itr = fileName.begin(); itr != fileName.end(); ++itr)
+    {
+        hash = (hash ^ static_cast<unsigned char>(*itr)) * 16777619u;
+    }
+    return *_shards[hash % _shards.size()];
+}
+
+ObjectCache::ObjectCacheMap::iterator ObjectCache::find(Shard& shard, const std::string& fileName, const Options* options, bool countAccess)
+{
+    ObjectCacheMap::iterator itr = shard._objectCache.find(FileNameOptionsPair(fileName, options));
+    if (itr!=shard._objectCache.end())
+    {
+        // move the entry to the most recently used end.
+        shard._lru.splice(shard._lru.begin(), shard._lru, itr->second._lruPosition);
+        itr->second._lastAccess = nextAccess();
+        if (countAccess) ++shard._numHits;
+    }
+    else if (countAccess)
+    {
+        ++shard._numMisses;
+    }
+    return itr;
+}
+
+unsigned int ObjectCache::insert(Shard& shard, const FileNameOptionsPair& key, osg::Object* object, double timestamp, std::size_t sizeInBytes, bool replace)
+{
+    std::pair<ObjectCacheMap::iterator, bool> result = shard._objectCache.insert(ObjectCacheMap::value_type(key, ObjectCacheEntry()));
+    ObjectCacheEntry& entry = result.first->second;
+    if (result.second)
+    {
+        shard._lru.push_front(&(result.first->first));
+        entry._lruPosition = shard._lru.begin();
+    }
+    else if (replace)
+    {
+        shard._lru.splice(shard._lru.begin(), shard._lru, entry._lruPosition);
+        removeSizeInBytes(entry._sizeInBytes);
+    }
+    else return 0;
+
+    entry._object = object;
+    entry._timestamp = timestamp;
+    entry._sizeInBytes = sizeInBytes;
+    entry._lastAccess = nextAccess();
+    addSizeInBytes(sizeInBytes);
+
+    return entry._lastAccess;
+}
+
+void ObjectCache::erase(Shard& shard, ObjectCacheMap::iterator itr)
+{
+    removeSizeInBytes(itr->second._sizeInBytes);
+    shard._lru.erase(itr->second._lruPosition);
+    shard._objectCache.erase(itr);
+}
+
+void ObjectCache::evict(unsigned int keptAccess)
+{
+    if (_maximumSizeInBytes==0) return;
+
+    // The shards are locked one at a time, so the oldest entry found may be used or evicted by another thread
+    // before its shard is locked again, in which case the search is repeated, a bounded number of times.
+    unsigned int numRetries = 0;
+    while(getSizeInBytes() > _maximumSizeInBytes)
+    {
+        // look for the least recently used entry of all the shards, comparing the age of their last access
+        // rather than the access counts themselves so that the wrapping of the count is harmless.
+        unsigned int currentAccess = _accessCount;
+        Shard* victimShard = 0;
+        unsigned int victimAccess = 0;
+        int victimAge = 0;
+        for(Shards::iterator sitr = _shards.begin(); sitr != _shards.end(); ++sitr)
+        {
+            Shard& shard = **sitr;
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(shard._objectCacheMutex);
+            if (shard._lru.empty()) continue;
+
+            // the entry just added is kept even if it exceeds the budget on its own
+            unsigned int lastAccess = shard._objectCache.find(*shard._lru.back())->second._lastAccess;
+            if (lastAccess==keptAccess) continue;
+
+            int age = static_cast<int>(currentAccess - lastAccess);
+            if (!victimShard || age > victimAge)
+            {
+                victimShard = &shard;
+                victimAccess = lastAccess;
+                victimAge = age;
+            }
+        }
+
+        if (!victimShard) return;
+
+        {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(victimShard->_objectCacheMutex);
+            if (!victimShard->_lru.empty())
+            {
+                ObjectCacheMap::iterator itr = victimShard->_objectCache.find(*victimShard->_lru.back());
+                if (itr->second._lastAccess==victimAccess)
+                {
+                    OSG_DEBUG<<"Evicting "<<itr->first.first<<" from ObjectCache "<<this<<std::endl;
+                    erase(*victimShard, itr);
+                    ++victimShard->_numEvictions;
+                    continue;
+                }
+            }
+        }
+
+        if (++numRetries > _shards.size()) return;
+    }
+}
+
+void ObjectCache::addSizeInBytes(std::size_t sizeInBytes)
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_sizeMutex);
+    _sizeInBytes += sizeInBytes;
+}
+
+void ObjectCache::removeSizeInBytes(std::size_t sizeInBytes)
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_sizeMutex);
+    _sizeInBytes -= sizeInBytes;
+}
+
+unsigned int ObjectCache::nextAccess()
+{
+    // 0 is reserved for no access
+    unsigned int access = ++_accessCount;
+    return access!=0 ? access : ++_accessCount;
+}
+
 void ObjectCache::addObjectCache(ObjectCache* objectCache)
 {
     // don't allow a cache to be added to itself.
     if (objectCache==this) return;
 
-    // lock both ObjectCache to prevent their contents from being modified by other threads while we merge.
-    OpenThreads::ScopedLock<OpenThreads::Mutex> lock1(_objectCacheMutex);
-    OpenThreads::ScopedLock<OpenThreads::Mutex> lock2(objectCache->_objectCacheMutex);
+    for(Shards::iterator sitr = objectCache->_shards.begin(); sitr != objectCache->_shards.end(); ++sitr)
+    {
+        // copy the shard under its lock so that only one cache is locked at a time.
+        typedef std::vector< std::pair<FileNameOptionsPair, ObjectCacheEntry> > Entries;
+        Entries entries;
+        {
+            Shard& source = **sitr;
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(source._objectCacheMutex);
+            entries.assign(source._objectCache.begin(), source._objectCache.end());
+        }
 
-    OSG_DEBUG<<"Inserting objects to main ObjectCache "<<objectCache->_objectCache.size()<<std::endl;
+        OSG_DEBUG<<"Inserting objects to main ObjectCache "<<entries.size()<<std::endl;
+
+        for(Entries::iterator itr = entries.begin(); itr != entries.end(); ++itr)
+        {
+            Shard& shard = getShard(itr->first.first);
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(shard._objectCacheMutex);
+            insert(shard, itr->first, itr->second._object.get(), itr->second._timestamp, itr->second._sizeInBytes, false);
+        }
 
-    _objectCache.insert(objectCache->_objectCache.begin(), objectCache->_objectCache.end());
+        evict(0);
+    }
 }
 
 
 void ObjectCache::addEntryToObjectCache(const std::string& filename, osg::Object* object, double timestamp, const Options *options)
 {
-    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_objectCacheMutex);
-    _objectCache[FileNameOptionsPair(filename, osg::clone(options))] = ObjectTimeStampPair(object,timestamp);
-    OSG_DEBUG<<"Adding "<<filename<<" with options '"<<(options ? options->getOptionString() : "")<<"' to ObjectCache "<<this<<std::endl;
+    // estimate the size before locking as it may traverse a whole subgraph.
+    std::size_t sizeInBytes = estimateSizeInBytes(object);
+
+    unsigned int access;
+    {
+        Shard& shard = getShard(filename);
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(shard._objectCacheMutex);
+        access = insert(shard, FileNameOptionsPair(filename, osg::clone(options)), object, timestamp, sizeInBytes, true);
+        OSG_DEBUG<<"Adding "<<filename<<" with options '"<<(options ? options->getOptionString() : "")<<"' to ObjectCache "<<this<<std::endl;
+    }
+
+    // evicting takes the other shard locks, so it is done once this one is released
+    evict(access);
 }
 
 osg::Object* ObjectCache::getFromObjectCache(const std::string& fileName, const Options *options)
 {
-    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_objectCacheMutex);
-    ObjectCacheMap::iterator itr = _objectCache.find(FileNameOptionsPair(fileName, options));
-    if (itr!=_objectCache.end())
+    Shard& shard = getShard(fileName);
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(shard._objectCacheMutex);
+    ObjectCacheMap::iterator itr = find(shard, fileName, options, true);
+    if (itr!=shard._objectCache.end())
     {
         osg::ref_ptr<const osgDB::Options> o = itr->first.second;
         if (o.valid())
@@ -88,17 +344,17 @@ osg::Object* ObjectCache::getFromObjectCache(const std::string& fileName, const
         {
             OSG_DEBUG<<"Found "<<fileName<<" in ObjectCache "<<this<<std::endl;
         }
-        return itr->second.first.get();
+        return itr->second._object.get();
     }
     else return 0;
 }
 
 osg::ref_ptr<osg::Object> ObjectCache::getRefFromObjectCache(const std::string& fileName, const Options *options)
 {
-    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_objectCacheMutex);
-    ObjectCacheMap::iterator itr;
-    itr = _objectCache.find(FileNameOptionsPair(fileName, options));
-    if (itr!=_objectCache.end())
+    Shard& shard = getShard(fileName);
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(shard._objectCacheMutex);
+    ObjectCacheMap::iterator itr = find(shard, fileName, options, true);
+    if (itr!=shard._objectCache.end())
     {
         osg::ref_ptr<const osgDB::Options> o = itr->first.second;
         if (o.valid())
@@ -109,70 +365,143 @@ osg::ref_ptr<osg::Object> ObjectCache::getRefFromObjectCache(const std::string&
         {
             OSG_DEBUG<<"Found "<<fileName<<" in ObjectCache "<<this<<std::endl;
         }
-        return itr->second.first.get();
+        return itr->second._object.get();
     }
     else return 0;
 }
 
 void ObjectCache::updateTimeStampOfObjectsInCacheWithExternalReferences(double referenceTime)
 {
-    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_objectCacheMutex);
-
-    // look for objects with external references and update their time stamp.
-    for(ObjectCacheMap::iterator itr=_objectCache.begin();
-        itr!=_objectCache.end();
-        ++itr)
+    for(Shards::iterator sitr = _shards.begin(); sitr != _shards.end(); ++sitr)
     {
-        // if ref count is greater the 1 the object has an external reference.
-        if (itr->second.first->referenceCount()>1)
+        Shard& shard = **sitr;
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(shard._objectCacheMutex);
+
+        // look for objects with external references and update their time stamp.
+        for(ObjectCacheMap::iterator itr=shard._objectCache.begin();
+            itr!=shard._objectCache.end();
+            ++itr)
         {
-            // so update it time stamp.
-            itr->second.second = referenceTime;
+            // if ref count is greater the 1 the object has an external reference.
+            if (itr->second._object->referenceCount()>1)
+            {
+                // so update it time stamp.
+                itr->second._timestamp = referenceTime;
+            }
         }
     }
 }
 
 void ObjectCache::removeExpiredObjectsInCache(double expiryTime)
 {
-    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_objectCacheMutex);
-
-    // Remove expired entries from object cache
-    ObjectCacheMap::iterator oitr = _objectCache.begin();
-    while(oitr != _objectCache.end())
+    for(Shards::iterator sitr = _shards.begin(); sitr != _shards.end(); ++sitr)
     {
-        if (oitr->second.second<=expiryTime)
-        {
-            _objectCache.erase(oitr++);
-        }
-        else
+        Shard& shard = **sitr;
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(shard._objectCacheMutex);
+
+        // Remove expired entries from object cache
+        ObjectCacheMap::iterator oitr = shard._objectCache.begin();
+        while(oitr != shard._objectCache.end())
         {
-            ++oitr;
+            if (oitr->second._timestamp<=expiryTime)
+            {
+                erase(shard, oitr++);
+            }
+            else
+            {
+                ++oitr;
+            }
         }
     }
 }
 
 void ObjectCache::removeFromObjectCache(const std::string& fileName, const Options *options)
 {
-    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_objectCacheMutex);
-    ObjectCacheMap::iterator itr = _objectCache.find(FileNameOptionsPair(fileName, options));
-    if (itr!=_objectCache.end()) _objectCache.erase(itr);
+    Shard& shard = getShard(fileName);
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(shard._objectCacheMutex);
+    ObjectCacheMap::iterator itr = find(shard, fileName, options, false);
+    if (itr!=shard._objectCache.end()) erase(shard, itr);
 }
 
 void ObjectCache::clear()
 {
-    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_objectCacheMutex);
-    _objectCache.clear();
+    for(Shards::iterator sitr = _shards.begin(); sitr != _shards.end(); ++sitr)
+    {
+        Shard& shard = **sitr;
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(shard._objectCacheMutex);
+        while(!shard._objectCache.empty())
+        {
+            erase(shard, shard._objectCache.begin());
+        }
+    }
 }
 
 void ObjectCache::releaseGLObjects(osg::State* state)
 {
-    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_objectCacheMutex);
+    for(Shards::iterator sitr = _shards.begin(); sitr != _shards.end(); ++sitr)
+    {
+        Shard& shard = **sitr;
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(shard._objectCacheMutex);
+
+        for(ObjectCacheMap::iterator itr = shard._objectCache.begin();
+            itr != shard._objectCache.end();
+            ++itr)
+        {
+            osg::Object* object = itr->second._object.get();
+            object->releaseGLObjects(state);
+        }
+    }
+}
+
+std::size_t ObjectCache::getSizeInBytes() const
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_sizeMutex);
+    return _sizeInBytes;
+}
 
-    for(ObjectCacheMap::iterator itr = _objectCache.begin();
-        itr != _objectCache.end();
-        ++itr)
+unsigned int ObjectCache::getNumObjects() const
+{
+    unsigned int numObjects = 0;
+    for(Shards::const_iterator sitr = _shards.begin(); sitr != _shards.end(); ++sitr)
     {
-        osg::Object* object = itr->second.first.get();
-        object->releaseGLObjects(state);
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock((*sitr)->_objectCacheMutex);
+        numObjects += static_cast<unsigned int>((*sitr)->_objectCache.size());
     }
+    return numObjects;
+}
+
+std::size_t ObjectCache::estimateSizeInBytes(const osg::Object* object)
+{
+    if (!object) return 0;
+
+    EstimateSizeVisitor esv;
+    osg::Object* nonConstObject = const_cast<osg::Object*>(object);
+    if (osg::Node* node = nonConstObject->asNode()) node->accept(esv);
+    else if (osg::StateSet* stateset = nonConstObject->asStateSet()) esv.applyStateSet(stateset);
+    else if (osg::StateAttribute* attribute = nonConstObject->asStateAttribute()) esv.applyTexture(attribute->asTexture());
+    else esv.applyData(dynamic_cast<const osg::BufferData*>(object));
+    return esv._sizeInBytes;
+}
+
+void ObjectCache::reportStats(osg::Stats* stats, unsigned int frameNumber) const
+{
+    if (!stats) return;
+
+    unsigned int numHits = 0, numMisses = 0, numEvictions = 0, numObjects = 0;
+    for(Shards::const_iterator sitr = _shards.begin(); sitr != _shards.end(); ++sitr)
+    {
+        const Shard& shard = **sitr;
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(shard._objectCacheMutex);
+        numHits += shard._numHits;
+        numMisses += shard._numMisses;
+        numEvictions += shard._numEvictions;
+        numObjects += static_cast<unsigned int>(shard._objectCache.size());
+    }
+    std::size_t sizeInBytes = getSizeInBytes();
+
+    stats->setAttribute(frameNumber, "ObjectCache hits", numHits);
+    stats->setAttribute(frameNumber, "ObjectCache misses", numMisses);
+    stats->setAttribute(frameNumber, "ObjectCache evictions", numEvictions);
+    stats->setAttribute(frameNumber, "ObjectCache objects", numObjects);
+    stats->setAttribute(frameNumber, "ObjectCache size in bytes", static_cast<double>(sizeInBytes));
 }
@@ -711,6 +711,35 @@ ObjectWrapperManager::ObjectWrapperManager()
 
 ObjectWrapperManager::~ObjectWrapperManager()
 {
+    for ( std::vector<WrapperSnapshot*>::iterator itr=_wrapperSnapshots.begin(); itr!=_wrapperSnapshots.end(); ++itr )
+    {
+        delete *itr;
+    }
+}
+
+void ObjectWrapperManager::publishWrapperSnapshot()
+{
+    // readers may still be looking up in the previous snapshots, so they are only released
+    // with the manager (snapshots are rebuilt once per batch of registered wrappers)
+    WrapperSnapshot* snapshot = new WrapperSnapshot( _wrappers.begin(), _wrappers.end() );
+    _wrapperSnapshots.push_back( snapshot );
+
+    while ( !_wrapperSnapshot.assign(snapshot, _wrapperSnapshot.get()) ) {}
+}
+
+void ObjectWrapperManager::resetWrapperSnapshot()
+{
+    while ( !_wrapperSnapshot.assign(0, _wrapperSnapshot.get()) ) {}
+}
+
+void ObjectWrapperManager::releaseWrapperSnapshots()
+{
+    resetWrapperSnapshot();
+    for ( std::vector<WrapperSnapshot*>::iterator itr=_wrapperSnapshots.begin(); itr!=_wrapperSnapshots.end(); ++itr )
+    {
+        delete *itr;
+    }
+    _wrapperSnapshots.clear();
 }
 
 
@@ -727,6 +756,7 @@ void ObjectWrapperManager::addWrapper( ObjectWrapper* wrapper )
                                << "' already exists." << std::endl;
     }
     _wrappers[wrapper->getName()] = wrapper;
+    resetWrapperSnapshot();
 }
 
 void ObjectWrapperManager::removeWrapper( ObjectWrapper* wrapper )
@@ -737,11 +767,25 @@ void ObjectWrapperManager::removeWrapper( ObjectWrapper* wrapper )
 
     WrapperMap::iterator itr = _wrappers.find( wrapper->getName() );
     if ( itr!=_wrappers.end() ) _wrappers.erase( itr );
+    resetWrapperSnapshot();
+
+    // the wrapper of an unloaded plugin must be destroyed before its code goes away
+    Registry* registry = Registry::instance();
+    if ( registry && registry->isClosingLibraries() ) releaseWrapperSnapshots();
 }
 
 ObjectWrapper* ObjectWrapperManager::findWrapper( const std::string& name )
 {
+    // lock free lookup, falling back to the locked one when the snapshot is outdated or misses
+    const WrapperSnapshot* snapshot = static_cast<const WrapperSnapshot*>( _wrapperSnapshot.get() );
+    if ( snapshot )
+    {
+        WrapperSnapshot::const_iterator itr = snapshot->find( name );
+        if ( itr!=snapshot->end() ) return itr->second.get();
+    }
+
     OpenThreads::ScopedLock<OpenThreads::ReentrantMutex> lock(_wrapperMutex);
+    if ( !_wrapperSnapshot.get() ) publishWrapperSnapshot();
 
     WrapperMap::iterator itr = _wrappers.find( name );
     if ( itr!=_wrappers.end() ) return itr->second.get();
@@ -832,7 +832,7 @@ void OutputStream::compress( std::ostream* ostream )
             return;
         }
 
-        if ( !compressor->compress(*ostream, schemaSource.str() + _compressSource.str()) )
+        if ( !compressor->compress(*ostream, schemaSource.str() + _compressSource.str(), _options.get()) )
             throwException( "OutputStream: Failed to compress stream." );
         if ( getException() ) return;
         _fields.pop_back();
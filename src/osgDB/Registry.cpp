@@ -62,6 +62,10 @@ static osg::ApplicationUsageProxy Registry_e1(osg::ApplicationUsage::ENVIRONMENT
 #endif
 
 static osg::ApplicationUsageProxy Registry_e2(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_BUILD_KDTREES on/off","Enable/disable the automatic building of KdTrees for each loaded Geometry.");
+static osg::ApplicationUsageProxy Registry_e4(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_FILE_CACHE_CONTENT_ADDRESSED <ON/OFF>","Store the files of the OSG_FILE_CACHE once per distinct content, named by a hash of their contents, with an in memory index of the cached files.");
+static osg::ApplicationUsageProxy Registry_e5(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_FILE_CACHE_MAX_SIZE <megabytes>","Maximum size of the content addressed OSG_FILE_CACHE, least recently used files being evicted beyond it.");
+static osg::ApplicationUsageProxy Registry_e6(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_FILE_CACHE_COMPRESS <ON/OFF>","Compress the files written to the content addressed OSG_FILE_CACHE.");
+static osg::ApplicationUsageProxy Registry_e3(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_OBJECT_CACHE_MAX_SIZE <megabytes>","Maximum size of the objects held in the Registry ObjectCache, least recently used objects being evicted beyond it.");
 
 
 // from MimeTypes.cpp
@@ -71,9 +75,8 @@ extern const char* builtinMimeTypeExtMappings[];
 class Registry::AvailableReaderWriterIterator
 {
 public:
-    AvailableReaderWriterIterator(Registry::ReaderWriterList& rwList, OpenThreads::ReentrantMutex& pluginMutex):
-        _rwList(rwList),
-        _pluginMutex(pluginMutex) {}
+    AvailableReaderWriterIterator(Registry& registry):
+        _registry(registry) {}
 
 
     ReaderWriter& operator * () { return *get(); }
@@ -91,16 +94,16 @@ protected:
 
     AvailableReaderWriterIterator& operator = (const AvailableReaderWriterIterator&) { return *this; }
 
-    Registry::ReaderWriterList&     _rwList;
-    OpenThreads::ReentrantMutex&    _pluginMutex;
+    Registry&                       _registry;
 
     std::set<ReaderWriter*>         _rwUsed;
 
     ReaderWriter* get()
     {
-        OpenThreads::ScopedLock<OpenThreads::ReentrantMutex> lock(_pluginMutex);
-        Registry::ReaderWriterList::iterator itr=_rwList.begin();
-        for(;itr!=_rwList.end();++itr)
+        // the current snapshot includes the ReaderWriters of the plugins loaded by the previous attempts
+        const Registry::ReaderWriterSnapshot& rwList = _registry.getReaderWriterSnapshot();
+        Registry::ReaderWriterSnapshot::const_iterator itr=rwList.begin();
+        for(;itr!=rwList.end();++itr)
         {
             if (_rwUsed.find(itr->get())==_rwUsed.end())
             {
@@ -226,6 +229,9 @@ Registry::Registry()
     _buildKdTreesHint = Options::NO_PREFERENCE;
     _kdTreeBuilder = new osg::KdTreeBuilder;
 
+    _closingLibraries = false;
+    publishReaderWriterSnapshot();
+
     const char* kdtree_str = getenv("OSG_BUILD_KDTREES");
     if (kdtree_str)
     {
@@ -247,11 +253,35 @@ Registry::Registry()
     if (fileCachePath)
     {
         _fileCache = new FileCache(fileCachePath);
+
+        if( (ptr = getenv("OSG_FILE_CACHE_COMPRESS")) != 0)
+        {
+            _fileCache->setCompressed(strcmp(ptr,"ON")==0 || strcmp(ptr,"on")==0);
+        }
+
+        // the index of a content addressed cache is read first, so that the maximum size applies to the files it holds
+        if( (ptr = getenv("OSG_FILE_CACHE_CONTENT_ADDRESSED")) != 0)
+        {
+            _fileCache->setContentAddressed(strcmp(ptr,"ON")==0 || strcmp(ptr,"on")==0);
+        }
+
+        if( (ptr = getenv("OSG_FILE_CACHE_MAX_SIZE")) != 0)
+        {
+            double maximumSize = osg::asciiToDouble(ptr);
+            if (maximumSize>0.0) _fileCache->setMaximumSizeInBytes(static_cast<unsigned long long>(maximumSize*1024.0*1024.0));
+        }
     }
 
     // assign ObjectCache.
     _objectCache = new ObjectCache;
 
+    if( (ptr = getenv("OSG_OBJECT_CACHE_MAX_SIZE")) != 0)
+    {
+        double maximumSize = osg::asciiToDouble(ptr);
+        if (maximumSize>0.0) _objectCache->setMaximumSizeInBytes(static_cast<std::size_t>(maximumSize*1024.0*1024.0));
+        OSG_INFO<<"Registry : ObjectCache maximum size = "<<maximumSize<<"MB"<<std::endl;
+    }
+
     _createNodeFromImage = false;
     _openingLibrary = false;
 
@@ -474,6 +504,11 @@ Registry::Registry()
 Registry::~Registry()
 {
     destruct();
+
+    for(std::vector<ReaderWriterSnapshot*>::iterator itr=_rwSnapshots.begin(); itr!=_rwSnapshots.end(); ++itr)
+    {
+        delete *itr;
+    }
 }
 
 void Registry::destruct()
@@ -606,6 +641,7 @@ void Registry::addReaderWriter(ReaderWriter* rw)
 
     _rwList.push_back(rw);
 
+    publishReaderWriterSnapshot();
 }
 
 
@@ -621,10 +657,36 @@ void Registry::removeReaderWriter(ReaderWriter* rw)
     if (rwitr!=_rwList.end())
     {
         _rwList.erase(rwitr);
+        publishReaderWriterSnapshot();
+
+        // the ReaderWriter of an unloaded plugin must be destroyed before its code goes away
+        if (_closingLibraries) releaseReaderWriterSnapshots();
     }
 
 }
 
+void Registry::publishReaderWriterSnapshot()
+{
+    // readers may still be iterating over the previous snapshots, so they are only
+    // released with the registry (plugins are loaded a few times per run), and they
+    // keep the ReaderWriters removed since alive
+    ReaderWriterSnapshot* snapshot = new ReaderWriterSnapshot(_rwList.begin(), _rwList.end());
+    _rwSnapshots.push_back(snapshot);
+
+    while(!_rwSnapshot.assign(snapshot, _rwSnapshot.get())) {}
+}
+
+void Registry::releaseReaderWriterSnapshots()
+{
+    ReaderWriterSnapshot* current = static_cast<ReaderWriterSnapshot*>(_rwSnapshot.get());
+    for(std::vector<ReaderWriterSnapshot*>::iterator itr=_rwSnapshots.begin(); itr!=_rwSnapshots.end(); ++itr)
+    {
+        if (*itr!=current) delete *itr;
+    }
+    _rwSnapshots.clear();
+    _rwSnapshots.push_back(current);
+}
+
 ImageProcessor* Registry::getImageProcessor()
 {
     {
@@ -825,11 +887,16 @@ Registry::LoadStatus Registry::loadLibrary(const std::string& fileName)
 
 bool Registry::closeLibrary(const std::string& fileName)
 {
+    releaseRetiredSnapshots();
+
     OpenThreads::ScopedLock<OpenThreads::ReentrantMutex> lock(_pluginMutex);
     DynamicLibraryList::iterator ditr = getLibraryItr(fileName);
     if (ditr!=_dlList.end())
     {
+        // plugins are not expected to be in use by other threads while they are unloaded
+        _closingLibraries = true;
         _dlList.erase(ditr);
+        _closingLibraries = false;
         return true;
     }
     return false;
@@ -838,8 +905,27 @@ bool Registry::closeLibrary(const std::string& fileName)
 void Registry::closeAllLibraries()
 {
     // OSG_NOTICE<<"Registry::closeAllLibraries()"<<std::endl;
+    releaseRetiredSnapshots();
+
     OpenThreads::ScopedLock<OpenThreads::ReentrantMutex> lock(_pluginMutex);
+    _closingLibraries = true;
     _dlList.clear();
+    _closingLibraries = false;
+}
+
+void Registry::releaseRetiredSnapshots()
+{
+    // at exit the plugins are finalized before the registry, so their ReaderWriters and wrappers have already
+    // been removed, only being kept alive by the retired snapshots, which must go before the plugin code is unloaded.
+    // The wrappers are released first as findWrapper() loads libraries while holding the wrapper mutex.
+    if (_objectWrapperManager.valid())
+    {
+        OpenThreads::ScopedLock<OpenThreads::ReentrantMutex> lock(_objectWrapperManager->_wrapperMutex);
+        _objectWrapperManager->releaseWrapperSnapshots();
+    }
+
+    OpenThreads::ScopedLock<OpenThreads::ReentrantMutex> lock(_pluginMutex);
+    releaseReaderWriterSnapshots();
 }
 
 Registry::DynamicLibraryList::iterator Registry::getLibraryItr(const std::string& fileName)
@@ -862,18 +948,33 @@ DynamicLibrary* Registry::getLibrary(const std::string& fileName)
 
 ReaderWriter* Registry::getReaderWriterForExtension(const std::string& ext)
 {
+    // lock free lookup among the loaded ReaderWriters
+    const ReaderWriterSnapshot& snapshot = getReaderWriterSnapshot();
+    for(ReaderWriterSnapshot::const_iterator itr=snapshot.begin();
+        itr!=snapshot.end();
+        ++itr)
+    {
+        if((*itr)->acceptsExtension(ext)) return itr->get();
+    }
+
     // record the existing reader writer.
     std::set<ReaderWriter*> rwOriginal;
 
     OpenThreads::ScopedLock<OpenThreads::ReentrantMutex> lock(_pluginMutex);
 
-    // first attempt one of the installed loaders
+    // first attempt one of the installed loaders, which may have been loaded since the
+    // snapshot was read (or directly added to the list returned by getReaderWriterList())
     for(ReaderWriterList::iterator itr=_rwList.begin();
         itr!=_rwList.end();
         ++itr)
     {
         rwOriginal.insert(itr->get());
-        if((*itr)->acceptsExtension(ext)) return (*itr).get();
+        if((*itr)->acceptsExtension(ext))
+        {
+            const ReaderWriterSnapshot& current = getReaderWriterSnapshot();
+            if (std::find(current.begin(), current.end(), *itr)==current.end()) publishReaderWriterSnapshot();
+            return (*itr).get();
+        }
     }
 
     // now look for a plug-in to load the file.
@@ -1179,7 +1280,7 @@ ReaderWriter::ReadResult Registry::read(const ReadFunctor& readFunctor)
     Results results;
 
     // first attempt to load the file from existing ReaderWriter's
-    AvailableReaderWriterIterator itr(_rwList, _pluginMutex);
+    AvailableReaderWriterIterator itr(*this);
     for(;itr.valid();++itr)
     {
         ReaderWriter::ReadResult rr = readFunctor.doRead(*itr);
@@ -1335,7 +1436,7 @@ ReaderWriter::WriteResult Registry::writeObjectImplementation(const Object& obj,
     Results results;
 
     // first attempt to load the file from existing ReaderWriter's
-    AvailableReaderWriterIterator itr(_rwList, _pluginMutex);
+    AvailableReaderWriterIterator itr(*this);
     for(;itr.valid();++itr)
     {
         ReaderWriter::WriteResult rr = itr->writeObject(obj,fileName,options);
@@ -1381,7 +1482,7 @@ ReaderWriter::WriteResult Registry::writeImageImplementation(const Image& image,
     Results results;
 
     // first attempt to load the file from existing ReaderWriter's
-    AvailableReaderWriterIterator itr(_rwList, _pluginMutex);
+    AvailableReaderWriterIterator itr(*this);
     for(;itr.valid();++itr)
     {
         ReaderWriter::WriteResult rr = itr->writeImage(image,fileName,options);
@@ -1426,7 +1527,7 @@ ReaderWriter::WriteResult Registry::writeHeightFieldImplementation(const HeightF
     Results results;
 
     // first attempt to load the file from existing ReaderWriter's
-    AvailableReaderWriterIterator itr(_rwList, _pluginMutex);
+    AvailableReaderWriterIterator itr(*this);
     for(;itr.valid();++itr)
     {
         ReaderWriter::WriteResult rr = itr->writeHeightField(HeightField,fileName,options);
@@ -1483,7 +1584,7 @@ ReaderWriter::WriteResult Registry::writeNodeImplementation(const Node& node,con
     Results results;
 
     // first attempt to write the file from existing ReaderWriter's
-    AvailableReaderWriterIterator itr(_rwList, _pluginMutex);
+    AvailableReaderWriterIterator itr(*this);
     for(;itr.valid();++itr)
     {
         ReaderWriter::WriteResult rr = itr->writeNode(node,fileName,options);
@@ -1529,7 +1630,7 @@ ReaderWriter::WriteResult Registry::writeShaderImplementation(const Shader& shad
     Results results;
 
     // first attempt to load the file from existing ReaderWriter's
-    AvailableReaderWriterIterator itr(_rwList, _pluginMutex);
+    AvailableReaderWriterIterator itr(*this);
     for(;itr.valid();++itr)
     {
         ReaderWriter::WriteResult rr = itr->writeShader(shader,fileName,options);
@@ -1576,7 +1677,7 @@ ReaderWriter::WriteResult Registry::writeScriptImplementation(const Script& imag
     Results results;
 
     // first attempt to load the file from existing ReaderWriter's
-    AvailableReaderWriterIterator itr(_rwList, _pluginMutex);
+    AvailableReaderWriterIterator itr(*this);
     for(;itr.valid();++itr)
     {
         ReaderWriter::WriteResult rr = itr->writeScript(image,fileName,options);
@@ -1709,8 +1810,10 @@ bool Registry::isProtocolRegistered(const std::string& protocol)
 
 void Registry::getReaderWriterListForProtocol(const std::string& protocol, ReaderWriterList& results) const
 {
-    for(ReaderWriterList::const_iterator i = _rwList.begin(); i != _rwList.end(); ++i)
-    {        if ((*i)->acceptsProtocol(protocol))
+    const ReaderWriterSnapshot& snapshot = getReaderWriterSnapshot();
+    for(ReaderWriterSnapshot::const_iterator i = snapshot.begin(); i != snapshot.end(); ++i)
+    {
+        if ((*i)->acceptsProtocol(protocol))
             results.push_back(*i);
     }
 }
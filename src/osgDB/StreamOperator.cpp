@@ -13,11 +13,57 @@
 
 #include <osgDB/StreamOperator>
 #include <osgDB/InputStream>
+#include <osg/Endian>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define OSGDB_SWAP_SSE2 1
+#endif
 
 using namespace osgDB;
 
 static long long prev_tellg = 0;
 
+// Reverses the bytes of count consecutive components of the given size. Components of
+// 2, 4 and 8 bytes are swapped 16 bytes at a time: bytes are first swapped inside each
+// 16 bits word, then the words are reversed inside each component.
+static void swapComponents( char* data, unsigned int count, unsigned int size )
+{
+    unsigned int i = 0;
+#ifdef OSGDB_SWAP_SSE2
+    if ( size==2 || size==4 || size==8 )
+    {
+        unsigned int perBlock = 16 / size;
+        for ( ; i + perBlock <= count; i += perBlock )
+        {
+            __m128i* block = reinterpret_cast<__m128i*>( data + i * size );
+            __m128i value = _mm_loadu_si128( block );
+            value = _mm_or_si128( _mm_slli_epi16(value, 8), _mm_srli_epi16(value, 8) );
+            if ( size==4 )
+            {
+                value = _mm_shufflelo_epi16( value, _MM_SHUFFLE(2, 3, 0, 1) );
+                value = _mm_shufflehi_epi16( value, _MM_SHUFFLE(2, 3, 0, 1) );
+            }
+            else if ( size==8 )
+            {
+                value = _mm_shufflelo_epi16( value, _MM_SHUFFLE(0, 1, 2, 3) );
+                value = _mm_shufflehi_epi16( value, _MM_SHUFFLE(0, 1, 2, 3) );
+            }
+            _mm_storeu_si128( block, value );
+        }
+    }
+#endif
+
+    char* ptr = data + i * size;
+    switch ( size )
+    {
+    case 2: for ( ; i<count; ++i, ptr+=2 ) osg::swapBytes2( ptr ); break;
+    case 4: for ( ; i<count; ++i, ptr+=4 ) osg::swapBytes4( ptr ); break;
+    case 8: for ( ; i<count; ++i, ptr+=8 ) osg::swapBytes8( ptr ); break;
+    default: for ( ; i<count; ++i, ptr+=size ) osg::swapBytes( ptr, size ); break;
+    }
+}
+
 void InputIterator::checkStream() const
 {
     if (_in->rdstate()&_in->failbit)
@@ -42,15 +88,7 @@ void InputIterator::readComponentArray( char* s, unsigned int numElements, unsig
 
         if (_byteSwap && componentSizeInBytes>1)
         {
-            char* ptr = s;
-            for(unsigned int i=0; i<numElements; ++i)
-            {
-                for(unsigned int j=0; j<numComponentsPerElements; ++j)
-                {
-                    osg::swapBytes( ptr, componentSizeInBytes );
-                    ptr += componentSizeInBytes;
-                }
-            }
+            swapComponents( s, numElements * numComponentsPerElements, componentSizeInBytes );
         }
     }
 }
@@ -0,0 +1,223 @@
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include <osgAnimation/UpdateMatrixTransform>
+
+#include "AnimationCompressionVisitor"
+
+
+namespace {
+    template<typename T>
+    T* getCallbackType(osg::Callback* callback) {
+        while(callback) {
+            if(T* typed = dynamic_cast<T*>(callback)) {
+                return typed;
+            }
+            callback = callback->getNestedCallback();
+        }
+        return 0;
+    }
+
+    // distance between the linear interpolation of the keys and the actual value
+    double getInterpolationError(const osg::Vec3& first, const osg::Vec3& last, float blend, const osg::Vec3& value) {
+        return (first * (1.f - blend) + last * blend - value).length();
+    }
+
+    // angle between the spherical interpolation of the keys and the actual value
+    double getInterpolationError(const osg::Quat& first, const osg::Quat& last, float blend, const osg::Quat& value) {
+        osg::Quat interpolated;
+        interpolated.slerp(blend, first, last);
+        double norm = interpolated.length() * value.length();
+        if(norm == 0.) {
+            return 0.;
+        }
+        double cosine = std::fabs(interpolated.asVec4() * value.asVec4()) / norm;
+        return 2. * std::acos(std::min(cosine, 1.));
+    }
+
+    // Douglas-Peucker: keys are kept (recursively) where the interpolation error is maximal
+    template<typename ContainerType>
+    void reduceKeyframes(ContainerType& keys, double tolerance) {
+        unsigned int size = keys.size();
+        if(size < 3) {
+            return;
+        }
+
+        std::vector<bool> keep(size, false);
+        keep[0] = keep[size - 1] = true;
+
+        std::vector< std::pair<unsigned int, unsigned int> > segments(1, std::make_pair(0u, size - 1));
+        while(!segments.empty()) {
+            unsigned int first = segments.back().first, last = segments.back().second;
+            segments.pop_back();
+            if(last - first < 2) {
+                continue;
+            }
+
+            double start = keys[first].getTime();
+            double duration = keys[last].getTime() - start;
+            double maxError = 0.;
+            unsigned int split = first;
+            for(unsigned int i = first + 1 ; i < last ; ++ i) {
+                float blend = duration > 0. ? static_cast<float>((keys[i].getTime() - start) / duration) : 0.f;
+                double error = getInterpolationError(keys[first].getValue(), keys[last].getValue(), blend, keys[i].getValue());
+                if(error > maxError) {
+                    maxError = error;
+                    split = i;
+                }
+            }
+
+            if(maxError > tolerance) {
+                keep[split] = true;
+                segments.push_back(std::make_pair(first, split));
+                segments.push_back(std::make_pair(split, last));
+            }
+        }
+
+        unsigned int kept = 0;
+        for(unsigned int i = 0 ; i < size ; ++ i) {
+            if(keep[i]) {
+                keys[kept ++] = keys[i];
+            }
+        }
+        keys.resize(kept);
+    }
+}
+
+
+AnimationCompressionVisitor::AnimationCompressionVisitor(double positionTolerance, double angleTolerance):
+    osg::NodeVisitor(osg::NodeVisitor::TRAVERSE_ALL_CHILDREN),
+    _positionTolerance(positionTolerance),
+    _angleTolerance(angleTolerance),
+    _keysBefore(0),
+    _keysAfter(0),
+    _bytesBefore(0),
+    _bytesAfter(0),
+    _logger("AnimationCompressionVisitor::compress(..)")
+{}
+
+
+void AnimationCompressionVisitor::apply(osg::Node& node) {
+    collectChannels(node);
+    traverse(node);
+}
+
+
+void AnimationCompressionVisitor::collectChannels(osg::Node& node) {
+    osgAnimation::BasicAnimationManager* manager = getCallbackType<osgAnimation::BasicAnimationManager>(node.getUpdateCallback());
+    if(manager) {
+        osgAnimation::AnimationList& animations = manager->getAnimationList();
+        for(osgAnimation::AnimationList::iterator animation = animations.begin() ; animation != animations.end() ; ++ animation) {
+            if(!animation->valid()) continue;
+
+            osgAnimation::ChannelList& channels = (*animation)->getChannels();
+            for(osgAnimation::ChannelList::iterator channel = channels.begin() ; channel != channels.end() ; ++ channel) {
+                if(channel->valid()) {
+                    _channels.push_back(channel->get());
+                }
+            }
+        }
+    }
+}
+
+
+void AnimationCompressionVisitor::apply(osg::MatrixTransform& transform) {
+    osg::Matrix matrix = transform.getMatrix();
+    if(!_matrices.empty()) {
+        matrix = matrix * _matrices.back();
+    }
+
+    int animated = _animated.empty() ? -1 : _animated.back();
+    osgAnimation::UpdateMatrixTransform* update = getCallbackType<osgAnimation::UpdateMatrixTransform>(transform.getUpdateCallback());
+    if(update) {
+        AnimatedTransform current;
+        current._position = matrix.getTrans();
+        current._parent = animated;
+        current._depth = animated >= 0 ? _transforms[animated]._depth + 1 : 1;
+
+        animated = _transforms.size();
+        _targets[update->getName()] = animated;
+        _transforms.push_back(current);
+    }
+
+    collectChannels(transform);
+    _matrices.push_back(matrix);
+    _animated.push_back(animated);
+    traverse(transform);
+    _matrices.pop_back();
+    _animated.pop_back();
+}
+
+
+void AnimationCompressionVisitor::compress() {
+    // children are registered after their parent: propagate heights and extents up from the leaves
+    for(int i = static_cast<int>(_transforms.size()) - 1 ; i >= 0 ; -- i) {
+        const AnimatedTransform& child = _transforms[i];
+        if(child._parent >= 0) {
+            AnimatedTransform& parent = _transforms[child._parent];
+            parent._height = std::max(parent._height, child._height + 1);
+            parent._extent = std::max(parent._extent, (child._position - parent._position).length() + child._extent);
+        }
+    }
+
+    for(std::vector<osgAnimation::Channel*>::iterator channel = _channels.begin() ; channel != _channels.end() ; ++ channel) {
+        std::map<std::string, unsigned int>::const_iterator target = _targets.find((*channel)->getTargetName());
+        compressChannel(**channel, target != _targets.end() ? &_transforms[target->second] : 0);
+    }
+
+    if(_keysBefore) {
+        _logger.setStat("keyframes before", _keysBefore);
+        _logger.setStat("keyframes after", _keysAfter);
+        _logger.setStat("keyframes bytes before", _bytesBefore);
+        _logger.setStat("keyframes bytes after", _bytesAfter);
+    }
+}
+
+
+void AnimationCompressionVisitor::compressChannel(osgAnimation::Channel& channel, const AnimatedTransform* transform) {
+    if(!transform) {
+        return;
+    }
+
+    // positional budget of the transform in the longest animated chain going through it
+    double chain = transform->_depth + transform->_height - 1;
+    double position = _positionTolerance / chain;
+
+    if(osgAnimation::Vec3LinearChannel* vec3 = dynamic_cast<osgAnimation::Vec3LinearChannel*>(&channel)) {
+        osgAnimation::Vec3KeyframeContainer* keys = vec3->getOrCreateSampler()->getKeyframeContainerTyped();
+        double tolerance = position;
+        if(channel.getName() == "scale" && transform->_extent > 0.) {
+            // relative scale error moves descendants proportionally to their distance
+            tolerance = position / transform->_extent;
+        }
+
+        unsigned int before = keys->size();
+        if(tolerance > 0.) {
+            reduceKeyframes(*keys, tolerance);
+        }
+        addStat(before, keys->size(), sizeof(osg::Vec3f));
+    }
+    else if(osgAnimation::QuatSphericalLinearChannel* quat = dynamic_cast<osgAnimation::QuatSphericalLinearChannel*>(&channel)) {
+        osgAnimation::QuatKeyframeContainer* keys = quat->getOrCreateSampler()->getKeyframeContainerTyped();
+        double tolerance = _angleTolerance;
+        if(transform->_extent > 0. && position > 0.) {
+            tolerance = tolerance > 0. ? std::min(tolerance, position / transform->_extent) : position / transform->_extent;
+        }
+
+        unsigned int before = keys->size();
+        if(tolerance > 0.) {
+            reduceKeyframes(*keys, tolerance);
+        }
+        addStat(before, keys->size(), 4 * sizeof(float));
+    }
+}
+
+
+void AnimationCompressionVisitor::addStat(unsigned int keysBefore, unsigned int keysAfter, unsigned int valueSize) {
+    // keys are exported as float32 time + value
+    _keysBefore += keysBefore;
+    _keysAfter += keysAfter;
+    _bytesBefore += keysBefore * (sizeof(float) + valueSize);
+    _bytesAfter += keysAfter * (sizeof(float) + valueSize);
+}
@@ -31,7 +31,7 @@ bool GeometryIndexSplitter::split(osg::Geometry& geometry) {
         }
     }
 
-    TriangleMeshGraph graph(geometry, false);
+    TriangleMeshGraph graph(geometry, false, &_logger);
 
     // only wireframe can be processed directly as they simply "duplicate" triangle or edge data;
     // lines/points may reference points not used for triangles so we keep a set of primitives
@@ -69,17 +69,29 @@ bool GeometryIndexSplitter::split(osg::Geometry& geometry) {
     // 3. insert wireframe edges corresponding to selected triangles
     // 4. extract subgeometry
 
+    IndexVector seeds;
+    unsigned int seedCursor = 0;
+    if(_strategy == CLUSTER_SPLIT) {
+        seeds = getSpatialOrder(geometry, graph);
+    }
+
     while(triangles.size() || lines.size() || points.size()) {
         Cluster cluster(_maxAllowedIndex);
-        IndexCache cache;
-        unsigned int candidate = std::numeric_limits<unsigned int>::max();
 
-        // let's consider that every insert needs the place for a full new primitive for simplicity
-        while(!cluster.fullOfTriangles() &&
-              (candidate = findCandidate(triangles, cache, graph)) != std::numeric_limits<unsigned int>::max()) {
-            cache.push_back(candidate);
-            Triangle t = graph.triangle(candidate);
-            cluster.addTriangle(t.v1(), t.v2(), t.v3());
+        if(_strategy == CLUSTER_SPLIT) {
+            growCluster(cluster, triangles, graph, seeds, seedCursor);
+        }
+        else {
+            IndexCache cache;
+            unsigned int candidate = std::numeric_limits<unsigned int>::max();
+
+            // let's consider that every insert needs the place for a full new primitive for simplicity
+            while(!cluster.fullOfTriangles() &&
+                  (candidate = findCandidate(triangles, cache, graph)) != std::numeric_limits<unsigned int>::max()) {
+                cache.push_back(candidate);
+                Triangle t = graph.triangle(candidate);
+                cluster.addTriangle(t.v1(), t.v2(), t.v3());
+            }
         }
 
         while(!cluster.fullOfLines() && lines.size()) {
@@ -138,8 +150,14 @@ bool GeometryIndexSplitter::split(osg::Geometry& geometry) {
                                             cluster.sublines,
                                             cluster.subwireframe,
                                             cluster.subpoints).geometry());
+
+        if(_strategy == CLUSTER_SPLIT) {
+            setBoundingSphere(*_geometryList.back());
+        }
     }
 
+    updateDuplicationStat(geometry);
+
     osg::notify(osg::NOTICE) << "geometry " << &geometry << " " << geometry.getName()
                                 << " vertexes (" << geometry.getVertexArray()->getNumElements()
                                 << ") has DrawElements index > " << _maxAllowedIndex << ", splitted to "
@@ -166,6 +184,138 @@ unsigned int GeometryIndexSplitter::findCandidate(IndexSet& triangles, const Ind
 }
 
 
+void GeometryIndexSplitter::growCluster(Cluster& cluster, IndexSet& triangles, const TriangleMeshGraph& graph,
+                                        const IndexVector& seeds, unsigned int& seedCursor) {
+    const unsigned int none = std::numeric_limits<unsigned int>::max();
+
+    // frontier triangles (sharing at least a vertex with the cluster) bucketed by the number
+    // of vertices they would add; buckets are only updated lazily as this number can only
+    // decrease while the cluster grows
+    IndexDeque frontier[3];
+
+    while(true) {
+        unsigned int candidate = none;
+        for(unsigned int bucket = 0 ; bucket < 3 && candidate == none ; ++ bucket) {
+            while(!frontier[bucket].empty()) {
+                unsigned int triangle = frontier[bucket].front();
+                frontier[bucket].pop_front();
+                if(triangles.count(triangle)) {
+                    candidate = triangle;
+                    break;
+                }
+            }
+        }
+
+        // disconnected from the cluster: seed a new region from the next triangle in spatial order
+        if(candidate == none) {
+            while(seedCursor < seeds.size() && !triangles.count(seeds[seedCursor])) {
+                ++ seedCursor;
+            }
+            if(seedCursor == seeds.size()) {
+                break;
+            }
+            candidate = seeds[seedCursor];
+        }
+
+        const Triangle& t = graph.triangle(candidate);
+        if(cluster.subvertices.size() + cluster.missing(t) >= cluster.maxIndex) {
+            break;
+        }
+
+        triangles.erase(candidate);
+        cluster.addTriangle(t.v1(), t.v2(), t.v3());
+
+        for(unsigned int i = 0 ; i < 3 ; ++ i) {
+            IndexRange incidents = graph.triangles(t[i]);
+            for(IndexRange::const_iterator incident = incidents.begin() ; incident != incidents.end() ; ++ incident) {
+                if(triangles.count(*incident)) {
+                    frontier[cluster.missing(graph.triangle(*incident))].push_back(*incident);
+                }
+            }
+        }
+    }
+}
+
+
+IndexVector GeometryIndexSplitter::getSpatialOrder(const osg::Geometry& geometry, const TriangleMeshGraph& graph) const {
+    const osg::Vec3Array* positions = dynamic_cast<const osg::Vec3Array*>(geometry.getVertexArray());
+    IndexVector order(graph.getNumTriangles());
+    for(unsigned int i = 0 ; i < order.size() ; ++ i) {
+        order[i] = i;
+    }
+    if(!positions || order.empty()) {
+        return order;
+    }
+
+    osg::BoundingBox bbox;
+    std::vector<osg::Vec3> centroids(order.size());
+    for(unsigned int i = 0 ; i < order.size() ; ++ i) {
+        const Triangle& t = graph.triangle(i);
+        centroids[i] = ((*positions)[t.v1()] + (*positions)[t.v2()] + (*positions)[t.v3()]) / 3.f;
+        bbox.expandBy(centroids[i]);
+    }
+
+    // sort triangles along a Morton (Z-order) curve of their centroid
+    std::vector< std::pair<unsigned int, unsigned int> > codes(order.size());
+    osg::Vec3 extent = bbox._max - bbox._min;
+    for(unsigned int i = 0 ; i < order.size() ; ++ i) {
+        unsigned int code = 0;
+        unsigned int cell[3];
+        for(unsigned int c = 0 ; c < 3 ; ++ c) {
+            float normalized = extent[c] > 0.f ? (centroids[i][c] - bbox._min[c]) / extent[c] : 0.f;
+            cell[c] = static_cast<unsigned int>(osg::clampBetween(normalized, 0.f, 1.f) * 1023.f);
+        }
+        for(unsigned int bit = 0 ; bit < 10 ; ++ bit) {
+            for(unsigned int c = 0 ; c < 3 ; ++ c) {
+                code |= ((cell[c] >> bit) & 1u) << (3 * bit + c);
+            }
+        }
+        codes[i] = std::pair<unsigned int, unsigned int>(code, i);
+    }
+    std::sort(codes.begin(), codes.end());
+
+    for(unsigned int i = 0 ; i < order.size() ; ++ i) {
+        order[i] = codes[i].second;
+    }
+    return order;
+}
+
+
+void GeometryIndexSplitter::setBoundingSphere(osg::Geometry& geometry) const {
+    const osg::Vec3Array* positions = dynamic_cast<const osg::Vec3Array*>(geometry.getVertexArray());
+    if(!positions || positions->empty()) return;
+
+    osg::BoundingBox bbox;
+    for(osg::Vec3Array::const_iterator position = positions->begin() ; position != positions->end() ; ++ position) {
+        bbox.expandBy(*position);
+    }
+
+    osg::BoundingSphere sphere(bbox.center(), 0.f);
+    for(osg::Vec3Array::const_iterator position = positions->begin() ; position != positions->end() ; ++ position) {
+        sphere.radius() = std::max(sphere.radius(), (*position - sphere.center()).length());
+    }
+
+    // the initial bound is what culling uses (and is serialized with the geometry), the sphere is
+    // kept as a user value for the exporters
+    geometry.setInitialBound(bbox);
+    geometry.setUserValue("boundingSphere", osg::Vec4(sphere.center(), sphere.radius()));
+}
+
+
+void GeometryIndexSplitter::updateDuplicationStat(const osg::Geometry& geometry) {
+    _numSourceVertices += geometry.getVertexArray()->getNumElements();
+    for(GeometryList::const_iterator split = _geometryList.begin() ; split != _geometryList.end() ; ++ split) {
+        if((*split)->getVertexArray()) {
+            _numSplitVertices += (*split)->getVertexArray()->getNumElements();
+        }
+    }
+
+    // ratio of vertices duplicated on cluster borders
+    _logger.setStat("border vertex duplication ratio",
+                    static_cast<double>(_numSplitVertices) / _numSourceVertices - 1.);
+}
+
+
 bool GeometryIndexSplitter::needToSplit(const osg::Geometry& geometry) const {
     for(unsigned int i = 0; i < geometry.getNumPrimitiveSets(); ++ i) {
         const osg::DrawElements* primitive = geometry.getPrimitiveSet(i)->getDrawElements();
@@ -55,50 +55,12 @@ void IndexMeshVisitor::process(osg::Geometry& geom) {
     new_primitives.reserve(primitives.size());
 
     // compute duplicate vertices
-    typedef std::vector<unsigned int> IndexList;
     unsigned int numVertices = geom.getVertexArray()->getNumElements();
-    IndexList indices(numVertices);
-    unsigned int i, j;
-    for(i = 0 ; i < numVertices ; ++ i) {
-        indices[i] = i;
-    }
-
-    VertexAttribComparitor arrayComparitor(geom);
-    std::sort(indices.begin(), indices.end(), arrayComparitor);
-
-    unsigned int lastUnique = 0;
-    unsigned int numUnique = 1;
-    for(i = 1 ; i < numVertices ; ++ i) {
-        if (arrayComparitor.compare(indices[lastUnique], indices[i]) != 0) {
-            lastUnique = i;
-            ++ numUnique;
-        }
-    }
-
     IndexList remapDuplicatesToOrignals(numVertices);
-    lastUnique = 0;
-    for(i = 1 ; i < numVertices ; ++ i) {
-        if (arrayComparitor.compare(indices[lastUnique],indices[i]) != 0) {
-            // found a new vertex entry, so previous run of duplicates needs
-            // to be put together.
-            unsigned int min_index = indices[lastUnique];
-            for(j = lastUnique + 1 ; j < i ; ++ j) {
-                min_index = osg::minimum(min_index, indices[j]);
-            }
-            for(j = lastUnique ; j < i ; ++ j) {
-                remapDuplicatesToOrignals[indices[j]] = min_index;
-            }
-            lastUnique = i;
-        }
-    }
-
-    unsigned int min_index = indices[lastUnique];
-    for(j = lastUnique + 1 ; j < i ; ++ j) {
-        min_index = osg::minimum(min_index, indices[j]);
-    }
-    for(j = lastUnique ; j < i ; ++ j) {
-        remapDuplicatesToOrignals[indices[j]] = min_index;
-    }
+    unsigned int numUnique = (_weldingMode == HASH_WELDING ?
+                              computeHashRemapping(geom, remapDuplicatesToOrignals) :
+                              computeSortRemapping(geom, remapDuplicatesToOrignals));
+    unsigned int i;
 
     // copy the arrays.
     IndexList finalMapping(numVertices);
@@ -118,7 +80,8 @@ void IndexMeshVisitor::process(osg::Geometry& geom) {
 
     // remap any shared vertex attributes
     RemapArray ra(copyMapping);
-    arrayComparitor.accept(ra);
+    GeometryArrayGatherer gatherer(geom);
+    gatherer.accept(ra);
 
     //Remap morphGeometry target
     remapGeometryVertices(ra, geom);
@@ -182,6 +145,83 @@ void IndexMeshVisitor::process(osg::Geometry& geom) {
 }
 
 
+unsigned int IndexMeshVisitor::computeSortRemapping(osg::Geometry& geom, IndexList& remapDuplicatesToOrignals)
+{
+    unsigned int numVertices = geom.getVertexArray()->getNumElements();
+    IndexList indices(numVertices);
+    unsigned int i, j;
+    for(i = 0 ; i < numVertices ; ++ i) {
+        indices[i] = i;
+    }
+
+    VertexAttribComparitor arrayComparitor(geom);
+    std::sort(indices.begin(), indices.end(), arrayComparitor);
+
+    unsigned int lastUnique = 0;
+    unsigned int numUnique = 1;
+    for(i = 1 ; i < numVertices ; ++ i) {
+        if (arrayComparitor.compare(indices[lastUnique], indices[i]) != 0) {
+            // found a new vertex entry, so previous run of duplicates needs
+            // to be put together.
+            unsigned int min_index = indices[lastUnique];
+            for(j = lastUnique + 1 ; j < i ; ++ j) {
+                min_index = osg::minimum(min_index, indices[j]);
+            }
+            for(j = lastUnique ; j < i ; ++ j) {
+                remapDuplicatesToOrignals[indices[j]] = min_index;
+            }
+            lastUnique = i;
+            ++ numUnique;
+        }
+    }
+
+    unsigned int min_index = indices[lastUnique];
+    for(j = lastUnique + 1 ; j < i ; ++ j) {
+        min_index = osg::minimum(min_index, indices[j]);
+    }
+    for(j = lastUnique ; j < i ; ++ j) {
+        remapDuplicatesToOrignals[indices[j]] = min_index;
+    }
+
+    return numUnique;
+}
+
+
+unsigned int IndexMeshVisitor::computeHashRemapping(osg::Geometry& geom, IndexList& remapDuplicatesToOrignals)
+{
+    const unsigned int empty = std::numeric_limits<unsigned int>::max();
+    unsigned int numVertices = geom.getVertexArray()->getNumElements();
+
+    // open addressing table with linear probing, kept at most half full
+    unsigned int capacity = 16;
+    while(capacity < 2 * numVertices) {
+        capacity <<= 1;
+    }
+    IndexList table(capacity, empty);
+    const unsigned int mask = capacity - 1;
+
+    VertexAttribHasher hasher(geom, _epsilon);
+    unsigned int numUnique = 0;
+
+    // vertices are inserted in increasing order so that duplicates are remapped
+    // to their smallest index, as done by the sort based path
+    for(unsigned int i = 0 ; i < numVertices ; ++ i) {
+        unsigned int slot = hasher.hash(i) & mask;
+        while(table[slot] != empty && !hasher.equal(table[slot], i)) {
+            slot = (slot + 1) & mask;
+        }
+
+        if(table[slot] == empty) {
+            table[slot] = i;
+            ++ numUnique;
+        }
+        remapDuplicatesToOrignals[i] = table[slot];
+    }
+
+    return numUnique;
+}
+
+
 void IndexMeshVisitor::addDrawElements(IndexList& data,
                                        osg::PrimitiveSet::Mode mode,
                                        osg::Geometry::PrimitiveSetList& primitives,
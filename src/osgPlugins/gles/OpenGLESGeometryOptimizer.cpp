@@ -20,11 +20,17 @@ osg::Node* OpenGLESGeometryOptimizer::optimize(osg::Node& node) {
             makeWireframe(model.get());
         }
 
-        // bind per vertex
-        makeBindPerVertex(model.get());
+        if(_numThreads > 1) {
+            // bind per vertex + index
+            makeGeometryStage(model.get(), INDEX_STAGE);
+        }
+        else {
+            // bind per vertex
+            makeBindPerVertex(model.get());
 
-        // index (merge exact duplicates + uses simple triangles & lines i.e. no strip/fan/loop)
-        makeIndexMesh(model.get());
+            // index (merge exact duplicates + uses simple triangles & lines i.e. no strip/fan/loop)
+            makeIndexMesh(model.get());
+        }
 
         // clean (remove degenerated data)
         std::string authoringTool;
@@ -32,12 +38,18 @@ osg::Node* OpenGLESGeometryOptimizer::optimize(osg::Node& node) {
             makeCleanGeometry(model.get());
         }
 
-        // smooth vertex normals (if geometry has no normal compute smooth normals)
-        makeSmoothNormal(model.get());
-
-        // tangent space
-        if (_generateTangentSpace) {
-            makeTangentSpace(model.get());
+        if(_numThreads > 1) {
+            // smooth vertex normals + tangent space
+            makeGeometryStage(model.get(), SMOOTH_STAGE);
+        }
+        else {
+            // smooth vertex normals (if geometry has no normal compute smooth normals)
+            makeSmoothNormal(model.get());
+
+            // tangent space
+            if (_generateTangentSpace) {
+                makeTangentSpace(model.get());
+            }
         }
 
         if(!_useDrawArray) {
@@ -45,18 +57,29 @@ osg::Node* OpenGLESGeometryOptimizer::optimize(osg::Node& node) {
             makeSplit(model.get());
         }
 
-        // strip
-        if(!_disableTriStrip) {
-            makeTriStrip(model.get());
-        }
-
-        if(_useDrawArray) {
-            // drawelements to drawarrays
-            makeDrawArray(model.get());
+        if(_numThreads > 1) {
+            // overdraw + strip + drawarrays/pre-transform
+            makeGeometryStage(model.get(), STRIP_STAGE);
         }
-        else if(!_disablePreTransform) {
-            // pre-transform
-            makePreTransform(model.get());
+        else {
+            // overdraw (triangle lists only)
+            if(_overdrawThreshold > 0.f) {
+                makeOverdrawReorder(model.get());
+            }
+
+            // strip
+            if(!_disableTriStrip) {
+                makeTriStrip(model.get());
+            }
+
+            if(_useDrawArray) {
+                // drawelements to drawarrays
+                makeDrawArray(model.get());
+            }
+            else if(!_disablePreTransform) {
+                // pre-transform
+                makePreTransform(model.get());
+            }
         }
 
         // unbind bones/weights from source and bind on RigGeometry
@@ -0,0 +1,324 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <osg/BoundingBox>
+#include <osg/Notify>
+#include <osgUtil/MeshOptimizers>
+
+#include "OverdrawReorderVisitor"
+
+
+namespace {
+    // FIFO post-transform cache (same model as osgUtil::VertexCacheMissVisitor)
+    class VertexCacheFIFO {
+    public:
+        VertexCacheFIFO(unsigned int numVertices, unsigned int cacheSize):
+            _timestamps(numVertices, 0),
+            _time(cacheSize + 1),
+            _cacheSize(cacheSize)
+        {}
+
+        // returns 1 if the vertex has to be transformed
+        unsigned int access(unsigned int vertex) {
+            if(_time - _timestamps[vertex] > _cacheSize) {
+                _timestamps[vertex] = _time ++;
+                return 1;
+            }
+            return 0;
+        }
+
+        unsigned int access(const std::vector<unsigned int>& indices, unsigned int triangle) {
+            return access(indices[3 * triangle]) + access(indices[3 * triangle + 1]) + access(indices[3 * triangle + 2]);
+        }
+
+        void flush() {
+            _time += _cacheSize + 1;
+        }
+
+    protected:
+        std::vector<unsigned int> _timestamps;
+        unsigned int _time;
+        unsigned int _cacheSize;
+    };
+
+
+    struct ClusterSorter {
+        ClusterSorter(const std::vector<float>& keys): _keys(keys)
+        {}
+
+        bool operator()(unsigned int a, unsigned int b) const {
+            return _keys[a] > _keys[b];
+        }
+
+        const std::vector<float>& _keys;
+    };
+
+
+    unsigned int getNumVertices(const std::vector<unsigned int>& indices) {
+        return indices.empty() ? 0 : *std::max_element(indices.begin(), indices.end()) + 1;
+    }
+}
+
+
+OverdrawReorderVisitor::OverdrawReorderVisitor(float threshold, unsigned int cacheSize):
+    GeometryUniqueVisitor("OverdrawReorderVisitor"),
+    _threshold(threshold),
+    _cacheSize(cacheSize),
+    _report(osg::isNotifyEnabled(osg::INFO)),
+    _numTriangles(0),
+    _missesBefore(0),
+    _missesAfter(0)
+{}
+
+
+OverdrawReorderVisitor::~OverdrawReorderVisitor() {
+    if(_report && _numTriangles) {
+        _logger.setStat("ACMR before", static_cast<double>(_missesBefore) / _numTriangles);
+        _logger.setStat("ACMR after", static_cast<double>(_missesAfter) / _numTriangles);
+        _logger.setStat("overdraw before", _overdrawBefore.ratio());
+        _logger.setStat("overdraw after", _overdrawAfter.ratio());
+    }
+}
+
+
+void OverdrawReorderVisitor::process(osg::Geometry& geometry) {
+    const osg::Vec3Array* positions = dynamic_cast<const osg::Vec3Array*>(geometry.getVertexArray());
+    if(!positions || positions->empty()) {
+        return;
+    }
+
+    for(unsigned int i = 0 ; i < geometry.getNumPrimitiveSets() ; ++ i) {
+        osg::DrawElements* primitive = geometry.getPrimitiveSet(i) ? geometry.getPrimitiveSet(i)->getDrawElements() : 0;
+        if(!primitive || primitive->getMode() != osg::PrimitiveSet::TRIANGLES || primitive->getNumIndices() < 6) {
+            continue;
+        }
+
+        IndexList indices(primitive->getNumIndices() - primitive->getNumIndices() % 3);
+        for(unsigned int k = 0 ; k < indices.size() ; ++ k) {
+            indices[k] = primitive->getElement(k);
+        }
+
+        if(_report) {
+            OverdrawStat overdraw = getOverdraw(*positions, indices);
+            _overdrawBefore._covered += overdraw._covered;
+            _overdrawBefore._shaded += overdraw._shaded;
+            _missesBefore += getCacheMisses(indices);
+        }
+
+        optimizeVertexCache(*positions, indices);
+        reorder(*positions, indices);
+
+        if(_report) {
+            OverdrawStat overdraw = getOverdraw(*positions, indices);
+            _overdrawAfter._covered += overdraw._covered;
+            _overdrawAfter._shaded += overdraw._shaded;
+            _missesAfter += getCacheMisses(indices);
+            _numTriangles += indices.size() / 3;
+        }
+
+        for(unsigned int k = 0 ; k < indices.size() ; ++ k) {
+            primitive->setElement(k, indices[k]);
+        }
+        primitive->dirty();
+    }
+}
+
+
+void OverdrawReorderVisitor::optimizeVertexCache(const osg::Array& vertices, IndexList& indices) const {
+    // osgUtil::VertexCacheVisitor only handles geometries made of triangles; work on a
+    // geometry holding the current primitive only
+    osg::ref_ptr<osg::Geometry> triangles = new osg::Geometry;
+    triangles->setVertexArray(const_cast<osg::Array*>(&vertices));
+    triangles->addPrimitiveSet(new osg::DrawElementsUInt(osg::PrimitiveSet::TRIANGLES, indices.begin(), indices.end()));
+
+    osgUtil::VertexCacheVisitor optimizer;
+    optimizer.optimizeVertices(*triangles);
+
+    osg::DrawElements* optimized = triangles->getPrimitiveSet(0)->getDrawElements();
+    if(optimized && optimized->getNumIndices() == indices.size()) {
+        for(unsigned int k = 0 ; k < indices.size() ; ++ k) {
+            indices[k] = optimized->getElement(k);
+        }
+    }
+}
+
+
+void OverdrawReorderVisitor::getClusters(const IndexList& indices, IndexList& clusters) const {
+    unsigned int numTriangles = indices.size() / 3;
+    VertexCacheFIFO cache(getNumVertices(indices), _cacheSize);
+
+    // hard boundaries: the cache has been flushed i.e. all vertices of the triangle miss
+    IndexList boundaries;
+    for(unsigned int t = 0 ; t < numTriangles ; ++ t) {
+        if(cache.access(indices, t) == 3 || t == 0) {
+            boundaries.push_back(t);
+        }
+    }
+    boundaries.push_back(numTriangles);
+
+    // soft boundaries: split wherever the local ACMR is within the budget of the hard cluster ACMR
+    for(unsigned int b = 0 ; b + 1 < boundaries.size() ; ++ b) {
+        unsigned int start = boundaries[b], end = boundaries[b + 1];
+
+        cache.flush();
+        unsigned int misses = 0;
+        for(unsigned int t = start ; t < end ; ++ t) {
+            misses += cache.access(indices, t);
+        }
+        float thresholdACMR = _threshold * misses / (end - start);
+
+        cache.flush();
+        clusters.push_back(start);
+        unsigned int clusterStart = start, clusterMisses = 0;
+        for(unsigned int t = start ; t < end ; ++ t) {
+            clusterMisses += cache.access(indices, t);
+            if(t + 1 < end && clusterMisses <= thresholdACMR * (t + 1 - clusterStart)) {
+                clusterStart = t + 1;
+                clusterMisses = 0;
+                clusters.push_back(clusterStart);
+                cache.flush();
+            }
+        }
+    }
+}
+
+
+void OverdrawReorderVisitor::reorder(const osg::Vec3Array& positions, IndexList& indices) const {
+    IndexList clusters;
+    getClusters(indices, clusters);
+    if(clusters.size() < 2) {
+        return;
+    }
+    clusters.push_back(indices.size() / 3);
+
+    // area weighted centroid and normal of each cluster
+    std::vector<osg::Vec3> centroids(clusters.size() - 1), normals(clusters.size() - 1);
+    std::vector<float> areas(clusters.size() - 1, 0.f);
+    osg::Vec3 meshCentroid;
+    float meshArea = 0.f;
+    for(unsigned int c = 0 ; c + 1 < clusters.size() ; ++ c) {
+        for(unsigned int t = clusters[c] ; t < clusters[c + 1] ; ++ t) {
+            const osg::Vec3& p1 = positions[indices[3 * t]],
+                             p2 = positions[indices[3 * t + 1]],
+                             p3 = positions[indices[3 * t + 2]];
+            osg::Vec3 normal = (p2 - p1) ^ (p3 - p1);
+            float area = normal.length();
+
+            centroids[c] += (p1 + p2 + p3) * (area / 3.f);
+            normals[c] += normal;
+            areas[c] += area;
+        }
+        meshCentroid += centroids[c];
+        meshArea += areas[c];
+    }
+    if(meshArea == 0.f) {
+        return;
+    }
+    meshCentroid /= meshArea;
+
+    // clusters far from the center and facing outward are more likely to occlude the others
+    std::vector<float> keys(clusters.size() - 1, 0.f);
+    IndexList order(clusters.size() - 1);
+    for(unsigned int c = 0 ; c < order.size() ; ++ c) {
+        order[c] = c;
+        if(areas[c] > 0.f) {
+            osg::Vec3 normal = normals[c];
+            normal.normalize();
+            keys[c] = (centroids[c] / areas[c] - meshCentroid) * normal;
+        }
+    }
+    std::stable_sort(order.begin(), order.end(), ClusterSorter(keys));
+
+    IndexList reordered;
+    reordered.reserve(indices.size());
+    for(IndexList::const_iterator c = order.begin() ; c != order.end() ; ++ c) {
+        reordered.insert(reordered.end(), indices.begin() + 3 * clusters[*c], indices.begin() + 3 * clusters[*c + 1]);
+    }
+    indices.swap(reordered);
+}
+
+
+unsigned int OverdrawReorderVisitor::getCacheMisses(const IndexList& indices) const {
+    VertexCacheFIFO cache(getNumVertices(indices), _cacheSize);
+    unsigned int misses = 0;
+    for(unsigned int t = 0 ; t < indices.size() / 3 ; ++ t) {
+        misses += cache.access(indices, t);
+    }
+    return misses;
+}
+
+
+OverdrawReorderVisitor::OverdrawStat OverdrawReorderVisitor::getOverdraw(const osg::Vec3Array& positions, const IndexList& indices) const {
+    const int resolution = 256;
+
+    osg::BoundingBox bbox;
+    for(IndexList::const_iterator index = indices.begin() ; index != indices.end() ; ++ index) {
+        bbox.expandBy(positions[*index]);
+    }
+
+    OverdrawStat stat;
+    std::vector<float> depths(resolution * resolution);
+
+    // orthographic views along +/- each axis with back face culling and depth test
+    for(unsigned int axis = 0 ; axis < 3 ; ++ axis) {
+        unsigned int u = (axis + 1) % 3, v = (axis + 2) % 3;
+        float su = bbox._max[u] > bbox._min[u] ? (resolution - 1) / (bbox._max[u] - bbox._min[u]) : 0.f;
+        float sv = bbox._max[v] > bbox._min[v] ? (resolution - 1) / (bbox._max[v] - bbox._min[v]) : 0.f;
+
+        for(int direction = -1 ; direction <= 1 ; direction += 2) {
+            std::fill(depths.begin(), depths.end(), std::numeric_limits<float>::max());
+
+            for(unsigned int t = 0 ; t < indices.size() / 3 ; ++ t) {
+                osg::Vec3 p[3] = { positions[indices[3 * t]], positions[indices[3 * t + 1]], positions[indices[3 * t + 2]] };
+                osg::Vec3 normal = (p[1] - p[0]) ^ (p[2] - p[0]);
+                if(normal[axis] * direction >= 0.f) {
+                    continue;
+                }
+
+                float x[3], y[3], z[3];
+                for(unsigned int k = 0 ; k < 3 ; ++ k) {
+                    x[k] = (p[k][u] - bbox._min[u]) * su;
+                    y[k] = (p[k][v] - bbox._min[v]) * sv;
+                    z[k] = p[k][axis] * direction;
+                }
+
+                float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+                if(area == 0.f) {
+                    continue;
+                }
+
+                int minX = std::max(0, static_cast<int>(std::ceil(std::min(x[0], std::min(x[1], x[2]))))),
+                    maxX = std::min(resolution - 1, static_cast<int>(std::floor(std::max(x[0], std::max(x[1], x[2]))))),
+                    minY = std::max(0, static_cast<int>(std::ceil(std::min(y[0], std::min(y[1], y[2]))))),
+                    maxY = std::min(resolution - 1, static_cast<int>(std::floor(std::max(y[0], std::max(y[1], y[2])))));
+
+                for(int py = minY ; py <= maxY ; ++ py) {
+                    for(int px = minX ; px <= maxX ; ++ px) {
+                        float w0 = ((x[2] - x[1]) * (py - y[1]) - (y[2] - y[1]) * (px - x[1])) / area,
+                              w1 = ((x[0] - x[2]) * (py - y[2]) - (y[0] - y[2]) * (px - x[2])) / area,
+                              w2 = 1.f - w0 - w1;
+                        if(w0 < 0.f || w1 < 0.f || w2 < 0.f) {
+                            continue;
+                        }
+
+                        float depth = w0 * z[0] + w1 * z[1] + w2 * z[2];
+                        float& pixel = depths[py * resolution + px];
+                        if(depth < pixel) {
+                            pixel = depth;
+                            ++ stat._shaded;
+                        }
+                    }
+                }
+            }
+
+            for(std::vector<float>::const_iterator depth = depths.begin() ; depth != depths.end() ; ++ depth) {
+                if(*depth != std::numeric_limits<float>::max()) {
+                    ++ stat._covered;
+                }
+            }
+        }
+    }
+
+    return stat;
+}
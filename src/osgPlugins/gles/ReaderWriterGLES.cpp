@@ -53,6 +53,13 @@ public:
          unsigned int maxIndexValue;
          unsigned int maxMorphTarget;
          bool exportNonGeometryDrawables;
+         unsigned int numThreads;
+         bool sortWelding;
+         bool clusterSplit;
+         double weldingEpsilon;
+         float overdrawThreshold;
+         double animationPositionTolerance;
+         double animationAngleTolerance;
 
          OptionsStruct() {
              glesMode = "all";
@@ -72,6 +79,13 @@ public:
              maxIndexValue = 0;
              maxMorphTarget = 0;
              exportNonGeometryDrawables = false;
+             numThreads = 1;
+             sortWelding = false;
+             clusterSplit = false;
+             weldingEpsilon = 0.;
+             overdrawThreshold = 0.f;
+             animationPositionTolerance = 0.;
+             animationAngleTolerance = 0.;
          }
     };
 
@@ -95,8 +109,15 @@ public:
         supportsOption("useDrawArray","prefer drawArray instead of drawelement with split of geometry");
         supportsOption("disableIndex","Do not index the geometry");
         supportsOption("maxIndexValue=<int>","set the maximum index value (first index is 0)");
+        supportsOption("clusterSplit","split geometries exceeding maxIndexValue in spatially coherent clusters, each having its bounding sphere as user value");
         supportsOption("maxMorphTarget=<int>", "set the maximum morph target in morph geometry (no limit by default)");
         supportsOption("exportNonGeometryDrawables", "export non geometry drawables, right now only text 2D supported" );
+        supportsOption("sortWelding", "use the legacy sort based vertex welding instead of hashing when indexing geometries");
+        supportsOption("weldingEpsilon=<float>", "weld vertices whose floating point attributes match on a grid of the given step (hash welding only)");
+        supportsOption("optimizeOverdraw[=<float>]", "reorder triangles to reduce overdraw, allowing the given vertex cache miss ratio increase (default 1.05); disables tristrip");
+        supportsOption("compressAnimation[=<float>]", "drop keyframes that can be interpolated within the given positional tolerance (default 0.001)");
+        supportsOption("animationAngleTolerance=<float>", "maximal rotation error in degrees of compressed animations (default 0.1)");
+        supportsOption("numThreads=<int>", "process geometries in parallel using <int> threads (0 uses the number of processors)");
     }
 
     virtual const char* className() const { return "GLES Optimizer"; }
@@ -130,7 +151,20 @@ public:
             if(options.maxIndexValue) {
                 optimizer.setMaxIndexValue(options.maxIndexValue);
             }
+            if(options.clusterSplit) {
+                optimizer.setSplitStrategy(GeometryIndexSplitter::CLUSTER_SPLIT);
+            }
+            if(options.overdrawThreshold > 0.f) {
+                optimizer.setOverdrawThreshold(options.overdrawThreshold);
+            }
+            if(options.animationPositionTolerance > 0.) {
+                optimizer.setAnimationCompression(options.animationPositionTolerance,
+                                                  osg::DegreesToRadians(options.animationAngleTolerance));
+            }
             optimizer.setMaxMorphTarget(options.maxMorphTarget);
+            optimizer.setNumThreads(options.numThreads);
+            optimizer.setWelding(options.sortWelding ? IndexMeshVisitor::SORT_WELDING : IndexMeshVisitor::HASH_WELDING,
+                                 options.weldingEpsilon);
 
             model = optimizer.optimize(*model);
         }
@@ -276,6 +310,25 @@ public:
                 {
                     localOptions.exportNonGeometryDrawables = true;
                 }
+                if (pre_equals == "sortWelding")
+                {
+                    localOptions.sortWelding = true;
+                }
+                if (pre_equals == "clusterSplit")
+                {
+                    localOptions.clusterSplit = true;
+                }
+                if (pre_equals == "optimizeOverdraw")
+                {
+                    localOptions.overdrawThreshold = post_equals.empty() ? 1.05f : static_cast<float>(osg::asciiToDouble(post_equals.c_str()));
+                }
+                if (pre_equals == "compressAnimation")
+                {
+                    localOptions.animationPositionTolerance = post_equals.empty() ? 1e-3 : osg::asciiToDouble(post_equals.c_str());
+                    if(localOptions.animationAngleTolerance <= 0.) {
+                        localOptions.animationAngleTolerance = 0.1;
+                    }
+                }
                 if (post_equals.length() > 0) {
                     if (pre_equals == "tangentSpaceTextureUnit") {
                         localOptions.tangentSpaceTextureUnit = atoi(post_equals.c_str());
@@ -289,9 +342,18 @@ public:
                     if (pre_equals == "maxIndexValue") {
                         localOptions.maxIndexValue = atoi(post_equals.c_str());
                     }
+                    if(pre_equals == "animationAngleTolerance") {
+                        localOptions.animationAngleTolerance = osg::asciiToDouble(post_equals.c_str());
+                    }
                     if(pre_equals == "maxMorphTarget") {
                         localOptions.maxMorphTarget = atoi(post_equals.c_str());
                     }
+                    if(pre_equals == "numThreads") {
+                        localOptions.numThreads = atoi(post_equals.c_str());
+                    }
+                    if(pre_equals == "weldingEpsilon") {
+                        localOptions.weldingEpsilon = osg::asciiToDouble(post_equals.c_str());
+                    }
                 }
             }
         }
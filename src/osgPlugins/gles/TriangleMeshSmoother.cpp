@@ -1,7 +1,7 @@
 #include "TriangleMeshSmoother"
 
 
-TriangleMeshSmoother::TriangleMeshSmoother(osg::Geometry& geometry, float creaseAngle, bool comparePosition, int mode):
+TriangleMeshSmoother::TriangleMeshSmoother(osg::Geometry& geometry, float creaseAngle, bool comparePosition, int mode, StatLogger* logger):
     _geometry(geometry),
     _creaseAngle(creaseAngle),
     _graph(0),
@@ -24,7 +24,7 @@ TriangleMeshSmoother::TriangleMeshSmoother(osg::Geometry& geometry, float crease
     }
 
     // build a unifier to consider deduplicated vertex indices
-    _graph = new TriangleMeshGraph(_geometry, comparePosition);
+    _graph = new TriangleMeshGraph(_geometry, comparePosition, logger);
 
     unsigned int nbTriangles = 0;
     for(unsigned int i = 0 ; i < _geometry.getNumPrimitiveSets() ; ++ i) {
@@ -150,8 +150,9 @@ void TriangleMeshSmoother::computeVertexNormals() {
         (*normals)[i].set(0.f, 0.f, 0.f);
     }
 
-    for(VertexIterator uniqueIndex = _graph->begin() ; uniqueIndex != _graph->end() ; ++ uniqueIndex) {
-        unsigned int index = uniqueIndex->_index;
+    IndexVector uniqueVertices = _graph->uniqueVertices();
+    for(IndexVector::const_iterator uniqueIndex = uniqueVertices.begin() ; uniqueIndex != uniqueVertices.end() ; ++ uniqueIndex) {
+        unsigned int index = *uniqueIndex;
         std::set<unsigned int> processed;
 
         std::vector<IndexVector> oneRing = _graph->vertexOneRing(index, _creaseAngle);
@@ -41,6 +41,7 @@
 #include <osgDB/ReadFile>
 #include <osgDB/FileUtils>
 #include <osgDB/FileNameUtils>
+#include <osgDB/MappedFile>
 
 #include <osgUtil/TriStripVisitor>
 #include <osgUtil/SmoothingVisitor>
@@ -63,6 +64,7 @@ public:
         supportsOption("noTriStripPolygons","Do not do the default tri stripping of polygons");
         supportsOption("generateFacetNormals","generate facet normals for verticies without normals");
         supportsOption("noReverseFaces","avoid to reverse faces when normals and triangles orientation are reversed");
+        supportsOption("readThreads=<n>","Number of threads parsing the file, one per processor by default");
 
         supportsOption("DIFFUSE=<unit>", "Set texture unit for diffuse texture");
         supportsOption("AMBIENT=<unit>", "Set texture unit for ambient texture");
@@ -149,6 +151,7 @@ protected:
         bool generateFacetNormals;
         bool fixBlackMaterials;
         bool noReverseFaces;
+        unsigned int readThreads;
         // This is the order in which the materials will be assigned to texture maps, unless
         // otherwise overriden
         typedef std::vector< std::pair<int,obj::Material::Map::TextureMapType> > TextureAllocationMap;
@@ -837,6 +840,7 @@ ReaderWriterOBJ::ObjOptionsStruct ReaderWriterOBJ::parseOptions(const osgDB::Rea
     localOptions.generateFacetNormals = false;
     localOptions.fixBlackMaterials = true;
     localOptions.noReverseFaces = false;
+    localOptions.readThreads = 0;
     localOptions.precision = std::numeric_limits<double>::digits10 + 2;
 
     if (options!=NULL)
@@ -880,6 +884,10 @@ ReaderWriterOBJ::ObjOptionsStruct ReaderWriterOBJ::parseOptions(const osgDB::Rea
             {
                 localOptions.noReverseFaces = true;
             }
+            else if (pre_equals == "readThreads")
+            {
+                localOptions.readThreads = std::max(std::atoi(post_equals.c_str()), 0);
+            }
             else if (pre_equals == "precision")
             {
                 int val = std::atoi(post_equals.c_str());
@@ -926,25 +934,32 @@ osgDB::ReaderWriter::ReadResult ReaderWriterOBJ::readNode(const std::string& fil
     if (fileName.empty()) return ReadResult::FILE_NOT_FOUND;
 
 
-    osgDB::ifstream fin(fileName.c_str());
-    if (fin)
-    {
+    // code for setting up the database path so that internally referenced file are searched for on relative paths.
+    osg::ref_ptr<Options> local_opt = options ? static_cast<Options*>(options->clone(osg::CopyOp::SHALLOW_COPY)) : new Options;
+    local_opt->getDatabasePathList().push_front(osgDB::getFilePath(fileName));
 
-        // code for setting up the database path so that internally referenced file are searched for on relative paths.
-        osg::ref_ptr<Options> local_opt = options ? static_cast<Options*>(options->clone(osg::CopyOp::SHALLOW_COPY)) : new Options;
-        local_opt->getDatabasePathList().push_front(osgDB::getFilePath(fileName));
+    ObjOptionsStruct localOptions = parseOptions(options);
 
-        obj::Model model;
-        model.setDatabasePath(osgDB::getFilePath(fileName.c_str()));
-        model.readOBJ(fin, local_opt.get());
+    obj::Model model;
+    model.setDatabasePath(osgDB::getFilePath(fileName.c_str()));
 
-        ObjOptionsStruct localOptions = parseOptions(options);
+    // parse the file in place and in parallel when it can be mapped, through a stream otherwise.
+    osg::ref_ptr<osgDB::MappedFile> mappedFile = new osgDB::MappedFile(fileName);
+    if (mappedFile->valid())
+    {
+        model.readOBJ(mappedFile->data(), mappedFile->size(), local_opt.get(), localOptions.readThreads);
+    }
+    else
+    {
+        osgDB::ifstream fin(fileName.c_str());
+        if (!fin) return ReadResult::FILE_NOT_HANDLED;
 
-        osg::Node* node = convertModelToSceneGraph(model, localOptions, local_opt.get());
-        return node;
+        model.readOBJ(fin, local_opt.get());
     }
+    mappedFile = 0;
 
-    return ReadResult::FILE_NOT_HANDLED;
+    osg::Node* node = convertModelToSceneGraph(model, localOptions, local_opt.get());
+    return node;
 }
 
 osgDB::ReaderWriter::ReadResult ReaderWriterOBJ::readNode(std::istream& fin, const Options* options) const
@@ -21,10 +21,17 @@
 #include "obj.h"
 
 #include <osg/Notify>
+#include <osg/Types>
 
 #include <osgDB/FileUtils>
 #include <osgDB/FileNameUtils>
 
+#include <OpenThreads/Atomic>
+#include <OpenThreads/Thread>
+
+#include <algorithm>
+#include <float.h>
+#include <limits.h>
 #include <string.h>
 
 using namespace obj;
@@ -120,28 +127,67 @@ static Material::Map parseTextureMap( const std::string& ss, Material::Map::Text
     return map;
 }
 
-bool Model::readline(std::istream& fin, char* line, const int LINE_SIZE)
+namespace
 {
-    if (LINE_SIZE<1) return false;
+    // Reads characters from memory through the subset of the std::istream interface used by readline.
+    class MemoryStream
+    {
+    public:
+        MemoryStream(const char* begin, const char* end):
+            _ptr(begin),
+            _end(end),
+            _failed(false) {}
+
+        int get()
+        {
+            if (_ptr<_end) return static_cast<unsigned char>(*_ptr++);
+            _failed = true;
+            return std::char_traits<char>::eof();
+        }
+
+        int peek() const { return _ptr<_end ? static_cast<unsigned char>(*_ptr) : std::char_traits<char>::eof(); }
+
+        const char* position() const { return _ptr; }
 
-    bool eatWhiteSpaceAtStart = true;
-    bool changeTabsToSpaces = true;
+        operator bool () const { return !_failed; }
 
-    char* ptr = line;
-    char* end = line+LINE_SIZE-1;
-    bool skipNewline = false;
-    while (fin && ptr<end)
+    protected:
+        const char* _ptr;
+        const char* _end;
+        bool        _failed;
+    };
+
+    template<class Stream>
+    void readLine(Stream& fin, char* line, const int LINE_SIZE)
     {
+        bool eatWhiteSpaceAtStart = true;
+        bool changeTabsToSpaces = true;
 
-        int c=fin.get();
-        int p=fin.peek();
-        if (c=='\r')
+        char* ptr = line;
+        char* end = line+LINE_SIZE-1;
+        bool skipNewline = false;
+        while (fin && ptr<end)
         {
-            if (p=='\n')
+
+            int c=fin.get();
+            int p=fin.peek();
+            if (c=='\r')
             {
-                // we have a windows line endings.
-                fin.get();
-                // OSG_NOTICE<<"We have dos line ending"<<std::endl;
+                if (p=='\n')
+                {
+                    // we have a windows line endings.
+                    fin.get();
+                    // OSG_NOTICE<<"We have dos line ending"<<std::endl;
+                    if (skipNewline)
+                    {
+                        skipNewline = false;
+                        *ptr++ = ' ';
+                        continue;
+                    }
+                    else break;
+                }
+                // we have Mac line ending
+                // OSG_NOTICE<<"We have mac line ending"<<std::endl;
                 if (skipNewline)
                 {
                     skipNewline = false;
@@ -150,62 +196,60 @@ bool Model::readline(std::istream& fin, char* line, const int LINE_SIZE)
                 }
                 else break;
             }
-            // we have Mac line ending
-            // OSG_NOTICE<<"We have mac line ending"<<std::endl;
-            if (skipNewline)
+            else if (c=='\n')
             {
-                skipNewline = false;
-                *ptr++ = ' ';
-                continue;
+                // we have unix line ending.
+                // OSG_NOTICE<<"We have unix line ending"<<std::endl;
+                if (skipNewline)
+                {
+                    *ptr++ = ' ';
+                    continue;
+                }
+                else break;
             }
-            else break;
-        }
-        else if (c=='\n')
-        {
-            // we have unix line ending.
-            // OSG_NOTICE<<"We have unix line ending"<<std::endl;
-            if (skipNewline)
+            else if (c=='\\' && (p=='\r' || p=='\n'))
             {
-                *ptr++ = ' ';
-                continue;
+                // need to keep return;
+                skipNewline = true;
             }
-            else break;
+            else if (c!=std::ifstream::traits_type::eof()) // don't copy eof.
+            {
+                skipNewline = false;
+
+                if (!eatWhiteSpaceAtStart || (c!=' ' && c!='\t'))
+                {
+                    eatWhiteSpaceAtStart = false;
+                    *ptr++ = c;
+                }
+            }
+
+
         }
-        else if (c=='\\' && (p=='\r' || p=='\n'))
+
+        // strip trailing spaces
+        while (ptr>line && *(ptr-1)==' ')
         {
-            // need to keep return;
-            skipNewline = true;
+            --ptr;
         }
-        else if (c!=std::ifstream::traits_type::eof()) // don't copy eof.
+
+        *ptr = 0;
+
+        if (changeTabsToSpaces)
         {
-            skipNewline = false;
 
-            if (!eatWhiteSpaceAtStart || (c!=' ' && c!='\t'))
+            for(ptr = line; *ptr != 0; ++ptr)
             {
-                eatWhiteSpaceAtStart = false;
-                *ptr++ = c;
+                if (*ptr == '\t') *ptr=' ';
             }
         }
-
-
-    }
-
-    // strip trailing spaces
-    while (ptr>line && *(ptr-1)==' ')
-    {
-        --ptr;
     }
+}
 
-    *ptr = 0;
-
-    if (changeTabsToSpaces)
-    {
+bool Model::readline(std::istream& fin, char* line, const int LINE_SIZE)
+{
+    if (LINE_SIZE<1) return false;
 
-        for(ptr = line; *ptr != 0; ++ptr)
-        {
-            if (*ptr == '\t') *ptr=' ';
-        }
-    }
+    readLine(fin, line, LINE_SIZE);
 
     return true;
 }
@@ -559,23 +603,159 @@ std::string trim(const std::string& s)
   return std::string(s, b, e - b + 1);
 }
 
-inline bool isZBrushColorField(char* line)
+inline bool isZBrushColorField(const char* line)
 {
     return strncmp(line, "#MRGB", 5) == 0;
 }
 
-bool Model::readOBJ(std::istream& fin, const osgDB::ReaderWriter::Options* options)
+namespace
 {
-    OSG_INFO<<"Reading OBJ file"<<std::endl;
+    inline bool isSpace(char c)
+    {
+        return c==' ' || c=='\t' || c=='\n' || c=='\v' || c=='\f' || c=='\r';
+    }
 
-    const int LINE_SIZE = 4096;
-    char line[LINE_SIZE];
-    float x = 0.0f, y = 0.0f, z = 0.0f, w = 0.0f;
-    float r,g,b,a;
+    inline bool isDigit(char c)
+    {
+        return c>='0' && c<='9';
+    }
 
-    while (fin)
+    // scanf("%f") fallback for the numbers the fast path doesn't convert
+    const char* scanFloat(const char* start, float& value)
     {
-        readline(fin,line,LINE_SIZE);
+        int length = 0;
+        return sscanf(start, "%f%n", &value, &length)==1 ? start+length : 0;
+    }
+
+    // Parses a float as scanf("%f") does, returning the end of the number or 0 if there is none.
+    // Plain decimal numbers are converted without sscanf, so without locale lookups nor allocation:
+    // a significand of up to 15 digits and a power of ten up to 22 are both exact doubles, so their
+    // product or quotient is the correctly rounded double, which rounds to the correctly rounded float
+    // unless it lies exactly halfway between two floats. That case, and other forms (hexadecimal,
+    // inf, nan, long significands, large exponents, denormals), are left to sscanf.
+    const char* parseFloat(const char* ptr, float& value)
+    {
+        static const double powersOfTen[] =
+        {
+            1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+            1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+        };
+
+        while (isSpace(*ptr)) ++ptr;
+        const char* start = ptr;
+
+        bool negative = false;
+        if (*ptr=='-' || *ptr=='+') negative = (*ptr++=='-');
+
+        double significand = 0.0;
+        int numDigits = 0, exponent = 0;
+        bool hasDigits = false;
+        for(; isDigit(*ptr); ++ptr)
+        {
+            hasDigits = true;
+            if (numDigits>0 || *ptr!='0')
+            {
+                if (++numDigits>15) return scanFloat(start, value);
+                significand = significand*10.0 + (*ptr-'0');
+            }
+        }
+        if (*ptr=='.')
+        {
+            for(++ptr; isDigit(*ptr); ++ptr)
+            {
+                hasDigits = true;
+                --exponent;
+                if (numDigits>0 || *ptr!='0')
+                {
+                    if (++numDigits>15) return scanFloat(start, value);
+                    significand = significand*10.0 + (*ptr-'0');
+                }
+            }
+        }
+        if (!hasDigits || *ptr=='x' || *ptr=='X') return scanFloat(start, value);
+
+        if (*ptr=='e' || *ptr=='E')
+        {
+            const char* exponentPtr = ptr+1;
+            bool negativeExponent = false;
+            if (*exponentPtr=='-' || *exponentPtr=='+') negativeExponent = (*exponentPtr++=='-');
+            if (!isDigit(*exponentPtr)) return scanFloat(start, value);
+
+            int explicitExponent = 0;
+            for(; isDigit(*exponentPtr); ++exponentPtr)
+            {
+                if (explicitExponent>1000) return scanFloat(start, value);
+                explicitExponent = explicitExponent*10 + (*exponentPtr-'0');
+            }
+            exponent += negativeExponent ? -explicitExponent : explicitExponent;
+            ptr = exponentPtr;
+        }
+
+        if (numDigits==0)
+        {
+            value = negative ? -0.0f : 0.0f;
+            return ptr;
+        }
+        if (exponent<-22 || exponent>22) return scanFloat(start, value);
+
+        double result = exponent<0 ? significand/powersOfTen[-exponent] : significand*powersOfTen[exponent];
+        if (result>FLT_MAX || result<FLT_MIN) return scanFloat(start, value);
+
+        // the 29 low bits of the double significand are dropped when rounding to float
+        uint64_t bits;
+        memcpy(&bits, &result, sizeof(bits));
+        if ((bits & 0x1fffffff)==0x10000000) return scanFloat(start, value);
+
+        value = static_cast<float>(negative ? -result : result);
+        return ptr;
+    }
+
+    // Parses up to maxValues floats separated by white spaces, as scanf("%f %f ...") does.
+    unsigned int parseFloats(const char* ptr, float* values, unsigned int maxValues)
+    {
+        unsigned int numValues = 0;
+        while (numValues<maxValues && (ptr = parseFloat(ptr, values[numValues]))!=0)
+        {
+            ++numValues;
+        }
+        return numValues;
+    }
+
+    // Parses an int as scanf("%d") does, returning the end of the number or 0 if there is none
+    // or if it does not fit in an int.
+    const char* parseInt(const char* ptr, int& value)
+    {
+        while (isSpace(*ptr)) ++ptr;
+
+        bool negative = false;
+        if (*ptr=='-' || *ptr=='+') negative = (*ptr++=='-');
+        if (!isDigit(*ptr)) return 0;
+
+        // accumulated as unsigned and checked at each digit so that it can never wrap
+        const unsigned int limit = negative ? static_cast<unsigned int>(INT_MAX)+1u : static_cast<unsigned int>(INT_MAX);
+        unsigned int result = 0;
+        bool overflow = false;
+        for(; isDigit(*ptr); ++ptr)
+        {
+            unsigned int digit = *ptr-'0';
+            if (result > (limit-digit)/10) overflow = true;
+            else result = result*10 + digit;
+        }
+        if (overflow) return 0;
+
+        value = (negative && result) ? -static_cast<int>(result-1u)-1 : static_cast<int>(result);
+        return ptr;
+    }
+
+    // Parses the comments, zBrush colors, vertices, normals and texture coordinates lines,
+    // returning false for the other lines.
+    bool readVertexData(const char* line, Model::Vec3Array& vertices, Model::Vec3Array& normals, Model::Vec2Array& texcoords, Model::Vec4Array& colors)
+    {
+        float values[7];
+        float& x = values[0];
+        float& y = values[1];
+        float& z = values[2];
+
         if ((line[0]=='#' && !isZBrushColorField(line)) || line[0]=='$')
         {
             // comment line
@@ -594,231 +774,167 @@ bool Model::readOBJ(std::istream& fin, const osgDB::ReaderWriter::Options* optio
                 colorFields = colorFields.substr(2);
 
                 currentValue = colorFields.substr(0,2);
-                r = static_cast<float>(strtol(currentValue.c_str(), NULL, 16)) / 255.;
+                float r = static_cast<float>(strtol(currentValue.c_str(), NULL, 16)) / 255.;
                 colorFields = colorFields.substr(2);
 
                 currentValue = colorFields.substr(0,2);
-                g = static_cast<float>(strtol(currentValue.c_str(), NULL, 16)) / 255.;
+                float g = static_cast<float>(strtol(currentValue.c_str(), NULL, 16)) / 255.;
                 colorFields = colorFields.substr(2);
 
                 currentValue = colorFields.substr(0,2);
-                b = static_cast<float>(strtol(currentValue.c_str(), NULL, 16)) / 255.;
+                float b = static_cast<float>(strtol(currentValue.c_str(), NULL, 16)) / 255.;
                 colorFields = colorFields.substr(2);
 
                 colors.push_back(osg::Vec4(r, g, b, 1.0));
             }
         }
-        else if (strlen(line)>0)
+        else if (line[0]==0)
         {
-            if (strncmp(line,"v ",2)==0)
-            {
-                unsigned int fieldsRead = sscanf(line+2,"%f %f %f %f %f %f %f", &x, &y, &z, &w, &g, &b, &a);
-
-                if (fieldsRead==1)
-                    vertices.push_back(osg::Vec3(x,0.0f,0.0f));
-                else if (fieldsRead==2)
-                    vertices.push_back(osg::Vec3(x,y,0.0f));
-                else if (fieldsRead==3)
-                    vertices.push_back(osg::Vec3(x,y,z));
-                else if (fieldsRead == 4)
-                    vertices.push_back(osg::Vec3(x/w,y/w,z/w));
-                else if (fieldsRead == 6)
-                {
-                    vertices.push_back(osg::Vec3(x,y,z));
-                    colors.push_back(osg::Vec4(w, g, b, 1.0));
-                }
-                else if ( fieldsRead == 7 )
-                {
-                    vertices.push_back(osg::Vec3(x,y,z));
-                    colors.push_back(osg::Vec4(w, g, b, a));
-                }
-            }
-            else if (strncmp(line,"vn ",3)==0)
+            // empty line
+        }
+        else if (strncmp(line,"v ",2)==0)
+        {
+            unsigned int fieldsRead = parseFloats(line+2, values, 7);
+            float& w = values[3];
+
+            if (fieldsRead==1)
+                vertices.push_back(osg::Vec3(x,0.0f,0.0f));
+            else if (fieldsRead==2)
+                vertices.push_back(osg::Vec3(x,y,0.0f));
+            else if (fieldsRead==3)
+                vertices.push_back(osg::Vec3(x,y,z));
+            else if (fieldsRead == 4)
+                vertices.push_back(osg::Vec3(x/w,y/w,z/w));
+            else if (fieldsRead == 6)
             {
-                unsigned int fieldsRead = sscanf(line+3,"%f %f %f", &x, &y, &z);
-
-                if (fieldsRead==1) normals.push_back(osg::Vec3(x,0.0f,0.0f));
-                else if (fieldsRead==2) normals.push_back(osg::Vec3(x,y,0.0f));
-                else if (fieldsRead==3) normals.push_back(osg::Vec3(x,y,z));
+                vertices.push_back(osg::Vec3(x,y,z));
+                colors.push_back(osg::Vec4(w, values[4], values[5], 1.0));
             }
-            else if (strncmp(line,"vt ",3)==0)
+            else if ( fieldsRead == 7 )
             {
-                unsigned int fieldsRead = sscanf(line+3,"%f %f %f", &x, &y, &z);
-
-                if (fieldsRead==1) texcoords.push_back(osg::Vec2(x,0.0f));
-                else if (fieldsRead==2) texcoords.push_back(osg::Vec2(x,y));
-                else if (fieldsRead==3) texcoords.push_back(osg::Vec2(x,y));
+                vertices.push_back(osg::Vec3(x,y,z));
+                colors.push_back(osg::Vec4(w, values[4], values[5], values[6]));
             }
-            else if (strncmp(line,"l ",2)==0 ||
-                     strncmp(line,"p ",2)==0 ||
-                     strncmp(line,"f ",2)==0)
-            {
-                char* ptr = line+2;
-
-                Element* element = new Element( (line[0]=='p') ? Element::POINTS :
-                                                (line[0]=='l') ? Element::POLYLINE :
-                                                Element::POLYGON );
+        }
+        else if (strncmp(line,"vn ",3)==0)
+        {
+            unsigned int fieldsRead = parseFloats(line+3, values, 3);
 
-                // OSG_NOTICE<<"face"<<ptr<<std::endl;
+            if (fieldsRead==1) normals.push_back(osg::Vec3(x,0.0f,0.0f));
+            else if (fieldsRead==2) normals.push_back(osg::Vec3(x,y,0.0f));
+            else if (fieldsRead==3) normals.push_back(osg::Vec3(x,y,z));
+        }
+        else if (strncmp(line,"vt ",3)==0)
+        {
+            unsigned int fieldsRead = parseFloats(line+3, values, 3);
 
-                int vi=0, ti=0, ni=0;
-                while(*ptr!=0)
-                {
-                    // skip white space
-                    while(*ptr==' ') ++ptr;
+            if (fieldsRead==1) texcoords.push_back(osg::Vec2(x,0.0f));
+            else if (fieldsRead==2) texcoords.push_back(osg::Vec2(x,y));
+            else if (fieldsRead==3) texcoords.push_back(osg::Vec2(x,y));
+        }
+        else
+        {
+            return false;
+        }
 
-                    if (sscanf(ptr, "%d/%d/%d", &vi, &ti, &ni) == 3)
-                    {
-                        // OSG_NOTICE<<"   vi="<<vi<<"/ti="<<ti<<"/ni="<<ni<<std::endl;
-                        element->vertexIndices.push_back(remapVertexIndex(vi));
-                        element->normalIndices.push_back(remapNormalIndex(ni));
-                        element->texCoordIndices.push_back(remapTexCoordIndex(ti));
-                    }
-                    else if (sscanf(ptr, "%d//%d", &vi, &ni) == 2)
-                    {
-                        // OSG_NOTICE<<"   vi="<<vi<<"//ni="<<ni<<std::endl;
-                        element->vertexIndices.push_back(remapVertexIndex(vi));
-                        if (remapNormalIndex(ni) < static_cast<int>(normals.size()))
-                            element->normalIndices.push_back(remapNormalIndex(ni));
-                    }
-                    else if (sscanf(ptr, "%d/%d", &vi, &ti) == 2)
-                    {
-                        // OSG_NOTICE<<"   vi="<<vi<<"/ti="<<ti<<std::endl;
-                        element->vertexIndices.push_back(remapVertexIndex(vi));
-                        if (remapTexCoordIndex(ti) < static_cast<int>(texcoords.size()))
-                            element->texCoordIndices.push_back(remapTexCoordIndex(ti));
-                    }
-                    else if (sscanf(ptr, "%d", &vi) == 1)
-                    {
-                        // OSG_NOTICE<<"   vi="<<vi<<std::endl;
-                        element->vertexIndices.push_back(remapVertexIndex(vi));
-                    }
+        return true;
+    }
 
-                    // skip to white space or end of line
-                    while(*ptr!=' ' && *ptr!=0) ++ptr;
+    inline bool isElementLine(const char* line)
+    {
+        return strncmp(line,"l ",2)==0 ||
+               strncmp(line,"p ",2)==0 ||
+               strncmp(line,"f ",2)==0;
+    }
 
-                }
+    // Parses a point, polyline or face line, relative indices being resolved against
+    // the number of vertices, normals and texture coordinates read before the line.
+    Element* readElement(const char* line, int numVertices, int numNormals, int numTexCoords)
+    {
+        const char* ptr = line+2;
 
-                if (!element->normalIndices.empty() && element->normalIndices.size() != element->vertexIndices.size())
-                {
-                    element->normalIndices.clear();
-                }
+        Element* element = new Element( (line[0]=='p') ? Element::POINTS :
+                                        (line[0]=='l') ? Element::POLYLINE :
+                                        Element::POLYGON );
 
-                if (!element->texCoordIndices.empty() && element->texCoordIndices.size() != element->vertexIndices.size())
-                {
-                    element->texCoordIndices.clear();
-                }
+        // OSG_NOTICE<<"face"<<ptr<<std::endl;
 
-                if (!element->vertexIndices.empty())
-                {
-                    Element::CoordinateCombination coordateCombination = element->getCoordinateCombination();
-                    if (coordateCombination!=currentElementState.coordinateCombination)
-                    {
-                        currentElementState.coordinateCombination = coordateCombination;
-                        currentElementList = 0; // reset the element list to force a recompute of which ElementList to use
-                    }
-                    addElement(element);
-                }
-                else
-                {
-                    // empty element, don't both adding, just unref to delete it.
-                    element->unref();
-                }
+        int vi=0, ti=0, ni=0;
+        while(*ptr!=0)
+        {
+            // skip white space
+            while(*ptr==' ') ++ptr;
 
-            }
-            else if (strncmp(line,"usemtl ",7)==0)
-            {
-                std::string materialName( line+7 );
-                if (currentElementState.materialName != materialName)
-                {
-                    currentElementState.materialName = materialName;
-                    currentElementList = 0; // reset the element list to force a recompute of which ElementList to use
-                }
-            }
-            else if (strncmp(line,"mtllib ",7)==0)
-            {
-                std::string materialFileName = trim( line+7 );
-                std::string fullPathFileName = osgDB::findDataFile( materialFileName, options );
-                if (!fullPathFileName.empty())
-                {
-                    osgDB::ifstream mfin( fullPathFileName.c_str() );
-                    if (mfin)
-                    {
-                        OSG_INFO << "Obj reading mtllib '" << fullPathFileName << "'\n";
-                        readMTL(mfin);
-                    }
-                    else
-                    {
-                        OSG_WARN << "Obj unable to load mtllib '" << fullPathFileName << "'\n";
-                    }
-                }
-                else
-                {
-                    OSG_WARN << "Obj unable to find mtllib '" << materialFileName << "'\n";
-                }
-            }
-            else if (strncmp(line,"o ",2)==0)
+            const char* p;
+            if ((p = parseInt(ptr, vi))!=0 && *p=='/' && (p = parseInt(p+1, ti))!=0 && *p=='/' && parseInt(p+1, ni)!=0)
             {
-                std::string objectName(line+2);
-                if (currentElementState.objectName != objectName)
-                {
-                    currentElementState.objectName = objectName;
-                    currentElementList = 0; // reset the element list to force a recompute of which ElementList to use
-                }
+                // OSG_NOTICE<<"   vi="<<vi<<"/ti="<<ti<<"/ni="<<ni<<std::endl;
+                element->vertexIndices.push_back((vi<0) ? numVertices+vi : vi-1);
+                element->normalIndices.push_back((ni<0) ? numNormals+ni : ni-1);
+                element->texCoordIndices.push_back((ti<0) ? numTexCoords+ti : ti-1);
             }
-            else if (strcmp(line,"o")==0)
+            else if ((p = parseInt(ptr, vi))!=0 && p[0]=='/' && p[1]=='/' && parseInt(p+2, ni)!=0)
             {
-                std::string objectName(""); // empty name
-                if (currentElementState.objectName != objectName)
-                {
-                    currentElementState.objectName = objectName;
-                    currentElementList = 0; // reset the element list to force a recompute of which ElementList to use
-                }
+                // OSG_NOTICE<<"   vi="<<vi<<"//ni="<<ni<<std::endl;
+                element->vertexIndices.push_back((vi<0) ? numVertices+vi : vi-1);
+                int normalIndex = (ni<0) ? numNormals+ni : ni-1;
+                if (normalIndex < numNormals)
+                    element->normalIndices.push_back(normalIndex);
             }
-            else if (strncmp(line,"g ",2)==0)
+            else if ((p = parseInt(ptr, vi))!=0 && *p=='/' && parseInt(p+1, ti)!=0)
             {
-                std::string groupName(line+2);
-                if (currentElementState.groupName != groupName)
-                {
-                    currentElementState.groupName = groupName;
-                    currentElementList = 0; // reset the element list to force a recompute of which ElementList to use
-                }
+                // OSG_NOTICE<<"   vi="<<vi<<"/ti="<<ti<<std::endl;
+                element->vertexIndices.push_back((vi<0) ? numVertices+vi : vi-1);
+                int texCoordIndex = (ti<0) ? numTexCoords+ti : ti-1;
+                if (texCoordIndex < numTexCoords)
+                    element->texCoordIndices.push_back(texCoordIndex);
             }
-            else if (strcmp(line,"g")==0)
+            else if (parseInt(ptr, vi)!=0)
             {
-                std::string groupName(""); // empty name
-                if (currentElementState.groupName != groupName)
-                {
-                    currentElementState.groupName = groupName;
-                    currentElementList = 0; // reset the element list to force a recompute of which ElementList to use
-                }
+                // OSG_NOTICE<<"   vi="<<vi<<std::endl;
+                element->vertexIndices.push_back((vi<0) ? numVertices+vi : vi-1);
             }
-            else if (strncmp(line,"s ",2)==0)
-            {
-                int smoothingGroup=0;
-                if (strncmp(line+2,"off",3)==0) smoothingGroup = 0;
-                else
-                {
-                    int result = sscanf(line+2,"%d",&smoothingGroup);
-                    if (result!=1)
-                    {
-                        OSG_NOTICE <<"*** error reading smoothing group ***"<<std::endl;
-                    }
-                }
 
-                if (currentElementState.smoothingGroup != smoothingGroup)
-                {
-                    currentElementState.smoothingGroup = smoothingGroup;
-                    currentElementList = 0; // reset the element list to force a recompute of which ElementList to use
-                }
-            }
-            else
-            {
-                OSG_NOTICE <<"*** line not handled *** :"<<line<<std::endl;
-            }
+            // skip to white space or end of line
+            while(*ptr!=' ' && *ptr!=0) ++ptr;
 
         }
 
+        if (!element->normalIndices.empty() && element->normalIndices.size() != element->vertexIndices.size())
+        {
+            element->normalIndices.clear();
+        }
+
+        if (!element->texCoordIndices.empty() && element->texCoordIndices.size() != element->vertexIndices.size())
+        {
+            element->texCoordIndices.clear();
+        }
+
+        return element;
+    }
+}
+
+bool Model::readOBJ(std::istream& fin, const osgDB::ReaderWriter::Options* options)
+{
+    OSG_INFO<<"Reading OBJ file"<<std::endl;
+
+    const int LINE_SIZE = 4096;
+    char line[LINE_SIZE];
+
+    while (fin)
+    {
+        readline(fin,line,LINE_SIZE);
+        if (readVertexData(line, vertices, normals, texcoords, colors))
+        {
+        }
+        else if (isElementLine(line))
+        {
+            addParsedElement(readElement(line, vertices.size(), normals.size(), texcoords.size()));
+        }
+        else
+        {
+            readState(line, options);
+        }
     }
 #if 0
     OSG_NOTICE <<"vertices :"<<vertices.size()<<std::endl;
@@ -846,6 +962,353 @@ bool Model::readOBJ(std::istream& fin, const osgDB::ReaderWriter::Options* optio
     return true;
 }
 
+namespace
+{
+    // line other than vertex data, kept to be applied in order once all the chunks are parsed
+    struct Command
+    {
+        const char*             line;
+        bool                    isElement;
+        int                     numVertices;  // read before the line in its chunk
+        int                     numNormals;
+        int                     numTexCoords;
+        osg::ref_ptr<Element>   element;
+    };
+
+    struct Chunk
+    {
+        Chunk(): begin(0), end(0), vertexOffset(0), normalOffset(0), texCoordOffset(0) {}
+
+        const char*             begin;
+        const char*             end;
+
+        Model::Vec3Array        vertices;
+        Model::Vec3Array        normals;
+        Model::Vec2Array        texcoords;
+        Model::Vec4Array        colors;
+        std::vector<Command>    commands;
+
+        int                     vertexOffset; // read before the chunk
+        int                     normalOffset;
+        int                     texCoordOffset;
+    };
+
+    struct ChunkJob
+    {
+        ChunkJob(std::vector<Chunk>& chunks): _chunks(chunks) {}
+        virtual ~ChunkJob() {}
+
+        virtual void process(Chunk& chunk) = 0;
+
+        // processes the chunks not yet taken by another thread
+        void processChunks()
+        {
+            unsigned int numChunks = _chunks.size();
+            for(unsigned int i=(++_next)-1; i<numChunks; i=(++_next)-1)
+            {
+                process(_chunks[i]);
+            }
+        }
+
+        std::vector<Chunk>& _chunks;
+        OpenThreads::Atomic _next;
+    };
+
+    // parses the vertex data and records the other lines
+    struct ReadVertexDataJob : public ChunkJob
+    {
+        ReadVertexDataJob(std::vector<Chunk>& chunks): ChunkJob(chunks) {}
+
+        virtual void process(Chunk& chunk)
+        {
+            const int LINE_SIZE = 4096;
+            char line[LINE_SIZE];
+
+            MemoryStream fin(chunk.begin, chunk.end);
+            while (fin)
+            {
+                const char* start = fin.position();
+                readLine(fin, line, LINE_SIZE);
+                if (!readVertexData(line, chunk.vertices, chunk.normals, chunk.texcoords, chunk.colors))
+                {
+                    Command command;
+                    command.line = start;
+                    command.isElement = isElementLine(line);
+                    command.numVertices = chunk.vertices.size();
+                    command.numNormals = chunk.normals.size();
+                    command.numTexCoords = chunk.texcoords.size();
+                    chunk.commands.push_back(command);
+                }
+            }
+        }
+    };
+
+    // parses the elements once the number of vertices, normals and texcoords before each chunk is known
+    struct ReadElementsJob : public ChunkJob
+    {
+        ReadElementsJob(std::vector<Chunk>& chunks): ChunkJob(chunks) {}
+
+        virtual void process(Chunk& chunk)
+        {
+            const int LINE_SIZE = 4096;
+            char line[LINE_SIZE];
+
+            for(std::vector<Command>::iterator itr = chunk.commands.begin(); itr != chunk.commands.end(); ++itr)
+            {
+                if (!itr->isElement) continue;
+
+                MemoryStream fin(itr->line, chunk.end);
+                readLine(fin, line, LINE_SIZE);
+                itr->element = readElement(line,
+                                           chunk.vertexOffset + itr->numVertices,
+                                           chunk.normalOffset + itr->numNormals,
+                                           chunk.texCoordOffset + itr->numTexCoords);
+            }
+        }
+    };
+
+    class ChunkThread : public OpenThreads::Thread
+    {
+    public:
+        ChunkThread(ChunkJob& job): _job(job) {}
+
+        virtual void run() { _job.processChunks(); }
+
+    protected:
+        ChunkJob& _job;
+    };
+
+    void runJob(ChunkJob& job, unsigned int numThreads)
+    {
+        std::vector<ChunkThread*> threads;
+        for(unsigned int i=1; i<numThreads; ++i)
+        {
+            threads.push_back(new ChunkThread(job));
+            threads.back()->start();
+        }
+
+        job.processChunks();
+
+        for(unsigned int i=0; i<threads.size(); ++i)
+        {
+            threads[i]->join();
+            delete threads[i];
+        }
+    }
+
+    // Returns the start of the first line after position that readline, reading from the start of
+    // the data, would also start a line at: the line before must end with a new line preceded by an
+    // ordinary character, as a backslash or a previous new line can make it a line continuation.
+    const char* findLineStart(const char* position, const char* begin, const char* end)
+    {
+        for(const char* ptr = std::max(position, begin+2); ptr<end; ++ptr)
+        {
+            if (ptr[-1]!='\n') continue;
+
+            const char* last = ptr-2;
+            if (*last=='\r' && last>begin) --last;
+            if (*last!='\\' && *last!='\n' && *last!='\r') return ptr;
+        }
+        return end;
+    }
+
+    template<class T>
+    void append(std::vector<T>& destination, const std::vector<T>& source)
+    {
+        destination.insert(destination.end(), source.begin(), source.end());
+    }
+}
+
+bool Model::readOBJ(const char* data, std::size_t size, const osgDB::ReaderWriter::Options* options, unsigned int numThreads)
+{
+    OSG_INFO<<"Reading OBJ file"<<std::endl;
+
+    if (numThreads==0) numThreads = std::max(OpenThreads::GetNumberOfProcessors(), 1);
+
+    // several chunks per thread to balance the load, but large enough for the split to be cheap
+    const std::size_t minimumChunkSize = 1<<20;
+    std::size_t chunkSize = std::max(size/(numThreads*4), minimumChunkSize);
+
+    std::vector<Chunk> chunks;
+    const char* end = data+size;
+    for(const char* begin = data; begin<end; )
+    {
+        Chunk chunk;
+        chunk.begin = begin;
+        chunk.end = (static_cast<std::size_t>(end-begin)>chunkSize) ? findLineStart(begin+chunkSize, data, end) : end;
+        chunks.push_back(chunk);
+        begin = chunk.end;
+    }
+    numThreads = std::min(numThreads, static_cast<unsigned int>(chunks.size()));
+
+    OSG_INFO<<"Reading OBJ file in "<<chunks.size()<<" chunks with "<<numThreads<<" threads"<<std::endl;
+
+    ReadVertexDataJob readVertexData(chunks);
+    runJob(readVertexData, numThreads);
+
+    int numVertices = vertices.size(), numNormals = normals.size(), numTexCoords = texcoords.size();
+    std::size_t numColors = colors.size();
+    for(std::vector<Chunk>::iterator itr = chunks.begin(); itr != chunks.end(); ++itr)
+    {
+        itr->vertexOffset = numVertices;
+        itr->normalOffset = numNormals;
+        itr->texCoordOffset = numTexCoords;
+        numVertices += itr->vertices.size();
+        numNormals += itr->normals.size();
+        numTexCoords += itr->texcoords.size();
+        numColors += itr->colors.size();
+    }
+
+    ReadElementsJob readElements(chunks);
+    runJob(readElements, numThreads);
+
+    vertices.reserve(numVertices);
+    normals.reserve(numNormals);
+    texcoords.reserve(numTexCoords);
+    colors.reserve(numColors);
+
+    const int LINE_SIZE = 4096;
+    char line[LINE_SIZE];
+    for(std::vector<Chunk>::iterator itr = chunks.begin(); itr != chunks.end(); ++itr)
+    {
+        append(vertices, itr->vertices);
+        append(normals, itr->normals);
+        append(texcoords, itr->texcoords);
+        append(colors, itr->colors);
+        Model::Vec3Array().swap(itr->vertices);
+        Model::Vec3Array().swap(itr->normals);
+        Model::Vec2Array().swap(itr->texcoords);
+        Model::Vec4Array().swap(itr->colors);
+
+        for(std::vector<Command>::iterator citr = itr->commands.begin(); citr != itr->commands.end(); ++citr)
+        {
+            if (citr->isElement)
+            {
+                addParsedElement(citr->element.get());
+            }
+            else
+            {
+                MemoryStream fin(citr->line, itr->end);
+                readLine(fin, line, LINE_SIZE);
+                readState(line, options);
+            }
+        }
+        std::vector<Command>().swap(itr->commands);
+    }
+
+    return true;
+}
+
+void Model::addParsedElement(Element* element)
+{
+    osg::ref_ptr<Element> ref = element;
+    if (!element->vertexIndices.empty())
+    {
+        Element::CoordinateCombination coordateCombination = element->getCoordinateCombination();
+        if (coordateCombination!=currentElementState.coordinateCombination)
+        {
+            currentElementState.coordinateCombination = coordateCombination;
+            currentElementList = 0; // reset the element list to force a recompute of which ElementList to use
+        }
+        addElement(element);
+    }
+    // else empty element, don't both adding, ref will delete it.
+}
+
+void Model::readState(const char* line, const osgDB::ReaderWriter::Options* options)
+{
+    if (strncmp(line,"usemtl ",7)==0)
+    {
+        std::string materialName( line+7 );
+        if (currentElementState.materialName != materialName)
+        {
+            currentElementState.materialName = materialName;
+            currentElementList = 0; // reset the element list to force a recompute of which ElementList to use
+        }
+    }
+    else if (strncmp(line,"mtllib ",7)==0)
+    {
+        std::string materialFileName = trim( line+7 );
+        std::string fullPathFileName = osgDB::findDataFile( materialFileName, options );
+        if (!fullPathFileName.empty())
+        {
+            osgDB::ifstream mfin( fullPathFileName.c_str() );
+            if (mfin)
+            {
+                OSG_INFO << "Obj reading mtllib '" << fullPathFileName << "'\n";
+                readMTL(mfin);
+            }
+            else
+            {
+                OSG_WARN << "Obj unable to load mtllib '" << fullPathFileName << "'\n";
+            }
+        }
+        else
+        {
+            OSG_WARN << "Obj unable to find mtllib '" << materialFileName << "'\n";
+        }
+    }
+    else if (strncmp(line,"o ",2)==0)
+    {
+        std::string objectName(line+2);
+        if (currentElementState.objectName != objectName)
+        {
+            currentElementState.objectName = objectName;
+            currentElementList = 0; // reset the element list to force a recompute of which ElementList to use
+        }
+    }
+    else if (strcmp(line,"o")==0)
+    {
+        std::string objectName(""); // empty name
+        if (currentElementState.objectName != objectName)
+        {
+            currentElementState.objectName = objectName;
+            currentElementList = 0; // reset the element list to force a recompute of which ElementList to use
+        }
+    }
+    else if (strncmp(line,"g ",2)==0)
+    {
+        std::string groupName(line+2);
+        if (currentElementState.groupName != groupName)
+        {
+            currentElementState.groupName = groupName;
+            currentElementList = 0; // reset the element list to force a recompute of which ElementList to use
+        }
+    }
+    else if (strcmp(line,"g")==0)
+    {
+        std::string groupName(""); // empty name
+        if (currentElementState.groupName != groupName)
+        {
+            currentElementState.groupName = groupName;
+            currentElementList = 0; // reset the element list to force a recompute of which ElementList to use
+        }
+    }
+    else if (strncmp(line,"s ",2)==0)
+    {
+        int smoothingGroup=0;
+        if (strncmp(line+2,"off",3)==0) smoothingGroup = 0;
+        else
+        {
+            int result = sscanf(line+2,"%d",&smoothingGroup);
+            if (result!=1)
+            {
+                OSG_NOTICE <<"*** error reading smoothing group ***"<<std::endl;
+            }
+        }
+
+        if (currentElementState.smoothingGroup != smoothingGroup)
+        {
+            currentElementState.smoothingGroup = smoothingGroup;
+            currentElementList = 0; // reset the element list to force a recompute of which ElementList to use
+        }
+    }
+    else
+    {
+        OSG_NOTICE <<"*** line not handled *** :"<<line<<std::endl;
+    }
+}
+
 
 void Model::addElement(Element* element)
 {
@@ -198,9 +198,21 @@ public:
     bool readMTL(std::istream& fin);
     bool readOBJ(std::istream& fin, const osgDB::ReaderWriter::Options* options);
 
+    /** Read an OBJ file held in memory, typically mapped, building the same model as readOBJ(std::istream&,..):
+      * the data is split into line aligned chunks whose vertex data and elements are parsed by numThreads
+      * threads (0 for one per processor), the element indices being offset by the vertex data of the previous
+      * chunks, and the material, group and smoothing state lines are then applied in order.*/
+    bool readOBJ(const char* data, std::size_t size, const osgDB::ReaderWriter::Options* options, unsigned int numThreads = 0);
+
     bool readline(std::istream& fin, char* line, const int LINE_SIZE);
     void addElement(Element* element);
 
+    /** Add a parsed element to the list of the current state, discarding it if it has no vertex.*/
+    void addParsedElement(Element* element);
+
+    /** Apply a material, object, group or smoothing group line.*/
+    void readState(const char* line, const osgDB::ReaderWriter::Options* options);
+
     osg::Vec3 averageNormal(const Element& element) const;
     osg::Vec3 computeNormal(const Element& element) const;
     bool needReverse(const Element& element) const;
@@ -0,0 +1,92 @@
+#ifndef OSG2_MAPPEDFILESTREAM
+#define OSG2_MAPPEDFILESTREAM
+
+#include <osg/ref_ptr>
+#include <osgDB/MappedFile>
+#include <istream>
+#include <streambuf>
+#include <string>
+#include <string.h>
+
+/** Read only stream buffer exposing a whole file mapped in memory as its get area:
+  * reads are plain memory copies out of the page cache, with no intermediate
+  * buffering nor system call per read, and seeking only moves the get pointer. */
+class MappedFileBuffer : public std::streambuf
+{
+public:
+    MappedFileBuffer( const std::string& fileName )
+    :   _file(new osgDB::MappedFile(fileName)), _data(0), _size(0)
+    {
+        if ( _file->valid() )
+        {
+            // the get area is never written to, streambuf just wants non const pointers
+            _data = const_cast<char*>( _file->data() );
+            _size = _file->size();
+            setg( _data, _data, _data + _size );
+        }
+    }
+
+    bool isMapped() const { return _data!=0; }
+
+protected:
+    virtual std::streamsize showmanyc()
+    { return egptr() - gptr(); }
+
+    virtual std::streamsize xsgetn( char* s, std::streamsize n )
+    {
+        std::streamsize available = egptr() - gptr();
+        if ( n>available ) n = available;
+        if ( n>0 )
+        {
+            memcpy( s, gptr(), n );
+            setg( eback(), gptr() + n, egptr() );
+        }
+        return n;
+    }
+
+    virtual pos_type seekoff( off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which )
+    {
+        if ( !_data || !(which & std::ios_base::in) ) return pos_type(off_type(-1));
+
+        off_type position = off;
+        if ( dir==std::ios_base::cur ) position += gptr() - eback();
+        else if ( dir==std::ios_base::end ) position += static_cast<off_type>(_size);
+        return seekpos( pos_type(position), which );
+    }
+
+    virtual pos_type seekpos( pos_type pos, std::ios_base::openmode which )
+    {
+        off_type position = pos;
+        if ( !_data || !(which & std::ios_base::in) || position<0 || position>static_cast<off_type>(_size) )
+            return pos_type(off_type(-1));
+
+        setg( _data, _data + position, _data + _size );
+        return pos;
+    }
+
+    osg::ref_ptr<osgDB::MappedFile> _file;
+    char* _data;
+    size_t _size;
+
+private:
+    MappedFileBuffer( const MappedFileBuffer& );
+    MappedFileBuffer& operator=( const MappedFileBuffer& );
+};
+
+/** Input stream over a memory mapped file; the stream is failed if the file can't be mapped. */
+class MappedFileStream : public std::istream
+{
+public:
+    MappedFileStream( const std::string& fileName )
+    :   std::istream(0), _buffer(fileName)
+    {
+        if ( _buffer.isMapped() ) rdbuf( &_buffer );
+    }
+
+    bool isMapped() const { return _buffer.isMapped(); }
+
+protected:
+    MappedFileBuffer _buffer;
+};
+
+#endif
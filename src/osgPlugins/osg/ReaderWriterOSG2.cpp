@@ -19,6 +19,7 @@
 #include <stdlib.h>
 #include "AsciiStreamOperator.h"
 #include "BinaryStreamOperator.h"
+#include "MappedFileStream.h"
 #include "XmlStreamOperator.h"
 
 using namespace osgDB;
@@ -128,9 +129,12 @@ public:
         supportsOption( "Ascii", "Import/Export option: Force reading/writing ascii file" );
         supportsOption( "XML", "Import/Export option: Force reading/writing XML file" );
         supportsOption( "ForceReadingImage", "Import option: Load an empty image instead if required file missed" );
+        supportsOption( "DisableMemoryMapping", "Import option: Read binary files through a regular file stream instead of mapping them in memory" );
         supportsOption( "SchemaData", "Export option: Record inbuilt schema data into a binary file" );
         supportsOption( "SchemaFile=<file>", "Import/Export option: Use/Record an ascii schema file" );
         supportsOption( "Compressor=<name>", "Export option: Use an inbuilt or user-defined compressor" );
+        supportsOption( "CompressorLevel=<level>", "Export option: Compression level (0-9) of the zlib based compressors" );
+        supportsOption( "CompressorBlockSize=<bytes>", "Export option: Size of the independently compressed blocks of the chunked compressor" );
         supportsOption( "WriteImageHint=<hint>", "Export option: Hint of writing image to stream: "
                         "<IncludeData> writes Image::data() directly; "
                         "<IncludeFile> writes the image file itself to stream; "
@@ -174,6 +178,11 @@ public:
         return local_opt.release();
     }
 
+    bool useMemoryMapping( std::ios::openmode mode, const Options* options ) const
+    {
+        return (mode & std::ios::binary)!=0 && options->getPluginStringData("DisableMemoryMapping").empty();
+    }
+
     virtual ReadResult readObject( const std::string& file, const Options* options ) const
     {
         ReadResult result = ReadResult::FILE_LOADED;
@@ -182,6 +191,12 @@ public:
         Options* local_opt = prepareReading( result, fileName, mode, options );
         if ( !result.success() ) return result;
 
+        if ( useMemoryMapping(mode, local_opt) )
+        {
+            MappedFileStream mapped( fileName );
+            if ( mapped.isMapped() ) return readObject( mapped, local_opt );
+        }
+
         osgDB::ifstream istream( fileName.c_str(), mode );
         return readObject( istream, local_opt );
     }
@@ -213,6 +228,12 @@ public:
         Options* local_opt = prepareReading( result, fileName, mode, options );
         if ( !result.success() ) return result;
 
+        if ( useMemoryMapping(mode, local_opt) )
+        {
+            MappedFileStream mapped( fileName );
+            if ( mapped.isMapped() ) return readImage( mapped, local_opt );
+        }
+
         osgDB::ifstream istream( fileName.c_str(), mode );
         return readImage( istream, local_opt );
     }
@@ -244,6 +265,12 @@ public:
         Options* local_opt = prepareReading( result, fileName, mode, options );
         if ( !result.success() ) return result;
 
+        if ( useMemoryMapping(mode, local_opt) )
+        {
+            MappedFileStream mapped( fileName );
+            if ( mapped.isMapped() ) return readNode( mapped, local_opt );
+        }
+
         osgDB::ifstream istream( fileName.c_str(), mode );
         return readNode( istream, local_opt );
     }
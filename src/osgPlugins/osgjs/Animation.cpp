@@ -13,6 +13,7 @@
 #include <osgAnimation/StackedMatrixElement>
 #include <osgAnimation/StackedScaleElement>
 #include <osg/Array>
+#include <osg/Math>
 #include "JSON_Objects"
 #include "WriteVisitor"
 
@@ -39,6 +40,31 @@ ADD_ARRAY_TYPE(unsigned int,   osg::UIntArray);
 ADD_ARRAY_TYPE(unsigned short, osg::UShortArray);
 
 
+// quaternion keys are stored as normalized 16 bits integers (value = quantized / 32767)
+template<typename ArrayType>
+static osg::Array* quantizeKeys(ArrayType* array)
+{ return array; }
+
+static osg::Array* quantizeKeys(osg::QuatArray* array)
+{
+    osg::Vec4sArray* quantized = new osg::Vec4sArray;
+    quantized->reserve(array->size());
+    for(osg::QuatArray::const_iterator key = array->begin() ; key != array->end() ; ++ key) {
+        osg::Vec4d value = key->asVec4();
+        double length = value.length();
+        if(length > 0.) {
+            value /= length;
+        }
+        quantized->push_back(osg::Vec4s(static_cast<short>(osg::round(value.x() * 32767.)),
+                                         static_cast<short>(osg::round(value.y() * 32767.)),
+                                         static_cast<short>(osg::round(value.z() * 32767.)),
+                                         static_cast<short>(osg::round(value.w() * 32767.))));
+    }
+    quantized->setUserValue("quantization", std::string("normalized"));
+    return quantized;
+}
+
+
 template<typename T>
 bool addJSONChannel(const std::string& channelType, T* channel, bool packByCoords, JSONObject& anim, WriteVisitor* writer, osg::Object* parent) {
     if (channel && channel->getSampler()) {
@@ -73,7 +99,12 @@ bool addJSONChannel(const std::string& channelType, T* channel, bool packByCoord
             values = valuesArray;
         }
 
-        jsKeys->getMaps()["Key"] = writer->createJSONBufferArray(values.get(), parent);
+        osg::ref_ptr<osg::Array> keyArray = values.get();
+        if(writer->getQuantizeQuaternions()) {
+            keyArray = quantizeKeys(values.get());
+        }
+
+        jsKeys->getMaps()["Key"] = writer->createJSONBufferArray(keyArray.get(), parent);
         json->getMaps()["KeyFrames"] = jsKeys;
 
         osg::ref_ptr<JSONObject> jsonChannel = new JSONObject();
@@ -13,6 +13,7 @@
 #include <osg/Texture2D>
 #include <osg/Texture1D>
 #include <osg/Image>
+#include <osg/ValueObject>
 #include <sstream>
 #include "WriteVisitor"
 
@@ -644,6 +645,30 @@ void JSONArray::write(json_stream& str,WriteVisitor& visitor)
 
 
 
+// dequantization parameters set by QuantizeBufferVisitor
+JSONObject* getJSONQuantization(const osg::Array* array)
+{
+    std::string mode;
+    if (!array->getUserValue("quantization", mode)) {
+        return 0;
+    }
+
+    JSONObject* quantization = new JSONObject;
+    quantization->getMaps()["Mode"] = new JSONValue<std::string>(mode);
+
+    osg::Vec3 offset3, scale3;
+    osg::Vec2 offset2, scale2;
+    if (array->getUserValue("quantization_offset", offset3) && array->getUserValue("quantization_scale", scale3)) {
+        quantization->getMaps()["Offset"] = new JSONVec3Array(offset3);
+        quantization->getMaps()["Scale"] = new JSONVec3Array(scale3);
+    }
+    else if (array->getUserValue("quantization_offset", offset2) && array->getUserValue("quantization_scale", scale2)) {
+        quantization->getMaps()["Offset"] = new JSONVec2Array(offset2);
+        quantization->getMaps()["Scale"] = new JSONVec2Array(scale2);
+    }
+    return quantization;
+}
+
 JSONObject* getDrawMode(GLenum mode)
 {
     JSONObject* result = 0;
@@ -0,0 +1,107 @@
+#include "MappedFile"
+
+#include <osgDB/fstream>
+#include <osg/Notify>
+
+#if defined(WIN32) && !defined(__CYGWIN__)
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+#else
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+
+MappedFile::MappedFile(const std::string& fileName):
+    _data(0),
+    _size(0),
+    _mapping(0),
+    _handle(0),
+    _opened(false)
+{
+#if defined(WIN32) && !defined(__CYGWIN__)
+    HANDLE file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(file != INVALID_HANDLE_VALUE) {
+        LARGE_INTEGER size;
+        if(GetFileSizeEx(file, &size)) {
+            _size = static_cast<size_t>(size.QuadPart);
+            if(_size == 0) {
+                _opened = true;
+            }
+            else {
+                HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+                if(mapping) {
+                    _data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+                    if(_data) {
+                        _mapping = mapping;
+                        _handle = file;
+                        _opened = true;
+                        return;
+                    }
+                    CloseHandle(mapping);
+                }
+            }
+        }
+        CloseHandle(file);
+    }
+#else
+    int file = open(fileName.c_str(), O_RDONLY);
+    if(file != -1) {
+        struct stat status;
+        if(fstat(file, &status) == 0) {
+            _size = static_cast<size_t>(status.st_size);
+            if(_size == 0) {
+                _opened = true;
+            }
+            else {
+                void* data = mmap(0, _size, PROT_READ, MAP_PRIVATE, file, 0);
+                if(data != MAP_FAILED) {
+                    _data = static_cast<const char*>(data);
+                    _mapping = data;
+                    _opened = true;
+                }
+            }
+        }
+        close(file);
+    }
+#endif
+
+    if(!_opened) {
+        // fallback to a regular read
+        osgDB::ifstream stream(fileName.c_str(), std::ios::in | std::ios::binary);
+        if(stream) {
+            stream.seekg(0, std::ios::end);
+            _buffer.resize(static_cast<size_t>(stream.tellg()));
+            stream.seekg(0, std::ios::beg);
+            if(!_buffer.empty()) {
+                stream.read(&_buffer[0], _buffer.size());
+            }
+            if(stream) {
+                _data = _buffer.empty() ? 0 : &_buffer[0];
+                _size = _buffer.size();
+                _opened = true;
+            }
+            else {
+                OSG_WARN << "MappedFile: unable to read '" << fileName << "'" << std::endl;
+            }
+        }
+    }
+}
+
+
+MappedFile::~MappedFile()
+{
+#if defined(WIN32) && !defined(__CYGWIN__)
+    if(_mapping) {
+        UnmapViewOfFile(_data);
+        CloseHandle(static_cast<HANDLE>(_mapping));
+        CloseHandle(static_cast<HANDLE>(_handle));
+    }
+#else
+    if(_mapping) {
+        munmap(_mapping, _size);
+    }
+#endif
+}
@@ -0,0 +1,1342 @@
+#include "ReadHandler"
+
+#include <osg/Endian>
+#include <osg/Geode>
+#include <osg/Geometry>
+#include <osg/LightSource>
+#include <osg/MatrixTransform>
+#include <osg/PagedLOD>
+#include <osg/Projection>
+#include <osg/Material>
+#include <osg/BlendFunc>
+#include <osg/BlendColor>
+#include <osg/CullFace>
+#include <osg/Texture2D>
+#include <osg/UserDataContainer>
+#include <osg/ValueObject>
+#include <osgDB/FileNameUtils>
+#include <osgDB/FileUtils>
+#include <osgDB/ReadFile>
+#include <osgDB/Registry>
+
+#include <osgAnimation/Bone>
+#include <osgAnimation/MorphGeometry>
+#include <osgAnimation/RigGeometry>
+#include <osgAnimation/Skeleton>
+
+#include <osgText/Text>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cmath>
+#include <cstring>
+#include <iterator>
+#include <sstream>
+
+#include "Base64"
+
+
+static const char* classNames[] = {
+    // nodes
+    "osg.Node",
+    "osg.MatrixTransform",
+    "osg.Projection",
+    "osg.LightSource",
+    "osg.PagedLOD",
+    "osgAnimation.Skeleton",
+    "osgAnimation.Bone",
+    // drawables
+    "osg.Geometry",
+    "osgAnimation.MorphGeometry",
+    "osgAnimation.RigGeometry",
+    "osgText.Text",
+    // primitives
+    "DrawArrays",
+    "DrawArrayLengths",
+    "DrawElementsUByte",
+    "DrawElementsUShort",
+    "DrawElementsUInt",
+    // states
+    "osg.StateSet",
+    "osg.Material",
+    "osg.BlendFunc",
+    "osg.BlendColor",
+    "osg.CullFace",
+    "osg.Texture",
+    "osg.Light",
+    // typed arrays
+    "Float32Array",
+    "Int8Array",
+    "Uint8Array",
+    "Int16Array",
+    "Uint16Array",
+    "Int32Array",
+    "Uint32Array",
+    0
+};
+
+
+static GLenum getDrawMode(const std::string& mode)
+{
+    if(mode == "POINTS") return GL_POINTS;
+    if(mode == "LINES") return GL_LINES;
+    if(mode == "LINE_LOOP") return GL_LINE_LOOP;
+    if(mode == "LINE_STRIP") return GL_LINE_STRIP;
+    if(mode == "TRIANGLE_STRIP") return GL_TRIANGLE_STRIP;
+    if(mode == "TRIANGLE_FAN") return GL_TRIANGLE_FAN;
+    return GL_TRIANGLES;
+}
+
+static GLenum getBlendFuncMode(const std::string& mode)
+{
+    if(mode == "DST_ALPHA") return osg::BlendFunc::DST_ALPHA;
+    if(mode == "DST_COLOR") return osg::BlendFunc::DST_COLOR;
+    if(mode == "ONE_MINUS_DST_ALPHA") return osg::BlendFunc::ONE_MINUS_DST_ALPHA;
+    if(mode == "ONE_MINUS_DST_COLOR") return osg::BlendFunc::ONE_MINUS_DST_COLOR;
+    if(mode == "ONE_MINUS_SRC_ALPHA") return osg::BlendFunc::ONE_MINUS_SRC_ALPHA;
+    if(mode == "ONE_MINUS_SRC_COLOR") return osg::BlendFunc::ONE_MINUS_SRC_COLOR;
+    if(mode == "SRC_ALPHA") return osg::BlendFunc::SRC_ALPHA;
+    if(mode == "SRC_ALPHA_SATURATE") return osg::BlendFunc::SRC_ALPHA_SATURATE;
+    if(mode == "SRC_COLOR") return osg::BlendFunc::SRC_COLOR;
+    if(mode == "CONSTANT_COLOR") return osg::BlendFunc::CONSTANT_COLOR;
+    if(mode == "ONE_MINUS_CONSTANT_COLOR") return osg::BlendFunc::ONE_MINUS_CONSTANT_COLOR;
+    if(mode == "CONSTANT_ALPHA") return osg::BlendFunc::CONSTANT_ALPHA;
+    if(mode == "ONE_MINUS_CONSTANT_ALPHA") return osg::BlendFunc::ONE_MINUS_CONSTANT_ALPHA;
+    if(mode == "ZERO") return osg::BlendFunc::ZERO;
+    return osg::BlendFunc::ONE;
+}
+
+static osg::Texture::FilterMode getFilterMode(const std::string& mode, osg::Texture::FilterMode defaultMode)
+{
+    if(mode == "LINEAR") return osg::Texture::LINEAR;
+    if(mode == "LINEAR_MIPMAP_LINEAR") return osg::Texture::LINEAR_MIPMAP_LINEAR;
+    if(mode == "LINEAR_MIPMAP_NEAREST") return osg::Texture::LINEAR_MIPMAP_NEAREST;
+    if(mode == "NEAREST") return osg::Texture::NEAREST;
+    if(mode == "NEAREST_MIPMAP_LINEAR") return osg::Texture::NEAREST_MIPMAP_LINEAR;
+    if(mode == "NEAREST_MIPMAP_NEAREST") return osg::Texture::NEAREST_MIPMAP_NEAREST;
+    return defaultMode;
+}
+
+static osg::Texture::WrapMode getWrapMode(const std::string& mode)
+{
+    if(mode == "CLAMP_TO_EDGE") return osg::Texture::CLAMP_TO_EDGE;
+    if(mode == "CLAMP_TO_BORDER") return osg::Texture::CLAMP_TO_BORDER;
+    if(mode == "REPEAT") return osg::Texture::REPEAT;
+    if(mode == "MIRROR") return osg::Texture::MIRROR;
+    return osg::Texture::CLAMP;
+}
+
+static osgText::Text::AlignmentType getAlignmentType(const std::string& type)
+{
+    if(type == "LEFT_CENTER") return osgText::Text::LEFT_CENTER;
+    if(type == "LEFT_BOTTOM") return osgText::Text::LEFT_BOTTOM;
+    if(type == "CENTER_TOP") return osgText::Text::CENTER_TOP;
+    if(type == "CENTER_CENTER") return osgText::Text::CENTER_CENTER;
+    if(type == "CENTER_BOTTOM") return osgText::Text::CENTER_BOTTOM;
+    if(type == "RIGHT_TOP") return osgText::Text::RIGHT_TOP;
+    if(type == "RIGHT_CENTER") return osgText::Text::RIGHT_CENTER;
+    if(type == "RIGHT_BOTTOM") return osgText::Text::RIGHT_BOTTOM;
+    if(type == "LEFT_BASE_LINE") return osgText::Text::LEFT_BASE_LINE;
+    if(type == "CENTER_BASE_LINE") return osgText::Text::CENTER_BASE_LINE;
+    if(type == "RIGHT_BASE_LINE") return osgText::Text::RIGHT_BASE_LINE;
+    if(type == "LEFT_BOTTOM_BASE_LINE") return osgText::Text::LEFT_BOTTOM_BASE_LINE;
+    if(type == "CENTER_BOTTOM_BASE_LINE") return osgText::Text::CENTER_BOTTOM_BASE_LINE;
+    if(type == "RIGHT_BOTTOM_BASE_LINE") return osgText::Text::RIGHT_BOTTOM_BASE_LINE;
+    return osgText::Text::LEFT_TOP;
+}
+
+static osg::Matrix getMatrix(const std::vector<double>& values)
+{
+    if(values.size() != 16) {
+        return osg::Matrix::identity();
+    }
+    return osg::Matrix(&values[0]);
+}
+
+// varint decoding, see JSONObject::varintEncoding; values are at most 32 bits wide, so longer
+// varints (more than 5 bytes) are rejected as corrupt
+template<typename T>
+static bool decodeVarint(const char* begin, const char* end, T* output, unsigned int count, bool zigzag)
+{
+    const unsigned char* current = reinterpret_cast<const unsigned char*>(begin);
+    const unsigned char* last = reinterpret_cast<const unsigned char*>(end);
+
+    for(unsigned int i = 0 ; i < count ; ++ i) {
+        unsigned int value = 0, shift = 0;
+        unsigned char byte;
+        do {
+            if(current == last || shift >= 32) {
+                return false;
+            }
+            byte = *current ++;
+            value |= static_cast<unsigned int>(byte & 0x7F) << shift;
+            shift += 7;
+        }
+        while(byte & 0x80);
+
+        if(zigzag) {
+            output[i] = static_cast<T>(static_cast<int>((value >> 1) ^ (~(value & 1) + 1)));
+        }
+        else {
+            output[i] = static_cast<T>(value);
+        }
+    }
+    return true;
+}
+
+template<typename T>
+static void appendElement(osg::Array* array, double value)
+{
+    static_cast<T*>(array)->push_back(static_cast<typename T::ElementDataType>(value));
+}
+
+
+
+const ReadHandler::Value* ReadHandler::Value::get(const std::string& key) const
+{
+    Record::const_iterator value = _record.find(key);
+    return value != _record.end() ? value->second.get() : 0;
+}
+
+double ReadHandler::Value::getNumber(const std::string& key, double defaultValue) const
+{
+    const Value* value = get(key);
+    return value && value->_type == NUMBER ? value->_number : defaultValue;
+}
+
+std::string ReadHandler::Value::getString(const std::string& key) const
+{
+    const Value* value = get(key);
+    return value && value->_type == STRING ? value->_string : std::string();
+}
+
+osg::Referenced* ReadHandler::Value::getObject(const std::string& key) const
+{
+    const Value* value = get(key);
+    return value ? value->getWrappedObject() : 0;
+}
+
+osg::Referenced* ReadHandler::Value::getWrappedObject() const
+{
+    if(_type == OBJECT) {
+        return _object.get();
+    }
+    if(_type == RECORD) {
+        for(Record::const_iterator value = _record.begin() ; value != _record.end() ; ++ value) {
+            if(value->second.valid() && value->second->_type == OBJECT) {
+                return value->second->_object.get();
+            }
+        }
+    }
+    return 0;
+}
+
+bool ReadHandler::Value::getVec(const std::string& key, float* v, unsigned int size) const
+{
+    const Value* value = get(key);
+    if(!value || value->_numbers.size() < size) {
+        return false;
+    }
+    for(unsigned int i = 0 ; i < size ; ++ i) {
+        v[i] = static_cast<float>(value->_numbers[i]);
+    }
+    return true;
+}
+
+
+
+ReadHandler::ReadHandler(const std::string& filePath, const osgDB::Options* options):
+    _filePath(filePath)
+{
+    _options = options ? static_cast<osgDB::Options*>(options->clone(osg::CopyOp::SHALLOW_COPY)) : new osgDB::Options;
+    if(!_filePath.empty()) {
+        _options->getDatabasePathList().push_front(_filePath);
+    }
+}
+
+osg::Node* ReadHandler::getRoot() const
+{
+    return _root.valid() ? _root->getObject<osg::Node>("osg.Node") : 0;
+}
+
+std::string ReadHandler::getCurrentKey() const
+{
+    if(_stack.empty()) {
+        return std::string();
+    }
+    const Frame& top = _stack.back();
+    return top._kind == Frame::OBJECT_FRAME ? top._currentKey : top._key;
+}
+
+bool ReadHandler::isClassName(const std::string& key) const
+{
+    for(const char** name = classNames ; *name ; ++ name) {
+        if(key == *name) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ReadHandler::isSkippedKey(const std::string& key) const
+{
+    if(key == "UpdateCallbacks") {
+        return true;
+    }
+    // unsupported class
+    if(key.compare(0, 3, "osg") == 0 && key.find('.') != std::string::npos && !isClassName(key)) {
+        OSG_INFO << "osgjs reader: skipping unsupported '" << key << "'" << std::endl;
+        return true;
+    }
+    return false;
+}
+
+bool ReadHandler::startObject()
+{
+    if(!_stack.empty()) {
+        Frame& top = _stack.back();
+        if(top._kind == Frame::SKIP_FRAME) {
+            ++ top._depth;
+            return true;
+        }
+        if(top._kind == Frame::ELEMENTS_FRAME) {
+            return false;
+        }
+    }
+
+    std::string key = getCurrentKey();
+    if(isSkippedKey(key)) {
+        _stack.push_back(Frame(Frame::SKIP_FRAME, key));
+        return true;
+    }
+
+    Frame frame(Frame::OBJECT_FRAME, key);
+    frame._value = new Value(Value::RECORD);
+    if(isClassName(key)) {
+        frame._className = key;
+        ScalarType type = getScalarType(key);
+        if(type != UNKNOWN_SCALAR) {
+            frame._data = new ArrayData(type);
+        }
+    }
+    _stack.push_back(frame);
+    return true;
+}
+
+bool ReadHandler::key(const std::string& key)
+{
+    if(_stack.empty()) {
+        return false;
+    }
+
+    Frame& top = _stack.back();
+    if(top._kind == Frame::OBJECT_FRAME) {
+        top._currentKey = key;
+        return true;
+    }
+    return top._kind == Frame::SKIP_FRAME;
+}
+
+bool ReadHandler::endObject()
+{
+    if(_stack.empty()) {
+        return false;
+    }
+
+    Frame& top = _stack.back();
+    if(top._kind == Frame::SKIP_FRAME) {
+        if(-- top._depth == 0) {
+            _stack.pop_back();
+        }
+        return true;
+    }
+    if(top._kind != Frame::OBJECT_FRAME) {
+        return false;
+    }
+
+    Frame frame = top;
+    _stack.pop_back();
+
+    osg::ref_ptr<Value> value = finish(frame);
+    return addValue(value.get());
+}
+
+bool ReadHandler::startArray()
+{
+    if(!_stack.empty()) {
+        Frame& top = _stack.back();
+        if(top._kind == Frame::SKIP_FRAME) {
+            ++ top._depth;
+            return true;
+        }
+        if(top._kind == Frame::ELEMENTS_FRAME) {
+            return false;
+        }
+    }
+
+    std::string key = getCurrentKey();
+    if(isSkippedKey(key)) {
+        _stack.push_back(Frame(Frame::SKIP_FRAME, key));
+        return true;
+    }
+
+    if(key == "Elements" && !_stack.empty() && _stack.back()._data.valid()) {
+        // typed array values are directly streamed in a typed osg array
+        ArrayData* data = _stack.back()._data.get();
+        data->_elements = createArray(data->_type, 1, 0);
+        if(!data->_elements) {
+            return false;
+        }
+
+        Frame frame(Frame::ELEMENTS_FRAME, key);
+        frame._data = data;
+        _stack.push_back(frame);
+        return true;
+    }
+
+    Frame frame(Frame::ARRAY_FRAME, key);
+    frame._value = new Value(Value::ARRAY);
+    _stack.push_back(frame);
+    return true;
+}
+
+bool ReadHandler::endArray()
+{
+    if(_stack.empty()) {
+        return false;
+    }
+
+    Frame& top = _stack.back();
+    switch(top._kind) {
+        case Frame::SKIP_FRAME:
+            if(-- top._depth == 0) {
+                _stack.pop_back();
+            }
+            return true;
+        case Frame::ELEMENTS_FRAME:
+            _stack.pop_back();
+            return true;
+        case Frame::ARRAY_FRAME:
+        {
+            osg::ref_ptr<Value> value = top._value;
+            _stack.pop_back();
+            return addValue(value.get());
+        }
+        default:
+            return false;
+    }
+}
+
+bool ReadHandler::value(const std::string& value)
+{
+    osg::ref_ptr<Value> json = new Value(Value::STRING);
+    json->_string = value;
+    return addValue(json.get());
+}
+
+bool ReadHandler::value(double value)
+{
+    if(_stack.empty()) {
+        return false;
+    }
+
+    // avoid allocating values for numerical arrays
+    Frame& top = _stack.back();
+    switch(top._kind) {
+        case Frame::SKIP_FRAME:
+            return true;
+        case Frame::ELEMENTS_FRAME:
+        {
+            osg::Array* elements = top._data->_elements.get();
+            switch(top._data->_type) {
+                case FLOAT32: appendElement<osg::FloatArray>(elements, value); break;
+                case INT8:    appendElement<osg::ByteArray>(elements, value); break;
+                case UINT8:   appendElement<osg::UByteArray>(elements, value); break;
+                case INT16:   appendElement<osg::ShortArray>(elements, value); break;
+                case UINT16:  appendElement<osg::UShortArray>(elements, value); break;
+                case INT32:   appendElement<osg::IntArray>(elements, value); break;
+                case UINT32:  appendElement<osg::UIntArray>(elements, value); break;
+                default:
+                    return false;
+            }
+            return true;
+        }
+        case Frame::ARRAY_FRAME:
+            top._value->_numbers.push_back(value);
+            return true;
+        default:
+        {
+            osg::ref_ptr<Value> json = new Value(Value::NUMBER);
+            json->_number = value;
+            return addValue(json.get());
+        }
+    }
+}
+
+bool ReadHandler::value(bool value)
+{
+    return this->value(value ? 1. : 0.);
+}
+
+bool ReadHandler::nullValue()
+{
+    if(!_stack.empty() && _stack.back()._kind == Frame::ELEMENTS_FRAME) {
+        return value(0.);
+    }
+    osg::ref_ptr<Value> json = new Value(Value::NONE);
+    return addValue(json.get());
+}
+
+bool ReadHandler::addValue(Value* value)
+{
+    if(_stack.empty()) {
+        _root = value;
+        return true;
+    }
+
+    Frame& top = _stack.back();
+    switch(top._kind) {
+        case Frame::SKIP_FRAME:
+            return true;
+        case Frame::OBJECT_FRAME:
+            top._value->_record[top._currentKey] = value;
+            return true;
+        case Frame::ARRAY_FRAME:
+            if(value && value->_type == Value::NUMBER) {
+                top._value->_numbers.push_back(value->_number);
+            }
+            else {
+                top._value->_values.push_back(value);
+            }
+            return true;
+        default:
+            return false;
+    }
+}
+
+ReadHandler::Value* ReadHandler::finish(Frame& frame)
+{
+    Value& value = *frame._value;
+    const Value* uid = value.get("UniqueID");
+
+    // shadow object referencing an object already read
+    if(uid && value._record.size() == 1) {
+        std::map<unsigned int, osg::ref_ptr<osg::Referenced> >::iterator object = _objects.find(static_cast<unsigned int>(uid->_number));
+        if(object != _objects.end()) {
+            Value* shadow = new Value(Value::OBJECT);
+            shadow->_object = object->second;
+            return shadow;
+        }
+    }
+
+    osg::ref_ptr<osg::Referenced> object;
+    if(frame._data.valid()) {
+        ArrayData* data = frame._data.get();
+        data->_file = value.getString("File");
+        data->_encoding = value.getString("Encoding");
+        data->_offset = static_cast<unsigned int>(value.getNumber("Offset"));
+        data->_hasSize = value.get("Size") != 0;
+        data->_size = static_cast<unsigned int>(value.getNumber("Size"));
+        object = data;
+    }
+    else if(!frame._className.empty()) {
+        object = createObject(frame._className, value);
+    }
+    else if(frame._key == "UserDataContainer") {
+        object = createUserDataContainer(value);
+    }
+    else if(value.get("Array") && value.get("ItemSize")) {
+        object = createBuffer(value, frame._key == "Indices");
+    }
+    else {
+        return frame._value.release();
+    }
+
+    if(!object) {
+        return new Value(Value::NONE);
+    }
+
+    if(uid) {
+        _objects[static_cast<unsigned int>(uid->_number)] = object;
+    }
+
+    Value* result = new Value(Value::OBJECT);
+    result->_object = object;
+    return result;
+}
+
+osg::Referenced* ReadHandler::createObject(const std::string& className, const Value& value)
+{
+    if(className == "osg.StateSet") {
+        return createStateSet(value);
+    }
+    if(className.compare(0, 4, "Draw") == 0) {
+        return createPrimitiveSet(className, value);
+    }
+    if(className == "osg.Geometry" || className == "osgAnimation.MorphGeometry" ||
+       className == "osgAnimation.RigGeometry" || className == "osgText.Text") {
+        return createDrawable(className, value);
+    }
+    if(className == "osg.Material" || className == "osg.BlendFunc" || className == "osg.BlendColor" ||
+       className == "osg.CullFace" || className == "osg.Texture" || className == "osg.Light") {
+        return createStateAttribute(className, value);
+    }
+    return createNode(className, value);
+}
+
+osg::UserDataContainer* ReadHandler::createUserDataContainer(const Value& value)
+{
+    osg::ref_ptr<osg::DefaultUserDataContainer> container = new osg::DefaultUserDataContainer;
+    container->setName(value.getString("Name"));
+
+    const Value* values = value.get("Values");
+    if(values) {
+        for(Value::List::const_iterator entry = values->_values.begin() ; entry != values->_values.end() ; ++ entry) {
+            if(entry->valid() && (*entry)->_type == Value::RECORD) {
+                // user values are stringified by the writer
+                container->addUserObject(new osg::StringValueObject((*entry)->getString("Name"),
+                                                                    (*entry)->getString("Value")));
+            }
+        }
+    }
+    return container.release();
+}
+
+void ReadHandler::readObject(osg::Object& object, const Value& value)
+{
+    const Value* name = value.get("Name");
+    if(name && name->_type == Value::STRING) {
+        object.setName(name->_string);
+    }
+
+    if(osg::UserDataContainer* container = value.getObject<osg::UserDataContainer>("UserDataContainer")) {
+        object.setUserDataContainer(container);
+    }
+}
+
+void ReadHandler::readNode(osg::Node& node, const Value& value)
+{
+    readObject(node, value);
+    if(osg::StateSet* stateSet = value.getObject<osg::StateSet>("StateSet")) {
+        node.setStateSet(stateSet);
+    }
+}
+
+void ReadHandler::readChildren(osg::Group& group, const Value& value)
+{
+    const Value* children = value.get("Children");
+    if(!children) {
+        return;
+    }
+
+    for(Value::List::const_iterator child = children->_values.begin() ; child != children->_values.end() ; ++ child) {
+        if(!child->valid()) continue;
+        if(osg::Node* node = dynamic_cast<osg::Node*>((*child)->getWrappedObject())) {
+            group.addChild(node);
+        }
+    }
+}
+
+osg::Node* ReadHandler::createNode(const std::string& className, const Value& value)
+{
+    osg::ref_ptr<osg::Group> group;
+
+    if(className == "osg.Node") {
+        // geodes are written as regular nodes having only drawable children
+        bool drawables = false, nodes = false;
+        if(const Value* children = value.get("Children")) {
+            for(Value::List::const_iterator child = children->_values.begin() ; child != children->_values.end() ; ++ child) {
+                if(!child->valid()) continue;
+                osg::Node* node = dynamic_cast<osg::Node*>((*child)->getWrappedObject());
+                if(node && node->asDrawable()) {
+                    drawables = true;
+                }
+                else if(node) {
+                    nodes = true;
+                }
+            }
+        }
+        group = (drawables && !nodes) ? new osg::Geode : new osg::Group;
+    }
+    else if(className == "osg.MatrixTransform") {
+        const Value* matrix = value.get("Matrix");
+        group = new osg::MatrixTransform(matrix ? getMatrix(matrix->_numbers) : osg::Matrix::identity());
+    }
+    else if(className == "osgAnimation.Skeleton") {
+        osg::ref_ptr<osgAnimation::Skeleton> skeleton = new osgAnimation::Skeleton;
+        if(const Value* matrix = value.get("Matrix")) {
+            skeleton->setMatrix(getMatrix(matrix->_numbers));
+        }
+        group = skeleton;
+    }
+    else if(className == "osgAnimation.Bone") {
+        osg::ref_ptr<osgAnimation::Bone> bone = new osgAnimation::Bone;
+        if(const Value* matrix = value.get("Matrix")) {
+            bone->setMatrix(getMatrix(matrix->_numbers));
+        }
+        if(const Value* matrix = value.get("InvBindMatrixInSkeletonSpace")) {
+            bone->setInvBindMatrixInSkeletonSpace(getMatrix(matrix->_numbers));
+        }
+        if(const Value* boundingBox = value.get("BoundingBox")) {
+            osg::Vec3 min, max;
+            if(boundingBox->getVec("min", min.ptr(), 3) && boundingBox->getVec("max", max.ptr(), 3)) {
+                bone->setUserValue("AABBonBone_min", min);
+                bone->setUserValue("AABBonBone_max", max);
+            }
+        }
+        group = bone;
+    }
+    else if(className == "osg.Projection") {
+        const Value* matrix = value.get("Matrix");
+        group = new osg::Projection(matrix ? getMatrix(matrix->_numbers) : osg::Matrix::identity());
+    }
+    else if(className == "osg.LightSource") {
+        osg::ref_ptr<osg::LightSource> lightSource = new osg::LightSource;
+        if(osg::Light* light = value.getObject<osg::Light>("Light")) {
+            lightSource->setLight(light);
+        }
+        group = lightSource;
+    }
+    else if(className == "osg.PagedLOD") {
+        osg::ref_ptr<osg::PagedLOD> plod = new osg::PagedLOD;
+
+        std::string centerMode = value.getString("CenterMode");
+        if(centerMode == "USER_DEFINED_CENTER") {
+            plod->setCenterMode(osg::LOD::USER_DEFINED_CENTER);
+        }
+        else if(centerMode == "UNION_OF_BOUNDING_SPHERE_AND_USER_DEFINED") {
+            plod->setCenterMode(osg::LOD::UNION_OF_BOUNDING_SPHERE_AND_USER_DEFINED);
+        }
+
+        osg::Vec4 center;
+        if(value.getVec("UserCenter", center.ptr(), 4)) {
+            plod->setCenter(osg::Vec3(center.x(), center.y(), center.z()));
+            plod->setRadius(center.w());
+        }
+
+        if(value.getString("RangeMode") == "PIXEL_SIZE_ON_SCREEN") {
+            plod->setRangeMode(osg::LOD::PIXEL_SIZE_ON_SCREEN);
+        }
+
+        const Value* ranges = value.get("RangeList");
+        const Value* files = value.get("RangeDataList");
+        for(unsigned int i = 0 ; ranges ; ++ i) {
+            std::ostringstream range, file;
+            range << "Range " << i;
+            file << "File " << i;
+
+            osg::Vec2 minMax;
+            if(!ranges->getVec(range.str(), minMax.ptr(), 2)) {
+                break;
+            }
+            plod->setRange(i, minMax.x(), minMax.y());
+            if(files && !files->getString(file.str()).empty()) {
+                plod->setFileName(i, files->getString(file.str()));
+            }
+        }
+        plod->setDatabasePath(_filePath.empty() ? _filePath : _filePath + osgDB::getNativePathSeparator());
+        group = plod;
+    }
+    else {
+        return 0;
+    }
+
+    readNode(*group, value);
+    readChildren(*group, value);
+    return group.release();
+}
+
+bool ReadHandler::readGeometry(osg::Geometry& geometry, const Value& value)
+{
+    readNode(geometry, value);
+
+    if(const Value* attributes = value.get("VertexAttributeList")) {
+        for(Value::Record::const_iterator attribute = attributes->_record.begin() ; attribute != attributes->_record.end() ; ++ attribute) {
+            osg::Array* array = attribute->second.valid() ? dynamic_cast<osg::Array*>(attribute->second->getWrappedObject()) : 0;
+            if(!array) {
+                OSG_WARN << "osgjs reader: invalid '" << attribute->first << "' attribute" << std::endl;
+                return false;
+            }
+
+            const std::string& name = attribute->first;
+            if(name == "Vertex") {
+                geometry.setVertexArray(array);
+            }
+            else if(name == "Normal") {
+                geometry.setNormalArray(array, osg::Array::BIND_PER_VERTEX);
+            }
+            else if(name == "Color") {
+                geometry.setColorArray(array, osg::Array::BIND_PER_VERTEX);
+            }
+            else if(name == "Tangent") {
+                array->setUserValue("tangent", true);
+                geometry.setVertexAttribArray(geometry.getNumVertexAttribArrays(), array, osg::Array::BIND_PER_VERTEX);
+            }
+            else if(name.compare(0, 8, "TexCoord") == 0) {
+                geometry.setTexCoordArray(atoi(name.c_str() + 8), array, osg::Array::BIND_PER_VERTEX);
+            }
+        }
+    }
+
+    if(const Value* primitives = value.get("PrimitiveSetList")) {
+        for(Value::List::const_iterator primitive = primitives->_values.begin() ; primitive != primitives->_values.end() ; ++ primitive) {
+            if(!primitive->valid()) continue;
+            if(osg::PrimitiveSet* primitiveSet = dynamic_cast<osg::PrimitiveSet*>((*primitive)->getWrappedObject())) {
+                geometry.addPrimitiveSet(primitiveSet);
+            }
+        }
+    }
+    return true;
+}
+
+osg::Drawable* ReadHandler::createDrawable(const std::string& className, const Value& value)
+{
+    if(className == "osg.Geometry") {
+        osg::ref_ptr<osg::Geometry> geometry = new osg::Geometry;
+        return readGeometry(*geometry, value) ? geometry.release() : 0;
+    }
+
+    if(className == "osgAnimation.MorphGeometry") {
+        osg::ref_ptr<osgAnimation::MorphGeometry> morphGeometry = new osgAnimation::MorphGeometry;
+        if(!readGeometry(*morphGeometry, value)) {
+            return 0;
+        }
+
+        if(const Value* targets = value.get("MorphTargets")) {
+            for(Value::List::const_iterator target = targets->_values.begin() ; target != targets->_values.end() ; ++ target) {
+                if(!target->valid()) continue;
+                if(osg::Geometry* geometry = dynamic_cast<osg::Geometry*>((*target)->getWrappedObject())) {
+                    // weights are driven by animations that are not read
+                    morphGeometry->addMorphTarget(geometry, 0.f);
+                }
+            }
+        }
+        return morphGeometry.release();
+    }
+
+    if(className == "osgAnimation.RigGeometry") {
+        osg::Geometry* source = value.getObject<osg::Geometry>("SourceGeometry");
+        if(!source) {
+            return 0;
+        }
+
+        osg::ref_ptr<osgAnimation::RigGeometry> rigGeometry = new osgAnimation::RigGeometry;
+        readObject(*rigGeometry, value);
+        rigGeometry->setSourceGeometry(source);
+
+        // restore bones/weights attributes as set by the gles RigAttributesVisitor
+        const Value* attributes = value.get("VertexAttributeList");
+        osg::Array* bones = attributes ? attributes->getObject<osg::Array>("Bones") : 0;
+        osg::Array* weights = attributes ? attributes->getObject<osg::Array>("Weights") : 0;
+        if(bones && weights) {
+            bones->setUserValue("bones", true);
+            if(const Value* boneMap = value.get("BoneMap")) {
+                for(Value::Record::const_iterator bone = boneMap->_record.begin() ; bone != boneMap->_record.end() ; ++ bone) {
+                    std::ostringstream oss;
+                    oss << "animationBone_" << static_cast<unsigned int>(bone->second->_number);
+                    bones->setUserValue(oss.str(), bone->first);
+                }
+            }
+            weights->setUserValue("weights", true);
+
+            rigGeometry->setVertexAttribArray(rigGeometry->getNumVertexAttribArrays(), bones, osg::Array::BIND_PER_VERTEX);
+            rigGeometry->setVertexAttribArray(rigGeometry->getNumVertexAttribArrays(), weights, osg::Array::BIND_PER_VERTEX);
+        }
+        return rigGeometry.release();
+    }
+
+    if(className == "osgText.Text") {
+        osg::ref_ptr<osgText::Text> text = new osgText::Text;
+        readNode(*text, value);
+
+        text->setText(value.getString("Text"), osgText::String::ENCODING_UTF8);
+
+        osg::Vec3 position;
+        if(value.getVec("Position", position.ptr(), 3)) {
+            text->setPosition(position);
+        }
+        osg::Vec4 color;
+        if(value.getVec("Color", color.ptr(), 4)) {
+            text->setColor(color);
+        }
+        text->setCharacterSize(value.getNumber("CharacterSize", 32.));
+        text->setAutoRotateToScreen(value.getNumber("AutoRotateToScreen") != 0.);
+        text->setAlignment(getAlignmentType(value.getString("Alignment")));
+
+        std::string layout = value.getString("Layout");
+        if(layout == "RIGHT_TO_LEFT") {
+            text->setLayout(osgText::Text::RIGHT_TO_LEFT);
+        }
+        else if(layout == "VERTICAL") {
+            text->setLayout(osgText::Text::VERTICAL);
+        }
+        return text.release();
+    }
+
+    return 0;
+}
+
+osg::PrimitiveSet* ReadHandler::createPrimitiveSet(const std::string& className, const Value& value)
+{
+    GLenum mode = getDrawMode(value.getString("Mode"));
+
+    if(className == "DrawArrays") {
+        return new osg::DrawArrays(mode,
+                                   static_cast<GLint>(value.getNumber("First")),
+                                   static_cast<GLsizei>(value.getNumber("Count")));
+    }
+
+    if(className == "DrawArrayLengths") {
+        osg::ref_ptr<osg::DrawArrayLengths> drawArrayLengths = new osg::DrawArrayLengths(mode, static_cast<GLint>(value.getNumber("First")));
+        if(const Value* lengths = value.get("ArrayLengths")) {
+            for(std::vector<double>::const_iterator length = lengths->_numbers.begin() ; length != lengths->_numbers.end() ; ++ length) {
+                drawArrayLengths->push_back(static_cast<GLsizei>(*length));
+            }
+        }
+        return drawArrayLengths.release();
+    }
+
+    // indices are directly read as DrawElements (see createBuffer)
+    osg::DrawElements* drawElements = value.getObject<osg::DrawElements>("Indices");
+    if(drawElements) {
+        drawElements->setMode(mode);
+    }
+    return drawElements;
+}
+
+osg::StateSet* ReadHandler::createStateSet(const Value& value)
+{
+    osg::ref_ptr<osg::StateSet> stateSet = new osg::StateSet;
+    readObject(*stateSet, value);
+
+    if(value.getString("RenderingHint") == "TRANSPARENT_BIN") {
+        stateSet->setRenderingHint(osg::StateSet::TRANSPARENT_BIN);
+    }
+
+    if(const Value* units = value.get("TextureAttributeList")) {
+        for(unsigned int unit = 0 ; unit < units->_values.size() ; ++ unit) {
+            const Value* attributes = units->_values[unit].get();
+            if(!attributes) continue;
+            for(Value::List::const_iterator attribute = attributes->_values.begin() ; attribute != attributes->_values.end() ; ++ attribute) {
+                if(!attribute->valid()) continue;
+                if(osg::Texture* texture = dynamic_cast<osg::Texture*>((*attribute)->getWrappedObject())) {
+                    stateSet->setTextureAttributeAndModes(unit, texture);
+                }
+            }
+        }
+    }
+
+    if(const Value* attributes = value.get("AttributeList")) {
+        for(Value::List::const_iterator attribute = attributes->_values.begin() ; attribute != attributes->_values.end() ; ++ attribute) {
+            if(!attribute->valid()) continue;
+            osg::StateAttribute* stateAttribute = dynamic_cast<osg::StateAttribute*>((*attribute)->getWrappedObject());
+            if(!stateAttribute) continue;
+
+            if(_disabledCullFaces.find(stateAttribute) != _disabledCullFaces.end()) {
+                stateSet->setMode(GL_CULL_FACE, osg::StateAttribute::OFF);
+            }
+            else {
+                stateSet->setAttributeAndModes(stateAttribute);
+            }
+        }
+    }
+
+    return stateSet.release();
+}
+
+osg::StateAttribute* ReadHandler::createStateAttribute(const std::string& className, const Value& value)
+{
+    osg::ref_ptr<osg::StateAttribute> attribute;
+
+    if(className == "osg.Material") {
+        osg::ref_ptr<osg::Material> material = new osg::Material;
+        osg::Vec4 color;
+        if(value.getVec("Ambient", color.ptr(), 4)) material->setAmbient(osg::Material::FRONT_AND_BACK, color);
+        if(value.getVec("Diffuse", color.ptr(), 4)) material->setDiffuse(osg::Material::FRONT_AND_BACK, color);
+        if(value.getVec("Specular", color.ptr(), 4)) material->setSpecular(osg::Material::FRONT_AND_BACK, color);
+        if(value.getVec("Emission", color.ptr(), 4)) material->setEmission(osg::Material::FRONT_AND_BACK, color);
+        material->setShininess(osg::Material::FRONT_AND_BACK, value.getNumber("Shininess"));
+        attribute = material;
+    }
+    else if(className == "osg.BlendFunc") {
+        attribute = new osg::BlendFunc(getBlendFuncMode(value.getString("SourceRGB")),
+                                       getBlendFuncMode(value.getString("DestinationRGB")),
+                                       getBlendFuncMode(value.getString("SourceAlpha")),
+                                       getBlendFuncMode(value.getString("DestinationAlpha")));
+    }
+    else if(className == "osg.BlendColor") {
+        osg::Vec4 color;
+        value.getVec("ConstantColor", color.ptr(), 4);
+        attribute = new osg::BlendColor(color);
+    }
+    else if(className == "osg.CullFace") {
+        std::string mode = value.getString("Mode");
+        osg::ref_ptr<osg::CullFace> cullFace = new osg::CullFace;
+        if(mode == "FRONT") {
+            cullFace->setMode(osg::CullFace::FRONT);
+        }
+        else if(mode == "FRONT_AND_BACK") {
+            cullFace->setMode(osg::CullFace::FRONT_AND_BACK);
+        }
+        else if(mode == "DISABLE") {
+            _disabledCullFaces.insert(cullFace.get());
+        }
+        attribute = cullFace;
+    }
+    else if(className == "osg.Texture") {
+        osg::ref_ptr<osg::Texture2D> texture = new osg::Texture2D;
+        texture->setFilter(osg::Texture::MIN_FILTER, getFilterMode(value.getString("MinFilter"), osg::Texture::LINEAR_MIPMAP_LINEAR));
+        texture->setFilter(osg::Texture::MAG_FILTER, getFilterMode(value.getString("MagFilter"), osg::Texture::LINEAR));
+        texture->setWrap(osg::Texture::WRAP_S, getWrapMode(value.getString("WrapS")));
+        texture->setWrap(osg::Texture::WRAP_T, getWrapMode(value.getString("WrapT")));
+
+        std::string file = value.getString("File");
+        if(!file.empty()) {
+            osg::ref_ptr<osg::Image> image = readImage(file);
+            if(image.valid()) {
+                texture->setImage(image.get());
+            }
+            else {
+                OSG_WARN << "osgjs reader: unable to read texture image '" << file.substr(0, 64) << "'" << std::endl;
+            }
+        }
+        attribute = texture;
+    }
+    else if(className == "osg.Light") {
+        osg::ref_ptr<osg::Light> light = new osg::Light(static_cast<int>(value.getNumber("LightNum")));
+        osg::Vec4 v4;
+        osg::Vec3 v3;
+        if(value.getVec("Ambient", v4.ptr(), 4)) light->setAmbient(v4);
+        if(value.getVec("Diffuse", v4.ptr(), 4)) light->setDiffuse(v4);
+        if(value.getVec("Specular", v4.ptr(), 4)) light->setSpecular(v4);
+        if(value.getVec("Position", v4.ptr(), 4)) light->setPosition(v4);
+        if(value.getVec("Direction", v3.ptr(), 3)) light->setDirection(v3);
+        light->setConstantAttenuation(value.getNumber("ConstantAttenuation", 1.));
+        light->setLinearAttenuation(value.getNumber("LinearAttenuation"));
+        light->setQuadraticAttenuation(value.getNumber("QuadraticAttenuation"));
+        light->setSpotExponent(value.getNumber("SpotExponent"));
+        light->setSpotCutoff(value.getNumber("SpotCutoff", 180.));
+        attribute = light;
+    }
+
+    if(attribute.valid()) {
+        readObject(*attribute, value);
+    }
+    return attribute.release();
+}
+
+osg::Image* ReadHandler::readImage(const std::string& file)
+{
+    // inlined images: "data:image/<extension>;base64,<data>"
+    if(file.compare(0, 5, "data:") == 0) {
+        size_t slash = file.find('/'),
+               semicolon = file.find(';'),
+               comma = file.find(',');
+        if(slash == std::string::npos || semicolon == std::string::npos || comma == std::string::npos || semicolon < slash) {
+            return 0;
+        }
+
+        osgDB::ReaderWriter* rw = osgDB::Registry::instance()->getReaderWriterForExtension(file.substr(slash + 1, semicolon - slash - 1));
+        if(!rw) {
+            return 0;
+        }
+
+        std::string decoded;
+        base64::decode(file.begin() + comma + 1, file.end(), std::back_inserter(decoded));
+        std::istringstream iss(decoded);
+        return rw->readImage(iss, _options.get()).takeImage();
+    }
+
+    return osgDB::readRefImageFile(file, _options.get()).release();
+}
+
+ReadHandler::ScalarType ReadHandler::getScalarType(const std::string& name) const
+{
+    if(name == "Float32Array") return FLOAT32;
+    if(name == "Int8Array") return INT8;
+    if(name == "Uint8Array") return UINT8;
+    if(name == "Int16Array") return INT16;
+    if(name == "Uint16Array") return UINT16;
+    if(name == "Int32Array") return INT32;
+    if(name == "Uint32Array") return UINT32;
+    return UNKNOWN_SCALAR;
+}
+
+unsigned int ReadHandler::getScalarSize(ScalarType type) const
+{
+    switch(type) {
+        case INT8:
+        case UINT8:
+            return 1;
+        case INT16:
+        case UINT16:
+            return 2;
+        case FLOAT32:
+        case INT32:
+        case UINT32:
+            return 4;
+        default:
+            return 0;
+    }
+}
+
+osg::Array* ReadHandler::createArray(ScalarType type, unsigned int itemSize, unsigned int size) const
+{
+    switch(type) {
+        case FLOAT32:
+            switch(itemSize) {
+                case 1: return new osg::FloatArray(size);
+                case 2: return new osg::Vec2Array(size);
+                case 3: return new osg::Vec3Array(size);
+                case 4: return new osg::Vec4Array(size);
+            }
+            break;
+        case INT8:
+            switch(itemSize) {
+                case 1: return new osg::ByteArray(size);
+                case 2: return new osg::Vec2bArray(size);
+                case 3: return new osg::Vec3bArray(size);
+                case 4: return new osg::Vec4bArray(size);
+            }
+            break;
+        case UINT8:
+            switch(itemSize) {
+                case 1: return new osg::UByteArray(size);
+                case 2: return new osg::Vec2ubArray(size);
+                case 3: return new osg::Vec3ubArray(size);
+                case 4: return new osg::Vec4ubArray(size);
+            }
+            break;
+        case INT16:
+            switch(itemSize) {
+                case 1: return new osg::ShortArray(size);
+                case 2: return new osg::Vec2sArray(size);
+                case 3: return new osg::Vec3sArray(size);
+                case 4: return new osg::Vec4sArray(size);
+            }
+            break;
+        case UINT16:
+            switch(itemSize) {
+                case 1: return new osg::UShortArray(size);
+                case 2: return new osg::Vec2usArray(size);
+                case 3: return new osg::Vec3usArray(size);
+                case 4: return new osg::Vec4usArray(size);
+            }
+            break;
+        case INT32:
+            switch(itemSize) {
+                case 1: return new osg::IntArray(size);
+                case 2: return new osg::Vec2iArray(size);
+                case 3: return new osg::Vec3iArray(size);
+                case 4: return new osg::Vec4iArray(size);
+            }
+            break;
+        case UINT32:
+            switch(itemSize) {
+                case 1: return new osg::UIntArray(size);
+                case 2: return new osg::Vec2uiArray(size);
+                case 3: return new osg::Vec3uiArray(size);
+                case 4: return new osg::Vec4uiArray(size);
+            }
+            break;
+        default:
+            break;
+    }
+    return 0;
+}
+
+osg::DrawElements* ReadHandler::createDrawElements(ScalarType type, unsigned int size) const
+{
+    switch(type) {
+        case UINT8:
+            return new osg::DrawElementsUByte(GL_TRIANGLES, size);
+        case UINT16:
+            return new osg::DrawElementsUShort(GL_TRIANGLES, size);
+        case UINT32:
+            return new osg::DrawElementsUInt(GL_TRIANGLES, size);
+        default:
+            return 0;
+    }
+}
+
+osg::Referenced* ReadHandler::createBuffer(const Value& value, bool indices)
+{
+    const Value* json = value.get("Array");
+    ArrayData* data = json ? dynamic_cast<ArrayData*>(json->getWrappedObject()) : 0;
+    if(!data) {
+        return 0;
+    }
+
+    unsigned int itemSize = static_cast<unsigned int>(value.getNumber("ItemSize", 1.));
+    unsigned int size = data->_hasSize ? data->_size :
+                        (data->_elements.valid() ? data->_elements->getNumElements() / std::max(itemSize, 1u) : 0);
+    unsigned int count = size * itemSize;
+
+    // the buffer is allocated with its final type and filled in place
+    if(indices) {
+        osg::ref_ptr<osg::DrawElements> drawElements = createDrawElements(data->_type, count);
+        if(!drawElements || (count && !fillBuffer(const_cast<GLvoid*>(drawElements->getDataPointer()), data->_type, count, *data))) {
+            OSG_WARN << "osgjs reader: unable to read indices" << std::endl;
+            return 0;
+        }
+        return drawElements.release();
+    }
+
+    osg::ref_ptr<osg::Array> array = createArray(data->_type, itemSize, size);
+    if(!array || (count && !fillBuffer(const_cast<GLvoid*>(array->getDataPointer()), data->_type, count, *data))) {
+        OSG_WARN << "osgjs reader: unable to read array" << std::endl;
+        return 0;
+    }
+
+    if(const Value* quantization = value.get("Quantization")) {
+        return dequantizeArray(*array, data->_type, *quantization);
+    }
+    return array.release();
+}
+
+osg::Array* ReadHandler::dequantizeArray(const osg::Array& array, ScalarType type, const Value& quantization) const
+{
+    unsigned int itemSize = array.getDataSize();
+    unsigned int size = array.getNumElements();
+    std::vector<float> scalars(size * itemSize);
+    for(unsigned int i = 0 ; i < scalars.size() ; ++ i) {
+        scalars[i] = getScalar(array.getDataPointer(), type, i);
+    }
+
+    std::string mode = quantization.getString("Mode");
+    if(mode == "bbox") {
+        const Value* offset = quantization.get("Offset");
+        const Value* scale = quantization.get("Scale");
+        if(!offset || !scale || offset->_numbers.size() < itemSize || scale->_numbers.size() < itemSize) {
+            return 0;
+        }
+
+        osg::Array* output = createArray(FLOAT32, itemSize, size);
+        float* values = static_cast<float*>(const_cast<GLvoid*>(output->getDataPointer()));
+        for(unsigned int i = 0 ; i < scalars.size() ; ++ i) {
+            unsigned int c = i % itemSize;
+            values[i] = static_cast<float>(offset->_numbers[c] + scalars[i] * scale->_numbers[c]);
+        }
+        return output;
+    }
+
+    if(mode == "octahedral" && (itemSize == 2 || itemSize == 3)) {
+        // normals are encoded on 2 components, tangents have an extra handedness component
+        osg::Array* output = createArray(FLOAT32, itemSize + 1, size);
+        float* values = static_cast<float*>(const_cast<GLvoid*>(output->getDataPointer()));
+        for(unsigned int i = 0 ; i < size ; ++ i) {
+            osg::Vec3 v(scalars[i * itemSize] / 32767.f, scalars[i * itemSize + 1] / 32767.f, 0.f);
+            v.z() = 1.f - std::fabs(v.x()) - std::fabs(v.y());
+            if(v.z() < 0.f) {
+                float x = v.x();
+                v.x() = (1.f - std::fabs(v.y())) * (x < 0.f ? -1.f : 1.f);
+                v.y() = (1.f - std::fabs(x)) * (v.y() < 0.f ? -1.f : 1.f);
+            }
+            v.normalize();
+
+            float* item = values + i * (itemSize + 1);
+            item[0] = v.x();
+            item[1] = v.y();
+            item[2] = v.z();
+            if(itemSize == 3) {
+                item[3] = scalars[i * itemSize + 2] < 0.f ? -1.f : 1.f;
+            }
+        }
+        return output;
+    }
+
+    if(mode == "normalized") {
+        osg::Array* output = createArray(FLOAT32, itemSize, size);
+        float* values = static_cast<float*>(const_cast<GLvoid*>(output->getDataPointer()));
+        for(unsigned int i = 0 ; i < scalars.size() ; ++ i) {
+            values[i] = scalars[i] / 32767.f;
+        }
+        return output;
+    }
+
+    OSG_WARN << "osgjs reader: unsupported quantization '" << mode << "'" << std::endl;
+    return 0;
+}
+
+float ReadHandler::getScalar(const void* data, ScalarType type, unsigned int index) const
+{
+    switch(type) {
+        case FLOAT32: return static_cast<const float*>(data)[index];
+        case INT8:    return static_cast<const GLbyte*>(data)[index];
+        case UINT8:   return static_cast<const GLubyte*>(data)[index];
+        case INT16:   return static_cast<const GLshort*>(data)[index];
+        case UINT16:  return static_cast<const GLushort*>(data)[index];
+        case INT32:   return static_cast<float>(static_cast<const GLint*>(data)[index]);
+        case UINT32:  return static_cast<float>(static_cast<const GLuint*>(data)[index]);
+        default:      return 0.f;
+    }
+}
+
+bool ReadHandler::fillBuffer(void* buffer, ScalarType type, unsigned int count, const ArrayData& data)
+{
+    unsigned int scalarSize = getScalarSize(type);
+
+    if(data._elements.valid()) {
+        if(data._elements->getNumElements() < count) {
+            return false;
+        }
+        memcpy(buffer, data._elements->getDataPointer(), count * scalarSize);
+        return true;
+    }
+
+    MappedFile* file = data._file.empty() ? 0 : getMappedFile(data._file);
+    if(!file || data._offset > file->size()) {
+        return false;
+    }
+
+    const char* begin = file->data() + data._offset;
+    const char* end = file->data() + file->size();
+
+    if(data._encoding == "varint") {
+        switch(type) {
+            case INT16:  return decodeVarint(begin, end, static_cast<short*>(buffer), count, true);
+            case UINT16: return decodeVarint(begin, end, static_cast<unsigned short*>(buffer), count, false);
+            case INT32:  return decodeVarint(begin, end, static_cast<int*>(buffer), count, true);
+            case UINT32: return decodeVarint(begin, end, static_cast<unsigned int*>(buffer), count, false);
+            default:
+                return false;
+        }
+    }
+
+    if(static_cast<size_t>(end - begin) < static_cast<size_t>(count) * scalarSize) {
+        return false;
+    }
+    memcpy(buffer, begin, count * scalarSize);
+
+    // binary buffers are written in little endian
+    if(osg::getCpuByteOrder() == osg::BigEndian && scalarSize > 1) {
+        char* bytes = static_cast<char*>(buffer);
+        for(unsigned int i = 0 ; i < count ; ++ i) {
+            osg::swapBytes(bytes + i * scalarSize, scalarSize);
+        }
+    }
+    return true;
+}
+
+MappedFile* ReadHandler::getMappedFile(const std::string& file)
+{
+    std::map<std::string, osg::ref_ptr<MappedFile> >::iterator mapped = _files.find(file);
+    if(mapped != _files.end()) {
+        return mapped->second.get();
+    }
+
+    osg::ref_ptr<MappedFile> mappedFile;
+    std::string path = osgDB::findDataFile(file, _options.get());
+    if(!path.empty()) {
+        mappedFile = new MappedFile(path);
+        if(!mappedFile->valid()) {
+            mappedFile = 0;
+        }
+    }
+
+    if(!mappedFile) {
+        OSG_WARN << "osgjs reader: unable to open binary file '" << file << "'" << std::endl;
+    }
+    _files[file] = mappedFile;
+    return mappedFile.get();
+}
@@ -22,19 +22,73 @@
 #include <osgAnimation/AnimationManagerBase>
 #include <osgAnimation/BasicAnimationManager>
 
+#include <iterator>
+#include <map>
 #include <vector>
 
+#include "json_reader"
 #include "json_stream"
 #include "JSON_Objects"
 #include "Animation"
 #include "CompactBufferVisitor"
+#include "QuantizeBufferVisitor"
 #include "WriteVisitor"
+#include "MappedFile"
+#include "ReadHandler"
 
 
 
 using namespace osg;
 
 
+// Deep copy keeping the objects shared within the graph shared in the copy, so that the exported
+// file does not duplicate them.
+class SharingCopyOp : public osg::CopyOp
+{
+public:
+    SharingCopyOp(CopyFlags flags):
+        osg::CopyOp(flags)
+    {}
+
+    virtual osg::Node* operator() (const osg::Node* node) const {
+        if(node && node->asDrawable()) return operator()(node->asDrawable());
+        return copy(node, DEEP_COPY_NODES);
+    }
+
+    virtual osg::Drawable* operator() (const osg::Drawable* drawable) const {
+        return copy(drawable, DEEP_COPY_DRAWABLES);
+    }
+
+    virtual osg::Array* operator() (const osg::Array* array) const {
+        return copy(array, DEEP_COPY_ARRAYS);
+    }
+
+    virtual osg::PrimitiveSet* operator() (const osg::PrimitiveSet* primitives) const {
+        return copy(primitives, DEEP_COPY_PRIMITIVES);
+    }
+
+protected:
+    template<typename T>
+    T* copy(const T* object, unsigned int flag) const {
+        if(!object || !(_flags & flag)) {
+            return const_cast<T*>(object);
+        }
+
+        std::map<const osg::Object*, osg::ref_ptr<osg::Object> >::iterator it = _copies.find(object);
+        if(it != _copies.end()) {
+            return static_cast<T*>(it->second.get());
+        }
+
+        T* copied = osg::clone(object, *this);
+        _copies[object] = copied;
+        return copied;
+    }
+
+    // must be mutable since CopyOp is passed around as const to the copy constructors
+    mutable std::map<const osg::Object*, osg::ref_ptr<osg::Object> > _copies;
+};
+
+
 class ReaderWriterJSON : public osgDB::ReaderWriter
 {
 public:
@@ -47,6 +101,9 @@ public:
          bool inlineImages;
          bool varint;
          bool strictJson;
+         bool quantize;
+         float quantizeMaxError;
+         bool quantizeQuaternions;
          std::vector<std::string> useSpecificBuffer;
          std::string baseLodURL;
          OptionsStruct() {
@@ -57,6 +114,9 @@ public:
              inlineImages = false;
              varint = false;
              strictJson = true;
+             quantize = false;
+             quantizeMaxError = 0.f;
+             quantizeQuaternions = false;
          }
     };
 
@@ -71,12 +131,17 @@ public:
         supportsOption("varint","Use varint encoding to serialize integer buffers");
         supportsOption("useSpecificBuffer=userkey1[=uservalue1][:buffername1],userkey2[=uservalue2][:buffername2]","uses specific buffers for unshared buffers attached to geometries having a specified user key/value. Buffer name *may* be specificed after ':' and will be set to uservalue by default. If no value is set then only the existence of a uservalue with key string is performed.");
         supportsOption("disableCompactBuffer","keep source types and do not try to optimize buffers size");
+        supportsOption("quantize","quantize vertex attributes (16 bits bounding box relative positions and texture coordinates, octahedral normals and tangents)");
+        supportsOption("quantizeMaxError=<float>","keep float positions for geometries whose quantization error, the distance between a vertex and its dequantized position, could exceed the given value");
+        supportsOption("quantizeQuaternions","store quaternion animation keys as normalized 16 bits integers");
         supportsOption("disableStrictJson","do not clean string (to utf8) or floating point (should be finite) values");
     }
 
-    virtual const char* className() const { return "OSGJS json Writer"; }
+    virtual const char* className() const { return "OSGJS json Reader/Writer"; }
 
     virtual ReadResult readNode(const std::string& fileName, const Options* options) const;
+    virtual ReadResult readNode(std::istream& fin, const Options* options) const;
+    virtual ReadResult readNodeModel(const char* begin, const char* end, const std::string& filePath, const Options* options) const;
 
     virtual WriteResult writeNode(const Node& node,
                                   const std::string& fileName,
@@ -111,14 +176,29 @@ public:
 
     virtual WriteResult writeNodeModel(const Node& node, json_stream& fout, const std::string& basename, const OptionsStruct& options) const
     {
-        // process regular model
-        osg::ref_ptr<osg::Node> model = osg::clone(&node);
+        // process regular model; the buffer visitors replace arrays and primitive sets of the geometries,
+        // which must then be copies rather than the geometries of the caller's scene
+        osg::ref_ptr<osg::Node> model;
+        if(!options.disableCompactBuffer || options.quantize) {
+            model = osg::clone(&node, SharingCopyOp(osg::CopyOp::DEEP_COPY_NODES |
+                                                    osg::CopyOp::DEEP_COPY_DRAWABLES |
+                                                    osg::CopyOp::DEEP_COPY_ARRAYS |
+                                                    osg::CopyOp::DEEP_COPY_PRIMITIVES));
+        }
+        else {
+            model = osg::clone(&node);
+        }
 
         if(!options.disableCompactBuffer) {
             CompactBufferVisitor compact;
             model->accept(compact);
         }
 
+        if(options.quantize) {
+            QuantizeBufferVisitor quantize(options.quantizeMaxError);
+            model->accept(quantize);
+        }
+
         WriteVisitor writer;
         try {
             //osgDB::writeNodeFile(*model, "/tmp/debug_osgjs.osg");
@@ -128,6 +208,7 @@ public:
             writer.setInlineImages(options.inlineImages);
             writer.setMaxTextureDimension(options.resizeTextureUpToPowerOf2);
             writer.setVarint(options.varint);
+            writer.setQuantizeQuaternions(options.quantizeQuaternions);
             writer.setBaseLodURL(options.baseLodURL);
             for(std::vector<std::string>::const_iterator specificBuffer = options.useSpecificBuffer.begin() ;
                 specificBuffer != options.useSpecificBuffer.end() ; ++ specificBuffer) {
@@ -197,6 +278,18 @@ public:
                 {
                     localOptions.varint = true;
                 }
+                if (pre_equals == "quantize")
+                {
+                    localOptions.quantize = true;
+                }
+                if (pre_equals == "quantizeMaxError" && post_equals.length() > 0)
+                {
+                    localOptions.quantizeMaxError = osg::asciiToFloat(post_equals.c_str());
+                }
+                if (pre_equals == "quantizeQuaternions")
+                {
+                    localOptions.quantizeQuaternions = true;
+                }
 
                 if (pre_equals == "resizeTextureUpToPowerOf2" && post_equals.length() > 0)
                 {
@@ -232,17 +325,38 @@ osgDB::ReaderWriter::ReadResult ReaderWriterJSON::readNode(const std::string& fi
     std::string ext = osgDB::getLowerCaseFileExtension(file);
     if (!acceptsExtension(ext)) return ReadResult::FILE_NOT_HANDLED;
 
-    // strip the pseudo-loader extension
-    std::string fileName = osgDB::getNameLessExtension( file );
-
-    fileName = osgDB::findDataFile( fileName, options );
+    std::string fileName = osgDB::findDataFile( file, options );
     if (fileName.empty()) return ReadResult::FILE_NOT_FOUND;
 
-    osg::ref_ptr<osg::Node> node = osgDB::readRefNodeFile( fileName, options );
-    if (!node)
-        return ReadResult::FILE_NOT_HANDLED;
+    osg::ref_ptr<MappedFile> mappedFile = new MappedFile(fileName);
+    if (!mappedFile->valid()) return ReadResult::ERROR_IN_READING_FILE;
+
+    return readNodeModel(mappedFile->data(), mappedFile->data() + mappedFile->size(),
+                         osgDB::getFilePath(fileName), options);
+}
+
+osgDB::ReaderWriter::ReadResult ReaderWriterJSON::readNode(std::istream& fin, const Options* options) const
+{
+    std::string content((std::istreambuf_iterator<char>(fin)), std::istreambuf_iterator<char>());
+    return readNodeModel(content.data(), content.data() + content.size(), std::string(), options);
+}
+
+osgDB::ReaderWriter::ReadResult ReaderWriterJSON::readNodeModel(const char* begin, const char* end,
+                                                                const std::string& filePath,
+                                                                const Options* options) const
+{
+    ReadHandler handler(filePath, options);
+    json_reader reader(begin, end);
+
+    if (!reader.parse(handler)) {
+        osg::notify(osg::WARN) << "can't read osgjs file: " << reader.getError() << std::endl;
+        return ReadResult::ERROR_IN_READING_FILE;
+    }
+
+    osg::ref_ptr<osg::Node> root = handler.getRoot();
+    if (!root) return ReadResult("no osgjs scene found");
 
-    return ReadResult::FILE_NOT_HANDLED;
+    return root.release();
 }
 
 // now register with Registry to instantiate the above
@@ -13,7 +13,9 @@
 #include "ply.h"
 
 #include <cstdlib>
+#include <cstring>
 #include <algorithm>
+#include <osg/Endian>
 #include <osg/Geometry>
 #include <osg/Geode>
 #include <osg/io_utils>
@@ -23,6 +25,159 @@ using namespace std;
 using namespace ply;
 
 
+namespace
+{
+    // number of records decoded at once by the bulk vertex reader
+    const int VERTEX_BLOCK_SIZE = 65536;
+
+    // position and type of a scalar property within a fixed size binary record
+    struct RecordProperty
+    {
+        int offset;
+        int type;
+    };
+
+    // Locates a vertex property in the records, only float and double values
+    // are bulk decoded for coordinates and only uchar values for colors
+    bool findRecordProperty( PlyElement* elem, const char* name,
+                             const bool color, RecordProperty& property )
+    {
+        int offset = 0;
+        for( int j = 0; j < elem->nprops; ++j )
+        {
+            const PlyProperty* prop = elem->props[j];
+            if( equal_strings( prop->name, name ) )
+            {
+                property.offset = offset;
+                property.type = prop->external_type;
+                if( color )
+                    return property.type == PLY_UCHAR || property.type == PLY_UINT8;
+                return property.type == PLY_FLOAT || property.type == PLY_FLOAT32 ||
+                       property.type == PLY_DOUBLE;
+            }
+            offset += ply_type_size[prop->external_type];
+        }
+        return false;
+    }
+
+    bool findRecordProperties( PlyElement* elem, const char* const* names,
+                               const int nNames, const bool color,
+                               RecordProperty* properties )
+    {
+        for( int i = 0; i < nNames; ++i )
+            if( !findRecordProperty( elem, names[i], color, properties[i] ) )
+                return false;
+        return true;
+    }
+
+    // Strided copy of one property out of a block of records, the swap is a
+    // template argument so that the loops are free of branches
+    template< typename T, bool Swap >
+    void decodeFloats( const char* records, const int recordSize, const int count,
+                       float* dst, const int dstStride )
+    {
+        for( int i = 0; i < count; ++i, records += recordSize, dst += dstStride )
+        {
+            T value;
+            memcpy( &value, records, sizeof( T ) );
+            if( Swap )
+                osg::swapBytes( reinterpret_cast< char* >( &value ), sizeof( T ) );
+            *dst = static_cast< float >( value );
+        }
+    }
+
+    void decodeFloats( const RecordProperty& property, const bool swap,
+                       const char* records, const int recordSize, const int count,
+                       float* dst, const int dstStride )
+    {
+        records += property.offset;
+        if( property.type == PLY_DOUBLE )
+        {
+            if( swap ) decodeFloats< double, true >( records, recordSize, count, dst, dstStride );
+            else decodeFloats< double, false >( records, recordSize, count, dst, dstStride );
+        }
+        else
+        {
+            if( swap ) decodeFloats< float, true >( records, recordSize, count, dst, dstStride );
+            else decodeFloats< float, false >( records, recordSize, count, dst, dstStride );
+        }
+    }
+
+    // colors are normalized as the ply_get_element path does
+    void decodeBytes( const RecordProperty& property, const char* records,
+                      const int recordSize, const int count,
+                      float* dst, const int dstStride )
+    {
+        records += property.offset;
+        for( int i = 0; i < count; ++i, records += recordSize, dst += dstStride )
+            *dst = static_cast< float >( static_cast< unsigned char >( *records ) / 255.0 );
+    }
+
+    void decodeVec3s( const RecordProperty* properties, const bool swap,
+                      const char* records, const int recordSize, const int count,
+                      osg::Vec3* dst )
+    {
+        for( int c = 0; c < 3; ++c )
+            decodeFloats( properties[c], swap, records, recordSize, count,
+                          dst->ptr() + c, 3 );
+    }
+
+    void decodeColors( const RecordProperty* properties, const int nComponents,
+                       const char* records, const int recordSize, const int count,
+                       osg::Vec4* dst )
+    {
+        for( int c = 0; c < nComponents; ++c )
+            decodeBytes( properties[c], records, recordSize, count,
+                         dst->ptr() + c, 4 );
+        if( nComponents < 4 )
+            for( int i = 0; i < count; ++i )
+                dst[i].a() = 1.0f;
+    }
+
+    // Buffered sequential reads of variable size binary records
+    class RecordReader
+    {
+    public:
+        RecordReader( FILE* fp ) : _fp( fp ), _buffer( 1 << 20 ), _begin( 0 ), _end( 0 ) {}
+
+        // returns the next size bytes, valid until the next call
+        const char* read( const size_t size )
+        {
+            if( _end - _begin < size )
+            {
+                // move the remaining bytes to the front and refill the buffer
+                memmove( &_buffer[0], &_buffer[_begin], _end - _begin );
+                _end -= _begin;
+                _begin = 0;
+                if( size > _buffer.size() )
+                    _buffer.resize( size );
+                _end += fread( &_buffer[_end], 1, _buffer.size() - _end, _fp );
+                if( _end < size )
+                    throw MeshException( "Error in reading PLY file."
+                                         "fread not succeeded." );
+            }
+            const char* data = &_buffer[_begin];
+            _begin += size;
+            return data;
+        }
+
+        // gives the bytes read ahead back to the file for the next element
+        void finish()
+        {
+            if( _end > _begin )
+                fseek( _fp, -static_cast< long >( _end - _begin ), SEEK_CUR );
+            _begin = _end = 0;
+        }
+
+    private:
+        FILE*               _fp;
+        std::vector< char > _buffer;
+        size_t              _begin;
+        size_t              _end;
+    };
+}
+
+
 /*  Contructor.  */
 VertexData::VertexData()
     : _invertFaces( false )
@@ -155,6 +310,9 @@ void VertexData::readVertices( PlyFile* file, const int nVertices,
             _specular = new osg::Vec4Array;
     }
 
+    if( readVerticesBinary( file, nVertices, fields ) )
+        return;
+
     // read in the vertices
     for( int i = 0; i < nVertices; ++i )
     {
@@ -190,6 +348,86 @@ void VertexData::readVertices( PlyFile* file, const int nVertices,
 }
 
 
+/*  Read the vertices of a binary file by blocks of records, decoding each
+    wanted property of a block at once instead of going through
+    ply_get_element for every vertex.  */
+bool VertexData::readVerticesBinary( PlyFile* file, const int nVertices,
+                                     const int fields )
+{
+    PlyElement* elem = find_element( file, "vertex" );
+    if( file->file_type == PLY_ASCII || !elem )
+        return false;
+
+    // records have a fixed size only if there are no lists
+    int recordSize = 0;
+    for( int j = 0; j < elem->nprops; ++j )
+    {
+        if( elem->props[j]->is_list )
+            return false;
+        recordSize += ply_type_size[elem->props[j]->external_type];
+    }
+
+    static const char* const positionNames[] = { "x", "y", "z" };
+    static const char* const normalNames[] = { "nx", "ny", "nz" };
+    static const char* const colorNames[] = { "red", "green", "blue", "alpha" };
+    static const char* const ambientNames[] = { "ambient_red", "ambient_green", "ambient_blue" };
+    static const char* const diffuseNames[] = { "diffuse_red", "diffuse_green", "diffuse_blue" };
+    static const char* const specularNames[] = { "specular_red", "specular_green", "specular_blue" };
+
+    RecordProperty position[3], normal[3], color[4], ambient[3], diffuse[3], specular[3];
+    const int nColorComponents = ( fields & RGBA ) ? 4 : 3;
+    if( !findRecordProperties( elem, positionNames, 3, false, position ) ||
+        ( ( fields & NORMALS ) && !findRecordProperties( elem, normalNames, 3, false, normal ) ) ||
+        ( ( fields & ( RGB | RGBA ) ) && !findRecordProperties( elem, colorNames, nColorComponents, true, color ) ) ||
+        ( ( fields & AMBIENT ) && !findRecordProperties( elem, ambientNames, 3, true, ambient ) ) ||
+        ( ( fields & DIFFUSE ) && !findRecordProperties( elem, diffuseNames, 3, true, diffuse ) ) ||
+        ( ( fields & SPECULAR ) && !findRecordProperties( elem, specularNames, 3, true, specular ) ) )
+        return false;
+
+    const bool swap = ( file->file_type == PLY_BINARY_BE ) !=
+                      ( osg::getCpuByteOrder() == osg::BigEndian );
+
+    const size_t base = _vertices->size();
+    _vertices->resize( base + nVertices );
+    if( fields & NORMALS )
+        _normals->resize( base + nVertices );
+    if( fields & ( RGB | RGBA ) )
+        _colors->resize( base + nVertices );
+    if( fields & AMBIENT )
+        _ambient->resize( base + nVertices );
+    if( fields & DIFFUSE )
+        _diffuse->resize( base + nVertices );
+    if( fields & SPECULAR )
+        _specular->resize( base + nVertices );
+
+    std::vector< char > block( static_cast< size_t >( recordSize ) *
+                               std::min( nVertices, VERTEX_BLOCK_SIZE ) + 1 );
+    for( int first = 0; first < nVertices; first += VERTEX_BLOCK_SIZE )
+    {
+        const int count = std::min( VERTEX_BLOCK_SIZE, nVertices - first );
+        if( fread( &block[0], recordSize, count, file->fp ) != static_cast< size_t >( count ) )
+            throw MeshException( "Error in reading PLY file."
+                                 "fread not succeeded." );
+
+        const char* records = &block[0];
+        const size_t index = base + first;
+        decodeVec3s( position, swap, records, recordSize, count, &(*_vertices)[index] );
+        if( fields & NORMALS )
+            decodeVec3s( normal, swap, records, recordSize, count, &(*_normals)[index] );
+        if( fields & ( RGB | RGBA ) )
+            decodeColors( color, nColorComponents, records, recordSize, count, &(*_colors)[index] );
+        if( fields & AMBIENT )
+            decodeColors( ambient, 3, records, recordSize, count, &(*_ambient)[index] );
+        if( fields & DIFFUSE )
+            decodeColors( diffuse, 3, records, recordSize, count, &(*_diffuse)[index] );
+        if( fields & SPECULAR )
+            decodeColors( specular, 3, records, recordSize, count, &(*_specular)[index] );
+    }
+
+    return true;
+}
+
+
 /*  Read the index data from the open file.  */
 void VertexData::readTriangles( PlyFile* file, const int nFaces )
 {
@@ -214,6 +452,8 @@ void VertexData::readTriangles( PlyFile* file, const int nFaces )
     if(!_quads.valid())
         _quads = new osg::DrawElementsUInt(osg::PrimitiveSet::QUADS);
 
+    if( readTrianglesBinary( file, nFaces ) )
+        return;
 
     const char NUM_VERTICES_TRIANGLE(3);
     const char NUM_VERTICES_QUAD(4);
@@ -247,6 +487,68 @@ void VertexData::readTriangles( PlyFile* file, const int nFaces )
 }
 
 
+/*  Read the faces of a binary file through a buffer, picking the triangles
+    and quads indices directly out of the records.  */
+bool VertexData::readTrianglesBinary( PlyFile* file, const int nFaces )
+{
+    PlyElement* elem = find_element( file, "face" );
+    if( file->file_type == PLY_ASCII || !elem )
+        return false;
+
+    // the records are the uchar count and 32 bit indices of the list,
+    // surrounded by scalar properties which are skipped
+    int leading = 0;
+    int trailing = 0;
+    bool foundList = false;
+    for( int j = 0; j < elem->nprops; ++j )
+    {
+        const PlyProperty* prop = elem->props[j];
+        if( prop->is_list )
+        {
+            if( foundList ||
+                !( equal_strings( prop->name, "vertex_indices" ) ||
+                   equal_strings( prop->name, "vertex_index" ) ) ||
+                !( prop->count_external == PLY_UCHAR || prop->count_external == PLY_UINT8 ) ||
+                !( prop->external_type == PLY_INT || prop->external_type == PLY_UINT ||
+                   prop->external_type == PLY_INT32 || prop->external_type == PLY_UINT32 ) )
+                return false;
+            foundList = true;
+        }
+        else if( foundList )
+            trailing += ply_type_size[prop->external_type];
+        else
+            leading += ply_type_size[prop->external_type];
+    }
+    if( !foundList )
+        return false;
+
+    const bool swap = ( file->file_type == PLY_BINARY_BE ) !=
+                      ( osg::getCpuByteOrder() == osg::BigEndian );
+
+    RecordReader reader( file->fp );
+    for( int i = 0; i < nFaces; ++i )
+    {
+        const int nVertices = static_cast< unsigned char >( reader.read( leading + 1 )[leading] );
+        const char* data = reader.read( nVertices * 4 + trailing );
+        if( nVertices != 3 && nVertices != 4 )
+            continue;
+
+        GLuint indices[4];
+        memcpy( indices, data, nVertices * 4 );
+        if( swap )
+            for( int j = 0; j < nVertices; ++j )
+                osg::swapBytes4( reinterpret_cast< char* >( &indices[j] ) );
+
+        osg::DrawElementsUInt& primitives = ( nVertices == 4 ? *_quads : *_triangles );
+        for( int j = 0; j < nVertices; ++j )
+            primitives.push_back( indices[_invertFaces ? nVertices - 1 - j : j] );
+    }
+    reader.finish();
+
+    return true;
+}
+
+
 /*  Open a PLY file and read vertex, color and index data. and returns the node  */
 osg::Node* VertexData::readPlyFile( const char* filename, const bool ignoreColors )
 {
@@ -66,6 +66,16 @@ namespace ply
         // Reads the triangle indices from the ply file
         void readTriangles( PlyFile* file, const int nFaces );
 
+        // Bulk reads the vertices of a binary file with fixed size records,
+        // returns false without reading anything if the layout needs the
+        // generic per property reader
+        bool readVerticesBinary( PlyFile* file, const int nVertices,
+                                 const int vertexFields );
+
+        // Bulk reads the faces of a binary file storing a single list of
+        // 32 bit indices, same fallback as readVerticesBinary
+        bool readTrianglesBinary( PlyFile* file, const int nFaces );
+
         bool        _invertFaces;
 
         // Vertex array in osg format
@@ -45,12 +45,16 @@
 
 #include <string.h>
 #include <memory>
+#include <vector>
+
+struct StlFacet;
 
 struct STLOptionsStruct {
     bool smooth;
     bool separateFiles;
     bool dontSaveNormals;
     bool noTriStripPolygons;
+    bool weldVertices;
 };
 
 STLOptionsStruct parseOptions(const osgDB::ReaderWriter::Options* options)  {
@@ -60,6 +64,7 @@ STLOptionsStruct parseOptions(const osgDB::ReaderWriter::Options* options)  {
     localOptions.separateFiles = false;
     localOptions.dontSaveNormals = false;
     localOptions.noTriStripPolygons = false;
+    localOptions.weldVertices = false;
 
     if (options != NULL)
     {
@@ -83,6 +88,10 @@ STLOptionsStruct parseOptions(const osgDB::ReaderWriter::Options* options)  {
             {
                 localOptions.noTriStripPolygons = true;
             }
+            else if (opt == "weldVertices")
+            {
+                localOptions.weldVertices = true;
+            }
         }
     }
 
@@ -102,6 +111,7 @@ public:
         supportsOption("smooth", "Run SmoothingVisitor");
         supportsOption("separateFiles", "Save each geode in a different file. Can result in a huge amount of files!");
         supportsOption("dontSaveNormals", "Set all normals to [0 0 0] when saving to a file.");
+        supportsOption("weldVertices", "Merge the identical vertices of binary files while reading them into an indexed geometry with smooth normals.");
     }
 
     virtual const char* className() const
@@ -136,7 +146,7 @@ private:
 
         virtual ReadResult read(FILE *fp) = 0;
 
-        osg::ref_ptr<osg::Geometry> asGeometry() const
+        virtual osg::ref_ptr<osg::Geometry> asGeometry() const
         {
             osg::ref_ptr<osg::Geometry> geom = new osg::Geometry;
 
@@ -235,7 +245,8 @@ private:
     public:
         BinaryReaderObject(unsigned int expectNumFacets, bool noTriStripPolygons, bool generateNormals = true)
             : ReaderObject(noTriStripPolygons, generateNormals),
-            _expectNumFacets(expectNumFacets)
+            _expectNumFacets(expectNumFacets),
+            _comesFromMagics(false)
         {
         }
 
@@ -243,6 +254,51 @@ private:
 
     protected:
         unsigned int _expectNumFacets;
+        bool _comesFromMagics;
+        osg::Vec4 _magicsHeaderColor;
+
+        // returns false if the facet has no color
+        bool getColor(const StlFacet& facet, osg::Vec4& color) const;
+
+        virtual void addFacet(const StlFacet& facet);
+    };
+
+    /**
+     * Binary reader merging the vertices sharing the same position (and
+     * color) as the facets are read, through a hash table of the vertices
+     * indices, so that an indexed geometry is built directly instead of
+     * three vertices, normals and colors per facet.
+     * As the facet normals can't be kept on shared vertices, per vertex
+     * normals are accumulated from the facets area weighted normals.
+     */
+    class WeldingBinaryReaderObject : public BinaryReaderObject
+    {
+    public:
+        WeldingBinaryReaderObject(unsigned int expectNumFacets, bool noTriStripPolygons, bool generateNormals = true)
+            : BinaryReaderObject(expectNumFacets, noTriStripPolygons, generateNormals),
+            _trackColors(false),
+            _hashMask(0)
+        {
+        }
+
+        ReadResult read(FILE *fp);
+
+        virtual osg::ref_ptr<osg::Geometry> asGeometry() const;
+
+    protected:
+        virtual void addFacet(const StlFacet& facet);
+
+        unsigned int weld(const osg::Vec3& position, unsigned short colorKey, const osg::Vec4& color);
+        unsigned int findSlot(const osg::Vec3& position, unsigned short colorKey) const;
+        void resizeHashTable(unsigned int numSlots);
+
+        bool _trackColors;
+        osg::ref_ptr<osg::DrawElementsUInt> _indices;
+        std::vector<unsigned short> _colorKeys;
+
+        // open addressing table of vertex indices + 1, 0 marking empty slots
+        std::vector<unsigned int> _hashTable;
+        unsigned int _hashMask;
     };
 
     class CreateStlVisitor : public osg::NodeVisitor
@@ -523,7 +579,9 @@ osgDB::ReaderWriter::ReadResult ReaderWriterSTL::readNode(const std::string& fil
 
     ReaderObject *readerObject;
 
-    if (isBinary)
+    if (isBinary && localOptions.weldVertices)
+        readerObject = new WeldingBinaryReaderObject(expectFacets, localOptions.noTriStripPolygons);
+    else if (isBinary)
         readerObject = new BinaryReaderObject(expectFacets, localOptions.noTriStripPolygons);
     else
         readerObject = new AsciiReaderObject(localOptions.noTriStripPolygons);
@@ -680,6 +738,21 @@ ReaderWriterSTL::ReaderObject::ReadResult ReaderWriterSTL::AsciiReaderObject::re
     return ReadEOF;
 }
 
+// Decodes a little endian facet record
+static void decodeFacet(const char* record, StlFacet& facet)
+{
+    memcpy(&facet.normal, record, 12 * sizeof(float));
+    memcpy(&facet.color, record + 12 * sizeof(float), sizeof(unsigned short));
+
+    if (osg::getCpuByteOrder() == osg::BigEndian)
+    {
+        float* values = &facet.normal.x;
+        for (unsigned int i = 0; i < 12; ++i)
+            osg::swapBytes4((char*) &values[i]);
+        osg::swapBytes2((char*) &facet.color);
+    }
+}
+
 ReaderWriterSTL::ReaderObject::ReadResult ReaderWriterSTL::BinaryReaderObject::read(FILE* fp)
 {
     if (isEmpty())
@@ -690,8 +763,7 @@ ReaderWriterSTL::ReaderObject::ReadResult ReaderWriterSTL::BinaryReaderObject::r
     _numFacets = _expectNumFacets;
 
     // Check if the file comes from Magics and retrieve the global color from the header
-    osg::Vec4 magicsHeaderColor;
-    bool comesFromMagics = fileComesFromMagics(fp, magicsHeaderColor);
+    _comesFromMagics = fileComesFromMagics(fp, _magicsHeaderColor);
 
     // seek to beginning of facets
     if (::fseek(fp, sizeof_StlHeader, SEEK_SET)!=0)
@@ -699,83 +771,280 @@ ReaderWriterSTL::ReaderObject::ReadResult ReaderWriterSTL::BinaryReaderObject::r
         return ReadError;
     }
 
+    // read the facets by blocks
+    const unsigned int blockSize = 4096;
+    std::vector<char> block(blockSize * sizeof_StlFacet);
     StlFacet facet;
-    for (unsigned int i = 0; i < _expectNumFacets; ++i)
+    for (unsigned int first = 0; first < _expectNumFacets; first += blockSize)
     {
-        if (::fread((void*) &facet, sizeof_StlFacet, 1, fp) != 1)
+        unsigned int count = osg::minimum(blockSize, _expectNumFacets - first);
+        unsigned int numRead = ::fread((void*) &block[0], sizeof_StlFacet, count, fp);
+        if (numRead != count)
         {
-            OSG_FATAL << "ReaderWriterSTL::readStlBinary: Failed to read facet " << i << std::endl;
+            OSG_FATAL << "ReaderWriterSTL::readStlBinary: Failed to read facet " << first + numRead << std::endl;
             return ReadError;
         }
 
-        // vertices
-        if (!_vertex.valid())
-            _vertex = new osg::Vec3Array;
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            decodeFacet(&block[i * sizeof_StlFacet], facet);
+            addFacet(facet);
+        }
+    }
 
-        osg::Vec3 v0(facet.vertex[0].x, facet.vertex[0].y, facet.vertex[0].z);
-        osg::Vec3 v1(facet.vertex[1].x, facet.vertex[1].y, facet.vertex[1].z);
-        osg::Vec3 v2(facet.vertex[2].x, facet.vertex[2].y, facet.vertex[2].z);
-        _vertex->push_back(v0);
-        _vertex->push_back(v1);
-        _vertex->push_back(v2);
+    return ReadEOF;
+}
 
-        // per-facet normal
-        osg::Vec3 normal;
-        if (_generateNormal)
+bool ReaderWriterSTL::BinaryReaderObject::getColor(const StlFacet& facet, osg::Vec4& color) const
+{
+    /*
+     * color extension
+     * RGB555 with most-significat bit indicating if color is present
+     *
+     * The magics files may use whether per-face or per-object colors
+     * for a given face, according to the value of the last bit (0 = per-face, 1 = per-object)
+     * Moreover, magics uses RGB instead of BGR (as the other softwares)
+     */
+
+    // Case of a Magics file
+    if(_comesFromMagics)
+    {
+        if(facet.color & StlHasColor) // The last bit is 1, the per-object color is used
         {
-            osg::Vec3 d01 = v1 - v0;
-            osg::Vec3 d02 = v2 - v0;
-            normal = d01 ^ d02;
-            normal.normalize();
+            color = _magicsHeaderColor;
         }
-        else
+        else // the last bit is 0, the facet has its own unique color
         {
-            normal.set(facet.normal.x, facet.normal.y, facet.normal.z);
+            float b = ((facet.color >> 10) & StlColorSize) / StlColorDepth;
+            float g = ((facet.color >> 5) & StlColorSize) / StlColorDepth;
+            float r = (facet.color & StlColorSize) / StlColorDepth;
+            color.set(r, g, b, 1.0f);
         }
+        return true;
+    }
+    // Case of a generic file
+    else if (facet.color & StlHasColor) // The color is valid if the last bit is 1
+    {
+        float r = ((facet.color >> 10) & StlColorSize) / StlColorDepth;
+        float g = ((facet.color >> 5) & StlColorSize) / StlColorDepth;
+        float b = (facet.color & StlColorSize) / StlColorDepth;
+        color.set(r, g, b, 1.0f);
+        return true;
+    }
 
-        if (!_normal.valid())
-            _normal = new osg::Vec3Array;
-        _normal->push_back(normal);
-
-        /*
-         * color extension
-         * RGB555 with most-significat bit indicating if color is present
-         *
-         * The magics files may use whether per-face or per-object colors
-         * for a given face, according to the value of the last bit (0 = per-face, 1 = per-object)
-         * Moreover, magics uses RGB instead of BGR (as the other softwares)
-         */
-        if (!_color.valid())
-        {
-            _color = new osg::Vec4Array;
-        }
+    return false;
+}
 
-        // Case of a Magics file
-        if(comesFromMagics)
-        {
-            if(facet.color & StlHasColor) // The last bit is 1, the per-object color is used
-            {
-                _color->push_back(magicsHeaderColor);
-            }
-            else // the last bit is 0, the facet has its own unique color
-            {
-                float b = ((facet.color >> 10) & StlColorSize) / StlColorDepth;
-                float g = ((facet.color >> 5) & StlColorSize) / StlColorDepth;
-                float r = (facet.color & StlColorSize) / StlColorDepth;
-                _color->push_back(osg::Vec4(r, g, b, 1.0f));
-            }
-        }
-        // Case of a generic file
-        else if (facet.color & StlHasColor) // The color is valid if the last bit is 1
-            {
-                float r = ((facet.color >> 10) & StlColorSize) / StlColorDepth;
-                float g = ((facet.color >> 5) & StlColorSize) / StlColorDepth;
-                float b = (facet.color & StlColorSize) / StlColorDepth;
-                _color->push_back(osg::Vec4(r, g, b, 1.0f));
-            }
+void ReaderWriterSTL::BinaryReaderObject::addFacet(const StlFacet& facet)
+{
+    // vertices
+    if (!_vertex.valid())
+        _vertex = new osg::Vec3Array;
+
+    osg::Vec3 v0(facet.vertex[0].x, facet.vertex[0].y, facet.vertex[0].z);
+    osg::Vec3 v1(facet.vertex[1].x, facet.vertex[1].y, facet.vertex[1].z);
+    osg::Vec3 v2(facet.vertex[2].x, facet.vertex[2].y, facet.vertex[2].z);
+    _vertex->push_back(v0);
+    _vertex->push_back(v1);
+    _vertex->push_back(v2);
+
+    // per-facet normal
+    osg::Vec3 normal;
+    if (_generateNormal)
+    {
+        osg::Vec3 d01 = v1 - v0;
+        osg::Vec3 d02 = v2 - v0;
+        normal = d01 ^ d02;
+        normal.normalize();
+    }
+    else
+    {
+        normal.set(facet.normal.x, facet.normal.y, facet.normal.z);
     }
 
-    return ReadEOF;
+    if (!_normal.valid())
+        _normal = new osg::Vec3Array;
+    _normal->push_back(normal);
+
+    if (!_color.valid())
+    {
+        _color = new osg::Vec4Array;
+    }
+
+    osg::Vec4 color;
+    if (getColor(facet, color))
+    {
+        _color->push_back(color);
+    }
+}
+
+ReaderWriterSTL::ReaderObject::ReadResult ReaderWriterSTL::WeldingBinaryReaderObject::read(FILE* fp)
+{
+    _indices = 0;
+
+    ReadResult result = BinaryReaderObject::read(fp);
+    if (!_indices.valid())
+        return result;
+
+    for(osg::Vec3Array::iterator itr = _normal->begin(); itr != _normal->end(); ++itr)
+    {
+        itr->normalize();
+    }
+
+    OSG_INFO << "ReaderWriterSTL: welded " << _numFacets * 3 << " vertices into " << _vertex->size() << std::endl;
+
+    // the hash table is only needed while reading
+    std::vector<unsigned int>().swap(_hashTable);
+    std::vector<unsigned short>().swap(_colorKeys);
+
+    return result;
+}
+
+void ReaderWriterSTL::WeldingBinaryReaderObject::addFacet(const StlFacet& facet)
+{
+    if (!_indices.valid())
+    {
+        _vertex = new osg::Vec3Array;
+        _normal = new osg::Vec3Array;
+        _indices = new osg::DrawElementsUInt(osg::PrimitiveSet::TRIANGLES);
+        _indices->reserve(_expectNumFacets * 3);
+        _colorKeys.clear();
+
+        // closed meshes have about half as many vertices as facets
+        unsigned int numSlots = 1024;
+        while (numSlots < _expectNumFacets) numSlots <<= 1;
+        resizeHashTable(numSlots);
+    }
+
+    // colors are kept if all the facets have one, as in the unwelded geometry
+    osg::Vec4 color;
+    bool hasColor = getColor(facet, color);
+    if (_indices->empty() && hasColor)
+    {
+        _trackColors = true;
+        _color = new osg::Vec4Array;
+    }
+    else if (_trackColors && !hasColor)
+    {
+        _trackColors = false;
+        _color = 0;
+        std::vector<unsigned short>().swap(_colorKeys);
+    }
+
+    // vertices sharing a position but not a color are kept apart
+    unsigned short colorKey = _trackColors ? facet.color : 0;
+
+    osg::Vec3 v0(facet.vertex[0].x, facet.vertex[0].y, facet.vertex[0].z);
+    osg::Vec3 v1(facet.vertex[1].x, facet.vertex[1].y, facet.vertex[1].z);
+    osg::Vec3 v2(facet.vertex[2].x, facet.vertex[2].y, facet.vertex[2].z);
+
+    unsigned int i0 = weld(v0, colorKey, color);
+    unsigned int i1 = weld(v1, colorKey, color);
+    unsigned int i2 = weld(v2, colorKey, color);
+    _indices->push_back(i0);
+    _indices->push_back(i1);
+    _indices->push_back(i2);
+
+    // the unnormalized facet normal weights the vertex normals by the facet areas
+    osg::Vec3 normal;
+    if (_generateNormal)
+    {
+        normal = (v1 - v0) ^ (v2 - v0);
+    }
+    else
+    {
+        normal.set(facet.normal.x, facet.normal.y, facet.normal.z);
+    }
+
+    (*_normal)[i0] += normal;
+    (*_normal)[i1] += normal;
+    (*_normal)[i2] += normal;
+}
+
+static inline unsigned int hashPosition(const osg::Vec3& position)
+{
+    // adding 0 turns -0 into +0 so that both hash the same
+    float values[3] = { position.x() + 0.0f, position.y() + 0.0f, position.z() + 0.0f };
+    unsigned int bits[3];
+    memcpy(bits, values, sizeof(bits));
+
+    unsigned int hash = bits[0] * 0x9E3779B1u;
+    hash = (hash ^ (hash >> 15) ^ bits[1]) * 0x85EBCA77u;
+    hash = (hash ^ (hash >> 13) ^ bits[2]) * 0xC2B2AE3Du;
+    return hash ^ (hash >> 16);
+}
+
+unsigned int ReaderWriterSTL::WeldingBinaryReaderObject::findSlot(const osg::Vec3& position, unsigned short colorKey) const
+{
+    // linear probing up to the vertex or an empty slot
+    unsigned int slot = hashPosition(position) & _hashMask;
+    while (_hashTable[slot] != 0)
+    {
+        unsigned int index = _hashTable[slot] - 1;
+        if ((*_vertex)[index] == position && (!_trackColors || _colorKeys[index] == colorKey))
+            break;
+        slot = (slot + 1) & _hashMask;
+    }
+    return slot;
+}
+
+unsigned int ReaderWriterSTL::WeldingBinaryReaderObject::weld(const osg::Vec3& position, unsigned short colorKey, const osg::Vec4& color)
+{
+    unsigned int slot = findSlot(position, colorKey);
+    if (_hashTable[slot] != 0)
+        return _hashTable[slot] - 1;
+
+    unsigned int index = _vertex->size();
+    _vertex->push_back(position);
+    _normal->push_back(osg::Vec3());
+    if (_trackColors)
+    {
+        _color->push_back(color);
+        _colorKeys.push_back(colorKey);
+    }
+    _hashTable[slot] = index + 1;
+
+    // keep the table at most half full
+    if (_vertex->size() * 2 > _hashTable.size())
+        resizeHashTable(_hashTable.size() * 2);
+
+    return index;
+}
+
+void ReaderWriterSTL::WeldingBinaryReaderObject::resizeHashTable(unsigned int numSlots)
+{
+    _hashTable.assign(numSlots, 0);
+    _hashMask = numSlots - 1;
+    for (unsigned int index = 0; index < _vertex->size(); ++index)
+    {
+        unsigned int slot = hashPosition((*_vertex)[index]) & _hashMask;
+        while (_hashTable[slot] != 0)
+            slot = (slot + 1) & _hashMask;
+        _hashTable[slot] = index + 1;
+    }
+}
+
+osg::ref_ptr<osg::Geometry> ReaderWriterSTL::WeldingBinaryReaderObject::asGeometry() const
+{
+    osg::ref_ptr<osg::Geometry> geom = new osg::Geometry;
+
+    geom->setVertexArray(_vertex.get());
+    geom->setNormalArray(_normal.get(), osg::Array::BIND_PER_VERTEX);
+
+    if (_color.valid())
+    {
+        OSG_INFO << "STL file with color" << std::endl;
+        geom->setColorArray(_color.get(), osg::Array::BIND_PER_VERTEX);
+    }
+
+    geom->addPrimitiveSet(_indices.get());
+
+    if(!_noTriStripPolygons) {
+        osgUtil::TriStripVisitor tristripper;
+        tristripper.stripify(*geom);
+    }
+
+    return geom;
 }
 
 osgDB::ReaderWriter::WriteResult ReaderWriterSTL::writeNode(const osg::Node& node, const std::string& fileName, const Options* opts) const
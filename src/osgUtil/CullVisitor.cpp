@@ -11,9 +11,13 @@
  * OpenSceneGraph Public License for more details.
 */
 #include <osg/Transform>
+#include <osg/MatrixTransform>
+#include <osg/PositionAttitudeTransform>
+#include <osg/Switch>
 #include <osg/Projection>
 #include <osg/Geode>
 #include <osg/LOD>
+#include <osg/PagedLOD>
 #include <osg/Billboard>
 #include <osg/LightSource>
 #include <osg/ClipNode>
@@ -30,8 +34,14 @@
 
 #include <osgUtil/CullVisitor>
 
+#include <OpenThreads/Thread>
+#include <OpenThreads/Mutex>
+#include <OpenThreads/Condition>
+#include <OpenThreads/ScopedLock>
+
 #include <float.h>
 #include <algorithm>
+#include <typeinfo>
 
 #include <osg/Timer>
 
@@ -43,6 +53,576 @@ inline float MAX_F(float a, float b)
 inline int EQUAL_F(float a, float b)
     { return a == b || fabsf(a-b) <= MAX_F(fabsf(a),fabsf(b))*1e-3f; }
 
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// ParallelCull, the threads and CullVisitors used to cull the children of wide groups in parallel
+//
+class CullVisitor::ParallelCull : public osg::Referenced
+{
+    public:
+
+        ParallelCull(const CullVisitor& prototype, unsigned int numThreads):
+            _parent(0),
+            _group(0),
+            _numChildren(0),
+            _generation(0),
+            _numPending(0),
+            _done(false)
+        {
+            // one CullVisitor per thread, plus one for the range culled by the calling thread.
+            for(unsigned int i=0; i<=numThreads; ++i)
+            {
+                CullVisitor* cv = prototype.clone();
+                cv->_parallelCullWorker = true;
+                _cullVisitors.push_back(cv);
+            }
+
+            for(unsigned int i=1; i<=numThreads; ++i)
+            {
+                Thread* thread = new Thread(this, i);
+                _threads.push_back(thread);
+                thread->startThread();
+            }
+        }
+
+        unsigned int getNumThreads() const { return static_cast<unsigned int>(_threads.size()); }
+
+        void reset()
+        {
+            for(CullVisitors::iterator itr = _cullVisitors.begin();
+                itr != _cullVisitors.end();
+                ++itr)
+            {
+                (*itr)->reset();
+                if ((*itr)->_rootStateGraph.valid()) (*itr)->_rootStateGraph->reset();
+            }
+
+            // drop the scans of groups that have since been deleted.
+            for(GroupScanMap::iterator itr = _groupScans.begin();
+                itr != _groupScans.end();)
+            {
+                if (itr->second._group.valid()) ++itr;
+                else _groupScans.erase(itr++);
+            }
+        }
+
+        /** Return true if the children of group can be culled in parallel: none of the nodes below it has a cull callback
+          * or is of a type whose cull isn't known to be thread safe and free of side effects on the camera's RenderStage,
+          * and no PagedLOD is reachable from two children, as its cull records its traversal and requests its children.
+          * The subgraphs of the children are scanned again only when their render leaf cache modified count changes,
+          * see osg::Node::dirtyRenderLeafCaches().*/
+        bool isParallelCullSafe(osg::Group& group)
+        {
+            GroupScan& scan = _groupScans[&group];
+            if (scan._group.get()==&group && scan._modifiedCount==group.getRenderLeafCacheModifiedCount()) return scan._safe;
+
+            scan._group = &group;
+            scan._modifiedCount = group.getRenderLeafCacheModifiedCount();
+            scan._safe = true;
+            scan._children.resize(group.getNumChildren());
+
+            for(unsigned int i=0; i<group.getNumChildren() && scan._safe; ++i)
+            {
+                osg::Node* child = group.getChild(i);
+                osg::Group* childGroup = child->asGroup();
+                unsigned int modifiedCount = childGroup ? childGroup->getRenderLeafCacheModifiedCount() : 0;
+
+                ChildScan& childScan = scan._children[i];
+                if (!childGroup || childScan._child.get()!=child || childScan._modifiedCount!=modifiedCount)
+                {
+                    Scanner scanner;
+                    child->accept(scanner);
+
+                    childScan._child = child;
+                    childScan._modifiedCount = modifiedCount;
+                    childScan._safe = scanner._safe;
+                    childScan._pagedLODs.swap(scanner._pagedLODs);
+                    std::sort(childScan._pagedLODs.begin(), childScan._pagedLODs.end());
+                    childScan._pagedLODs.erase(std::unique(childScan._pagedLODs.begin(), childScan._pagedLODs.end()), childScan._pagedLODs.end());
+                }
+
+                scan._safe = childScan._safe;
+            }
+
+            if (scan._safe)
+            {
+                PagedLODs pagedLODs;
+                for(ChildScans::const_iterator itr = scan._children.begin();
+                    itr != scan._children.end();
+                    ++itr)
+                {
+                    pagedLODs.insert(pagedLODs.end(), itr->_pagedLODs.begin(), itr->_pagedLODs.end());
+                }
+
+                // each child's list is free of duplicates, so a duplicate is reachable from two children.
+                std::sort(pagedLODs.begin(), pagedLODs.end());
+                scan._safe = std::adjacent_find(pagedLODs.begin(), pagedLODs.end())==pagedLODs.end();
+            }
+
+            return scan._safe;
+        }
+
+        void traverse(CullVisitor& parent, osg::Group& group)
+        {
+            {
+                OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+                _parent = &parent;
+                _group = &group;
+                _numChildren = group.getNumChildren();
+                _numPending = getNumThreads();
+                ++_generation;
+                _startCondition.broadcast();
+            }
+
+            _cullVisitors[0]->parallelCull(parent, group, rangeBegin(0), rangeBegin(1));
+
+            {
+                OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+                while(_numPending>0) _finishedCondition.wait(&_mutex);
+            }
+
+            for(unsigned int i=0; i<_cullVisitors.size(); ++i)
+            {
+                parent.mergeParallelCull(*_cullVisitors[i], group, rangeBegin(i), rangeBegin(i+1));
+            }
+        }
+
+    protected:
+
+        virtual ~ParallelCull()
+        {
+            {
+                OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+                _done = true;
+                _startCondition.broadcast();
+            }
+
+            for(Threads::iterator itr = _threads.begin();
+                itr != _threads.end();
+                ++itr)
+            {
+                (*itr)->join();
+                delete *itr;
+            }
+        }
+
+        class Thread : public OpenThreads::Thread
+        {
+            public:
+                Thread(ParallelCull* parallelCull, unsigned int index):
+                    _parallelCull(parallelCull),
+                    _index(index) {}
+
+                virtual void run() { _parallelCull->run(_index); }
+
+            protected:
+                ParallelCull*   _parallelCull;
+                unsigned int    _index;
+        };
+
+        /** First child of the range culled by CullVisitor index, children are spread evenly across the CullVisitors.*/
+        unsigned int rangeBegin(unsigned int index) const
+        {
+            unsigned int numRanges = static_cast<unsigned int>(_cullVisitors.size());
+            return (_numChildren/numRanges)*index + osg::minimum(index, _numChildren%numRanges);
+        }
+
+        void run(unsigned int index)
+        {
+            unsigned int generation = 0;
+            while(true)
+            {
+                {
+                    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+                    while(!_done && _generation==generation) _startCondition.wait(&_mutex);
+                    if (_done) return;
+                    generation = _generation;
+                }
+
+                _cullVisitors[index]->parallelCull(*_parent, *_group, rangeBegin(index), rangeBegin(index+1));
+
+                {
+                    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+                    if (--_numPending==0) _finishedCondition.broadcast();
+                }
+            }
+        }
+
+        typedef std::vector<const osg::PagedLOD*> PagedLODs;
+
+        /** Visits every node of a subgraph, whatever its node mask, flagging the subgraph as not safe to cull on a parallel cull
+          * thread as soon as it finds a node with a cull callback or of a type not listed here, and collecting its PagedLODs.*/
+        class Scanner : public osg::NodeVisitor
+        {
+            public:
+
+                Scanner():
+                    osg::NodeVisitor(TRAVERSE_ALL_CHILDREN),
+                    _safe(true)
+                {
+                    setNodeMaskOverride(0xffffffff);
+                }
+
+                virtual void apply(osg::Node& node) { check(node, typeid(node)==typeid(osg::Node)); }
+                virtual void apply(osg::Group& node) { check(node, typeid(node)==typeid(osg::Group)); }
+                virtual void apply(osg::Geode& node) { check(node, typeid(node)==typeid(osg::Geode)); }
+                virtual void apply(osg::Billboard& node) { check(node, typeid(node)==typeid(osg::Billboard)); }
+                virtual void apply(osg::Switch& node) { check(node, typeid(node)==typeid(osg::Switch)); }
+                virtual void apply(osg::LOD& node) { check(node, typeid(node)==typeid(osg::LOD)); }
+                virtual void apply(osg::LightSource& node) { check(node, typeid(node)==typeid(osg::LightSource)); }
+                virtual void apply(osg::ClipNode& node) { check(node, typeid(node)==typeid(osg::ClipNode)); }
+                virtual void apply(osg::TexGenNode& node) { check(node, typeid(node)==typeid(osg::TexGenNode)); }
+
+                virtual void apply(osg::PagedLOD& node)
+                {
+                    _pagedLODs.push_back(&node);
+                    check(node, typeid(node)==typeid(osg::PagedLOD));
+                }
+
+                virtual void apply(osg::Transform& node)
+                {
+                    check(node, typeid(node)==typeid(osg::MatrixTransform) || typeid(node)==typeid(osg::PositionAttitudeTransform));
+                }
+
+                // drawables are culled by CullVisitor::apply(Drawable&) whatever their type.
+                virtual void apply(osg::Drawable& drawable) { check(drawable, true); }
+
+                bool        _safe;
+                PagedLODs   _pagedLODs;
+
+            protected:
+
+                void check(osg::Node& node, bool knownType)
+                {
+                    if (!_safe) return;
+                    if (!knownType || node.getCullCallback()) { _safe = false; return; }
+                    traverse(node);
+                }
+        };
+
+        struct ChildScan
+        {
+            ChildScan():
+                _modifiedCount(0),
+                _safe(false) {}
+
+            osg::observer_ptr<osg::Node>    _child;
+            unsigned int                    _modifiedCount;
+            bool                            _safe;
+            PagedLODs                       _pagedLODs;
+        };
+
+        typedef std::vector<ChildScan> ChildScans;
+
+        struct GroupScan
+        {
+            GroupScan():
+                _modifiedCount(0),
+                _safe(false) {}
+
+            osg::observer_ptr<osg::Group>   _group;
+            unsigned int                    _modifiedCount;
+            bool                            _safe;
+            ChildScans                      _children;
+        };
+
+        typedef std::map<const osg::Group*, GroupScan> GroupScanMap;
+
+        typedef std::vector< osg::ref_ptr<CullVisitor> > CullVisitors;
+        typedef std::vector< Thread* > Threads;
+
+        GroupScanMap            _groupScans;
+        CullVisitors            _cullVisitors;
+        Threads                 _threads;
+
+        OpenThreads::Mutex      _mutex;
+        OpenThreads::Condition  _startCondition;
+        OpenThreads::Condition  _finishedCondition;
+
+        CullVisitor*            _parent;
+        osg::Group*             _group;
+        unsigned int            _numChildren;
+        unsigned int            _generation;
+        unsigned int            _numPending;
+        bool                    _done;
+};
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// RenderLeafCache, the drawables of the subgraph of a Group along with their StateSet's and
+// transforms relative to the Group, see osg::Group::setCacheRenderLeaves(..)
+//
+class CullVisitor::RenderLeafCache : public osg::Referenced
+{
+    public:
+
+        RenderLeafCache():
+            _cacheable(false),
+            _modifiedCount(0),
+            _traversalMode(osg::NodeVisitor::TRAVERSE_NONE),
+            _traversalMask(0),
+            _nodeMaskOverride(0) {}
+
+        /** A StateSet pushed on the way down to the drawables, and the index of the StateSet pushed before it, or -1.*/
+        struct StatePath
+        {
+            StatePath(osg::StateSet* stateset, int parent):
+                _stateset(stateset),
+                _parent(parent) {}
+
+            osg::ref_ptr<osg::StateSet> _stateset;
+            int                         _parent;
+        };
+
+        /** The bounding sphere, in the coordinate frame of the group, of a node with culling active on the way down to
+          * the drawables, and the index of the bound of the node above it, or -1.*/
+        struct NodeBound
+        {
+            NodeBound(const osg::BoundingSphere& bs, int parent):
+                _bs(bs),
+                _parent(parent) {}
+
+            osg::BoundingSphere         _bs;
+            int                         _parent;
+        };
+
+        struct Leaf
+        {
+            osg::ref_ptr<osg::Drawable> _drawable;
+            osg::BoundingBox            _bb;            // bounding box of the drawable in the coordinate frame of the group.
+            int                         _matrix;        // index of the matrix relative to the group, or -1 for the group's own.
+            int                         _statePath;     // index of the last StateSet pushed, or -1 for none.
+            int                         _bound;         // index of the bound of the closest node with culling active, or -1.
+        };
+
+        typedef std::vector<osg::Matrix>    MatrixList;
+        typedef std::vector<StatePath>      StatePathList;
+        typedef std::vector<NodeBound>      NodeBoundList;
+        typedef std::vector<Leaf>           LeafList;
+
+        enum BoundCullResult
+        {
+            BOUND_NOT_TESTED = 0,
+            BOUND_VISIBLE,
+            BOUND_CULLED
+        };
+
+        bool isUpToDate(const osg::Group& group, const osg::NodeVisitor& nv) const
+        {
+            return _group.get()==&group &&
+                   _modifiedCount==group.getRenderLeafCacheModifiedCount() &&
+                   _traversalMode==nv.getTraversalMode() &&
+                   _traversalMask==nv.getTraversalMask() &&
+                   _nodeMaskOverride==nv.getNodeMaskOverride();
+        }
+
+        void build(osg::Group& group, const osg::NodeVisitor& nv)
+        {
+            _group = &group;
+            _modifiedCount = group.getRenderLeafCacheModifiedCount();
+            _traversalMode = nv.getTraversalMode();
+            _traversalMask = nv.getTraversalMask();
+            _nodeMaskOverride = nv.getNodeMaskOverride();
+
+            _matrices.clear();
+            _statePaths.clear();
+            _bounds.clear();
+            _leaves.clear();
+
+            Builder builder(*this, nv);
+            if (typeid(group)==typeid(osg::Group) && !group.getCullCallback()) group.traverse(builder);
+            else builder._cacheable = false;
+
+            _cacheable = builder._cacheable;
+            if (!_cacheable)
+            {
+                _matrices.clear();
+                _statePaths.clear();
+                _bounds.clear();
+                _leaves.clear();
+            }
+
+            _refMatrices.resize(_matrices.size());
+            _boundCullResults.resize(_bounds.size());
+        }
+
+        /** Test the bounds of the nodes above a drawable like the traversal of the subgraph would, so that their view
+          * frustum and small feature culling still applies, each bound being tested at most once per cull.*/
+        bool isCulled(int bound, osg::CullStack& cullStack)
+        {
+            if (bound<0) return false;
+
+            unsigned char& result = _boundCullResults[bound];
+            if (result==BOUND_NOT_TESTED)
+            {
+                const NodeBound& nodeBound = _bounds[bound];
+                result = (isCulled(nodeBound._parent, cullStack) || cullStack.isCulled(nodeBound._bs)) ? BOUND_CULLED : BOUND_VISIBLE;
+            }
+            return result==BOUND_CULLED;
+        }
+
+        /** Collects the drawables of a subgraph, flagging the subgraph as not cacheable as soon as it finds a node whose
+          * cull depends on the view or isn't known to be handled like a plain osg::Group by the CullVisitor.*/
+        class Builder : public osg::NodeVisitor
+        {
+            public:
+
+                Builder(RenderLeafCache& cache, const osg::NodeVisitor& nv):
+                    osg::NodeVisitor(nv.getTraversalMode()),
+                    _cache(cache),
+                    _cacheable(true),
+                    _matrix(-1),
+                    _statePath(-1),
+                    _bound(-1)
+                {
+                    setTraversalMask(nv.getTraversalMask());
+                    setNodeMaskOverride(nv.getNodeMaskOverride());
+                }
+
+                virtual void apply(osg::Node& node)
+                {
+                    if (typeid(node)==typeid(osg::Node)) collect(node, 0);
+                    else _cacheable = false;
+                }
+
+                virtual void apply(osg::Group& node)
+                {
+                    if (typeid(node)==typeid(osg::Group)) collect(node, 0);
+                    else _cacheable = false;
+                }
+
+                virtual void apply(osg::Switch& node)
+                {
+                    if (typeid(node)==typeid(osg::Switch)) collect(node, 0);
+                    else _cacheable = false;
+                }
+
+                virtual void apply(osg::Geode& node)
+                {
+                    if (typeid(node)==typeid(osg::Geode)) collect(node, 0);
+                    else _cacheable = false;
+                }
+
+                virtual void apply(osg::Transform& node)
+                {
+                    if ((typeid(node)==typeid(osg::MatrixTransform) || typeid(node)==typeid(osg::PositionAttitudeTransform)) &&
+                        node.getReferenceFrame()==osg::Transform::RELATIVE_RF)
+                    {
+                        collect(node, &node);
+                    }
+                    else _cacheable = false;
+                }
+
+                virtual void apply(osg::Drawable& drawable)
+                {
+                    if (!_cacheable) return;
+                    if (drawable.getCullCallback()) { _cacheable = false; return; }
+
+                    int statePath = _statePath;
+                    if (drawable.getStateSet()) statePath = pushStateSet(drawable.getStateSet());
+
+                    Leaf leaf;
+                    leaf._drawable = &drawable;
+                    leaf._matrix = _matrix;
+                    leaf._statePath = statePath;
+                    leaf._bound = _bound;
+
+                    const osg::BoundingBox& bb = drawable.getBoundingBox();
+                    if (_matrix<0) leaf._bb = bb;
+                    else if (bb.valid())
+                    {
+                        for(unsigned int i=0; i<8; ++i) leaf._bb.expandBy(bb.corner(i)*_cache._matrices[_matrix]);
+                    }
+
+                    _cache._leaves.push_back(leaf);
+                }
+
+                RenderLeafCache&    _cache;
+                bool                _cacheable;
+
+            protected:
+
+                Builder& operator = (const Builder&) { return *this; }
+
+                int pushStateSet(osg::StateSet* stateset)
+                {
+                    _cache._statePaths.push_back(StatePath(stateset, _statePath));
+                    return static_cast<int>(_cache._statePaths.size())-1;
+                }
+
+                void collect(osg::Node& node, osg::Transform* transform)
+                {
+                    if (!_cacheable) return;
+                    if (node.getCullCallback()) { _cacheable = false; return; }
+
+                    int previousStatePath = _statePath;
+                    if (node.getStateSet()) _statePath = pushStateSet(node.getStateSet());
+
+                    // the bound of a node is in the coordinate frame of its parent, so transform it before pushing the node's matrix.
+                    int previousBound = _bound;
+                    if (node.isCullingActive()) _bound = pushBound(node.getBound());
+
+                    int previousMatrix = _matrix;
+                    if (transform)
+                    {
+                        osg::Matrix matrix;
+                        if (_matrix>=0) matrix = _cache._matrices[_matrix];
+                        transform->computeLocalToWorldMatrix(matrix, this);
+
+                        _cache._matrices.push_back(matrix);
+                        _matrix = static_cast<int>(_cache._matrices.size())-1;
+                    }
+
+                    traverse(node);
+
+                    _matrix = previousMatrix;
+                    _bound = previousBound;
+                    _statePath = previousStatePath;
+                }
+
+                int pushBound(const osg::BoundingSphere& bs)
+                {
+                    if (_matrix<0) _cache._bounds.push_back(NodeBound(bs, _bound));
+                    else
+                    {
+                        // transform the sphere the same way osg::Transform::computeBound() does.
+                        const osg::Matrix& matrix = _cache._matrices[_matrix];
+                        osg::Vec3 center = bs.center()*matrix;
+                        float radius2 = 0.0f;
+                        for(unsigned int i=0; i<3; ++i)
+                        {
+                            osg::Vec3 dash = bs.center();
+                            dash[i] += bs.radius();
+                            radius2 = osg::maximum(radius2, (dash*matrix-center).length2());
+                        }
+                        _cache._bounds.push_back(NodeBound(osg::BoundingSphere(center, sqrtf(radius2)), _bound));
+                    }
+                    return static_cast<int>(_cache._bounds.size())-1;
+                }
+
+                int _matrix;
+                int _statePath;
+                int _bound;
+        };
+
+        osg::observer_ptr<osg::Group>   _group;
+        bool                            _cacheable;
+        unsigned int                    _modifiedCount;
+        osg::NodeVisitor::TraversalMode _traversalMode;
+        osg::Node::NodeMask             _traversalMask;
+        osg::Node::NodeMask             _nodeMaskOverride;
+
+        MatrixList                      _matrices;
+        StatePathList                   _statePaths;
+        NodeBoundList                   _bounds;
+        LeafList                        _leaves;
+
+        // the model view matrices and the results of the bound tests of the current cull, created on demand.
+        std::vector<osg::RefMatrix*>    _refMatrices;
+        std::vector<unsigned char>      _boundCullResults;
+};
+
 
 CullVisitor::CullVisitor():
     osg::NodeVisitor(CULL_VISITOR,TRAVERSE_ACTIVE_CHILDREN),
@@ -52,7 +632,10 @@ CullVisitor::CullVisitor():
     _computed_znear(FLT_MAX),
     _computed_zfar(-FLT_MAX),
     _currentReuseRenderLeafIndex(0),
-    _numberOfEncloseOverrideRenderBinDetails(0)
+    _numberOfEncloseOverrideRenderBinDetails(0),
+    _parallelCullWorker(false),
+    _parallelCullAborted(false),
+    _parallelCullFirstRenderLeaf(0)
 {
     _identifier = new Identifier;
 }
@@ -68,7 +651,10 @@ CullVisitor::CullVisitor(const CullVisitor& rhs):
     _computed_zfar(-FLT_MAX),
     _currentReuseRenderLeafIndex(0),
     _numberOfEncloseOverrideRenderBinDetails(0),
-    _identifier(rhs._identifier)
+    _identifier(rhs._identifier),
+    _parallelCullWorker(false),
+    _parallelCullAborted(false),
+    _parallelCullFirstRenderLeaf(0)
 {
 }
 
@@ -133,6 +719,23 @@ void CullVisitor::reset()
 
     _nearPlaneCandidateMap.clear();
     _farPlaneCandidateMap.clear();
+
+    _parallelCullFirstRenderLeaf = 0;
+
+    // reset the parallel cull threads' CullVisitors, or drop them if the number of threads has changed.
+    if (_parallelCull.valid())
+    {
+        if (_parallelCull->getNumThreads()!=_numParallelCullThreads) _parallelCull = 0;
+        else _parallelCull->reset();
+    }
+
+    // drop the drawables cached for groups that have since been deleted.
+    for(RenderLeafCacheMap::iterator itr = _renderLeafCacheMap.begin();
+        itr != _renderLeafCacheMap.end();)
+    {
+        if (itr->second->_group.valid()) ++itr;
+        else _renderLeafCacheMap.erase(itr++);
+    }
 }
 
 float CullVisitor::getDistanceToEyePoint(const Vec3& pos, bool withLODScale) const
@@ -1224,7 +1827,24 @@ void CullVisitor::apply(Group& node)
     StateSet* node_state = node.getStateSet();
     if (node_state) pushStateSet(node_state);
 
-    handle_cull_callbacks_and_traverse(node);
+    // add the drawables cached for static subgraphs straight to the render graph, rather than traversing them.
+    if (!node.getCacheRenderLeaves() || !cullRenderLeafCache(node))
+    {
+        // split the cull of wide plain groups across the parallel cull threads, subclasses
+        // of Group are left alone as they may implement their own traverse().
+        if (_numParallelCullThreads>0 && !_parallelCullWorker &&
+            node.getNumChildren()>=osg::maximum(_parallelCullMinimumNumChildren, 2u) &&
+            !node.getCullCallback() &&
+            (_traversalMode==TRAVERSE_ACTIVE_CHILDREN || _traversalMode==TRAVERSE_ALL_CHILDREN) &&
+            typeid(node)==typeid(osg::Group))
+        {
+            parallelTraverse(node);
+        }
+        else
+        {
+            handle_cull_callbacks_and_traverse(node);
+        }
+    }
 
     // pop the node's state off the render graph stack.
     if (node_state) popStateSet();
@@ -1343,6 +1963,9 @@ void CullVisitor::apply(LOD& node)
 
 void CullVisitor::apply(osg::ClearNode& node)
 {
+    // the clear settings belong to the camera's RenderStage
+    if (abortParallelCull()) return;
+
     // simply override the current earth sky.
     if (node.getRequiresClear())
     {
@@ -1466,6 +2089,9 @@ class RenderStageCache : public osg::Object, public osg::Observer
 
 void CullVisitor::apply(osg::Camera& camera)
 {
+    // cameras set up their own RenderStage's, leave them to the camera's CullVisitor
+    if (abortParallelCull()) return;
+
     // push the node's state.
     StateSet* node_state = camera.getStateSet();
     if (node_state) pushStateSet(node_state);
@@ -1748,6 +2374,9 @@ void CullVisitor::apply(osg::OccluderNode& node)
 
 void CullVisitor::apply(osg::OcclusionQueryNode& node)
 {
+    // queries are keyed on the camera, and issue RenderStage specific geometry
+    if (abortParallelCull()) return;
+
     if (isCulled(node)) return;
 
     // push the culling mode.
@@ -1778,3 +2407,312 @@ void CullVisitor::apply(osg::OcclusionQueryNode& node)
     popCurrentMask();
 }
 
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Parallel cull of wide groups
+//
+void CullVisitor::parallelTraverse(osg::Group& group)
+{
+    // a change in the number of threads is applied by reset(), as the current CullVisitors' RenderLeaf's are in use until the next frame.
+    if (!_parallelCull.valid()) _parallelCull = new ParallelCull(*this, _numParallelCullThreads);
+
+    // compute the bounds of the subgraph up front, so that changes to it dirty the modified counts the scan relies on,
+    // rather than lazily from several threads at once.
+    group.getBound();
+
+    if (_parallelCull->isParallelCullSafe(group)) _parallelCull->traverse(*this, group);
+    else handle_cull_callbacks_and_traverse(group);
+}
+
+void CullVisitor::parallelCull(CullVisitor& parent, osg::Group& group, unsigned int begin, unsigned int end)
+{
+    // inherit the traversal settings of the parent.
+    _traversalNumber = parent._traversalNumber;
+    _traversalMode = parent._traversalMode;
+    _traversalMask = parent._traversalMask;
+    _nodeMaskOverride = parent._nodeMaskOverride;
+    _frameStamp = parent._frameStamp;
+    _databaseRequestHandler = parent._databaseRequestHandler;
+    _imageRequestHandler = parent._imageRequestHandler;
+    setUserDataContainer(parent.getUserDataContainer());
+    setCullSettings(parent);
+    _renderInfo = parent._renderInfo;
+    _identifier = parent._identifier;
+
+    // start from the parent's node path, culling, matrix and viewport stacks.
+    _nodePath = parent._nodePath;
+    _occluderList = parent._occluderList;
+    _projectionStack = parent._projectionStack;
+    _modelviewStack = parent._modelviewStack;
+    _MVPW_Stack = parent._MVPW_Stack;
+    _viewportStack = parent._viewportStack;
+    _referenceViewPoints = parent._referenceViewPoints;
+    _eyePointStack = parent._eyePointStack;
+    _viewPointStack = parent._viewPointStack;
+    _clipspaceCullingStack = parent._clipspaceCullingStack;
+    _projectionCullingStack = parent._projectionCullingStack;
+    _modelviewCullingStack.assign(parent._modelviewCullingStack.begin(), parent._modelviewCullingStack.begin()+parent._index_modelviewCullingStack);
+    _index_modelviewCullingStack = parent._index_modelviewCullingStack;
+    _back_modelviewCullingStack = _index_modelviewCullingStack>0 ? &_modelviewCullingStack[_index_modelviewCullingStack-1] : 0;
+    _frustumVolume = parent._frustumVolume;
+    _bbCornerNear = parent._bbCornerNear;
+    _bbCornerFar = parent._bbCornerFar;
+
+    // collect the drawables into our own StateGraph and RenderStage fragments, the StateGraph
+    // fragment's root standing for the parent's current StateGraph.
+    if (!_rootStateGraph) _rootStateGraph = new StateGraph;
+    _currentStateGraph = _rootStateGraph.get();
+
+    if (!_rootRenderStage) _rootRenderStage = new RenderStage;
+    _rootRenderStage->setCamera(parent.getCurrentCamera());
+    _currentRenderBin = _rootRenderStage.get();
+    _renderBinStack.clear();
+    _numberOfEncloseOverrideRenderBinDetails = parent._numberOfEncloseOverrideRenderBinDetails;
+
+    _computed_znear = parent._computed_znear;
+    _computed_zfar = parent._computed_zfar;
+
+    _parallelCullAborted = false;
+    _parallelCullFirstRenderLeaf = _currentReuseRenderLeafIndex;
+
+    for(unsigned int i=begin; i<end && !_parallelCullAborted; ++i)
+    {
+        group.getChild(i)->accept(*this);
+    }
+
+    // restore the traversal mode disabled by abortParallelCull(), and release the parent's stacks.
+    _traversalMode = parent._traversalMode;
+
+    _nodePath.clear();
+    _projectionStack.clear();
+    _modelviewStack.clear();
+    _MVPW_Stack.clear();
+    _viewportStack.clear();
+    _clipspaceCullingStack.clear();
+    _projectionCullingStack.clear();
+    _index_modelviewCullingStack = 0;
+    _back_modelviewCullingStack = 0;
+}
+
+static unsigned int countRenderLeaves(const StateGraph* sg)
+{
+    unsigned int numLeaves = sg->_leaves.size();
+    for(StateGraph::ChildList::const_iterator itr = sg->_children.begin();
+        itr != sg->_children.end();
+        ++itr)
+    {
+        numLeaves += countRenderLeaves(itr->second.get());
+    }
+    return numLeaves;
+}
+
+void CullVisitor::mergeParallelCull(CullVisitor& worker, osg::Group& group, unsigned int begin, unsigned int end)
+{
+    StateGraph* fragment = worker._rootStateGraph.get();
+    RenderStage* fragmentStage = worker._rootRenderStage.get();
+    unsigned int firstLeaf = worker._parallelCullFirstRenderLeaf;
+    unsigned int endLeaf = worker._currentReuseRenderLeafIndex;
+
+    // RenderLeaf's that haven't been created by createOrReuseRenderLeaf() can't be put back in traversal
+    // order, so cull the range again serially along with the aborted ones.
+    if (worker._parallelCullAborted || countRenderLeaves(fragment)!=endLeaf-firstLeaf)
+    {
+        worker._nearPlaneCandidateMap.clear();
+        worker._farPlaneCandidateMap.clear();
+        fragment->clean();
+        fragmentStage->reset();
+
+        for(unsigned int i=begin; i<end; ++i)
+        {
+            group.getChild(i)->accept(*this);
+        }
+        return;
+    }
+
+    // near and far planes
+    if (worker._computed_znear<_computed_znear) _computed_znear = worker._computed_znear;
+    if (worker._computed_zfar>_computed_zfar) _computed_zfar = worker._computed_zfar;
+
+    _nearPlaneCandidateMap.insert(worker._nearPlaneCandidateMap.begin(), worker._nearPlaneCandidateMap.end());
+    _farPlaneCandidateMap.insert(worker._farPlaneCandidateMap.begin(), worker._farPlaneCandidateMap.end());
+    worker._nearPlaneCandidateMap.clear();
+    worker._farPlaneCandidateMap.clear();
+
+    // positioned lights, clip planes and texgens
+    PositionalStateContainer* positionalState = fragmentStage->getPositionalStateContainer();
+    if (!positionalState->_attrList.empty() || !positionalState->_texAttrListMap.empty())
+    {
+        RenderStage* stage = getCurrentRenderStage();
+        for(PositionalStateContainer::AttrMatrixList::iterator itr = positionalState->_attrList.begin();
+            itr != positionalState->_attrList.end();
+            ++itr)
+        {
+            stage->addPositionedAttribute(itr->second.get(), itr->first.get());
+        }
+
+        for(PositionalStateContainer::TexUnitAttrMatrixListMap::iterator titr = positionalState->_texAttrListMap.begin();
+            titr != positionalState->_texAttrListMap.end();
+            ++titr)
+        {
+            for(PositionalStateContainer::AttrMatrixList::iterator itr = titr->second.begin();
+                itr != titr->second.end();
+                ++itr)
+            {
+                stage->addPositionedTextureAttribute(titr->first, itr->second.get(), itr->first.get());
+            }
+        }
+    }
+
+    // add the RenderLeaf's in the order they were culled, pushing the StateSet's of their fragment StateGraph
+    // onto our own StateGraph so that they end up in the same StateGraph's and RenderBin's as if culled here.
+    std::vector<StateGraph*> mergedPath;
+    std::vector<StateGraph*> leafPath;
+    StateGraph* currentFragment = fragment;
+    for(unsigned int i=firstLeaf; i<endLeaf; ++i)
+    {
+        RenderLeaf* leaf = worker._reuseRenderLeafList[i].get();
+        if (leaf->_parent!=currentFragment)
+        {
+            leafPath.clear();
+            for(StateGraph* sg = leaf->_parent; sg && sg!=fragment; sg = sg->_parent)
+            {
+                leafPath.push_back(sg);
+            }
+            std::reverse(leafPath.begin(), leafPath.end());
+
+            unsigned int numShared = 0;
+            while(numShared<mergedPath.size() && numShared<leafPath.size() && mergedPath[numShared]==leafPath[numShared]) ++numShared;
+
+            while(mergedPath.size()>numShared)
+            {
+                popStateSet();
+                mergedPath.pop_back();
+            }
+
+            for(unsigned int j=numShared; j<leafPath.size(); ++j)
+            {
+                pushStateSet(leafPath[j]->getStateSet());
+                mergedPath.push_back(leafPath[j]);
+            }
+
+            currentFragment = leaf->_parent;
+        }
+
+        leaf->_traversalNumber = _traversalNumber++;
+
+        if (_currentStateGraph->leaves_empty())
+        {
+            _currentRenderBin->addStateGraph(_currentStateGraph);
+        }
+        _currentStateGraph->addLeaf(leaf);
+    }
+
+    while(!mergedPath.empty())
+    {
+        popStateSet();
+        mergedPath.pop_back();
+    }
+
+    fragment->clean();
+    fragmentStage->reset();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Cached drawables of static subgraphs
+//
+bool CullVisitor::cullRenderLeafCache(osg::Group& group)
+{
+    // the StateSet's of the culling set's state frustums depend on the bounds of each drawable.
+    if (!getCurrentCullingSet().getStateFrustumList().empty()) return false;
+
+    // bring the bounds of the subgraph up to date, dirtying the cache if they had been dirtied.
+    group.getBound();
+
+    osg::ref_ptr<RenderLeafCache>& cache = _renderLeafCacheMap[&group];
+    if (!cache) cache = new RenderLeafCache;
+    if (!cache->isUpToDate(group, *this)) cache->build(group, *this);
+    if (!cache->_cacheable) return false;
+
+    RefMatrix* modelview = getModelViewMatrix();
+    std::fill(cache->_refMatrices.begin(), cache->_refMatrices.end(), static_cast<RefMatrix*>(0));
+    std::fill(cache->_boundCullResults.begin(), cache->_boundCullResults.end(), static_cast<unsigned char>(RenderLeafCache::BOUND_NOT_TESTED));
+
+    std::vector<int> pushedPath;
+    std::vector<int> leafPath;
+    int currentStatePath = -1;
+    for(RenderLeafCache::LeafList::const_iterator itr = cache->_leaves.begin();
+        itr != cache->_leaves.end();
+        ++itr)
+    {
+        const RenderLeafCache::Leaf& leaf = *itr;
+        osg::Drawable* drawable = leaf._drawable.get();
+
+        // the group's culling mask has already been narrowed down to the planes its bound crosses,
+        // so these tests are free for groups entirely within the view frustum.
+        if (cache->isCulled(leaf._bound, *this)) continue;
+        if (drawable->isCullingActive() && isCulled(leaf._bb)) continue;
+
+        RefMatrix* matrix = modelview;
+        if (leaf._matrix>=0)
+        {
+            RefMatrix*& refMatrix = cache->_refMatrices[leaf._matrix];
+            if (!refMatrix) refMatrix = createOrReuseMatrix(cache->_matrices[leaf._matrix]*(*modelview));
+            matrix = refMatrix;
+        }
+
+        const BoundingBox& bb = drawable->getBoundingBox();
+        if (_computeNearFar && bb.valid())
+        {
+            if (!updateCalculatedNearFar(*matrix,*drawable,false)) continue;
+        }
+
+        float depth = bb.valid() ? distance(bb.center(),*matrix) : 0.0f;
+        if (osg::isNaN(depth))
+        {
+            OSG_NOTICE<<"CullVisitor::cullRenderLeafCache(Group&) detected NaN,"<<std::endl
+                                    <<"    depth="<<depth<<", center=("<<bb.center()<<"),"<<std::endl
+                                    <<"    matrix="<<*matrix<<std::endl;
+            continue;
+        }
+
+        // push and pop the StateSet's down to the common parent of the previous and current drawables.
+        if (leaf._statePath!=currentStatePath)
+        {
+            leafPath.clear();
+            for(int i = leaf._statePath; i>=0; i = cache->_statePaths[i]._parent)
+            {
+                leafPath.push_back(i);
+            }
+            std::reverse(leafPath.begin(), leafPath.end());
+
+            unsigned int numShared = 0;
+            while(numShared<pushedPath.size() && numShared<leafPath.size() && pushedPath[numShared]==leafPath[numShared]) ++numShared;
+
+            while(pushedPath.size()>numShared)
+            {
+                popStateSet();
+                pushedPath.pop_back();
+            }
+
+            for(unsigned int i=numShared; i<leafPath.size(); ++i)
+            {
+                pushStateSet(cache->_statePaths[leafPath[i]]._stateset.get());
+                pushedPath.push_back(leafPath[i]);
+            }
+
+            currentStatePath = leaf._statePath;
+        }
+
+        addDrawableAndDepth(drawable,matrix,depth);
+    }
+
+    while(!pushedPath.empty())
+    {
+        popStateSet();
+        pushedPath.pop_back();
+    }
+
+    return true;
+}
@@ -22,6 +22,7 @@
 #include <osg/AlphaFunc>
 
 #include <algorithm>
+#include <map>
 
 using namespace osg;
 using namespace osgUtil;
@@ -38,6 +39,7 @@ class RenderBinPrototypeList : osg::depends_on<OpenThreads::Mutex*, osg::Referen
             add("SORT_BACK_TO_FRONT",new RenderBin(RenderBin::SORT_BACK_TO_FRONT));
             add("SORT_FRONT_TO_BACK",new RenderBin(RenderBin::SORT_FRONT_TO_BACK));
             add("TraversalOrderBin",new RenderBin(RenderBin::TRAVERSAL_ORDER));
+            add("StateKeySortedBin",new RenderBin(RenderBin::SORT_BY_STATE_KEY));
         }
 
         void add(const std::string& name, RenderBin* bin)
@@ -113,7 +115,7 @@ void RenderBin::removeRenderBinPrototype(RenderBin* proto)
 
 static bool s_defaultBinSortModeInitialized = false;
 static RenderBin::SortMode s_defaultBinSortMode = RenderBin::SORT_BY_STATE;
-static osg::ApplicationUsageProxy RenderBin_e0(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_DEFAULT_BIN_SORT_MODE <type>","SORT_BY_STATE | SORT_BY_STATE_THEN_FRONT_TO_BACK | SORT_FRONT_TO_BACK | SORT_BACK_TO_FRONT");
+static osg::ApplicationUsageProxy RenderBin_e0(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_DEFAULT_BIN_SORT_MODE <type>","SORT_BY_STATE | SORT_BY_STATE_THEN_FRONT_TO_BACK | SORT_FRONT_TO_BACK | SORT_BACK_TO_FRONT | TRAVERSAL_ORDER | SORT_BY_STATE_KEY");
 
 void RenderBin::setDefaultRenderBinSortMode(RenderBin::SortMode mode)
 {
@@ -136,6 +138,7 @@ RenderBin::SortMode RenderBin::getDefaultRenderBinSortMode()
             else if (strcmp(str,"SORT_FRONT_TO_BACK")==0) s_defaultBinSortMode = RenderBin::SORT_FRONT_TO_BACK;
             else if (strcmp(str,"SORT_BACK_TO_FRONT")==0) s_defaultBinSortMode = RenderBin::SORT_BACK_TO_FRONT;
             else if (strcmp(str,"TRAVERSAL_ORDER")==0) s_defaultBinSortMode = RenderBin::TRAVERSAL_ORDER;
+            else if (strcmp(str,"SORT_BY_STATE_KEY")==0) s_defaultBinSortMode = RenderBin::SORT_BY_STATE_KEY;
         }
     }
 
@@ -250,6 +253,9 @@ void RenderBin::sortImplementation()
         case(TRAVERSAL_ORDER):
             sortTraversalOrder();
             break;
+        case(SORT_BY_STATE_KEY):
+            sortByStateKey();
+            break;
     }
 }
 
@@ -346,6 +352,214 @@ void RenderBin::sortTraversalOrder()
     std::sort(_renderLeafList.begin(),_renderLeafList.end(),TraversalOrderFunctor());
 }
 
+namespace
+{
+
+// Dense ids given to the programs and textures in their order of first appearance, 0 standing for none.
+class StateKeyIds
+{
+public:
+    uint64_t getId(const osg::StateAttribute* attribute)
+    {
+        if (!attribute) return 0;
+
+        std::pair<IdMap::iterator, bool> result = _ids.insert(IdMap::value_type(attribute, _ids.size()+1));
+        return result.first->second;
+    }
+
+    uint64_t getMaxId() const { return _ids.size(); }
+
+protected:
+    typedef std::map<const osg::StateAttribute*, uint64_t> IdMap;
+    IdMap _ids;
+};
+
+// number of bits needed to store the values from 0 to maxValue.
+unsigned int numBits(uint64_t maxValue)
+{
+    unsigned int bits = 0;
+    while(bits<64 && (maxValue>>bits)!=0) ++bits;
+    return bits;
+}
+
+// find the program and the texture of unit 0 a StateGraph inherits from its closest StateSets.
+void findProgramAndTexture(const StateGraph* sg, const osg::StateAttribute*& program, const osg::StateAttribute*& texture)
+{
+    program = 0;
+    texture = 0;
+    for(; sg && (!program || !texture); sg = sg->_parent)
+    {
+        const osg::StateSet* stateset = sg->getStateSet();
+        if (!stateset) continue;
+
+        if (!program) program = stateset->getAttribute(osg::StateAttribute::PROGRAM);
+        if (!texture) texture = stateset->getTextureAttribute(0, osg::StateAttribute::TEXTURE);
+    }
+}
+
+// Stable least significant digit radix sort of the keys, one byte at a time. The histograms
+// of all the bytes are gathered in a single pass, and the bytes all keys share are skipped.
+template<class KeyList>
+void radixSort(KeyList& keys, KeyList& scratch)
+{
+    const unsigned int numKeys = keys.size();
+    if (numKeys<2) return;
+
+    unsigned int counts[8][256];
+    memset(counts, 0, sizeof(counts));
+    for(typename KeyList::const_iterator itr = keys.begin(); itr != keys.end(); ++itr)
+    {
+        uint64_t key = itr->_key;
+        for(unsigned int byte = 0; byte<8; ++byte, key >>= 8)
+        {
+            ++counts[byte][key & 0xff];
+        }
+    }
+
+    scratch.resize(numKeys);
+    for(unsigned int byte = 0; byte<8; ++byte)
+    {
+        unsigned int shift = byte*8;
+        unsigned int* count = counts[byte];
+        if (count[(keys.front()._key >> shift) & 0xff]==numKeys) continue;
+
+        unsigned int offset = 0;
+        for(unsigned int i = 0; i<256; ++i)
+        {
+            unsigned int size = count[i];
+            count[i] = offset;
+            offset += size;
+        }
+
+        for(typename KeyList::const_iterator itr = keys.begin(); itr != keys.end(); ++itr)
+        {
+            scratch[count[(itr->_key >> shift) & 0xff]++] = *itr;
+        }
+        keys.swap(scratch);
+    }
+}
+
+}
+
+void RenderBin::sortByStateKey()
+{
+    // first pass hands out the ids of the programs and textures, and gathers the depth range the depths are quantized over.
+    StateKeyIds programIds, textureIds;
+    std::vector<uint64_t> stateGraphIds;
+    stateGraphIds.reserve(_stateGraphList.size()*2);
+    float minDepth = FLT_MAX;
+    float maxDepth = -FLT_MAX;
+    unsigned int numLeaves = 0;
+    uint64_t numStateGraphs = 0;
+    bool detectedNaN = false;
+    StateGraphList::iterator itr;
+    for(itr=_stateGraphList.begin();
+        itr!=_stateGraphList.end();
+        ++itr)
+    {
+        if ((*itr)->_leaves.empty()) continue;
+
+        const osg::StateAttribute* program;
+        const osg::StateAttribute* texture;
+        findProgramAndTexture(*itr, program, texture);
+        stateGraphIds.push_back(programIds.getId(program));
+        stateGraphIds.push_back(textureIds.getId(texture));
+        ++numStateGraphs;
+
+        for(StateGraph::LeafList::iterator dw_itr = (*itr)->_leaves.begin();
+            dw_itr != (*itr)->_leaves.end();
+            ++dw_itr)
+        {
+            float depth = (*dw_itr)->_depth;
+            if (osg::isNaN(depth))
+            {
+                detectedNaN = true;
+                continue;
+            }
+            ++numLeaves;
+
+            // infinite depths are keyed before and after the range rather than widening it.
+            if (depth<-FLT_MAX || depth>FLT_MAX) continue;
+            if (depth<minDepth) minDepth = depth;
+            if (depth>maxDepth) maxDepth = depth;
+        }
+    }
+
+    if (detectedNaN) OSG_NOTICE<<"Warning: RenderBin::sortByStateKey() detected NaN depth values, database may be corrupted."<<std::endl;
+
+    // keys are, from the most significant bits down, the program, the texture and the StateGraph in cull order,
+    // each given the bits its number of ids needs, and the depth quantized front to back over 16 bits. Bins with
+    // too many StateGraphs to fit in the 48 bits left are sorted by state then front to back.
+    unsigned int programBits = numBits(programIds.getMaxId());
+    unsigned int textureBits = numBits(textureIds.getMaxId());
+    unsigned int stateGraphBits = numBits(numStateGraphs);
+    unsigned int stateBits = programBits + textureBits + stateGraphBits;
+    if (stateBits>48)
+    {
+        OSG_INFO<<"RenderBin::sortByStateKey() "<<numStateGraphs<<" StateGraphs don't fit in the sort keys, sorting by state then front to back."<<std::endl;
+        sortByStateThenFrontToBack();
+        return;
+    }
+
+    const unsigned int depthBits = 16;
+    const uint64_t maxDepthKey = (uint64_t(1)<<depthBits)-1;
+    double depthScale = maxDepth>minDepth ? double(maxDepthKey-2)/(double(maxDepth)-double(minDepth)) : 0.0;
+
+    _renderLeafList.clear();
+    _stateKeyList.clear();
+    _stateKeyList.reserve(numLeaves);
+    uint64_t stateGraphId = 0;
+    for(itr=_stateGraphList.begin();
+        itr!=_stateGraphList.end();
+        ++itr)
+    {
+        if ((*itr)->_leaves.empty()) continue;
+
+        uint64_t stateKey = stateGraphIds[stateGraphId*2];
+        stateKey = (stateKey << textureBits) | stateGraphIds[stateGraphId*2+1];
+        stateKey = (stateKey << stateGraphBits) | stateGraphId;
+        stateKey <<= depthBits;
+        ++stateGraphId;
+
+        for(StateGraph::LeafList::iterator dw_itr = (*itr)->_leaves.begin();
+            dw_itr != (*itr)->_leaves.end();
+            ++dw_itr)
+        {
+            float depth = (*dw_itr)->_depth;
+            if (osg::isNaN(depth)) continue;
+
+            // finite depths are quantized from 1 to maxDepthKey-1, clamping rather than converting out of range values.
+            uint64_t depthKey;
+            if (depth<-FLT_MAX) depthKey = 0;
+            else if (depth>FLT_MAX) depthKey = maxDepthKey;
+            else
+            {
+                double scaledDepth = (double(depth)-double(minDepth))*depthScale;
+                depthKey = 1 + (scaledDepth>0.0 ? (scaledDepth<double(maxDepthKey-2) ? uint64_t(scaledDepth) : maxDepthKey-2) : 0);
+            }
+
+            StateKey key;
+            key._key = stateKey | depthKey;
+            key._leaf = dw_itr->get();
+            _stateKeyList.push_back(key);
+        }
+    }
+
+    radixSort(_stateKeyList, _stateKeyScratchList);
+
+    _renderLeafList.reserve(_stateKeyList.size());
+    for(StateKeyList::iterator key_itr = _stateKeyList.begin();
+        key_itr != _stateKeyList.end();
+        ++key_itr)
+    {
+        _renderLeafList.push_back(key_itr->_leaf);
+    }
+    _stateKeyList.clear();
+
+    // empty the render graph list to prevent it being drawn along side the render leaf list (see drawImplementation.)
+    _stateGraphList.clear();
+}
+
 void RenderBin::copyLeavesFromStateGraphListToRenderLeafList()
 {
     _renderLeafList.clear();
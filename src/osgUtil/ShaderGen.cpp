@@ -58,9 +58,9 @@ public:
 
     osg::Uniform *getUniform(const std::string& name) const
     {
-        UniformMap::const_iterator it = _uniformMap.find(name);
-        return it != _uniformMap.end() ?
-            const_cast<osg::Uniform *>(it->second.uniformVec.back().first) : 0;
+        unsigned int index = _uniformMap.find(osg::Uniform::getNameID(name));
+        return (index != _uniformMap.size() && !_uniformMap.stack(index).uniformVec.empty()) ?
+            const_cast<osg::Uniform *>(_uniformMap.stack(index).uniformVec.back().first) : 0;
     }
 
 protected:
@@ -69,16 +69,16 @@ protected:
         osg::StateAttribute::GLMode mode,
         osg::StateAttribute::GLModeValue def = osg::StateAttribute::INHERIT) const
     {
-        ModeMap::const_iterator it = modeMap.find(mode);
-        return (it != modeMap.end() && it->second.valueVec.size()) ? it->second.valueVec.back() : def;
+        unsigned int index = modeMap.find(mode);
+        return (index != modeMap.size() && modeMap.stack(index).valueVec.size()) ? modeMap.stack(index).valueVec.back() : def;
     }
 
     osg::StateAttribute *getAttribute(const AttributeMap &attributeMap,
         osg::StateAttribute::Type type, unsigned int member = 0) const
     {
-        AttributeMap::const_iterator it = attributeMap.find(std::make_pair(type, member));
-        return (it != attributeMap.end() && it->second.attributeVec.size()) ?
-            const_cast<osg::StateAttribute*>(it->second.attributeVec.back().first) : 0;
+        unsigned int index = attributeMap.find(std::make_pair(type, member));
+        return (index != attributeMap.size() && attributeMap.stack(index).attributeVec.size()) ?
+            const_cast<osg::StateAttribute*>(attributeMap.stack(index).attributeVec.back().first) : 0;
     }
 };
 
@@ -1304,6 +1304,22 @@ void CompositeViewer::updateTraversal()
     osgDB::Registry::instance()->updateTimeStampOfObjectsInCacheWithExternalReferences(*getFrameStamp());
     osgDB::Registry::instance()->removeExpiredObjectsInCache(*getFrameStamp());
 
+    if (getViewerStats() && getViewerStats()->collectStats("objectcache") && osgDB::Registry::instance()->getObjectCache())
+    {
+        osgDB::Registry::instance()->getObjectCache()->reportStats(getViewerStats(), getFrameStamp()->getFrameNumber());
+    }
+
+    if (getViewerStats() && getViewerStats()->collectStats("databasepager"))
+    {
+        for(Scenes::iterator sitr = scenes.begin();
+            sitr != scenes.end();
+            ++sitr)
+        {
+            osgDB::DatabasePager* dp = (*sitr)->getDatabasePager();
+            if (dp) dp->reportStats(getViewerStats(), getFrameStamp()->getFrameNumber());
+        }
+    }
+
 
     if (_incrementalCompileOperation.valid())
     {
@@ -1149,6 +1149,16 @@ void Viewer::updateTraversal()
     osgDB::Registry::instance()->updateTimeStampOfObjectsInCacheWithExternalReferences(*getFrameStamp());
     osgDB::Registry::instance()->removeExpiredObjectsInCache(*getFrameStamp());
 
+    if (getViewerStats() && getViewerStats()->collectStats("objectcache") && osgDB::Registry::instance()->getObjectCache())
+    {
+        osgDB::Registry::instance()->getObjectCache()->reportStats(getViewerStats(), getFrameStamp()->getFrameNumber());
+    }
+
+    if (getViewerStats() && getViewerStats()->collectStats("databasepager") && _scene->getDatabasePager())
+    {
+        _scene->getDatabasePager()->reportStats(getViewerStats(), getFrameStamp()->getFrameNumber());
+    }
+
 
     if (_updateOperations.valid())
     {
@@ -135,6 +135,11 @@ REGISTER_OBJECT_WRAPPER( Group,
 {
     ADD_USER_SERIALIZER( Children );  // _children
 
+    {
+        UPDATE_TO_VERSION_SCOPED( 147 )
+        ADD_BOOL_SERIALIZER( CacheRenderLeaves, false );  // _cacheRenderLeaves
+    }
+
     ADD_METHOD_OBJECT( "getNumChildren", GroupGetNumChildren );
     ADD_METHOD_OBJECT( "getChild", GroupGetChild );
     ADD_METHOD_OBJECT( "setChild", GroupSetChild );